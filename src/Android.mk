@@ -40,7 +40,8 @@ COMMON_SRC_FILES := \
 	Common/Resource.cpp \
 	Common/Socket.cpp \
 	Common/Thread.cpp \
-	Common/Timer.cpp
+	Common/Timer.cpp \
+	Common/WorkerPool.cpp
 
 COMMON_SRC_FILES += \
 	Main/Config.cpp \
@@ -66,13 +67,17 @@ COMMON_SRC_FILES += \
 	Renderer/Clipper.cpp \
 	Renderer/Color.cpp \
 	Renderer/Context.cpp \
+	Renderer/DeferredClear.cpp \
 	Renderer/ETC_Decoder.cpp \
+	Renderer/HierarchicalZ.cpp \
 	Renderer/Matrix.cpp \
 	Renderer/PixelProcessor.cpp \
 	Renderer/Plane.cpp \
 	Renderer/Point.cpp \
 	Renderer/QuadRasterizer.cpp \
 	Renderer/Renderer.cpp \
+	Renderer/RoutineArchive.cpp \
+	Renderer/RoutineCompiler.cpp \
 	Renderer/Sampler.cpp \
 	Renderer/SetupProcessor.cpp \
 	Renderer/Surface.cpp \
@@ -141,6 +146,10 @@ endif
 # Common Subzero defines
 COMMON_CFLAGS += -DALLOW_DUMP=0 -DALLOW_TIMERS=0 -DALLOW_LLVM_CL=0 -DALLOW_LLVM_IR=0 -DALLOW_LLVM_IR_AS_INPUT=0 -DALLOW_MINIMAL_BUILD=0 -DALLOW_WASM=0 -DICE_THREAD_LOCAL_HACK=1
 
+ifdef use_subzero
+COMMON_CFLAGS += -DROUTINE_ARCHIVE=1
+endif
+
 # Subzero target
 LOCAL_CFLAGS_x86 += -DSZTARGET=X8632
 LOCAL_CFLAGS_x86_64 += -DSZTARGET=X8664
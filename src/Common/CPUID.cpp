@@ -36,6 +36,9 @@ namespace sw
 	bool CPUID::SSE3 = detectSSE3();
 	bool CPUID::SSSE3 = detectSSSE3();
 	bool CPUID::SSE4_1 = detectSSE4_1();
+	bool CPUID::AVX = detectAVX();
+	bool CPUID::AVX2 = detectAVX2();
+	bool CPUID::FMA = detectFMA();
 	int CPUID::cores = detectCoreCount();
 	int CPUID::affinity = detectAffinity();
 
@@ -46,6 +49,9 @@ namespace sw
 	bool CPUID::enableSSE3 = true;
 	bool CPUID::enableSSSE3 = true;
 	bool CPUID::enableSSE4_1 = true;
+	bool CPUID::enableAVX = true;
+	bool CPUID::enableAVX2 = true;
+	bool CPUID::enableFMA = true;
 
 	void CPUID::setEnableMMX(bool enable)
 	{
@@ -58,6 +64,9 @@ namespace sw
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
 		}
 	}
 
@@ -72,6 +81,9 @@ namespace sw
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
 		}
 	}
 
@@ -90,6 +102,9 @@ namespace sw
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
 		}
 	}
 
@@ -108,6 +123,9 @@ namespace sw
 			enableSSE3 = false;
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
 		}
 	}
 
@@ -126,6 +144,9 @@ namespace sw
 		{
 			enableSSSE3 = false;
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
 		}
 	}
 
@@ -144,6 +165,9 @@ namespace sw
 		else
 		{
 			enableSSE4_1 = false;
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
 		}
 	}
 
@@ -160,6 +184,67 @@ namespace sw
 			enableSSE3 = true;
 			enableSSSE3 = true;
 		}
+		else
+		{
+			enableAVX = false;
+			enableAVX2 = false;
+			enableFMA = false;
+		}
+	}
+
+	void CPUID::setEnableAVX(bool enable)
+	{
+		enableAVX = enable;
+
+		if(enableAVX)
+		{
+			enableMMX = true;
+			enableCMOV = true;
+			enableSSE = true;
+			enableSSE2 = true;
+			enableSSE3 = true;
+			enableSSSE3 = true;
+			enableSSE4_1 = true;
+		}
+		else
+		{
+			enableAVX2 = false;
+			enableFMA = false;
+		}
+	}
+
+	void CPUID::setEnableAVX2(bool enable)
+	{
+		enableAVX2 = enable;
+
+		if(enableAVX2)
+		{
+			enableMMX = true;
+			enableCMOV = true;
+			enableSSE = true;
+			enableSSE2 = true;
+			enableSSE3 = true;
+			enableSSSE3 = true;
+			enableSSE4_1 = true;
+			enableAVX = true;
+		}
+	}
+
+	void CPUID::setEnableFMA(bool enable)
+	{
+		enableFMA = enable;
+
+		if(enableFMA)
+		{
+			enableMMX = true;
+			enableCMOV = true;
+			enableSSE = true;
+			enableSSE2 = true;
+			enableSSE3 = true;
+			enableSSSE3 = true;
+			enableSSE4_1 = true;
+			enableAVX = true;
+		}
 	}
 
 	static void cpuid(int registers[4], int info)
@@ -178,6 +263,39 @@ namespace sw
 		#endif
 	}
 
+	static void cpuid(int registers[4], int info, int subinfo)
+	{
+		#if defined(__i386__) || defined(__x86_64__)
+			#if defined(_WIN32)
+				__cpuidex(registers, info, subinfo);
+			#else
+				__asm volatile("cpuid": "=a" (registers[0]), "=b" (registers[1]), "=c" (registers[2]), "=d" (registers[3]): "a" (info), "c" (subinfo));
+			#endif
+		#else
+			registers[0] = 0;
+			registers[1] = 0;
+			registers[2] = 0;
+			registers[3] = 0;
+		#endif
+	}
+
+	// Register state enabled by the operating system. Only valid when CPUID reports OSXSAVE.
+	static long long xgetbv()
+	{
+		#if defined(__i386__) || defined(__x86_64__)
+			#if defined(_WIN32)
+				return _xgetbv(0);
+			#else
+				unsigned int eax;
+				unsigned int edx;
+				__asm volatile(".byte 0x0F, 0x01, 0xD0": "=a" (eax), "=d" (edx): "c" (0));   // xgetbv
+				return ((long long)edx << 32) | eax;
+			#endif
+		#else
+			return 0;
+		#endif
+	}
+
 	bool CPUID::detectMMX()
 	{
 		int registers[4];
@@ -227,6 +345,39 @@ namespace sw
 		return SSE4_1 = (registers[2] & 0x00080000) != 0;
 	}
 
+	bool CPUID::detectAVX()
+	{
+		int registers[4];
+		cpuid(registers, 1);
+		bool avx = (registers[2] & 0x10000000) != 0;
+		bool osxsave = (registers[2] & 0x08000000) != 0;
+
+		// The operating system must also preserve the upper halves of the YMM registers
+		return AVX = avx && osxsave && (xgetbv() & 0x00000006) == 0x00000006;
+	}
+
+	bool CPUID::detectAVX2()
+	{
+		int registers[4];
+		cpuid(registers, 0);
+		int maxInfo = registers[0];
+
+		if(maxInfo < 7)
+		{
+			return AVX2 = false;
+		}
+
+		cpuid(registers, 7, 0);
+		return AVX2 = detectAVX() && (registers[1] & 0x00000020) != 0;
+	}
+
+	bool CPUID::detectFMA()
+	{
+		int registers[4];
+		cpuid(registers, 1);
+		return FMA = detectAVX() && (registers[2] & 0x00001000) != 0;
+	}
+
 	int CPUID::detectCoreCount()
 	{
 		int cores = 0;
@@ -251,7 +402,6 @@ namespace sw
 		#endif
 
 		if(cores < 1)  cores = 1;
-		if(cores > 16) cores = 16;
 
 		return cores;   // FIXME: Number of physical cores
 	}
@@ -275,12 +425,22 @@ namespace sw
 
 				processAffinityMask >>= 1;
 			}
+		#elif defined(__linux__)
+			cpu_set_t cpuSet;
+
+			if(sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+			{
+				cores = CPU_COUNT(&cpuSet);
+			}
+			else
+			{
+				return detectCoreCount();
+			}
 		#else
 			return detectCoreCount();   // FIXME: Assumes no affinity limitation
 		#endif
 
 		if(cores < 1)  cores = 1;
-		if(cores > 16) cores = 16;
 
 		return cores;
 	}
@@ -36,6 +36,9 @@ namespace sw
 		static bool supportsSSE3();
 		static bool supportsSSSE3();
 		static bool supportsSSE4_1();
+		static bool supportsAVX();
+		static bool supportsAVX2();
+		static bool supportsFMA();
 		static int coreCount();
 		static int processAffinity();
 
@@ -46,6 +49,9 @@ namespace sw
 		static void setEnableSSE3(bool enable);
 		static void setEnableSSSE3(bool enable);
 		static void setEnableSSE4_1(bool enable);
+		static void setEnableAVX(bool enable);
+		static void setEnableAVX2(bool enable);
+		static void setEnableFMA(bool enable);
 
 		static void setFlushToZero(bool enable);        // Denormal results are written as zero
 		static void setDenormalsAreZero(bool enable);   // Denormal inputs are read as zero
@@ -58,6 +64,9 @@ namespace sw
 		static bool SSE3;
 		static bool SSSE3;
 		static bool SSE4_1;
+		static bool AVX;
+		static bool AVX2;
+		static bool FMA;
 		static int cores;
 		static int affinity;
 
@@ -68,6 +77,9 @@ namespace sw
 		static bool enableSSE3;
 		static bool enableSSSE3;
 		static bool enableSSE4_1;
+		static bool enableAVX;
+		static bool enableAVX2;
+		static bool enableFMA;
 
 		static bool detectMMX();
 		static bool detectCMOV();
@@ -76,6 +88,9 @@ namespace sw
 		static bool detectSSE3();
 		static bool detectSSSE3();
 		static bool detectSSE4_1();
+		static bool detectAVX();
+		static bool detectAVX2();
+		static bool detectFMA();
 		static int detectCoreCount();
 		static int detectAffinity();
 	};
@@ -123,6 +138,21 @@ namespace sw
 		return SSE4_1 && enableSSE4_1;
 	}
 
+	inline bool CPUID::supportsAVX()
+	{
+		return AVX && enableAVX;
+	}
+
+	inline bool CPUID::supportsAVX2()
+	{
+		return AVX2 && enableAVX2;
+	}
+
+	inline bool CPUID::supportsFMA()
+	{
+		return FMA && enableFMA;
+	}
+
 	inline int CPUID::coreCount()
 	{
 		return cores;
@@ -45,6 +45,19 @@ namespace sw
 		return hs.h;
 	}
 
+	inline short halfAsShort(half h)
+	{
+		union
+		{
+			half h;
+			short s;
+		} hs;
+
+		hs.h = h;
+
+		return hs.s;
+	}
+
 	class RGB9E5
 	{
 		unsigned int R : 9;
@@ -33,6 +33,25 @@ namespace sw
 		return hash;
 	}
 
+	unsigned int FNV_1a(const unsigned int *data, int count)
+	{
+		unsigned int hash = 0x811C9DC5;
+
+		for(int i = 0; i < count; i++)
+		{
+			hash = (hash ^ data[i]) * 16777619;
+		}
+
+		// The low bits only depend on the low bits of the data so far, so mix in the high bits
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35;
+		hash ^= hash >> 16;
+
+		return hash;
+	}
+
 	unsigned char sRGB8toLinear8(unsigned char value)
 	{
 		static unsigned char sRGBtoLinearTable[256] = { 255 };
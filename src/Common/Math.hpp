@@ -362,6 +362,7 @@ namespace sw
 	unsigned char sRGB8toLinear8(unsigned char value);
 
 	uint64_t FNV_1a(const unsigned char *data, int size);   // Fowler-Noll-Vo hash function
+	unsigned int FNV_1a(const unsigned int *data, int count);   // Word-wise, with avalanche, for hash table indices
 
 	// Round up to the next multiple of alignment
 	inline unsigned int align(unsigned int value, unsigned int alignment)
@@ -0,0 +1,106 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_TaskDeque_hpp
+#define sw_TaskDeque_hpp
+
+#include "Debug.hpp"
+
+#include <atomic>
+
+namespace sw
+{
+	// Fixed capacity work-stealing deque (Chase-Lev). Only the owning thread
+	// may push() and pop(), at the bottom end. Any other thread may steal()
+	// from the top end. The capacity must be a power of two and exceed the
+	// number of tasks that can be in flight at any time, as the deque does
+	// not grow.
+	class TaskDeque
+	{
+	public:
+		explicit TaskDeque(int capacity) : mask(capacity - 1), top(0), bottom(0)
+		{
+			ASSERT((capacity & mask) == 0);
+
+			buffer = new std::atomic<int>[capacity];
+		}
+
+		~TaskDeque()
+		{
+			delete[] buffer;
+		}
+
+		void push(int value)
+		{
+			long long b = bottom.load(std::memory_order_relaxed);
+			ASSERT(b - top.load(std::memory_order_acquire) <= mask);
+
+			buffer[b & mask].store(value, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_release);
+		}
+
+		bool pop(int &value)
+		{
+			long long b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			long long t = top.load(std::memory_order_relaxed);
+
+			if(t > b)   // Empty
+			{
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			value = buffer[b & mask].load(std::memory_order_relaxed);
+
+			if(t == b)   // Last element, race against thieves
+			{
+				bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+
+				return won;
+			}
+
+			return true;
+		}
+
+		bool steal(int &value)
+		{
+			long long t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			long long b = bottom.load(std::memory_order_acquire);
+
+			if(t >= b)   // Empty
+			{
+				return false;
+			}
+
+			value = buffer[t & mask].load(std::memory_order_relaxed);
+
+			return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+
+	private:
+		const long long mask;
+		std::atomic<int> *buffer;
+
+		// Keep the thieves' and the owner's end on separate cache lines
+		std::atomic<long long> top;
+		char padding[64];
+		std::atomic<long long> bottom;
+	};
+}
+
+#endif   // sw_TaskDeque_hpp
@@ -0,0 +1,193 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "WorkerPool.hpp"
+
+#include "CPUID.hpp"
+#include "Math.hpp"
+
+#include <algorithm>
+
+namespace sw
+{
+	WorkerPool &WorkerPool::shared()
+	{
+		static WorkerPool pool(CPUID::processAffinity());
+
+		return pool;
+	}
+
+	WorkerPool::WorkerPool(int threadCount) : threadCount(max(threadCount, 1))
+	{
+		helper = nullptr;
+		exitThreads = false;
+
+		if(this->threadCount > 1)
+		{
+			helper = new Thread*[this->threadCount - 1];
+
+			for(int i = 0; i < this->threadCount - 1; i++)
+			{
+				helper[i] = new Thread(threadFunction, this);
+			}
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		if(!helper)
+		{
+			return;
+		}
+
+		queueMutex.lock();
+		exitThreads = true;
+		queueMutex.unlock();
+
+		wake.signal();
+
+		for(int i = 0; i < threadCount - 1; i++)
+		{
+			helper[i]->join();
+			delete helper[i];
+		}
+
+		delete[] helper;
+	}
+
+	int WorkerPool::getThreadCount() const
+	{
+		return threadCount;
+	}
+
+	void WorkerPool::run(void (*function)(void *parameters, int index), void *parameters, int count)
+	{
+		Job job;
+		job.function = function;
+		job.parameters = parameters;
+		job.count = count;
+		job.next = 0;
+		job.wanted = min(count, threadCount) - 1;
+		job.active = 0;
+		job.detached = false;
+
+		if(job.wanted < 1)
+		{
+			work(&job);
+
+			return;
+		}
+
+		queueMutex.lock();
+		queue.push_back(&job);
+		queueMutex.unlock();
+
+		wake.signal();
+
+		work(&job);
+
+		// Helpers which joined may still be processing their last item
+		queueMutex.lock();
+		queue.erase(std::find(queue.begin(), queue.end(), &job));
+		job.detached = true;
+		bool busy = job.active > 0;
+		queueMutex.unlock();
+
+		if(busy)
+		{
+			job.finished.wait();
+		}
+	}
+
+	void WorkerPool::threadFunction(void *parameters)
+	{
+		static_cast<WorkerPool*>(parameters)->workLoop();
+	}
+
+	void WorkerPool::workLoop()
+	{
+		while(true)
+		{
+			wake.wait();
+
+			if(exitThreads)
+			{
+				wake.signal();   // Pass it on to the next helper
+
+				return;
+			}
+
+			while(Job *job = join())
+			{
+				work(job);
+
+				queueMutex.lock();
+				bool last = --job->active == 0 && job->detached;
+				queueMutex.unlock();
+
+				if(last)
+				{
+					job->finished.signal();
+				}
+			}
+		}
+	}
+
+	WorkerPool::Job *WorkerPool::join()
+	{
+		Job *job = nullptr;
+		bool more = false;
+
+		queueMutex.lock();
+
+		for(Job *queued : queue)
+		{
+			if(queued->wanted > 0 && queued->next < queued->count)
+			{
+				if(!job)
+				{
+					job = queued;
+					job->wanted--;
+					job->active++;
+				}
+
+				more = more || queued->wanted > 0;
+			}
+		}
+
+		queueMutex.unlock();
+
+		if(more)
+		{
+			wake.signal();   // Let another helper join too
+		}
+
+		return job;
+	}
+
+	void WorkerPool::work(Job *job)
+	{
+		while(true)
+		{
+			int index = job->next.fetchAdd(1);
+
+			if(index >= job->count)
+			{
+				return;
+			}
+
+			job->function(job->parameters, index);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_WorkerPool_hpp
+#define sw_WorkerPool_hpp
+
+#include "Thread.hpp"
+#include "MutexLock.hpp"
+
+#include <deque>
+
+namespace sw
+{
+	// Helper threads which process the items of jobs together with the calling threads. One pool
+	// is shared by the whole process; its size is fixed when it's first used.
+	class WorkerPool
+	{
+	public:
+		static WorkerPool &shared();
+
+		explicit WorkerPool(int threadCount);   // Including a calling thread
+
+		~WorkerPool();
+
+		int getThreadCount() const;
+
+		// Calls function(parameters, index) for each index in [0, count), and returns when they've all
+		// completed. The calling thread processes items too, so concurrent and nested jobs always make
+		// progress, with idle helpers joining in.
+		void run(void (*function)(void *parameters, int index), void *parameters, int count);
+
+	private:
+		struct Job
+		{
+			void (*function)(void *parameters, int index);
+			void *parameters;
+			int count;
+			AtomicInt next;
+
+			int wanted;   // Helpers yet to join
+			int active;   // Helpers processing items
+			bool detached;   // Removed from the queue by the calling thread
+			Event finished;
+		};
+
+		static void threadFunction(void *parameters);
+		void workLoop();
+		Job *join();   // Picks a queued job which wants more helpers
+		static void work(Job *job);
+
+		const int threadCount;
+		Thread **helper;
+		Event wake;
+		bool exitThreads;
+
+		MutexLock queueMutex;   // Only held to enqueue, join or remove jobs
+		std::deque<Job*> queue;
+	};
+}
+
+#endif   // sw_WorkerPool_hpp
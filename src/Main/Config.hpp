@@ -22,6 +22,11 @@
 
 #define ASTC_SUPPORT 0
 
+// Storing routines on disk requires a back-end which can load code images (Subzero)
+#ifndef ROUTINE_ARCHIVE
+#define ROUTINE_ARCHIVE 0
+#endif
+
 // Worker thread count when not set by SwiftConfig
 // 0 = process affinity count (recommended)
 // 1 = rendering on main thread (no worker threads), useful for debugging
@@ -75,8 +80,8 @@ namespace sw
 
 	enum
 	{
-		OUTLINE_RESOLUTION = 8192,   // Maximum vertical resolution of the render target
 		MIPMAP_LEVELS = 14,
+		OUTLINE_RESOLUTION = 1 << (MIPMAP_LEVELS - 1),   // Maximum vertical resolution of the render target, the same as the maximum texture size
 		TEXTURE_IMAGE_UNITS = 16,
 		VERTEX_TEXTURE_IMAGE_UNITS = 16,
 		TOTAL_IMAGE_UNITS = TEXTURE_IMAGE_UNITS + VERTEX_TEXTURE_IMAGE_UNITS,
@@ -96,6 +101,8 @@ namespace sw
 		MAX_PROGRAM_TEXEL_OFFSET = 7,
 		MAX_TEXTURE_LOD = MIPMAP_LEVELS - 2,   // Trilinear accesses lod+1
 		RENDERTARGETS = 8,
+		BATCH_SIZE = 128,   // Maximum number of primitives processed together by a vertex and setup task
+		MAX_THREADS = 256,   // Maximum number of rendering threads, primitive units and pixel clusters (must be power of 2)
 	};
 }
 
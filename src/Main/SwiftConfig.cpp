@@ -335,9 +335,25 @@ namespace sw
 		html += "</select></td>\n";
 		html += "</tr>\n";
 		html += "<tr><td>Vertex cache size:</td><td><select name='vertexCacheSize' title='The number of processed vertices being cached for reuse. Lower numbers save memory but require more vertices to be reprocessed.'>\n";
+		html += "<option value='16'"   + (config.vertexCacheSize == 16   ? selected : empty) + ">16</option>\n";
+		html += "<option value='32'"   + (config.vertexCacheSize == 32   ? selected : empty) + ">32</option>\n";
 		html += "<option value='64'"   + (config.vertexCacheSize == 64   ? selected : empty) + ">64 (default)</option>\n";
+		html += "<option value='128'"  + (config.vertexCacheSize == 128  ? selected : empty) + ">128</option>\n";
+		html += "<option value='256'"  + (config.vertexCacheSize == 256  ? selected : empty) + ">256</option>\n";
+		html += "<option value='512'"  + (config.vertexCacheSize == 512  ? selected : empty) + ">512</option>\n";
+		html += "<option value='1024'" + (config.vertexCacheSize == 1024 ? selected : empty) + ">1024</option>\n";
 		html += "</select></td>\n";
 		html += "</tr>\n";
+		html += "<tr><td>Vertex cache associativity:</td><td><select name='vertexCacheAssociativity' title='The number of places each processed vertex can be cached in. Higher numbers reprocess fewer vertices when their indices collide, but make each lookup slower.'>\n";
+		html += "<option value='1'" + (config.vertexCacheAssociativity == 1 ? selected : empty) + ">Direct mapped (default)</option>\n";
+		html += "<option value='2'" + (config.vertexCacheAssociativity == 2 ? selected : empty) + ">2-way</option>\n";
+		html += "<option value='4'" + (config.vertexCacheAssociativity == 4 ? selected : empty) + ">4-way</option>\n";
+		html += "<option value='8'" + (config.vertexCacheAssociativity == 8 ? selected : empty) + ">8-way</option>\n";
+		html += "</select></td>\n";
+		html += "</tr>\n";
+		html += "<tr><td>Vertex deduplication:</td><td><input name = 'vertexDeduplication' type='checkbox'" + (config.vertexDeduplication == true ? checked : empty) + " title='If checked the shared vertices of indexed triangle lists are processed only once per batch of triangles.'></td></tr>\n";
+		html += "<tr><td>Texture tiling:</td><td><input name = 'textureTiling' type='checkbox'" + (config.textureTiling == true ? checked : empty) + " title='If checked large 2D textures are sampled from a copy stored in 4x4 texel tiles, which improves cache locality at the cost of extra memory.'></td></tr>\n";
+		html += "<tr><td>Asynchronous compilation:</td><td><input name = 'asynchronousCompilation' type='checkbox'" + (config.asynchronousCompilation ? checked : empty) + " title='If checked routines missing from the caches are compiled in the background, so the application does not stall while new state combinations are encountered. Rendering of the draw calls using them is deferred until they are ready.'></td></tr>";
 		html += "</table>\n";
 		html += "<h2><em>Quality</em></h2>\n";
 		html += "<table>\n";
@@ -391,12 +407,25 @@ namespace sw
 		html += "<option value='14'" + (config.threadCount == 14 ? selected : empty) + ">14</option>\n";
 		html += "<option value='15'" + (config.threadCount == 15 ? selected : empty) + ">15</option>\n";
 		html += "<option value='16'" + (config.threadCount == 16 ? selected : empty) + ">16</option>\n";
+		html += "<option value='24'" + (config.threadCount == 24 ? selected : empty) + ">24</option>\n";
+		html += "<option value='32'" + (config.threadCount == 32 ? selected : empty) + ">32</option>\n";
+		html += "<option value='48'" + (config.threadCount == 48 ? selected : empty) + ">48</option>\n";
+		html += "<option value='64'" + (config.threadCount == 64 ? selected : empty) + ">64</option>\n";
+		html += "</select></td></tr>\n";
+		html += "<tr><td>Scanline binning:</td><td><select name='binHeight' title='The height of the bands of scanlines each rendering thread is responsible for. Taller bands keep more of the render target in the cache of each thread.'>\n";
+		html += "<option value='0'"   + (config.binHeight <= 2   ? selected : empty) + ">Interleaved scanline pairs (default)</option>\n";
+		html += "<option value='16'"  + (config.binHeight == 16  ? selected : empty) + ">16 scanlines</option>\n";
+		html += "<option value='32'"  + (config.binHeight == 32  ? selected : empty) + ">32 scanlines</option>\n";
+		html += "<option value='64'"  + (config.binHeight == 64  ? selected : empty) + ">64 scanlines</option>\n";
+		html += "<option value='128'" + (config.binHeight == 128 ? selected : empty) + ">128 scanlines</option>\n";
 		html += "</select></td></tr>\n";
+		html += "<tr><td>Hierarchical Z culling:</td><td><input name = 'hierarchicalZ' type='checkbox'" + (config.hierarchicalZ ? checked : empty) + " title='If checked triangles which are entirely behind the contents of the depth buffer are culled before rasterization.'></td></tr>";
 		html += "<tr><td>Enable SSE:</td><td><input name = 'enableSSE' type='checkbox'" + (config.enableSSE ? checked : empty) + " disabled='disabled' title='If checked enables the use of SSE instruction set extentions if supported by the CPU.'></td></tr>";
 		html += "<tr><td>Enable SSE2:</td><td><input name = 'enableSSE2' type='checkbox'" + (config.enableSSE2 ? checked : empty) + " title='If checked enables the use of SSE2 instruction set extentions if supported by the CPU.'></td></tr>";
 		html += "<tr><td>Enable SSE3:</td><td><input name = 'enableSSE3' type='checkbox'" + (config.enableSSE3 ? checked : empty) + " title='If checked enables the use of SSE3 instruction set extentions if supported by the CPU.'></td></tr>";
 		html += "<tr><td>Enable SSSE3:</td><td><input name = 'enableSSSE3' type='checkbox'" + (config.enableSSSE3 ? checked : empty) + " title='If checked enables the use of SSSE3 instruction set extentions if supported by the CPU.'></td></tr>";
 		html += "<tr><td>Enable SSE4.1:</td><td><input name = 'enableSSE4_1' type='checkbox'" + (config.enableSSE4_1 ? checked : empty) + " title='If checked enables the use of SSE4.1 instruction set extentions if supported by the CPU.'></td></tr>";
+		html += "<tr><td>Enable AVX:</td><td><input name = 'enableAVX' type='checkbox'" + (config.enableAVX ? checked : empty) + " title='If checked enables the use of AVX, AVX2 and FMA instruction set extentions if supported by the CPU.'></td></tr>";
 		html += "</table>\n";
 		html += "<h2><em>Compiler optimizations</em></h2>\n";
 		html += "<table>\n";
@@ -417,6 +446,7 @@ namespace sw
 			html += "</select></td></tr>\n";
 		}
 
+		html += "<tr><td>Shader instruction optimization:</td><td><input name = 'shaderOptimization' type='checkbox'" + (config.shaderOptimization == true ? checked : empty) + " title='If checked copy propagation, constant folding and dead code elimination are applied to shader instructions before code generation.'></td></tr>\n";
 		html += "</table>\n";
 		html += "<h2><em>Testing & Experimental</em></h2>\n";
 		html += "<table>\n";
@@ -431,7 +461,7 @@ namespace sw
 		html += "<option value='0'" + (config.frameBufferAPI == 0 ? selected : empty) + ">DirectDraw (default)</option>\n";
 		html += "<option value='1'" + (config.frameBufferAPI == 1 ? selected : empty) + ">GDI</option>\n";
 		html += "</select></td>\n";
-		html += "<tr><td>DLL precaching:</td><td><input name = 'precache' type='checkbox'" + (config.precache == true ? checked : empty) + " title='If checked dynamically generated routines will be stored in a DLL for faster loading on application restart.'></td></tr>";
+		html += "<tr><td>Routine precaching:</td><td><input name = 'precache' type='checkbox'" + (config.precache == true ? checked : empty) + " title='If checked dynamically generated routines will be stored in files for faster loading on application restart. Requires the Subzero back-end.'></td></tr>";
 		html += "<tr><td>Shadow mapping extensions:</td><td><select name='shadowMapping' title='Features that may accelerate or improve the quality of shadow mapping.'>\n";
 		html += "<option value='0'" + (config.shadowMapping == 0 ? selected : empty) + ">None</option>\n";
 		html += "<option value='1'" + (config.shadowMapping == 1 ? selected : empty) + ">Fetch4</option>\n";
@@ -534,11 +564,14 @@ namespace sw
 	void SwiftConfig::parsePost(const char *post)
 	{
 		// Only enabled checkboxes appear in the POST
+		config.hierarchicalZ = false;
 		config.enableSSE = true;
 		config.enableSSE2 = false;
 		config.enableSSE3 = false;
 		config.enableSSSE3 = false;
 		config.enableSSE4_1 = false;
+		config.enableAVX = false;
+		config.shaderOptimization = false;
 		config.disableServer = false;
 		config.forceWindowed = false;
 		config.complementaryDepthBuffer = false;
@@ -547,6 +580,9 @@ namespace sw
 		config.disableAlphaMode = false;
 		config.disable10BitMode = false;
 		config.precache = false;
+		config.vertexDeduplication = false;
+		config.textureTiling = false;
+		config.asynchronousCompilation = false;
 		config.forceClearRegisters = false;
 
 		while(*post != 0)
@@ -586,6 +622,10 @@ namespace sw
 			{
 				config.vertexCacheSize = integer;
 			}
+			else if(sscanf(post, "vertexCacheAssociativity=%d", &integer))
+			{
+				config.vertexCacheAssociativity = integer;
+			}
 			else if(sscanf(post, "textureSampleQuality=%d", &integer))
 			{
 				config.textureSampleQuality = integer;
@@ -610,6 +650,10 @@ namespace sw
 			{
 				config.threadCount = integer;
 			}
+			else if(sscanf(post, "binHeight=%d", &integer))
+			{
+				config.binHeight = integer;
+			}
 			else if(sscanf(post, "frameBufferAPI=%d", &integer))
 			{
 				config.frameBufferAPI = integer;
@@ -618,6 +662,10 @@ namespace sw
 			{
 				config.shadowMapping = integer;
 			}
+			else if(strstr(post, "hierarchicalZ=on"))
+			{
+				config.hierarchicalZ = true;
+			}
 			else if(strstr(post, "enableSSE=on"))
 			{
 				config.enableSSE = true;
@@ -650,10 +698,21 @@ namespace sw
 					config.enableSSE4_1 = true;
 				}
 			}
+			else if(strstr(post, "enableAVX=on"))
+			{
+				if(config.enableSSE4_1)
+				{
+					config.enableAVX = true;
+				}
+			}
 			else if(sscanf(post, "optimization%d=%d", &index, &integer))
 			{
 				config.optimization[index - 1] = (Optimization)integer;
 			}
+			else if(strstr(post, "shaderOptimization=on"))
+			{
+				config.shaderOptimization = true;
+			}
 			else if(strstr(post, "disableServer=on"))
 			{
 				config.disableServer = true;
@@ -686,6 +745,18 @@ namespace sw
 			{
 				config.precache = true;
 			}
+			else if(strstr(post, "vertexDeduplication=on"))
+			{
+				config.vertexDeduplication = true;
+			}
+			else if(strstr(post, "textureTiling=on"))
+			{
+				config.textureTiling = true;
+			}
+			else if(strstr(post, "asynchronousCompilation=on"))
+			{
+				config.asynchronousCompilation = true;
+			}
 			else if(strstr(post, "forceClearRegisters=on"))
 			{
 				config.forceClearRegisters = true;
@@ -725,23 +796,32 @@ namespace sw
 		config.pixelRoutineCacheSize = ini.getInteger("Caches", "PixelRoutineCacheSize", 1024);
 		config.setupRoutineCacheSize = ini.getInteger("Caches", "SetupRoutineCacheSize", 1024);
 		config.vertexCacheSize = ini.getInteger("Caches", "VertexCacheSize", 64);
+		config.vertexCacheAssociativity = ini.getInteger("Caches", "VertexCacheAssociativity", 1);
+		config.vertexDeduplication = ini.getBoolean("Caches", "VertexDeduplication", true);
+		config.textureTiling = ini.getBoolean("Caches", "TextureTiling", false);
+		config.asynchronousCompilation = ini.getBoolean("Caches", "AsynchronousCompilation", false);
 		config.textureSampleQuality = ini.getInteger("Quality", "TextureSampleQuality", 2);
 		config.mipmapQuality = ini.getInteger("Quality", "MipmapQuality", 1);
 		config.perspectiveCorrection = ini.getBoolean("Quality", "PerspectiveCorrection", true);
 		config.transcendentalPrecision = ini.getInteger("Quality", "TranscendentalPrecision", 2);
 		config.transparencyAntialiasing = ini.getInteger("Quality", "TransparencyAntialiasing", 0);
 		config.threadCount = ini.getInteger("Processor", "ThreadCount", DEFAULT_THREAD_COUNT);
+		config.binHeight = ini.getInteger("Processor", "BinHeight", 0);
+		config.hierarchicalZ = ini.getBoolean("Processor", "HierarchicalZ", true);
 		config.enableSSE = ini.getBoolean("Processor", "EnableSSE", true);
 		config.enableSSE2 = ini.getBoolean("Processor", "EnableSSE2", true);
 		config.enableSSE3 = ini.getBoolean("Processor", "EnableSSE3", true);
 		config.enableSSSE3 = ini.getBoolean("Processor", "EnableSSSE3", true);
 		config.enableSSE4_1 = ini.getBoolean("Processor", "EnableSSE4_1", true);
+		config.enableAVX = ini.getBoolean("Processor", "EnableAVX", true);
 
 		for(int pass = 0; pass < 10; pass++)
 		{
 			config.optimization[pass] = (Optimization)ini.getInteger("Optimization", "OptimizationPass" + itoa(pass + 1), pass == 0 ? InstructionCombining : Disabled);
 		}
 
+		config.shaderOptimization = ini.getBoolean("Optimization", "ShaderOptimization", true);
+
 		config.disableServer = ini.getBoolean("Testing", "DisableServer", false);
 		config.forceWindowed = ini.getBoolean("Testing", "ForceWindowed", false);
 		config.complementaryDepthBuffer = ini.getBoolean("Testing", "ComplementaryDepthBuffer", false);
@@ -783,23 +863,32 @@ namespace sw
 		ini.addValue("Caches", "PixelRoutineCacheSize", itoa(config.pixelRoutineCacheSize));
 		ini.addValue("Caches", "SetupRoutineCacheSize", itoa(config.setupRoutineCacheSize));
 		ini.addValue("Caches", "VertexCacheSize", itoa(config.vertexCacheSize));
+		ini.addValue("Caches", "VertexCacheAssociativity", itoa(config.vertexCacheAssociativity));
+		ini.addValue("Caches", "VertexDeduplication", itoa(config.vertexDeduplication));
+		ini.addValue("Caches", "TextureTiling", itoa(config.textureTiling));
+		ini.addValue("Caches", "AsynchronousCompilation", itoa(config.asynchronousCompilation));
 		ini.addValue("Quality", "TextureSampleQuality", itoa(config.textureSampleQuality));
 		ini.addValue("Quality", "MipmapQuality", itoa(config.mipmapQuality));
 		ini.addValue("Quality", "PerspectiveCorrection", itoa(config.perspectiveCorrection));
 		ini.addValue("Quality", "TranscendentalPrecision", itoa(config.transcendentalPrecision));
 		ini.addValue("Quality", "TransparencyAntialiasing", itoa(config.transparencyAntialiasing));
 		ini.addValue("Processor", "ThreadCount", itoa(config.threadCount));
+		ini.addValue("Processor", "BinHeight", itoa(config.binHeight));
+		ini.addValue("Processor", "HierarchicalZ", itoa(config.hierarchicalZ));
 	//	ini.addValue("Processor", "EnableSSE", itoa(config.enableSSE));
 		ini.addValue("Processor", "EnableSSE2", itoa(config.enableSSE2));
 		ini.addValue("Processor", "EnableSSE3", itoa(config.enableSSE3));
 		ini.addValue("Processor", "EnableSSSE3", itoa(config.enableSSSE3));
 		ini.addValue("Processor", "EnableSSE4_1", itoa(config.enableSSE4_1));
+		ini.addValue("Processor", "EnableAVX", itoa(config.enableAVX));
 
 		for(int pass = 0; pass < 10; pass++)
 		{
 			ini.addValue("Optimization", "OptimizationPass" + itoa(pass + 1), itoa(config.optimization[pass]));
 		}
 
+		ini.addValue("Optimization", "ShaderOptimization", itoa(config.shaderOptimization));
+
 		ini.addValue("Testing", "DisableServer", itoa(config.disableServer));
 		ini.addValue("Testing", "ForceWindowed", itoa(config.forceWindowed));
 		ini.addValue("Testing", "ComplementaryDepthBuffer", itoa(config.complementaryDepthBuffer));
@@ -38,17 +38,25 @@ namespace sw
 			int pixelRoutineCacheSize;
 			int setupRoutineCacheSize;
 			int vertexCacheSize;
+			int vertexCacheAssociativity;
+			bool vertexDeduplication;
+			bool textureTiling;
+			bool asynchronousCompilation;
 			int textureSampleQuality;
 			int mipmapQuality;
 			bool perspectiveCorrection;
 			int transcendentalPrecision;
 			int threadCount;
+			int binHeight;
+			bool hierarchicalZ;
 			bool enableSSE;
 			bool enableSSE2;
 			bool enableSSE3;
 			bool enableSSSE3;
 			bool enableSSE4_1;
+			bool enableAVX;
 			Optimization optimization[10];
+			bool shaderOptimization;
 			bool disableServer;
 			bool keepSystemCursor;
 			bool forceWindowed;
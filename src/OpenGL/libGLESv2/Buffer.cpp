@@ -22,6 +22,11 @@
 #include "VertexDataManager.h"
 #include "IndexDataManager.h"
 
+namespace
+{
+	enum { MAX_INDEX_RANGES = 1024 };   // Per buffer, to bound the cost of data which keeps being drawn at new offsets
+}
+
 namespace es2
 {
 
@@ -34,6 +39,7 @@ Buffer::Buffer(GLuint name) : NamedObject(name)
 	mOffset = 0;
 	mLength = 0;
 	mAccess = 0;
+	mRendererWrites = false;
 }
 
 Buffer::~Buffer()
@@ -54,6 +60,8 @@ void Buffer::bufferData(const void *data, GLsizeiptr size, GLenum usage)
 
 	mSize = size;
 	mUsage = usage;
+	mIndexRanges.clear();
+	mRendererWrites = false;
 
 	if(size > 0)
 	{
@@ -77,6 +85,8 @@ void Buffer::bufferSubData(const void *data, GLsizeiptr size, GLintptr offset)
 {
 	if(mContents && data)
 	{
+		mIndexRanges.clear();
+
 		char *buffer = (char*)mContents->lock(sw::PUBLIC);
 		memcpy(buffer + offset, data, size);
 		mContents->unlock();
@@ -87,6 +97,8 @@ void* Buffer::mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
 {
 	if(mContents)
 	{
+		mIndexRanges.clear();   // The application can write to it until unmapped
+
 		char* buffer = (char*)mContents->lock(sw::PUBLIC);
 		mIsMapped = true;
 		mOffset = offset;
@@ -115,4 +127,44 @@ sw::Resource *Buffer::getResource()
 	return mContents;
 }
 
+bool Buffer::getIndexRange(GLenum type, GLintptr offset, GLsizei count, GLuint *minIndex, GLuint *maxIndex) const
+{
+	IndexRangeKey key = {type, offset, count};
+	auto range = mIndexRanges.find(key);
+
+	if(range == mIndexRanges.end())
+	{
+		return false;
+	}
+
+	*minIndex = range->second.minIndex;
+	*maxIndex = range->second.maxIndex;
+
+	return true;
+}
+
+void Buffer::addIndexRange(GLenum type, GLintptr offset, GLsizei count, GLuint minIndex, GLuint maxIndex)
+{
+	if(mRendererWrites)
+	{
+		return;
+	}
+
+	if(mIndexRanges.size() >= MAX_INDEX_RANGES)
+	{
+		mIndexRanges.clear();
+	}
+
+	IndexRangeKey key = {type, offset, count};
+	IndexRange range = {minIndex, maxIndex};
+
+	mIndexRanges[key] = range;
+}
+
+void Buffer::markRendererWrite()
+{
+	mIndexRanges.clear();
+	mRendererWrites = true;
+}
+
 }
@@ -25,6 +25,7 @@
 #include <GLES2/gl2.h>
 
 #include <cstddef>
+#include <map>
 #include <vector>
 
 namespace es2
@@ -53,7 +54,31 @@ public:
 
 	sw::Resource *getResource();
 
+	// Minimum and maximum of previously scanned ranges of indices, until the contents change
+	bool getIndexRange(GLenum type, GLintptr offset, GLsizei count, GLuint *minIndex, GLuint *maxIndex) const;
+	void addIndexRange(GLenum type, GLintptr offset, GLsizei count, GLuint minIndex, GLuint maxIndex);
+	void invalidateIndexRanges() { mIndexRanges.clear(); }
+	void markRendererWrite();   // Ranges aren't cached any more, since the renderer writes asynchronously
+
 private:
+	struct IndexRangeKey
+	{
+		bool operator<(const IndexRangeKey &other) const
+		{
+			return offset != other.offset ? offset < other.offset : (count != other.count ? count < other.count : type < other.type);
+		}
+
+		GLenum type;
+		GLintptr offset;
+		GLsizei count;
+	};
+
+	struct IndexRange
+	{
+		GLuint minIndex;
+		GLuint maxIndex;
+	};
+
 	sw::Resource *mContents;
 	size_t mSize;
 	GLenum mUsage;
@@ -61,6 +86,9 @@ private:
 	GLintptr mOffset;
 	GLsizeiptr mLength;
 	GLbitfield mAccess;
+
+	std::map<IndexRangeKey, IndexRange> mIndexRanges;
+	bool mRendererWrites;
 };
 
 class BufferBinding
@@ -41,6 +41,7 @@
 #include <EGL/eglext.h>
 
 #include <algorithm>
+#include <climits>
 #include <string>
 
 namespace es2
@@ -3023,11 +3024,11 @@ void Context::applyState(GLenum drawMode)
 	device->setRasterizerDiscard(mState.rasterizerDiscardEnabled);
 }
 
-GLenum Context::applyVertexBuffer(GLint base, GLint first, GLsizei count, GLsizei instanceId)
+GLenum Context::applyVertexBuffer(GLint base, GLint first, GLsizei count, GLsizei instanceCount)
 {
 	TranslatedAttribute attributes[MAX_VERTEX_ATTRIBS];
 
-	GLenum err = mVertexDataManager->prepareVertexData(first, count, attributes, instanceId);
+	GLenum err = mVertexDataManager->prepareVertexData(first, count, attributes, instanceCount);
 	if(err != GL_NO_ERROR)
 	{
 		return err;
@@ -3049,13 +3050,17 @@ GLenum Context::applyVertexBuffer(GLint base, GLint first, GLsizei count, GLsize
 
 		int stride = attributes[i].stride;
 
-		buffer = (char*)buffer + stride * base;
+		if(!attributes[i].divisor)   // Instanced attributes aren't indexed by vertex
+		{
+			buffer = (char*)buffer + stride * base;
+		}
 
 		sw::Stream attribute(resource, buffer, stride);
 
 		attribute.type = attributes[i].type;
 		attribute.count = attributes[i].count;
 		attribute.normalized = attributes[i].normalized;
+		attribute.divisor = attributes[i].divisor;
 
 		int stream = program->getAttributeStream(i);
 		device->setInputStream(stream, attribute);
@@ -3176,21 +3181,21 @@ void Context::applyTextures(sw::SamplerType samplerType)
 				device->setMaxAnisotropy(samplerType, samplerIndex, maxAnisotropy);
 				device->setHighPrecisionFiltering(samplerType, samplerIndex, mState.textureFilteringHint == GL_NICEST);
 
-				applyTexture(samplerType, samplerIndex, texture);
+				applyTexture(samplerType, samplerIndex, texture, es2sw::ConvertMipMapFilter(minFilter) != sw::MIPMAP_NONE);
 			}
 			else
 			{
-				applyTexture(samplerType, samplerIndex, nullptr);
+				applyTexture(samplerType, samplerIndex, nullptr, false);
 			}
 		}
 		else
 		{
-			applyTexture(samplerType, samplerIndex, nullptr);
+			applyTexture(samplerType, samplerIndex, nullptr, false);
 		}
 	}
 }
 
-void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture)
+void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture, bool mipmapped)
 {
 	Program *program = getCurrentProgram();
 	int sampler = (type == sw::SAMPLER_PIXEL) ? index : 16 + index;
@@ -3221,6 +3226,8 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 		int maxLevel = std::min(baseTexture->getTopLevel(), baseTexture->getMaxLevel());
 		GLenum target = baseTexture->getTarget();
 
+		// Without mipmapping, only the dimensions of the levels above the base are used,
+		// so they don't get decoded until they're sampled.
 		switch(target)
 		{
 		case GL_TEXTURE_2D:
@@ -3240,7 +3247,7 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 
 					egl::Image *surface = texture->getImage(surfaceLevel);
 					device->setTextureLevel(sampler, 0, mipmapLevel, surface,
-					                        (target == GL_TEXTURE_RECTANGLE_ARB) ? sw::TEXTURE_RECTANGLE : sw::TEXTURE_2D);
+					                        (target == GL_TEXTURE_RECTANGLE_ARB) ? sw::TEXTURE_RECTANGLE : sw::TEXTURE_2D, mipmapped || mipmapLevel == 0);
 				}
 			}
 			break;
@@ -3258,7 +3265,7 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 					}
 
 					egl::Image *surface = texture->getImage(surfaceLevel);
-					device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_3D);
+					device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_3D, mipmapped || mipmapLevel == 0);
 				}
 			}
 			break;
@@ -3276,7 +3283,7 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 					}
 
 					egl::Image *surface = texture->getImage(surfaceLevel);
-					device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_2D_ARRAY);
+					device->setTextureLevel(sampler, 0, mipmapLevel, surface, sw::TEXTURE_2D_ARRAY, mipmapped || mipmapLevel == 0);
 				}
 			}
 			break;
@@ -3286,7 +3293,12 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 
 				for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
 				{
-					cubeTexture->updateBorders(mipmapLevel);
+					bool sampled = mipmapped || mipmapLevel == 0;
+
+					if(sampled)
+					{
+						cubeTexture->updateBorders(mipmapLevel);
+					}
 
 					for(int face = 0; face < 6; face++)
 					{
@@ -3298,7 +3310,7 @@ void Context::applyTexture(sw::SamplerType type, int index, Texture *baseTexture
 						}
 
 						egl::Image *surface = cubeTexture->getImage(face, surfaceLevel);
-						device->setTextureLevel(sampler, face, mipmapLevel, surface, sw::TEXTURE_CUBE);
+						device->setTextureLevel(sampler, face, mipmapLevel, surface, sw::TEXTURE_CUBE, sampled);
 					}
 				}
 			}
@@ -3337,6 +3349,11 @@ void Context::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum
 	GLsizei outputWidth = (mState.packParameters.rowLength > 0) ? mState.packParameters.rowLength : width;
 	GLsizei outputPitch = gl::ComputePitch(outputWidth, format, type, mState.packParameters.alignment);
 	GLsizei outputHeight = (mState.packParameters.imageHeight == 0) ? height : mState.packParameters.imageHeight;
+	if(getPixelPackBuffer())
+	{
+		getPixelPackBuffer()->invalidateIndexRanges();
+	}
+
 	pixels = getPixelPackBuffer() ? (unsigned char*)getPixelPackBuffer()->data() + (ptrdiff_t)pixels : (unsigned char*)pixels;
 	pixels = ((char*)pixels) + gl::ComputePackingOffset(format, type, outputWidth, outputHeight, mState.packParameters);
 
@@ -3549,38 +3566,46 @@ void Context::drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instan
 
 	applyState(mode);
 
-	for(int i = 0; i < instanceCount; ++i)
+	if(instanceCount <= 0)
 	{
-		device->setInstanceID(i);
+		return;
+	}
 
-		GLenum err = applyVertexBuffer(0, first, count, i);
-		if(err != GL_NO_ERROR)
-		{
-			return error(err);
-		}
+	if(primitiveCount > INT_MAX / instanceCount)
+	{
+		return error(GL_OUT_OF_MEMORY);
+	}
 
-		applyShaders();
-		applyTextures();
+	// All instances are rendered by a single draw call
+	device->setInstanceCount(instanceCount);
 
-		if(!getCurrentProgram()->validateSamplers(false))
-		{
-			return error(GL_INVALID_OPERATION);
-		}
+	GLenum err = applyVertexBuffer(0, first, count, instanceCount);
+	if(err != GL_NO_ERROR)
+	{
+		return error(err);
+	}
 
-		if(primitiveCount <= 0)
-		{
-			return;
-		}
+	applyShaders();
+	applyTextures();
 
-		TransformFeedback* transformFeedback = getTransformFeedback();
-		if(!cullSkipsDraw(mode) || (transformFeedback->isActive() && !transformFeedback->isPaused()))
-		{
-			device->drawPrimitive(primitiveType, primitiveCount);
-		}
-		if(transformFeedback)
-		{
-			transformFeedback->addVertexOffset(primitiveCount * verticesPerPrimitive);
-		}
+	if(!getCurrentProgram()->validateSamplers(false))
+	{
+		return error(GL_INVALID_OPERATION);
+	}
+
+	if(primitiveCount <= 0)
+	{
+		return;
+	}
+
+	TransformFeedback* transformFeedback = getTransformFeedback();
+	if(!cullSkipsDraw(mode) || (transformFeedback->isActive() && !transformFeedback->isPaused()))
+	{
+		device->drawPrimitive(primitiveType, primitiveCount);
+	}
+	if(transformFeedback)
+	{
+		transformFeedback->addVertexOffset(primitiveCount * verticesPerPrimitive * instanceCount);
 	}
 }
 
@@ -3637,39 +3662,47 @@ void Context::drawElements(GLenum mode, GLuint start, GLuint end, GLsizei count,
 
 	applyState(internalMode);
 
-	for(int i = 0; i < instanceCount; ++i)
+	if(instanceCount <= 0)
 	{
-		device->setInstanceID(i);
+		return;
+	}
 
-		GLsizei vertexCount = indexInfo.maxIndex - indexInfo.minIndex + 1;
-		err = applyVertexBuffer(-(int)indexInfo.minIndex, indexInfo.minIndex, vertexCount, i);
-		if(err != GL_NO_ERROR)
-		{
-			return error(err);
-		}
+	if(indexInfo.primitiveCount > static_cast<unsigned int>(INT_MAX / instanceCount))
+	{
+		return error(GL_OUT_OF_MEMORY);
+	}
 
-		applyShaders();
-		applyTextures();
+	// All instances are rendered by a single draw call
+	device->setInstanceCount(instanceCount);
 
-		if(!getCurrentProgram()->validateSamplers(false))
-		{
-			return error(GL_INVALID_OPERATION);
-		}
+	GLsizei vertexCount = indexInfo.maxIndex - indexInfo.minIndex + 1;
+	err = applyVertexBuffer(-(int)indexInfo.minIndex, indexInfo.minIndex, vertexCount, instanceCount);
+	if(err != GL_NO_ERROR)
+	{
+		return error(err);
+	}
 
-		if(primitiveCount <= 0)
-		{
-			return;
-		}
+	applyShaders();
+	applyTextures();
 
-		TransformFeedback* transformFeedback = getTransformFeedback();
-		if(!cullSkipsDraw(internalMode) || (transformFeedback->isActive() && !transformFeedback->isPaused()))
-		{
-			device->drawIndexedPrimitive(primitiveType, indexInfo.indexOffset, indexInfo.primitiveCount);
-		}
-		if(transformFeedback)
-		{
-			transformFeedback->addVertexOffset(indexInfo.primitiveCount * verticesPerPrimitive);
-		}
+	if(!getCurrentProgram()->validateSamplers(false))
+	{
+		return error(GL_INVALID_OPERATION);
+	}
+
+	if(primitiveCount <= 0)
+	{
+		return;
+	}
+
+	TransformFeedback* transformFeedback = getTransformFeedback();
+	if(!cullSkipsDraw(internalMode) || (transformFeedback->isActive() && !transformFeedback->isPaused()))
+	{
+		device->drawIndexedPrimitive(primitiveType, indexInfo.indexOffset, indexInfo.primitiveCount);
+	}
+	if(transformFeedback)
+	{
+		transformFeedback->addVertexOffset(indexInfo.primitiveCount * verticesPerPrimitive * instanceCount);
 	}
 }
 
@@ -706,12 +706,12 @@ private:
 	void applyScissor(int width, int height);
 	bool applyRenderTarget();
 	void applyState(GLenum drawMode);
-	GLenum applyVertexBuffer(GLint base, GLint first, GLsizei count, GLsizei instanceId);
+	GLenum applyVertexBuffer(GLint base, GLint first, GLsizei count, GLsizei instanceCount);
 	GLenum applyIndexBuffer(const void *indices, GLuint start, GLuint end, GLsizei count, GLenum mode, GLenum type, TranslatedIndexData *indexInfo);
 	void applyShaders();
 	void applyTextures();
 	void applyTextures(sw::SamplerType type);
-	void applyTexture(sw::SamplerType type, int sampler, Texture *texture);
+	void applyTexture(sw::SamplerType type, int sampler, Texture *texture, bool mipmapped);
 	void clearColorBuffer(GLint drawbuffer, void *value, sw::Format format);
 
 	void detachBuffer(GLuint buffer);
@@ -18,6 +18,7 @@
 #include "IndexDataManager.h"
 
 #include "Buffer.h"
+#include "IndexRange.h"
 #include "common/debug.h"
 
 #include <string.h>
@@ -192,26 +193,11 @@ void copyIndices(GLenum mode, GLenum type, const std::vector<GLsizei>& restartIn
 	}
 }
 
-template<class IndexType>
-void computeRange(const IndexType *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex, std::vector<GLsizei>* restartIndices)
+void computeRange(GLenum type, const void *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex, std::vector<GLsizei>* restartIndices)
 {
 	*maxIndex = 0;
 	*minIndex = MAX_ELEMENTS_INDICES;
 
-	for(GLsizei i = 0; i < count; i++)
-	{
-		if(restartIndices && indices[i] == IndexType(-1))
-		{
-			restartIndices->push_back(i);
-			continue;
-		}
-		if(*minIndex > indices[i]) *minIndex = indices[i];
-		if(*maxIndex < indices[i]) *maxIndex = indices[i];
-	}
-}
-
-void computeRange(GLenum type, const void *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex, std::vector<GLsizei>* restartIndices)
-{
 	if(type == GL_UNSIGNED_BYTE)
 	{
 		computeRange(static_cast<const GLubyte*>(indices), count, minIndex, maxIndex, restartIndices);
@@ -290,7 +276,19 @@ GLenum IndexDataManager::prepareIndexData(GLenum mode, GLenum type, GLuint start
 	}
 
 	std::vector<GLsizei>* restartIndices = primitiveRestart ? new std::vector<GLsizei>() : nullptr;
-	computeRange(type, indices, count, &translated->minIndex, &translated->maxIndex, restartIndices);
+
+	// The positions of restart indices aren't cached, so those ranges are always scanned
+	bool cachedRange = buffer && !restartIndices && buffer->getIndexRange(type, offset, count, &translated->minIndex, &translated->maxIndex);
+
+	if(!cachedRange)
+	{
+		computeRange(type, indices, count, &translated->minIndex, &translated->maxIndex, restartIndices);
+
+		if(buffer && !restartIndices)
+		{
+			buffer->addIndexRange(type, offset, count, translated->minIndex, translated->maxIndex);
+		}
+	}
 
 	StreamingIndexBuffer *streamingBuffer = mStreamingBuffer;
 
@@ -0,0 +1,155 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// IndexRange.h: Defines the scans which find the range of the
+// vertices referenced by index buffers.
+
+#ifndef LIBGLESV2_INDEXRANGE_H_
+#define LIBGLESV2_INDEXRANGE_H_
+
+#include "Common/CPUID.hpp"
+
+#include <GLES2/gl2.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__i386__) || defined(__x86_64__)
+	#include <emmintrin.h>
+#endif
+
+namespace es2
+{
+
+#if defined(__i386__) || defined(__x86_64__)
+// Scans the bulk of the indices 16 bytes at a time, and returns how many were processed.
+// SSE2 only has unsigned minimum and maximum for bytes, so wider indices get biased to signed.
+inline GLsizei computeRangeSSE2(const GLubyte *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex)
+{
+	__m128i minimum = _mm_set1_epi8(-1);
+	__m128i maximum = _mm_setzero_si128();
+
+	GLsizei i = 0;
+
+	for(; i + 16 <= count; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(indices + i));
+		minimum = _mm_min_epu8(minimum, x);
+		maximum = _mm_max_epu8(maximum, x);
+	}
+
+	GLubyte minimums[16];
+	GLubyte maximums[16];
+	_mm_storeu_si128((__m128i*)minimums, minimum);
+	_mm_storeu_si128((__m128i*)maximums, maximum);
+
+	for(int j = 0; j < 16 && i > 0; j++)
+	{
+		*minIndex = std::min(*minIndex, (GLuint)minimums[j]);
+		*maxIndex = std::max(*maxIndex, (GLuint)maximums[j]);
+	}
+
+	return i;
+}
+
+inline GLsizei computeRangeSSE2(const GLushort *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex)
+{
+	const __m128i bias = _mm_set1_epi16(-0x8000);
+	__m128i minimum = _mm_set1_epi16(0x7FFF);
+	__m128i maximum = _mm_set1_epi16(-0x8000);
+
+	GLsizei i = 0;
+
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(indices + i)), bias);
+		minimum = _mm_min_epi16(minimum, x);
+		maximum = _mm_max_epi16(maximum, x);
+	}
+
+	GLushort minimums[8];
+	GLushort maximums[8];
+	_mm_storeu_si128((__m128i*)minimums, _mm_xor_si128(minimum, bias));
+	_mm_storeu_si128((__m128i*)maximums, _mm_xor_si128(maximum, bias));
+
+	for(int j = 0; j < 8 && i > 0; j++)
+	{
+		*minIndex = std::min(*minIndex, (GLuint)minimums[j]);
+		*maxIndex = std::max(*maxIndex, (GLuint)maximums[j]);
+	}
+
+	return i;
+}
+
+inline GLsizei computeRangeSSE2(const GLuint *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex)
+{
+	const __m128i bias = _mm_set1_epi32(0x80000000);
+	__m128i minimum = _mm_set1_epi32(0x7FFFFFFF);
+	__m128i maximum = _mm_set1_epi32(0x80000000);
+
+	GLsizei i = 0;
+
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(indices + i)), bias);
+		__m128i less = _mm_cmplt_epi32(x, minimum);
+		__m128i greater = _mm_cmpgt_epi32(x, maximum);
+		minimum = _mm_or_si128(_mm_and_si128(less, x), _mm_andnot_si128(less, minimum));
+		maximum = _mm_or_si128(_mm_and_si128(greater, x), _mm_andnot_si128(greater, maximum));
+	}
+
+	GLuint minimums[4];
+	GLuint maximums[4];
+	_mm_storeu_si128((__m128i*)minimums, _mm_xor_si128(minimum, bias));
+	_mm_storeu_si128((__m128i*)maximums, _mm_xor_si128(maximum, bias));
+
+	for(int j = 0; j < 4 && i > 0; j++)
+	{
+		*minIndex = std::min(*minIndex, minimums[j]);
+		*maxIndex = std::max(*maxIndex, maximums[j]);
+	}
+
+	return i;
+}
+#endif
+
+// Widens [*minIndex, *maxIndex] to include the indices. When restartIndices is provided,
+// the primitive restart indices are left out of the range and their positions get recorded.
+template<class IndexType>
+void computeRange(const IndexType *indices, GLsizei count, GLuint *minIndex, GLuint *maxIndex, std::vector<GLsizei>* restartIndices)
+{
+	GLsizei i = 0;
+
+	#if defined(__i386__) || defined(__x86_64__)
+		if(!restartIndices && sw::CPUID::supportsSSE2())   // Restart indices have to be located one by one
+		{
+			i = computeRangeSSE2(indices, count, minIndex, maxIndex);
+		}
+	#endif
+
+	for(; i < count; i++)
+	{
+		if(restartIndices && indices[i] == IndexType(-1))
+		{
+			restartIndices->push_back(i);
+			continue;
+		}
+		if(*minIndex > indices[i]) *minIndex = indices[i];
+		if(*maxIndex < indices[i]) *maxIndex = indices[i];
+	}
+}
+
+}
+
+#endif   // LIBGLESV2_INDEXRANGE_H_
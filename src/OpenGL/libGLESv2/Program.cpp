@@ -1272,6 +1272,7 @@ namespace es2
 				int nbComponentsPerReg = rowCount > 1 ? rowCount : colCount;
 				int componentStride = rowCount * colCount * size;
 				int baseOffset = transformFeedback->vertexOffset() * componentStride * sizeof(float);
+				transformFeedbackBuffers[index].get()->markRendererWrite();
 				device->VertexProcessor::setTransformFeedbackBuffer(index,
 					transformFeedbackBuffers[index].get()->getResource(),
 					transformFeedbackBuffers[index].getOffset() + baseOffset,
@@ -1287,6 +1288,7 @@ namespace es2
 			// In INTERLEAVED_ATTRIBS mode, the values of one or more output variables
 			// written by a vertex shader are written, interleaved, into the buffer object
 			// bound to the first transform feedback binding point (index = 0).
+			transformFeedbackBuffers[0].get()->markRendererWrite();
 			sw::Resource* resource = transformFeedbackBuffers[0].get()->getResource();
 			int componentStride = static_cast<int>(totalLinkedVaryingsComponents);
 			int baseOffset = transformFeedbackBuffers[0].getOffset() + (transformFeedback->vertexOffset() * componentStride * sizeof(float));
@@ -1573,6 +1575,9 @@ namespace es2
 			return;
 		}
 
+		// Don't compute vertex outputs which aren't interpolated or captured
+		vertexBinary->removeUnusedOutputs();
+
 		if(!linkAttributes())
 		{
 			return;
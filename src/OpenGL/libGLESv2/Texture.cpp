@@ -789,7 +789,9 @@ void Texture2D::generateMipmaps()
 			return error(GL_OUT_OF_MEMORY);
 		}
 
-		getDevice()->stretchRect(image[i - 1], 0, image[i], 0, Device::ALL_BUFFERS | Device::USE_FILTER);
+		sw::Surface *source = image[i - 1];
+		sw::Surface *dest = image[i];
+		getDevice()->downsample(&source, &dest, 1, false);
 	}
 }
 
@@ -1326,12 +1328,16 @@ void TextureCubeMap::generateMipmaps()
 	int p = log2(image[0][mBaseLevel]->getWidth()) + mBaseLevel;
 	int q = std::min(p, mMaxLevel);
 
-	for(int f = 0; f < 6; f++)
+	// The faces of each level are filtered together
+	for(int i = mBaseLevel + 1; i <= q; i++)
 	{
-		ASSERT(image[f][mBaseLevel]);
+		sw::Surface *source[6];
+		sw::Surface *dest[6];
 
-		for(int i = mBaseLevel + 1; i <= q; i++)
+		for(int f = 0; f < 6; f++)
 		{
+			ASSERT(image[f][mBaseLevel]);
+
 			if(image[f][i])
 			{
 				image[f][i]->release();
@@ -1345,8 +1351,11 @@ void TextureCubeMap::generateMipmaps()
 				return error(GL_OUT_OF_MEMORY);
 			}
 
-			getDevice()->stretchRect(image[f][i - 1], 0, image[f][i], 0, Device::ALL_BUFFERS | Device::USE_FILTER);
+			source[f] = image[f][i - 1];
+			dest[f] = image[f][i];
 		}
+
+		getDevice()->downsample(source, dest, 6, false);
 	}
 }
 
@@ -1759,7 +1768,9 @@ void Texture3D::generateMipmaps()
 			return error(GL_OUT_OF_MEMORY);
 		}
 
-		getDevice()->stretchCube(image[i - 1], image[i]);
+		sw::Surface *source = image[i - 1];
+		sw::Surface *dest = image[i];
+		getDevice()->downsample(&source, &dest, 1, true);
 	}
 }
 
@@ -1856,14 +1867,9 @@ void Texture2DArray::generateMipmaps()
 			return error(GL_OUT_OF_MEMORY);
 		}
 
-		GLsizei srcw = image[i - 1]->getWidth();
-		GLsizei srch = image[i - 1]->getHeight();
-		for(int z = 0; z < depth; ++z)
-		{
-			sw::SliceRectF srcRect(0.0f, 0.0f, static_cast<float>(srcw), static_cast<float>(srch), z);
-			sw::SliceRect dstRect(0, 0, w, h, z);
-			getDevice()->stretchRect(image[i - 1], &srcRect, image[i], &dstRect, Device::ALL_BUFFERS | Device::USE_FILTER);
-		}
+		sw::Surface *source = image[i - 1];
+		sw::Surface *dest = image[i];
+		getDevice()->downsample(&source, &dest, 1, false);   // Layers are filtered independently
 	}
 }
 
@@ -25,6 +25,12 @@
 namespace
 {
 	enum {INITIAL_STREAM_BUFFER_SIZE = 1024 * 1024};
+
+	// Number of elements read by all instances of an instanced attribute
+	GLsizei instanceElements(GLsizei instanceCount, GLuint divisor)
+	{
+		return (instanceCount + divisor - 1) / divisor;
+	}
 }
 
 namespace es2
@@ -109,7 +115,7 @@ unsigned int VertexDataManager::writeAttributeData(StreamingVertexBuffer *vertex
 	return streamOffset;
 }
 
-GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *translated, GLsizei instanceId)
+GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *translated, GLsizei instanceCount)
 {
 	if(!mStreamingBuffer)
 	{
@@ -130,7 +136,7 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 			if(!attrib.mBoundBuffer)
 			{
 				const bool isInstanced = attrib.mDivisor > 0;
-				mStreamingBuffer->addRequiredSpace(attrib.typeSize() * (isInstanced ? 1 : count));
+				mStreamingBuffer->addRequiredSpace(attrib.typeSize() * (isInstanced ? instanceElements(instanceCount, attrib.mDivisor) : count));
 			}
 		}
 	}
@@ -148,8 +154,10 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 			{
 				const bool isInstanced = attrib.mDivisor > 0;
 
-				// Instanced vertices do not apply the 'start' offset
-				GLint firstVertexIndex = isInstanced ? instanceId / attrib.mDivisor : start;
+				// Instanced vertices do not apply the 'start' offset. The renderer advances
+				// them per instance, so the elements of all instances are made available.
+				GLint firstVertexIndex = isInstanced ? 0 : start;
+				GLsizei elementCount = isInstanced ? instanceElements(instanceCount, attrib.mDivisor) : count;
 
 				Buffer *buffer = attrib.mBoundBuffer;
 
@@ -166,11 +174,11 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 				{
 					translated[i].vertexBuffer = staticBuffer;
 					translated[i].offset = firstVertexIndex * attrib.stride() + static_cast<int>(attrib.mOffset);
-					translated[i].stride = isInstanced ? 0 : attrib.stride();
+					translated[i].stride = attrib.stride();
 				}
 				else
 				{
-					unsigned int streamOffset = writeAttributeData(mStreamingBuffer, firstVertexIndex, isInstanced ? 1 : count, attrib);
+					unsigned int streamOffset = writeAttributeData(mStreamingBuffer, firstVertexIndex, elementCount, attrib);
 
 					if(streamOffset == ~0u)
 					{
@@ -179,9 +187,11 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 
 					translated[i].vertexBuffer = mStreamingBuffer->getResource();
 					translated[i].offset = streamOffset;
-					translated[i].stride = isInstanced ? 0 : attrib.typeSize();
+					translated[i].stride = attrib.typeSize();
 				}
 
+				translated[i].divisor = attrib.mDivisor;
+
 				switch(attrib.mType)
 				{
 				case GL_BYTE:           translated[i].type = sw::STREAMTYPE_SBYTE;  break;
@@ -227,6 +237,7 @@ GLenum VertexDataManager::prepareVertexData(GLint start, GLsizei count, Translat
 				}
 				translated[i].count = 4;
 				translated[i].stride = 0;
+				translated[i].divisor = 0;
 				translated[i].offset = 0;
 				translated[i].normalized = false;
 			}
@@ -34,6 +34,7 @@ struct TranslatedAttribute
 
 	unsigned int offset;
 	unsigned int stride;   // 0 means not to advance the read pointer at all
+	unsigned int divisor;  // Advance once per this many instances instead of per vertex, if non-zero
 
 	sw::Resource *vertexBuffer;
 };
@@ -83,7 +84,7 @@ public:
 
 	void dirtyCurrentValue(int index) { mDirtyCurrentValue[index] = true; }
 
-	GLenum prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *outAttribs, GLsizei instanceId);
+	GLenum prepareVertexData(GLint start, GLsizei count, TranslatedAttribute *outAttribs, GLsizei instanceCount);
 
 private:
 	unsigned int writeAttributeData(StreamingVertexBuffer *vertexBuffer, GLint start, GLsizei count, const VertexAttribute &attribute);
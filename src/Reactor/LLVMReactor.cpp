@@ -27,6 +27,7 @@
 #include "llvm/Target/TargetData.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "../lib/ExecutionEngine/JIT/JIT.h"
 
 #include "LLVMRoutine.hpp"
@@ -35,7 +36,6 @@
 #include "Common/CPUID.hpp"
 #include "Common/Thread.hpp"
 #include "Common/Memory.hpp"
-#include "Common/MutexLock.hpp"
 
 #include <fstream>
 
@@ -64,14 +64,39 @@ namespace llvm
 
 namespace
 {
-	sw::LLVMRoutineManager *routineManager = nullptr;
-	llvm::ExecutionEngine *executionEngine = nullptr;
-	llvm::IRBuilder<> *builder = nullptr;
-	llvm::LLVMContext *context = nullptr;
-	llvm::Module *module = nullptr;
-	llvm::Function *function = nullptr;
-
-	sw::MutexLock codegenMutex;
+	// Each routine is built in its own LLVM context, private to the building thread,
+	// so that routines can be compiled concurrently
+	thread_local sw::LLVMRoutineManager *routineManager = nullptr;
+	thread_local llvm::ExecutionEngine *executionEngine = nullptr;
+	thread_local llvm::IRBuilder<> *builder = nullptr;
+	thread_local llvm::LLVMContext *context = nullptr;
+	thread_local llvm::Module *module = nullptr;
+	thread_local llvm::Function *function = nullptr;
+
+	bool initializeLLVM()
+	{
+		llvm::llvm_start_multithreaded();   // Guards LLVM's global state shared by all contexts
+		llvm::InitializeNativeTarget();
+		llvm::JITEmitDebugInfo = false;
+
+		llvm::UnsafeFPMath = true;
+	//	llvm::NoInfsFPMath = true;
+	//	llvm::NoNaNsFPMath = true;
+
+		#if defined(_WIN32)
+			HMODULE CodeAnalyst = LoadLibrary("CAJitNtfyLib.dll");
+			if(CodeAnalyst)
+			{
+				CodeAnalystInitialize = (bool(*)())GetProcAddress(CodeAnalyst, "CAJIT_Initialize");
+				CodeAnalystCompleteJITLog = (void(*)())GetProcAddress(CodeAnalyst, "CAJIT_CompleteJITLog");
+				CodeAnalystLogJITCode = (bool(*)(const void*, unsigned int, const wchar_t*))GetProcAddress(CodeAnalyst, "CAJIT_LogJITCode");
+
+				CodeAnalystInitialize();
+			}
+		#endif
+
+		return true;
+	}
 }
 
 namespace sw
@@ -181,16 +206,10 @@ namespace sw
 
 	Nucleus::Nucleus()
 	{
-		::codegenMutex.lock();   // Reactor and LLVM are currently not thread safe
-
-		llvm::InitializeNativeTarget();
-		llvm::JITEmitDebugInfo = false;
-
-		if(!::context)
-		{
-			::context = new llvm::LLVMContext();
-		}
+		static bool initialized = initializeLLVM();   // Thread-safe one-time initialization
+		(void)initialized;
 
+		::context = new llvm::LLVMContext();
 		::module = new llvm::Module("", *::context);
 		::routineManager = new LLVMRoutineManager();
 
@@ -208,27 +227,14 @@ namespace sw
 		MAttrs.push_back(CPUID::supportsSSE3()   ? "+sse3"  : "-sse3");
 		MAttrs.push_back(CPUID::supportsSSSE3()  ? "+ssse3" : "-ssse3");
 		MAttrs.push_back(CPUID::supportsSSE4_1() ? "+sse41" : "-sse41");
+		MAttrs.push_back("-avx");    // Incomplete in this LLVM version, which also predates AVX2
+		MAttrs.push_back("-fma3");
 
 		std::string error;
 		llvm::TargetMachine *targetMachine = llvm::EngineBuilder::selectTarget(::module, architecture, "", MAttrs, llvm::Reloc::Default, llvm::CodeModel::JITDefault, &error);
 		::executionEngine = llvm::JIT::createJIT(::module, 0, ::routineManager, llvm::CodeGenOpt::Aggressive, true, targetMachine);
 
-		if(!::builder)
-		{
-			::builder = new llvm::IRBuilder<>(*::context);
-
-			#if defined(_WIN32)
-				HMODULE CodeAnalyst = LoadLibrary("CAJitNtfyLib.dll");
-				if(CodeAnalyst)
-				{
-					CodeAnalystInitialize = (bool(*)())GetProcAddress(CodeAnalyst, "CAJIT_Initialize");
-					CodeAnalystCompleteJITLog = (void(*)())GetProcAddress(CodeAnalyst, "CAJIT_CompleteJITLog");
-					CodeAnalystLogJITCode = (bool(*)(const void*, unsigned int, const wchar_t*))GetProcAddress(CodeAnalyst, "CAJIT_LogJITCode");
-
-					CodeAnalystInitialize();
-				}
-			#endif
-		}
+		::builder = new llvm::IRBuilder<>(*::context);
 	}
 
 	Nucleus::~Nucleus()
@@ -240,7 +246,11 @@ namespace sw
 		::function = nullptr;
 		::module = nullptr;
 
-		::codegenMutex.unlock();
+		delete ::builder;
+		::builder = nullptr;
+
+		delete ::context;
+		::context = nullptr;
 	}
 
 	Routine *Nucleus::acquireRoutine(const wchar_t *name, bool runOptimizations)
@@ -289,42 +299,38 @@ namespace sw
 		return routine;
 	}
 
-	void Nucleus::optimize()
+	Routine *Nucleus::loadRoutine(const void *image, size_t size)
 	{
-		static llvm::PassManager *passManager = nullptr;
-
-		if(!passManager)
-		{
-			passManager = new llvm::PassManager();
+		return nullptr;   // JIT-compiled code contains absolute addresses, so it is never stored
+	}
 
-			llvm::UnsafeFPMath = true;
-		//	llvm::NoInfsFPMath = true;
-		//	llvm::NoNaNsFPMath = true;
+	void Nucleus::optimize()
+	{
+		llvm::PassManager passManager;   // Not shared, as routines may be built concurrently
 
-			passManager->add(new llvm::TargetData(*::executionEngine->getTargetData()));
-			passManager->add(llvm::createScalarReplAggregatesPass());
+		passManager.add(new llvm::TargetData(*::executionEngine->getTargetData()));
+		passManager.add(llvm::createScalarReplAggregatesPass());
 
-			for(int pass = 0; pass < 10 && optimization[pass] != Disabled; pass++)
+		for(int pass = 0; pass < 10 && optimization[pass] != Disabled; pass++)
+		{
+			switch(optimization[pass])
 			{
-				switch(optimization[pass])
-				{
-				case Disabled:                                                                       break;
-				case CFGSimplification:    passManager->add(llvm::createCFGSimplificationPass());    break;
-				case LICM:                 passManager->add(llvm::createLICMPass());                 break;
-				case AggressiveDCE:        passManager->add(llvm::createAggressiveDCEPass());        break;
-				case GVN:                  passManager->add(llvm::createGVNPass());                  break;
-				case InstructionCombining: passManager->add(llvm::createInstructionCombiningPass()); break;
-				case Reassociate:          passManager->add(llvm::createReassociatePass());          break;
-				case DeadStoreElimination: passManager->add(llvm::createDeadStoreEliminationPass()); break;
-				case SCCP:                 passManager->add(llvm::createSCCPPass());                 break;
-				case ScalarReplAggregates: passManager->add(llvm::createScalarReplAggregatesPass()); break;
-				default:
-					assert(false);
-				}
+			case Disabled:                                                                     break;
+			case CFGSimplification:    passManager.add(llvm::createCFGSimplificationPass());    break;
+			case LICM:                 passManager.add(llvm::createLICMPass());                 break;
+			case AggressiveDCE:        passManager.add(llvm::createAggressiveDCEPass());        break;
+			case GVN:                  passManager.add(llvm::createGVNPass());                  break;
+			case InstructionCombining: passManager.add(llvm::createInstructionCombiningPass()); break;
+			case Reassociate:          passManager.add(llvm::createReassociatePass());          break;
+			case DeadStoreElimination: passManager.add(llvm::createDeadStoreEliminationPass()); break;
+			case SCCP:                 passManager.add(llvm::createSCCPPass());                 break;
+			case ScalarReplAggregates: passManager.add(llvm::createScalarReplAggregatesPass()); break;
+			default:
+				assert(false);
 			}
 		}
 
-		passManager->run(*::module);
+		passManager.run(*::module);
 	}
 
 	Value *Nucleus::allocateStackVariable(Type *type, int arraySize)
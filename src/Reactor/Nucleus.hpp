@@ -17,6 +17,7 @@
 
 #include <cassert>
 #include <cstdarg>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -54,6 +55,7 @@ namespace sw
 		virtual ~Nucleus();
 
 		Routine *acquireRoutine(const wchar_t *name, bool runOptimizations = true);
+		static Routine *loadRoutine(const void *image, size_t size);   // Returns null if the image can't be loaded
 
 		static Value *allocateStackVariable(Type *type, int arraySize = 0);
 		static BasicBlock *createBasicBlock();
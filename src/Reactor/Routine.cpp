@@ -44,4 +44,9 @@ namespace sw
 	{
 		assert(bindCount == 0);
 	}
+
+	bool Routine::getImage(const void *&image, size_t &size)
+	{
+		return false;
+	}
 }
@@ -15,6 +15,8 @@
 #ifndef sw_Routine_hpp
 #define sw_Routine_hpp
 
+#include <cstddef>
+
 namespace sw
 {
 	class Routine
@@ -26,6 +28,10 @@ namespace sw
 
 		virtual const void *getEntry() = 0;
 
+		// Position-independent code image which can be reloaded with Nucleus::loadRoutine().
+		// Only available before the first getEntry() call, and not supported by all back-ends.
+		virtual bool getImage(const void *&image, size_t &size);
+
 		// Reference counting
 		void bind();
 		void unbind();
@@ -49,16 +49,15 @@
 
 namespace
 {
-	Ice::GlobalContext *context = nullptr;
-	Ice::Cfg *function = nullptr;
-	Ice::CfgNode *basicBlock = nullptr;
-	Ice::CfgLocalAllocatorScope *allocator = nullptr;
-	sw::Routine *routine = nullptr;
-
-	std::mutex codegenMutex;
-
-	Ice::ELFFileStreamer *elfFile = nullptr;
-	Ice::Fdstream *out = nullptr;
+	// Each thread builds routines in its own Subzero context, so they can be compiled concurrently
+	thread_local Ice::GlobalContext *context = nullptr;
+	thread_local Ice::Cfg *function = nullptr;
+	thread_local Ice::CfgNode *basicBlock = nullptr;
+	thread_local Ice::CfgLocalAllocatorScope *allocator = nullptr;
+	thread_local sw::Routine *routine = nullptr;
+
+	thread_local Ice::ELFFileStreamer *elfFile = nullptr;
+	thread_local Ice::Fdstream *out = nullptr;
 }
 
 namespace
@@ -447,6 +446,12 @@ namespace sw
 			buffer.reserve(0x1000);
 		}
 
+		ELFMemoryStreamer(const void *image, size_t size) : Routine(), entry(nullptr)
+		{
+			buffer.assign((const uint8_t*)image, (const uint8_t*)image + size);
+			position = size;
+		}
+
 		~ELFMemoryStreamer() override
 		{
 			#if defined(_WIN32)
@@ -506,6 +511,19 @@ namespace sw
 			return entry;
 		}
 
+		bool getImage(const void *&image, size_t &size) override
+		{
+			if(entry || buffer.empty())
+			{
+				return false;   // Relocated in place
+			}
+
+			image = &buffer[0];
+			size = buffer.size();
+
+			return true;
+		}
+
 	private:
 		void *entry;
 		std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
@@ -516,10 +534,8 @@ namespace sw
 		#endif
 	};
 
-	Nucleus::Nucleus()
+	static bool initializeFlags()
 	{
-		::codegenMutex.lock();   // Reactor is currently not thread safe
-
 		Ice::ClFlags &Flags = Ice::ClFlags::Flags;
 		Ice::ClFlags::getParsedClFlags(Flags);
 
@@ -528,7 +544,7 @@ namespace sw
 			Flags.setTargetInstructionSet(Ice::ARM32InstructionSet_HWDivArm);
 		#else   // x86
 			Flags.setTargetArch(sizeof(void*) == 8 ? Ice::Target_X8664 : Ice::Target_X8632);
-			Flags.setTargetInstructionSet(CPUID::SSE4_1 ? Ice::X86InstructionSet_SSE4_1 : Ice::X86InstructionSet_SSE2);
+			Flags.setTargetInstructionSet(CPUID::SSE4_1 ? Ice::X86InstructionSet_SSE4_1 : Ice::X86InstructionSet_SSE2);   // Subzero has no AVX instruction sets
 		#endif
 		Flags.setOutFileType(Ice::FT_Elf);
 		Flags.setOptLevel(Ice::Opt_2);
@@ -536,6 +552,14 @@ namespace sw
 		Flags.setVerbose(false ? Ice::IceV_Most : Ice::IceV_None);
 		Flags.setDisableHybridAssembly(true);
 
+		return true;
+	}
+
+	Nucleus::Nucleus()
+	{
+		static bool initialized = initializeFlags();   // The flags are global, shared by all contexts
+		(void)initialized;
+
 		static llvm::raw_os_ostream cout(std::cout);
 		static llvm::raw_os_ostream cerr(std::cerr);
 
@@ -564,8 +588,6 @@ namespace sw
 
 		delete ::elfFile;
 		delete ::out;
-
-		::codegenMutex.unlock();
 	}
 
 	Routine *Nucleus::acquireRoutine(const wchar_t *name, bool runOptimizations)
@@ -609,6 +631,24 @@ namespace sw
 		return handoffRoutine;
 	}
 
+	Routine *Nucleus::loadRoutine(const void *image, size_t size)
+	{
+		if(size < sizeof(ElfHeader) || !reinterpret_cast<const ElfHeader*>(image)->checkMagic())
+		{
+			return nullptr;
+		}
+
+		ELFMemoryStreamer *routine = new ELFMemoryStreamer(image, size);
+
+		if(!routine->getEntry())
+		{
+			delete routine;
+			return nullptr;
+		}
+
+		return routine;
+	}
+
 	void Nucleus::optimize()
 	{
 		sw::optimize(::function);
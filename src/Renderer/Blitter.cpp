@@ -14,16 +14,47 @@
 
 #include "Blitter.hpp"
 
+#include "RoutineArchive.hpp"
 #include "Shader/ShaderCore.hpp"
 #include "Reactor/Reactor.hpp"
+#include "Common/Half.hpp"
 #include "Common/Memory.hpp"
+#include "Common/WorkerPool.hpp"
 #include "Common/Debug.hpp"
 
 namespace sw
 {
+	bool precacheBlitter = false;
+
+	static const int minBandHeight = 32;    // Rows
+	static const int minBandedArea = 128 * 128;   // Pixels, below which dispatching costs more than it saves
+
+	#if ROUTINE_ARCHIVE
+		static RoutineArchive &archive()
+		{
+			static RoutineArchive archive("sw-blitter");   // Shared by all blitters
+			return archive;
+		}
+	#endif
+
+	unsigned int Blitter::State::flags() const
+	{
+		return writeMask | clearOperation << 8 | filter << 9 | useStencil << 10 | convertSRGB << 11 |
+		       clampToEdge << 12 | downsample << 13 | downsampleDepth << 14;
+	}
+
+	unsigned int Blitter::State::computeHash() const
+	{
+		const unsigned int key[] = {flags(), (unsigned int)sourceFormat, (unsigned int)destFormat, (unsigned int)destSamples};
+
+		return FNV_1a(key, sizeof(key) / sizeof(key[0]));
+	}
+
 	Blitter::Blitter()
 	{
 		blitCache = new RoutineCache<State>(1024);
+
+		threadCount = 1;
 	}
 
 	Blitter::~Blitter()
@@ -31,6 +62,69 @@ namespace sw
 		delete blitCache;
 	}
 
+	void Blitter::setThreadCount(int count)
+	{
+		threadCount = count;
+	}
+
+	void Blitter::blitBands(void (*blitFunction)(const BlitData *data), const BlitData &data, bool advanceY)
+	{
+		int width = data.x1d - data.x0d;
+		int height = data.y1d - data.y0d;
+		int count = min(threadCount, height / minBandHeight);
+
+		if(count < 2 || width * height < minBandedArea)
+		{
+			blitFunction(&data);
+
+			return;
+		}
+
+		std::vector<Band> bands;
+		addBands(bands, blitFunction, data, count, advanceY);
+
+		WorkerPool::shared().run(renderBand, &bands, (int)bands.size());
+	}
+
+	void Blitter::addBands(std::vector<Band> &bands, void (*blitFunction)(const BlitData *data), const BlitData &data, int count, bool advanceY)
+	{
+		int height = data.y1d - data.y0d;
+
+		// Bands start on even rows so that quad layout row pairs aren't shared
+		int bandHeight = ((height + count - 1) / count + 1) & ~1;
+		float y = data.y0;
+		int j = data.y0d;
+
+		while(j < data.y1d)
+		{
+			bands.push_back({blitFunction, data});
+			BlitData &b = bands.back().data;
+
+			b.y0 = y;
+			b.y0d = j;
+			b.y1d = min(j + bandHeight, data.y1d);
+
+			// Step the source coordinate row by row, like the routine does, so every band
+			// samples exactly the same source locations as a single pass would
+			if(advanceY)
+			{
+				for(int row = j; row < b.y1d; row++)
+				{
+					y += data.h;
+				}
+			}
+
+			j = b.y1d;
+		}
+	}
+
+	void Blitter::renderBand(void *parameters, int index)
+	{
+		const Band &band = (*static_cast<std::vector<Band>*>(parameters))[index];
+
+		band.function(&band.data);
+	}
+
 	void Blitter::clear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
 	{
 		if(fastClear(pixel, format, dest, dRect, rgbaMask))
@@ -81,6 +175,15 @@ namespace sw
 			         ((uint32_t)(255 * g + 0.5f) << 8) |
 			         ((uint32_t)(255 * r + 0.5f) << 0);
 			break;
+		case FORMAT_R16F:
+			if((rgbaMask & 0x1) != 0x1) return false;
+			packed = (uint16_t)halfAsShort(half(r));
+			break;
+		case FORMAT_G16R16F:
+			if((rgbaMask & 0x3) != 0x3) return false;
+			packed = ((uint32_t)(uint16_t)halfAsShort(half(g)) << 16) |
+			         ((uint32_t)(uint16_t)halfAsShort(half(r)) << 0);
+			break;
 		case FORMAT_X8R8G8B8:
 			if((rgbaMask & 0x7) != 0x7) return false;
 			packed = ((uint32_t)(255) << 24) |
@@ -100,6 +203,17 @@ namespace sw
 		}
 
 		bool useDestInternal = !dest->isExternalDirty();
+
+		if(useDestInternal && dest->isEntire(dRect) && dest->getInternalFormat() == dest->getFormat())
+		{
+			uint32_t pattern = (Surface::bytes(dest->getFormat()) == 2) ? (packed | packed << 16) : packed;
+
+			if(dest->deferClear(pattern))
+			{
+				return true;
+			}
+		}
+
 		uint8_t *slice = (uint8_t*)dest->lock(dRect.x0, dRect.y0, dRect.slice, sw::LOCK_WRITEONLY, sw::PUBLIC, useDestInternal);
 
 		for(int j = 0; j < dest->getSamples(); j++)
@@ -221,6 +335,143 @@ namespace sw
 		dest->unlockInternal();
 	}
 
+	// Whether filtering halves the dimension, or keeps a single texel
+	static bool isHalved(int source, int dest)
+	{
+		return source == 2 * dest || (source == 1 && dest == 1);
+	}
+
+	void Blitter::downsample(Surface *const *sources, Surface *const *dests, int count, bool volume)
+	{
+		std::vector<Band> jobs;
+		std::vector<std::pair<Surface*, bool>> locked;
+		int area = 0;
+
+		for(int i = 0; i < count; i++)
+		{
+			Surface *source = sources[i];
+			Surface *dest = dests[i];
+
+			if(dest->getInternalFormat() == FORMAT_NULL)
+			{
+				continue;
+			}
+
+			int sWidth = source->getWidth();
+			int sHeight = source->getHeight();
+			int sDepth = source->getDepth();
+			int dWidth = dest->getWidth();
+			int dHeight = dest->getHeight();
+			int dDepth = dest->getDepth();
+
+			ASSERT(volume || sDepth == dDepth);
+
+			bool useSourceInternal = !source->isExternalDirty();
+			bool useDestInternal = !dest->isExternalDirty();
+
+			State state(Options(true, false, true));
+			state.sourceFormat = source->getFormat(useSourceInternal);
+			state.destFormat = dest->getFormat(useDestInternal);
+			state.destSamples = dest->getSamples();
+
+			// Bilinear filtering at the center of each destination texel then averages a fixed block of source texels.
+			// Other ratios are filtered like regular blits, except for volumes, which use the generic 3D path.
+			state.downsample = isHalved(sWidth, dWidth) && isHalved(sHeight, dHeight) && (!volume || isHalved(sDepth, dDepth)) &&
+			                   !Surface::isNonNormalizedInteger(state.sourceFormat) &&
+			                   !Surface::hasQuadLayout(state.sourceFormat) && !Surface::hasQuadLayout(state.destFormat);
+			state.downsampleDepth = state.downsample && volume && sDepth > 1;
+			state.hash = state.computeHash();
+
+			Routine *routine = (state.downsample || !volume) ? getRoutine(state) : nullptr;
+
+			if(!routine)
+			{
+				if(volume)
+				{
+					blit3D(source, dest);
+				}
+				else for(int z = 0; z < dDepth; z++)
+				{
+					SliceRectF sRect(0.0f, 0.0f, static_cast<float>(sWidth), static_cast<float>(sHeight), z);
+					SliceRect dRect(0, 0, dWidth, dHeight, z);
+					blit(source, sRect, dest, dRect, Options(true, false, true));
+				}
+
+				continue;
+			}
+
+			unsigned char *sBuffer = (unsigned char*)source->lock(0, 0, 0, sw::LOCK_READONLY, sw::PUBLIC, useSourceInternal);
+			unsigned char *dBuffer = (unsigned char*)dest->lock(0, 0, 0, sw::LOCK_DISCARD, sw::PUBLIC, useDestInternal);
+			locked.push_back({source, useSourceInternal});
+			locked.push_back({dest, useDestInternal});
+
+			int sSliceB = source->getSliceB(useSourceInternal);
+
+			BlitData data;
+
+			data.sPitchB = source->getPitchB(useSourceInternal);
+			data.dPitchB = dest->getPitchB(useDestInternal);
+			data.dSliceB = dest->getSliceB(useDestInternal);
+
+			data.w = static_cast<float>(sWidth) / static_cast<float>(dWidth);
+			data.h = static_cast<float>(sHeight) / static_cast<float>(dHeight);
+			data.x0 = 0.5f * data.w;
+			data.y0 = 0.5f * data.h;
+
+			data.x0d = 0;
+			data.x1d = dWidth;
+			data.y0d = 0;
+			data.y1d = dHeight;
+
+			data.sWidth = sWidth;
+			data.sHeight = sHeight;
+
+			void (*function)(const BlitData *data) = (void(*)(const BlitData*))routine->getEntry();
+
+			for(int z = 0; z < dDepth; z++)
+			{
+				int sz = state.downsampleDepth ? 2 * z : z;
+
+				data.source = sBuffer + sz * sSliceB;
+				data.source2 = sBuffer + min(sz + 1, sDepth - 1) * sSliceB;
+				data.dest = dBuffer + z * data.dSliceB;
+
+				jobs.push_back({function, data});
+			}
+
+			area += dWidth * dHeight * dDepth;
+		}
+
+		if(threadCount > 1 && area >= minBandedArea)
+		{
+			// Split the jobs into enough row bands to occupy all threads
+			int bandsPerJob = (threadCount + (int)jobs.size() - 1) / (int)jobs.size();
+
+			std::vector<Band> bands;
+
+			for(const Band &job : jobs)
+			{
+				int height = job.data.y1d - job.data.y0d;
+
+				addBands(bands, job.function, job.data, max(min(bandsPerJob, height / minBandHeight), 1), true);
+			}
+
+			WorkerPool::shared().run(renderBand, &bands, (int)bands.size());
+		}
+		else
+		{
+			for(const Band &job : jobs)
+			{
+				job.function(&job.data);
+			}
+		}
+
+		for(const std::pair<Surface*, bool> &surface : locked)
+		{
+			surface.first->unlock(surface.second);
+		}
+	}
+
 	bool Blitter::read(Float4 &c, Pointer<Byte> element, const State &state)
 	{
 		c = Float4(0.0f, 0.0f, 0.0f, 1.0f);
@@ -375,6 +626,18 @@ namespace sw
 		case FORMAT_R32F:
 			c.x = *Pointer<Float>(element);
 			break;
+		case FORMAT_A16B16G16R16F:
+			c = halfToFloat(Int4(*Pointer<UShort4>(element)));
+			break;
+		case FORMAT_X16B16G16R16F:
+			c.xyz = halfToFloat(Int4(*Pointer<UShort4>(element)));
+			break;
+		case FORMAT_G16R16F:
+			c.xy = halfToFloat(Insert(Int4(Int(*Pointer<UShort>(element))), Int(*Pointer<UShort>(element + 2)), 1));
+			break;
+		case FORMAT_R16F:
+			c.x = Extract(halfToFloat(Int4(Int(*Pointer<UShort>(element)))), 0);
+			break;
 		case FORMAT_R5G6B5:
 			c.x = Float(Int((*Pointer<UShort>(element) & UShort(0xF800)) >> UShort(11)));
 			c.y = Float(Int((*Pointer<UShort>(element) & UShort(0x07E0)) >> UShort(5)));
@@ -537,6 +800,27 @@ namespace sw
 		case FORMAT_R32F:
 			if(writeR) { *Pointer<Float>(element) = c.x; }
 			break;
+		case FORMAT_A16B16G16R16F:
+			if(writeRGBA)
+			{
+				*Pointer<Short4>(element) = Short4(floatToHalf(c));
+			}
+			else
+			{
+				if(writeR) { *Pointer<Short>(element) = Short(Extract(floatToHalf(c), 0)); }
+				if(writeG) { *Pointer<Short>(element + 2) = Short(Extract(floatToHalf(c), 1)); }
+				if(writeB) { *Pointer<Short>(element + 4) = Short(Extract(floatToHalf(c), 2)); }
+				if(writeA) { *Pointer<Short>(element + 6) = Short(Extract(floatToHalf(c), 3)); }
+			}
+			break;
+		case FORMAT_X16B16G16R16F:
+			if(writeA) { *Pointer<Short>(element + 6) = Short(0x3C00); }   // 1.0
+			if(writeB) { *Pointer<Short>(element + 4) = Short(Extract(floatToHalf(c), 2)); }
+		case FORMAT_G16R16F:
+			if(writeG) { *Pointer<Short>(element + 2) = Short(Extract(floatToHalf(c), 1)); }
+		case FORMAT_R16F:
+			if(writeR) { *Pointer<Short>(element) = Short(Extract(floatToHalf(c), 0)); }
+			break;
 		case FORMAT_A8B8G8R8I:
 		case FORMAT_A8B8G8R8_SNORM:
 			if(writeA) { *Pointer<SByte>(element + 3) = SByte(RoundInt(Float(c.w))); }
@@ -1039,6 +1323,10 @@ namespace sw
 		case FORMAT_B32G32R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_R32F:
+		case FORMAT_A16B16G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_R16F:
 		case FORMAT_A2B10G10R10UI:
 			scale = vector(1.0f, 1.0f, 1.0f, 1.0f);
 			break;
@@ -1178,6 +1466,11 @@ namespace sw
 
 	Routine *Blitter::generate(const State &state)
 	{
+		if(state.downsample)
+		{
+			return generateDownsample(state);
+		}
+
 		Function<Void(Pointer<Byte>)> function;
 		{
 			Pointer<Byte> blit(function.Arg<0>());
@@ -1390,6 +1683,151 @@ namespace sw
 		return function(L"BlitRoutine");
 	}
 
+	Routine *Blitter::generateDownsample(const State &state)
+	{
+		Function<Void(Pointer<Byte>)> function;
+		{
+			Pointer<Byte> blit(function.Arg<0>());
+
+			Pointer<Byte> source = *Pointer<Pointer<Byte>>(blit + OFFSET(BlitData,source));
+			Pointer<Byte> source2 = *Pointer<Pointer<Byte>>(blit + OFFSET(BlitData,source2));
+			Pointer<Byte> dest = *Pointer<Pointer<Byte>>(blit + OFFSET(BlitData,dest));
+			Int sPitchB = *Pointer<Int>(blit + OFFSET(BlitData,sPitchB));
+			Int dPitchB = *Pointer<Int>(blit + OFFSET(BlitData,dPitchB));
+			Int dSliceB = *Pointer<Int>(blit + OFFSET(BlitData,dSliceB));
+
+			Int x0d = *Pointer<Int>(blit + OFFSET(BlitData,x0d));
+			Int x1d = *Pointer<Int>(blit + OFFSET(BlitData,x1d));
+			Int y0d = *Pointer<Int>(blit + OFFSET(BlitData,y0d));
+			Int y1d = *Pointer<Int>(blit + OFFSET(BlitData,y1d));
+
+			Int sWidth = *Pointer<Int>(blit + OFFSET(BlitData,sWidth));
+			Int sHeight = *Pointer<Int>(blit + OFFSET(BlitData,sHeight));
+
+			int srcBytes = Surface::bytes(state.sourceFormat);
+			int dstBytes = Surface::bytes(state.destFormat);
+			bool preScaled = state.convertSRGB && Surface::isSRGBformat(state.sourceFormat);
+
+			// Dimensions with a single texel read it twice
+			Int stepX = IfThenElse(sWidth > 1, Int(2 * srcBytes), Int(srcBytes));
+			Int stepY = IfThenElse(sHeight > 1, sPitchB * 2, sPitchB);
+			Int nextX = stepX - Int(srcBytes);
+			Int nextY = stepY - sPitchB;
+
+			For(Int j = y0d, j < y1d, j++)
+			{
+				Int offset = j * stepY + x0d * stepX;
+				Pointer<Byte> d = dest + j * dPitchB + x0d * dstBytes;
+
+				For(Int i = x0d, i < x1d, i++)
+				{
+					Float4 color;
+
+					for(int k = 0; k < (state.downsampleDepth ? 2 : 1); k++)
+					{
+						Pointer<Byte> s = (k == 0 ? source : source2) + offset;
+
+						Float4 c00; if(!read(c00, s, state)) return nullptr;
+						Float4 c01; if(!read(c01, s + nextX, state)) return nullptr;
+						Float4 c10; if(!read(c10, s + nextY, state)) return nullptr;
+						Float4 c11; if(!read(c11, s + nextY + nextX, state)) return nullptr;
+
+						if(preScaled) // sRGB -> RGB
+						{
+							if(!ApplyScaleAndClamp(c00, state)) return nullptr;
+							if(!ApplyScaleAndClamp(c01, state)) return nullptr;
+							if(!ApplyScaleAndClamp(c10, state)) return nullptr;
+							if(!ApplyScaleAndClamp(c11, state)) return nullptr;
+						}
+
+						// Same arithmetic as bilinear filtering with half weights, for identical results
+						Float4 half(0.5f);
+						Float4 average = (c00 * half + c01 * half) * half +
+						                 (c10 * half + c11 * half) * half;
+
+						if(k == 0)
+						{
+							color = average;
+						}
+						else
+						{
+							color = color * half + average * half;
+						}
+					}
+
+					if(!ApplyScaleAndClamp(color, state, preScaled))
+					{
+						return nullptr;
+					}
+
+					Pointer<Byte> sample = d;
+
+					for(int s = 0; s < state.destSamples; s++)
+					{
+						if(!write(color, sample, state))
+						{
+							return nullptr;
+						}
+
+						sample += dSliceB;
+					}
+
+					offset += stepX;
+					d += dstBytes;
+				}
+			}
+		}
+
+		return function(L"DownsampleRoutine");
+	}
+
+	Routine *Blitter::getRoutine(const State &state)
+	{
+		criticalSection.lock();
+		Routine *blitRoutine = blitCache->query(state);
+
+		if(!blitRoutine)
+		{
+			#if ROUTINE_ARCHIVE
+				std::vector<unsigned char> key;
+
+				if(precacheBlitter)
+				{
+					// The options contain undefined padding bits, so the key is made of the individual fields
+					const unsigned int fields[] = {state.writeMask, state.clearOperation, state.filter, state.useStencil, state.convertSRGB, state.clampToEdge,
+					                               state.downsample, state.downsampleDepth, state.sourceFormat, state.destFormat, static_cast<unsigned int>(state.destSamples)};
+					key.assign(reinterpret_cast<const unsigned char*>(fields), reinterpret_cast<const unsigned char*>(fields) + sizeof(fields));
+
+					blitRoutine = archive().load(key);
+				}
+			#endif
+
+			if(!blitRoutine)
+			{
+				blitRoutine = generate(state);
+
+				if(!blitRoutine)
+				{
+					criticalSection.unlock();
+					return nullptr;
+				}
+
+				#if ROUTINE_ARCHIVE
+					if(precacheBlitter)
+					{
+						archive().store(key, blitRoutine);
+					}
+				#endif
+			}
+
+			blitCache->add(state, blitRoutine);
+		}
+
+		criticalSection.unlock();
+
+		return blitRoutine;
+	}
+
 	bool Blitter::blitReactor(Surface *source, const SliceRectF &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options &options)
 	{
 		ASSERT(!options.clearOperation || ((source->getWidth() == 1) && (source->getHeight() == 1) && (source->getDepth() == 1)));
@@ -1420,25 +1858,15 @@ namespace sw
 		state.sourceFormat = isStencil ? source->getStencilFormat() : source->getFormat(useSourceInternal);
 		state.destFormat = isStencil ? dest->getStencilFormat() : dest->getFormat(useDestInternal);
 		state.destSamples = dest->getSamples();
+		state.hash = state.computeHash();
 
-		criticalSection.lock();
-		Routine *blitRoutine = blitCache->query(state);
+		Routine *blitRoutine = getRoutine(state);
 
 		if(!blitRoutine)
 		{
-			blitRoutine = generate(state);
-
-			if(!blitRoutine)
-			{
-				criticalSection.unlock();
-				return false;
-			}
-
-			blitCache->add(state, blitRoutine);
+			return false;
 		}
 
-		criticalSection.unlock();
-
 		void (*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
 
 		BlitData data;
@@ -1467,7 +1895,14 @@ namespace sw
 		data.sWidth = source->getWidth();
 		data.sHeight = source->getHeight();
 
-		blitFunction(&data);
+		if(source != dest)   // Bands could read each other's output otherwise
+		{
+			blitBands(blitFunction, data, !options.clearOperation);
+		}
+		else
+		{
+			blitFunction(&data);
+		}
 
 		if(isStencil)
 		{
@@ -18,8 +18,10 @@
 #include "Surface.hpp"
 #include "RoutineCache.hpp"
 #include "Reactor/Reactor.hpp"
+#include "Common/Thread.hpp"
 
 #include <string.h>
+#include <vector>
 
 namespace sw
 {
@@ -27,11 +29,12 @@ namespace sw
 	{
 		struct Options
 		{
-			Options() = default;
+			Options()
+				: writeMask(0), clearOperation(false), filter(false), useStencil(false), convertSRGB(false), clampToEdge(false), downsample(false), downsampleDepth(false) {}
 			Options(bool filter, bool useStencil, bool convertSRGB)
-				: writeMask(0xF), clearOperation(false), filter(filter), useStencil(useStencil), convertSRGB(convertSRGB), clampToEdge(false) {}
+				: writeMask(0xF), clearOperation(false), filter(filter), useStencil(useStencil), convertSRGB(convertSRGB), clampToEdge(false), downsample(false), downsampleDepth(false) {}
 			Options(unsigned int writeMask)
-				: writeMask(writeMask), clearOperation(true), filter(false), useStencil(false), convertSRGB(true), clampToEdge(false) {}
+				: writeMask(writeMask), clearOperation(true), filter(false), useStencil(false), convertSRGB(true), clampToEdge(false), downsample(false), downsampleDepth(false) {}
 
 			union
 			{
@@ -51,6 +54,8 @@ namespace sw
 			bool useStencil : 1;
 			bool convertSRGB : 1;
 			bool clampToEdge : 1;
+			bool downsample : 1;        // Box filter halving each dimension which has more than one texel
+			bool downsampleDepth : 1;   // Also averages a pair of source slices
 		};
 
 		struct State : Options
@@ -60,12 +65,20 @@ namespace sw
 
 			bool operator==(const State &state) const
 			{
-				return memcmp(this, &state, sizeof(State)) == 0;
+				return hash == state.hash && flags() == state.flags() && sourceFormat == state.sourceFormat &&
+				       destFormat == state.destFormat && destSamples == state.destSamples;
 			}
 
-			Format sourceFormat;
-			Format destFormat;
-			int destSamples;
+			unsigned int computeHash() const;
+
+			Format sourceFormat = FORMAT_NULL;
+			Format destFormat = FORMAT_NULL;
+			int destSamples = 0;
+
+			unsigned int hash = 0;
+
+		private:
+			unsigned int flags() const;   // All options, without the padding bits
 		};
 
 		struct BlitData
@@ -88,6 +101,14 @@ namespace sw
 
 			int sWidth;
 			int sHeight;
+
+			void *source2;   // Second source slice, when downsampling depth
+		};
+
+		struct Band
+		{
+			void (*function)(const BlitData *data);
+			BlitData data;
 		};
 
 	public:
@@ -98,6 +119,13 @@ namespace sw
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
 		void blit3D(Surface *source, Surface *dest);
 
+		// Filters each source into the destination with the same index, which holds the next mipmap level.
+		// All slices are filtered independently unless the surfaces are volumes. The jobs of all surfaces and
+		// slices, and row bands of the larger ones, get processed in parallel.
+		void downsample(Surface *const *sources, Surface *const *dests, int count, bool volume);
+
+		void setThreadCount(int threadCount);   // Large blits are split into row bands, rendered in parallel
+
 	private:
 		bool fastClear(void *pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
 
@@ -111,10 +139,18 @@ namespace sw
 		static Float4 LinearToSRGB(Float4 &color);
 		static Float4 sRGBtoLinear(Float4 &color);
 		bool blitReactor(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, const Options &options);
+		Routine *getRoutine(const State &state);
 		Routine *generate(const State &state);
+		Routine *generateDownsample(const State &state);
+
+		void blitBands(void (*blitFunction)(const BlitData *data), const BlitData &data, bool advanceY);
+		static void addBands(std::vector<Band> &bands, void (*blitFunction)(const BlitData *data), const BlitData &data, int count, bool advanceY);
+		static void renderBand(void *parameters, int index);
 
 		RoutineCache<State> *blitCache;
 		MutexLock criticalSection;
+
+		int threadCount;   // Limits the bands dispatched to the shared worker pool
 	};
 }
 
@@ -302,7 +302,7 @@ namespace sw
 		pixelShader = 0;
 		vertexShader = 0;
 
-		instanceID = 0;
+		instanceCount = 1;
 
 		occlusionEnabled = false;
 		transformFeedbackQueryEnabled = false;
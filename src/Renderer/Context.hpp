@@ -490,7 +490,7 @@ namespace sw
 		float bias;
 
 		// Instancing
-		int instanceID;
+		int instanceCount;
 
 		// Fixed-function vertex pipeline state
 		bool lightingEnable;
@@ -0,0 +1,139 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "DeferredClear.hpp"
+
+#include "Common/Memory.hpp"
+#include "Common/Thread.hpp"
+#include "Common/Math.hpp"
+
+#include <string.h>
+
+namespace sw
+{
+	DeferredClear::DeferredClear(int height)
+		: height(height), bandCount((height + BAND_HEIGHT - 1) / BAND_HEIGHT),
+		  buffer(nullptr), pitchB(0), sliceB(0), samples(0), pattern(0), pending(0)
+	{
+		state = new std::atomic<int>[bandCount];
+
+		for(int i = 0; i < bandCount; i++)
+		{
+			state[i] = WRITTEN;
+		}
+	}
+
+	DeferredClear::~DeferredClear()
+	{
+		delete[] state;
+	}
+
+	void DeferredClear::defer(void *buffer, int pitchB, int sliceB, int samples, unsigned int pattern)
+	{
+		this->buffer = buffer;
+		this->pitchB = pitchB;
+		this->sliceB = sliceB;
+		this->samples = samples;
+		this->pattern = pattern;
+
+		for(int i = 0; i < bandCount; i++)
+		{
+			state[i].store(PENDING, std::memory_order_relaxed);
+		}
+
+		pending.store(bandCount, std::memory_order_release);
+	}
+
+	void DeferredClear::discard()
+	{
+		for(int i = 0; i < bandCount; i++)
+		{
+			state[i].store(WRITTEN, std::memory_order_relaxed);
+		}
+
+		pending.store(0, std::memory_order_release);
+	}
+
+	void DeferredClear::materialize(int y0, int y1)
+	{
+		if(!isPending())
+		{
+			return;
+		}
+
+		int first = max(y0, 0) / BAND_HEIGHT;
+		int last = min((min(y1, height) + BAND_HEIGHT - 1) / BAND_HEIGHT, bandCount);
+
+		// Write the unclaimed bands first, then wait for the ones claimed by other threads
+		for(int band = first; band < last; band++)
+		{
+			int expected = PENDING;
+
+			if(state[band].load(std::memory_order_relaxed) == PENDING &&
+			   state[band].compare_exchange_strong(expected, WRITING, std::memory_order_acquire))
+			{
+				fill(band);
+
+				state[band].store(WRITTEN, std::memory_order_release);
+				pending.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		for(int band = first; band < last; band++)
+		{
+			while(state[band].load(std::memory_order_acquire) != WRITTEN)
+			{
+				Thread::yield();
+			}
+		}
+	}
+
+	void DeferredClear::materialize()
+	{
+		materialize(0, height);
+	}
+
+	void DeferredClear::fill(int band)
+	{
+		int y0 = band * BAND_HEIGHT;
+		int y1 = min(y0 + BAND_HEIGHT, height);
+
+		// The last band also covers the padding rows of the slice
+		int bytes = (band == bandCount - 1) ? sliceB - y0 * pitchB : (y1 - y0) * pitchB;
+
+		unsigned char element[4];
+		memcpy(element, &pattern, sizeof(element));
+
+		for(int s = 0; s < samples; s++)
+		{
+			unsigned char *row = (unsigned char*)buffer + s * sliceB + y0 * pitchB;
+			int count = bytes;
+
+			// The pattern is aligned to the buffer, which is aligned to its elements
+			while(((size_t)row & 0x3) && count > 0)
+			{
+				*row = element[(size_t)row & 0x3];
+				row++;
+				count--;
+			}
+
+			clear((uint32_t*)row, pattern, count / 4);
+
+			for(int i = count & ~0x3; i < count; i++)
+			{
+				row[i] = element[i & 0x3];
+			}
+		}
+	}
+}
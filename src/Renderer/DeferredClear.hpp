@@ -0,0 +1,77 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_DeferredClear_hpp
+#define sw_DeferredClear_hpp
+
+#include "Common/Types.hpp"
+
+#include <atomic>
+
+namespace sw
+{
+	// Clear of an entire buffer to a repeating 32-bit pattern, which only gets written to
+	// bands of rows when they're first accessed. Bands can be written concurrently by the
+	// renderer's threads, each one by whichever thread gets to it first.
+	class DeferredClear
+	{
+	public:
+		enum
+		{
+			BAND_HEIGHT = 16   // Rows, even so that quad layout row pairs aren't shared
+		};
+
+		explicit DeferredClear(int height);
+
+		~DeferredClear();
+
+		// Replaces any pending clear. Requires exclusive access to the buffer.
+		void defer(void *buffer, int pitchB, int sliceB, int samples, unsigned int pattern);
+		void discard();
+
+		inline bool isPending() const;
+
+		void materialize(int y0, int y1);   // Writes the pending rows of the bands overlapping [y0, y1)
+		void materialize();
+
+	private:
+		enum State
+		{
+			WRITTEN,
+			PENDING,
+			WRITING
+		};
+
+		void fill(int band);
+
+		const int height;
+		const int bandCount;
+
+		void *buffer;
+		int pitchB;
+		int sliceB;
+		int samples;
+		unsigned int pattern;
+
+		std::atomic<int> *state;
+		std::atomic<int> pending;   // Number of bands not written yet
+	};
+
+	bool DeferredClear::isPending() const
+	{
+		return pending.load(std::memory_order_acquire) != 0;
+	}
+}
+
+#endif   // sw_DeferredClear_hpp
@@ -86,21 +86,32 @@ namespace
 		return (x << 1) | (x >> 6);
 	}
 
+	// Extension of clamped EAC values to 16-bit normalized, as specified for 16-bit decoding
+	inline short extendEAC(int x, bool isSigned)
+	{
+		if(isSigned)
+		{
+			return (x >= 0) ? ((x << 5) | (x >> 5)) : -((-x << 5) | (-x >> 5));
+		}
+
+		return (x << 5) | (x >> 6);
+	}
+
 	struct ETC2
 	{
-		// Decodes unsigned single or dual channel block to bytes
+		// Decodes single or dual channel block to bytes, or to 16-bit normalized values for EAC
 		static void DecodeBlock(const ETC2** sources, unsigned char *dest, int nbChannels, int x, int y, int w, int h, int pitch, bool isSigned, bool isEAC)
 		{
 			if(isEAC)
 			{
 				for(int j = 0; j < 4 && (y + j) < h; j++)
 				{
-					int* sDst = reinterpret_cast<int*>(dest);
+					short* sDst = reinterpret_cast<short*>(dest);
 					for(int i = 0; i < 4 && (x + i) < w; i++)
 					{
 						for(int c = nbChannels - 1; c >= 0; c--)
 						{
-							sDst[i * nbChannels + c] = clampEAC(sources[c]->getSingleChannel(i, j, isSigned, true), isSigned);
+							sDst[i * nbChannels + c] = extendEAC(clampEAC(sources[c]->getSingleChannel(i, j, isSigned, true), isSigned), isSigned);
 						}
 					}
 					dest += pitch;
@@ -673,7 +684,7 @@ namespace
 	};
 }
 
-// Decodes 1 to 4 channel images to 8 bit output
+// Decodes 1 to 4 channel images to 8 bit output, or 16 bit normalized output for EAC R11/RG11
 bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, int h, int dstW, int dstH, int dstPitch, int dstBpp, InputType inputType)
 {
 	const ETC2* sources[2];
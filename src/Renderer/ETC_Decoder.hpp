@@ -26,7 +26,7 @@ public:
 		ETC_RGBA
 	};
 
-	/// ETC_Decoder::Decode - Decodes 1 to 4 channel images to 8 bit output
+	/// ETC_Decoder::Decode - Decodes 1 to 4 channel images to 8 bit output, or 16 bit normalized output for EAC R11/RG11
 	/// @param src            Pointer to ETC2 encoded image
 	/// @param dst            Pointer to BGRA, 8 bit output
 	/// @param w              src image width
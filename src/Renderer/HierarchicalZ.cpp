@@ -0,0 +1,316 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "HierarchicalZ.hpp"
+
+#include "Polygon.hpp"
+#include "Primitive.hpp"
+#include "Renderer.hpp"
+#include "Common/Math.hpp"
+
+#include <string.h>
+
+namespace sw
+{
+	extern bool complementaryDepthBuffer;
+
+	bool hierarchicalZCulling = true;   // Culling of occluded primitives against the tiles, set by SwiftConfig
+
+	// Margins for the rounding of interpolated depth, and the precision of 16-bit depth formats
+	static const float interpolationError = 1.0f / (1 << 20);
+	static const float quantizationError = 1.0f / (1 << 15);
+
+	std::atomic<unsigned int> HierarchicalZ::serialCounter(0);
+
+	static inline uint64_t tileValue(float depth, unsigned int serial)
+	{
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+
+		return (uint64_t)serial << 32 | bits;
+	}
+
+	static inline float tileDepth(uint64_t value)
+	{
+		uint32_t bits = (uint32_t)value;
+		float depth;
+		memcpy(&depth, &bits, sizeof(depth));
+
+		return depth;
+	}
+
+	static inline unsigned int tileSerial(uint64_t value)
+	{
+		return (unsigned int)(value >> 32);
+	}
+
+	// Evaluated the same way as by the rasterizer
+	static inline float interpolateZ(const Primitive &primitive, int x, int y)
+	{
+		float Dz = primitive.z.C.x + ((float)y + primitive.yQuad.x) * primitive.z.B.x;
+
+		return Dz + ((float)x + primitive.xQuad.x) * primitive.z.A.x;
+	}
+
+	HierarchicalZ::HierarchicalZ(int width, int height)
+		: width(width), height(height),
+		  tilesX((width + TILE_SIZE - 1) / TILE_SIZE), tilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+		  valid(false)   // Contents are undefined until cleared
+	{
+		tile = new std::atomic<uint64_t>[tilesX * tilesY];
+
+		for(int i = 0; i < tilesX * tilesY; i++)
+		{
+			tile[i] = tileValue(1.0f, 0);
+		}
+	}
+
+	HierarchicalZ::~HierarchicalZ()
+	{
+		delete[] tile;
+	}
+
+	void HierarchicalZ::clear(float depth, int x0, int y0, int x1, int y1, bool valid)
+	{
+		// Clears wait for all rendering to finish, so every following draw call can use the tiles
+		for(int ty = y0 / TILE_SIZE; ty * TILE_SIZE < y1; ty++)
+		{
+			for(int tx = x0 / TILE_SIZE; tx * TILE_SIZE < x1; tx++)
+			{
+				bool entire = tx * TILE_SIZE >= x0 && min((tx + 1) * TILE_SIZE, width) <= x1 &&
+				              ty * TILE_SIZE >= y0 && min((ty + 1) * TILE_SIZE, height) <= y1;
+
+				std::atomic<uint64_t> &t = tile[ty * tilesX + tx];
+				float maximum = entire ? depth : max(tileDepth(t), depth);
+
+				t = tileValue(maximum, 0);
+			}
+		}
+
+		this->valid = valid;
+	}
+
+	void HierarchicalZ::invalidate()
+	{
+		valid = false;
+	}
+
+	bool HierarchicalZ::isValid() const
+	{
+		return valid;
+	}
+
+	unsigned int HierarchicalZ::newSerial()
+	{
+		unsigned int serial = ++serialCounter;
+
+		return serial != 0 ? serial : ++serialCounter;   // Zero is reserved for clears
+	}
+
+	bool HierarchicalZ::beginDraw(Test &test, DepthCompareMode depthCompareMode, bool depthWriteEnable, bool cullable, bool exactCoverage)
+	{
+		bool decreasing = depthCompareMode == DEPTH_LESS || depthCompareMode == DEPTH_LESSEQUAL ||
+		                  depthCompareMode == DEPTH_EQUAL || depthCompareMode == DEPTH_NEVER;
+
+		if(depthWriteEnable && (!decreasing || complementaryDepthBuffer))
+		{
+			invalidate();
+
+			return false;
+		}
+
+		if(!hierarchicalZCulling || !cullable || complementaryDepthBuffer || !isValid() ||
+		   (depthCompareMode != DEPTH_LESS && depthCompareMode != DEPTH_LESSEQUAL))
+		{
+			return false;
+		}
+
+		test.serial = newSerial();
+		test.lessEqual = depthCompareMode == DEPTH_LESSEQUAL;
+		test.update = depthWriteEnable && exactCoverage;
+
+		return true;
+	}
+
+	bool HierarchicalZ::cull(Primitive &primitive, const Triangle &triangle, const Polygon &polygon, const DrawData &data, const Test &test)
+	{
+		int xMin = max(data.scissorX0, 0);
+		int xMax = min(data.scissorX1, width);
+		int yMin = max(primitive.yMin, 0);
+		int yMax = min(primitive.yMax, height);
+
+		// Vertices in 28.4 fixed-point, obtained the same way as by the setup routine
+		const int n = polygon.n;
+		int64_t X[16];
+		int64_t Y[16];
+		int64_t rounding = 0;
+
+		if(polygon.i == 0)
+		{
+			const Vertex *v[3] = {&triangle.v0, &triangle.v1, &triangle.v2};
+
+			for(int i = 0; i < 3; i++)
+			{
+				X[i] = v[i]->X;
+				Y[i] = v[i]->Y;
+			}
+		}
+		else   // Clipped; reproject
+		{
+			const float4 *const *P = polygon.P[polygon.i];
+
+			for(int i = 0; i < n; i++)
+			{
+				const float4 &v = *P[i];
+				float rhw = v.w != 0.0f ? 1.0f / v.w : 1.0f;
+
+				X[i] = iround(data.X0x16.x + v.x * rhw * data.Wx16.x);
+				Y[i] = iround(data.Y0x16.x + v.y * rhw * data.Hx16.x);
+			}
+
+			rounding = 2;   // Ties may be rounded differently than by the setup routine
+		}
+
+		int64_t area = 0;
+		int64_t left = X[0];
+		int64_t right = X[0];
+
+		for(int i = 0; i < n; i++)
+		{
+			int j = (i + 1) % n;
+
+			area += X[i] * Y[j] - X[j] * Y[i];
+			left = min(left, X[i]);
+			right = max(right, X[i]);
+		}
+
+		const int64_t orientation = (area > 0) - (area < 0);
+
+		// Horizontal extent, with a pixel of margin
+		xMin = max(xMin, (int)((left + 0xF) >> 4) - 1);
+		xMax = min(xMax, (int)((right + 0xF) >> 4) + 1);
+
+		if(xMin >= xMax || yMin >= yMax)
+		{
+			return false;
+		}
+
+		const bool update = test.update && orientation != 0;
+
+		int firstRow = -1;
+		int lastRow = -1;
+
+		for(int ty = yMin / TILE_SIZE; ty * TILE_SIZE < yMax; ty++)
+		{
+			int y0 = max(ty * TILE_SIZE, yMin);
+			int y1 = min((ty + 1) * TILE_SIZE, yMax) - 1;
+			bool occluded = true;
+
+			for(int tx = xMin / TILE_SIZE; tx * TILE_SIZE < xMax; tx++)
+			{
+				int x0 = max(tx * TILE_SIZE, xMin);
+				int x1 = min((tx + 1) * TILE_SIZE, xMax) - 1;
+
+				// Depth is planar, so its extremes over the tile are at the corners
+				float z00 = interpolateZ(primitive, x0, y0);
+				float z01 = interpolateZ(primitive, x1, y0);
+				float z10 = interpolateZ(primitive, x0, y1);
+				float z11 = interpolateZ(primitive, x1, y1);
+
+				float zMin = min(min(z00, z01), min(z10, z11));
+				float zMax = max(max(z00, z01), max(z10, z11));
+
+				std::atomic<uint64_t> &t = tile[ty * tilesX + tx];
+				uint64_t value = t.load(std::memory_order_acquire);
+
+				if(occluded)
+				{
+					// Tiles lowered by this or later draw calls may depend on primitives rasterized after this one
+					unsigned int serial = tileSerial(value);
+					bool previous = serial == 0 || (int)(test.serial - serial) > 0;
+
+					float margin = test.lessEqual ? quantizationError : interpolationError;
+
+					// Depth clamping can only reduce depth values above 1
+					occluded = previous && min(zMin, 1.0f) >= tileDepth(value) + margin;
+				}
+
+				if(!occluded && !update)
+				{
+					break;
+				}
+
+				bool entire = x0 == tx * TILE_SIZE && x1 == (tx + 1) * TILE_SIZE - 1 &&
+				              y0 == ty * TILE_SIZE && y1 == (ty + 1) * TILE_SIZE - 1;
+
+				if(update && entire)
+				{
+					int64_t cornerX[4] = {x0 << 4, x1 << 4, x0 << 4, x1 << 4};
+					int64_t cornerY[4] = {y0 << 4, y0 << 4, y1 << 4, y1 << 4};
+					bool covered = true;
+
+					for(int c = 0; c < 4 && covered; c++)
+					{
+						for(int i = 0; i < n; i++)
+						{
+							int j = (i + 1) % n;
+							int64_t DX = X[j] - X[i];
+							int64_t DY = Y[j] - Y[i];
+							int64_t edge = DX * (cornerY[c] - Y[i]) - DY * (cornerX[c] - X[i]);
+
+							// Strictly inside, regardless of the fill convention
+							if(edge * orientation <= rounding * (abs(DX) + abs(DY)))
+							{
+								covered = false;
+								break;
+							}
+						}
+					}
+
+					// Every pixel of the tile now passes the depth test and gets written, or already had a lower value.
+					// Concurrent updates may get lost, which only makes the tile less tight.
+					float lowered = max(zMax + interpolationError, 0.0f);
+
+					while(covered && lowered < tileDepth(value))
+					{
+						if(t.compare_exchange_weak(value, tileValue(lowered, test.serial), std::memory_order_acq_rel))
+						{
+							break;
+						}
+					}
+				}
+			}
+
+			if(!occluded)
+			{
+				if(firstRow < 0)
+				{
+					firstRow = ty;
+				}
+
+				lastRow = ty;
+			}
+		}
+
+		if(firstRow < 0)
+		{
+			return true;
+		}
+
+		primitive.yMin = max(primitive.yMin, firstRow * TILE_SIZE);
+		primitive.yMax = min(primitive.yMax, (lastRow + 1) * TILE_SIZE);
+
+		return false;
+	}
+}
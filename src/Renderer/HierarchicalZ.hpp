@@ -0,0 +1,82 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_HierarchicalZ_hpp
+#define sw_HierarchicalZ_hpp
+
+#include "Context.hpp"
+#include "Common/Types.hpp"
+
+#include <atomic>
+
+namespace sw
+{
+	struct Primitive;
+	struct Triangle;
+	struct Polygon;
+	struct DrawData;
+
+	// Conservative maximum depth of each tile of a depth buffer, used to cull primitives
+	// which are entirely behind its contents before rasterizing them. Only valid while the
+	// depth values don't increase, so it's reset by clearing the entire buffer.
+	class HierarchicalZ
+	{
+	public:
+		enum
+		{
+			TILE_SIZE = 8   // Pixels
+		};
+
+		struct Test
+		{
+			unsigned int serial;   // Of the draw call, to only use tiles lowered by previous ones
+			bool lessEqual;        // Else DEPTH_LESS
+			bool update;           // Depth gets written wherever a primitive covers a pixel
+		};
+
+		HierarchicalZ(int width, int height);
+
+		~HierarchicalZ();
+
+		void clear(float depth, int x0, int y0, int x1, int y1, bool valid);
+		void invalidate();   // Until the next clear which makes it valid
+		bool isValid() const;
+
+		static unsigned int newSerial();
+
+		// Invalidates the tiles if the draw call can raise depth values. Returns true if its primitives
+		// can be culled, which requires them to be rasterized with exact interpolated depth (cullable),
+		// and fills in the test. Tiles only get lowered when every covered pixel writes depth (exactCoverage).
+		bool beginDraw(Test &test, DepthCompareMode depthCompareMode, bool depthWriteEnable, bool cullable, bool exactCoverage);
+
+		// Returns true if the primitive is occluded. Otherwise occluded rows of tiles are removed from its
+		// vertical range, and tiles covered entirely by the (clipped) triangle get lowered.
+		bool cull(Primitive &primitive, const Triangle &triangle, const Polygon &polygon, const DrawData &data, const Test &test);
+
+	private:
+		const int width;
+		const int height;
+		const int tilesX;
+		const int tilesY;
+
+		// Depth bits in the lower half, serial of the draw call which lowered it in the upper half
+		std::atomic<uint64_t> *tile;
+
+		std::atomic<bool> valid;
+
+		static std::atomic<unsigned int> serialCounter;
+	};
+}
+
+#endif   // sw_HierarchicalZ_hpp
@@ -19,6 +19,14 @@
 
 namespace sw
 {
+	struct CacheStatistics
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+	};
+
+	// Keys provide a precomputed hash member, and an equality operator.
 	template<class Key, class Data>
 	class LRUCache
 	{
@@ -27,21 +35,38 @@ namespace sw
 
 		~LRUCache();
 
-		Data *query(const Key &key) const;
+		Data *query(const Key &key);
 		Data *add(const Key &key, Data *data);
 	
 		int getSize() {return size;}
-		Key &getKey(int i) {return key[i];}
+		const CacheStatistics &getStatistics() const {return statistics;}
 
 	private:
+		struct Entry
+		{
+			Key key;
+			Data *data;
+
+			int next;    // Less recently used
+			int prev;    // More recently used
+			int chain;   // Next entry in the same bucket
+		};
+
+		int find(const Key &key) const;
+		void unlink(int i);
+		void pushFront(int i);
+
 		int size;
 		int mask;
-		int top;
 		int fill;
 
-		Key *key;
-		Key **ref;
-		Data **data;
+		int head;   // Most recently used
+		int tail;   // Least recently used
+
+		Entry *entry;
+		int *bucket;
+
+		CacheStatistics statistics;
 	};
 }
 
@@ -52,93 +77,166 @@ namespace sw
 	{
 		size = ceilPow2(n);
 		mask = size - 1;
-		top = 0;
 		fill = 0;
 
-		key = new Key[size];
-		ref = new Key*[size];
-		data = new Data*[size];
+		head = -1;
+		tail = -1;
+
+		entry = new Entry[size];
+		bucket = new int[size];
 
 		for(int i = 0; i < size; i++)
 		{
-			data[i] = nullptr;
-
-			ref[i] = &key[i];
+			entry[i].data = nullptr;
+			bucket[i] = -1;
 		}
+
+		statistics.hits = 0;
+		statistics.misses = 0;
+		statistics.evictions = 0;
 	}
 
 	template<class Key, class Data>
 	LRUCache<Key, Data>::~LRUCache()
 	{
-		delete[] key;
-		key = nullptr;
-
-		delete[] ref;
-		ref = nullptr;
-
 		for(int i = 0; i < size; i++)
 		{
-			if(data[i])
+			if(entry[i].data)
 			{
-				data[i]->unbind();
-				data[i] = nullptr;
+				entry[i].data->unbind();
+				entry[i].data = nullptr;
 			}
 		}
 
-		delete[] data;
-		data = nullptr;
+		delete[] entry;
+		entry = nullptr;
+
+		delete[] bucket;
+		bucket = nullptr;
 	}
 
 	template<class Key, class Data>
-	Data *LRUCache<Key, Data>::query(const Key &key) const
+	Data *LRUCache<Key, Data>::query(const Key &key)
 	{
-		for(int i = top; i > top - fill; i--)
+		int i = find(key);
+
+		if(i == -1)
 		{
-			int j = i & mask;
+			statistics.misses++;
 
-			if(key == *ref[j])
-			{
-				Data *hit = data[j];
+			return nullptr;   // Not found
+		}
 
-				if(i != top)
-				{
-					// Move one up
-					int k = (j + 1) & mask;
+		statistics.hits++;
+
+		if(i != head)
+		{
+			unlink(i);
+			pushFront(i);
+		}
+
+		return entry[i].data;
+	}
+
+	template<class Key, class Data>
+	Data *LRUCache<Key, Data>::add(const Key &key, Data *data)
+	{
+		data->bind();
+
+		int i = find(key);
+
+		if(i != -1)   // Replace
+		{
+			entry[i].data->unbind();
+			unlink(i);
+		}
+		else
+		{
+			if(fill < size)
+			{
+				i = fill++;
+			}
+			else   // Evict the least recently used entry
+			{
+				i = tail;
+				unlink(i);
 
-					Data *swapD = data[k];
-					data[k] = data[j];
-					data[j] = swapD;
+				int *link = &bucket[entry[i].key.hash & mask];
 
-					Key *swapK = ref[k];
-					ref[k] = ref[j];
-					ref[j] = swapK;
+				while(*link != i)
+				{
+					link = &entry[*link].chain;
 				}
 
-				return hit;
+				*link = entry[i].chain;
+
+				entry[i].data->unbind();
+				statistics.evictions++;
 			}
+
+			entry[i].key = key;
+			entry[i].chain = bucket[key.hash & mask];
+			bucket[key.hash & mask] = i;
 		}
 
-		return nullptr;   // Not found
+		entry[i].data = data;
+		pushFront(i);
+
+		return data;
 	}
 
 	template<class Key, class Data>
-	Data *LRUCache<Key, Data>::add(const Key &key, Data *data)
+	int LRUCache<Key, Data>::find(const Key &key) const
 	{
-		top = (top + 1) & mask;
-		fill = fill + 1 < size ? fill + 1 : size;
+		for(int i = bucket[key.hash & mask]; i != -1; i = entry[i].chain)
+		{
+			if(key == entry[i].key)
+			{
+				return i;
+			}
+		}
 
-		*ref[top] = key;
+		return -1;
+	}
 
-		data->bind();
+	template<class Key, class Data>
+	void LRUCache<Key, Data>::unlink(int i)
+	{
+		if(entry[i].prev != -1)
+		{
+			entry[entry[i].prev].next = entry[i].next;
+		}
+		else
+		{
+			head = entry[i].next;
+		}
 
-		if(this->data[top])
+		if(entry[i].next != -1)
+		{
+			entry[entry[i].next].prev = entry[i].prev;
+		}
+		else
 		{
-			this->data[top]->unbind();
+			tail = entry[i].prev;
 		}
+	}
 
-		this->data[top] = data;
+	template<class Key, class Data>
+	void LRUCache<Key, Data>::pushFront(int i)
+	{
+		entry[i].prev = -1;
+		entry[i].next = head;
 
-		return data;
+		if(head != -1)
+		{
+			entry[head].prev = i;
+		}
+		else
+		{
+			tail = i;
+		}
+
+		head = i;
 	}
 }
 
@@ -16,6 +16,7 @@
 
 #include "Surface.hpp"
 #include "Primitive.hpp"
+#include "RoutineArchive.hpp"
 #include "Shader/PixelPipeline.hpp"
 #include "Shader/PixelProgram.hpp"
 #include "Shader/PixelShader.hpp"
@@ -32,17 +33,31 @@ namespace sw
 
 	bool precachePixel = false;
 
-	unsigned int PixelProcessor::States::computeHash()
-	{
-		unsigned int *state = (unsigned int*)this;
-		unsigned int hash = 0;
+	#if ROUTINE_ARCHIVE
+		static RoutineArchive &archive()
+		{
+			static RoutineArchive archive("sw-pixel");   // Shared by all renderers
+			return archive;
+		}
 
-		for(unsigned int i = 0; i < sizeof(States) / 4; i++)
+		static std::vector<unsigned char> archiveKey(const PixelProcessor::State &state, const PixelShader *shader)
 		{
-			hash ^= state[i];
+			std::vector<unsigned char> key(sizeof(PixelProcessor::States) + sizeof(uint64_t));
+
+			PixelProcessor::States &states = *reinterpret_cast<PixelProcessor::States*>(&key[0]);
+			memcpy(&states, static_cast<const PixelProcessor::States*>(&state), sizeof(PixelProcessor::States));
+			states.shaderID = 0;   // Only unique within the process
+
+			uint64_t shaderHash = shader ? shader->getContentHash() : 0;
+			memcpy(&key[sizeof(PixelProcessor::States)], &shaderHash, sizeof(uint64_t));
+
+			return key;
 		}
+	#endif
 
-		return hash;
+	unsigned int PixelProcessor::States::computeHash()
+	{
+		return FNV_1a((const unsigned int*)this, sizeof(States) / 4);
 	}
 
 	PixelProcessor::State::State()
@@ -74,6 +89,8 @@ namespace sw
 
 		routineCache = 0;
 		setRoutineCacheSize(1024);
+
+		routineCompiler = nullptr;
 	}
 
 	PixelProcessor::~PixelProcessor()
@@ -923,7 +940,17 @@ namespace sw
 	void PixelProcessor::setRoutineCacheSize(int cacheSize)
 	{
 		delete routineCache;
-		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precachePixel ? "sw-pixel" : 0);
+		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536));
+	}
+
+	void PixelProcessor::setRoutineCompiler(RoutineCompiler *compiler)
+	{
+		routineCompiler = compiler;
+	}
+
+	const CacheStatistics &PixelProcessor::getRoutineCacheStatistics() const
+	{
+		return routineCache->getStatistics();
 	}
 
 	void PixelProcessor::setFogRanges(float start, float end)
@@ -1176,25 +1203,65 @@ namespace sw
 
 		if(!routine)
 		{
-			const bool integerPipeline = (context->pixelShaderModel() <= 0x0104);
-			QuadRasterizer *generator = nullptr;
-
-			if(integerPipeline)
+			if(routineCompiler)
 			{
-				generator = new PixelPipeline(state, context->pixelShader);
+				routine = routineCompiler->compile(generate, state, context->pixelShader);
 			}
 			else
 			{
-				generator = new PixelProgram(state, context->pixelShader);
+				routine = generate(state, context->pixelShader);
 			}
 
-			generator->generate();
-			routine = (*generator)(L"PixelRoutine_%0.8X", state.shaderID);
-			delete generator;
-
 			routineCache->add(state, routine);
+
+			if(routineCompiler)
+			{
+				routine->unbind();   // Now referenced by the cache
+			}
 		}
 
 		return routine;
 	}
+
+	Routine *PixelProcessor::generate(const State &state, const PixelShader *shader)
+	{
+		#if ROUTINE_ARCHIVE
+			std::vector<unsigned char> key;
+
+			if(precachePixel)
+			{
+				key = archiveKey(state, shader);
+
+				if(Routine *routine = archive().load(key))
+				{
+					return routine;
+				}
+			}
+		#endif
+
+		const bool integerPipeline = !shader || (shader->getShaderModel() <= 0x0104);
+		QuadRasterizer *generator = nullptr;
+
+		if(integerPipeline)
+		{
+			generator = new PixelPipeline(state, shader);
+		}
+		else
+		{
+			generator = new PixelProgram(state, shader);
+		}
+
+		generator->generate();
+		Routine *routine = (*generator)(L"PixelRoutine_%0.8X", state.shaderID);
+		delete generator;
+
+		#if ROUTINE_ARCHIVE
+			if(precachePixel)
+			{
+				archive().store(key, routine);
+			}
+		#endif
+
+		return routine;
+	}
 }
@@ -17,6 +17,7 @@
 
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "RoutineCompiler.hpp"
 
 namespace sw
 {
@@ -306,6 +307,8 @@ namespace sw
 		const State update() const;
 		Routine *routine(const State &state);
 		void setRoutineCacheSize(int routineCacheSize);
+		void setRoutineCompiler(RoutineCompiler *compiler);
+		const CacheStatistics &getRoutineCacheStatistics() const;
 
 		// Shader constants
 		word4 cW[8][4];
@@ -331,9 +334,12 @@ namespace sw
 
 		void setFogRanges(float start, float end);
 
+		static Routine *generate(const State &state, const PixelShader *shader);
+
 		Context *const context;
 
 		RoutineCache<State> *routineCache;
+		RoutineCompiler *routineCompiler;   // Null unless compiling asynchronously
 	};
 }
 
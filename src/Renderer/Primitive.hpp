@@ -69,11 +69,32 @@ namespace sw
 			unsigned short right;
 		};
 
+		// Non-horizontal polygon edge, in the incremental form used to walk it one scanline at a time
+		struct Edge
+		{
+			int y1;     // First scanline
+			int y2;     // Scanline past the last one
+			int x;      // Ceiled edge position at y1
+			int d;      // Error-term
+			int Q;      // Edge-step
+			int R;      // Error-step
+			int D;      // Error-overflow
+			int side;   // Offset of the left or right end of the span
+		};
+
+		int edgeCount;
+		int xFill;   // Initial span position of multisample outlines
+		Edge edge[16];
+	};
+
+	// Scanline spans of a primitive, built from its edges by the pixel cluster rasterizing it
+	struct Outline
+	{
 		// The rasterizer adds a zero length span to the top and bottom of the polygon to allow
 		// for 2x2 pixel processing. We need an even number of spans to keep accesses aligned.
-		Span outlineUnderflow[2];
-		Span outline[OUTLINE_RESOLUTION];
-		Span outlineOverflow[2];
+		Primitive::Span underflow[2];
+		Primitive::Span span[OUTLINE_RESOLUTION];
+		Primitive::Span overflow[2];
 	};
 }
 
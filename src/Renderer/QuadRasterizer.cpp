@@ -17,6 +17,7 @@
 #include "Primitive.hpp"
 #include "Renderer.hpp"
 #include "Shader/Constants.hpp"
+#include "Shader/SetupRoutine.hpp"
 #include "Common/Math.hpp"
 #include "Common/Debug.hpp"
 
@@ -26,8 +27,6 @@ namespace sw
 	extern bool complementaryDepthBuffer;
 	extern bool fullPixelPositionRegister;
 
-	extern int clusterCount;
-
 	QuadRasterizer::QuadRasterizer(const PixelProcessor::State &state, const PixelShader *pixelShader) : state(state), shader(pixelShader)
 	{
 	}
@@ -48,22 +47,32 @@ namespace sw
 		#endif
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
+		outline = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,outline)) + cluster * (int)(4 * sizeof(Outline));
 		occlusion = 0;
-		int clusterCount = Renderer::getClusterCount();
+		Int clusterCount = *Pointer<Int>(data + OFFSET(DrawData,clusterCount));
+		Int binHeight = *Pointer<Int>(data + OFFSET(DrawData,binHeight));
+		Int binPeriod = clusterCount * binHeight;   // Each cluster owns one bin of scanlines per period
+		Int binStart = cluster * binHeight;
 
 		Do
 		{
 			Int yMin = *Pointer<Int>(primitive + OFFSET(Primitive,yMin));
 			Int yMax = *Pointer<Int>(primitive + OFFSET(Primitive,yMax));
 
-			Int cluster2 = cluster + cluster;
-			yMin += clusterCount * 2 - 2 - cluster2;
-			yMin &= -clusterCount * 2;
-			yMin += cluster2;
+			// Start at the first scanline pair of this cluster's bins which isn't above the primitive
+			Int y = (yMin & -binPeriod) + binStart;
 
-			If(yMin < yMax)
+			If(y + binHeight <= yMin)
 			{
-				rasterize(yMin, yMax);
+				y += binPeriod;
+			}
+
+			y = Max(y, yMin & 0xFFFFFFFE);
+
+			If(y < yMax)
+			{
+				walkEdges(yMin, yMax);
+				rasterize(y, yMax);
 			}
 
 			primitive += sizeof(Primitive) * state.multiSample;
@@ -90,6 +99,113 @@ namespace sw
 		Return();
 	}
 
+	void QuadRasterizer::walkEdges(Int &yMin, Int &yMax)
+	{
+		Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
+		Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
+
+		// Only the scanlines in this cluster's bins are walked
+		Int binHeight = *Pointer<Int>(data + OFFSET(DrawData,binHeight));
+		Int binPeriod = *Pointer<Int>(data + OFFSET(DrawData,clusterCount)) * binHeight;
+		Int binStart = cluster * binHeight;
+		Int binSkip = binPeriod - binHeight;   // Scanlines owned by other clusters
+
+		auto firstScanline = [&](const Int &y)   // First scanline of this cluster at or below y
+		{
+			Int first = (y & -binPeriod) + binStart;
+			first = IfThenElse(first + binHeight <= y, first + binPeriod, first);
+
+			return Max(first, y);
+		};
+
+		for(unsigned int q = 0; q < state.multiSample; q++)
+		{
+			Pointer<Byte> span = outline + q * sizeof(Outline) + OFFSET(Outline,span);
+
+			if(state.multiSample > 1)
+			{
+				Short x = Short(*Pointer<Int>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,xFill)));
+
+				Int y = firstScanline(yMin - 1);
+
+				While(y < yMax + 1)
+				{
+					Int binEnd = Min((y | (binHeight - 1)) + 1, yMax + 1);
+
+					For(, y < binEnd, y++)
+					{
+						*Pointer<Short>(span + y * sizeof(Primitive::Span) + OFFSET(Primitive::Span,left)) = x;
+						*Pointer<Short>(span + y * sizeof(Primitive::Span) + OFFSET(Primitive::Span,right)) = x;
+					}
+
+					y += binSkip;
+				}
+			}
+
+			Int edgeCount = *Pointer<Int>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,edgeCount));
+			Pointer<Byte> edge = primitive + q * sizeof(Primitive) + OFFSET(Primitive,edge);
+
+			For(Int i = 0, i < edgeCount, i++)
+			{
+				Int y1 = *Pointer<Int>(edge + OFFSET(Primitive::Edge,y1));
+				Int y2 = Min(*Pointer<Int>(edge + OFFSET(Primitive::Edge,y2)), yMax + 1);
+				Int y = firstScanline(Max(y1, yMin - 1));
+
+				If(y < y2)
+				{
+					Int x = *Pointer<Int>(edge + OFFSET(Primitive::Edge,x));
+					Int d = *Pointer<Int>(edge + OFFSET(Primitive::Edge,d));
+					Int Q = *Pointer<Int>(edge + OFFSET(Primitive::Edge,Q));
+					Int R = *Pointer<Int>(edge + OFFSET(Primitive::Edge,R));
+					Int D = *Pointer<Int>(edge + OFFSET(Primitive::Edge,D));
+					Pointer<Byte> side = span + *Pointer<Int>(edge + OFFSET(Primitive::Edge,side));
+
+					Int Qk;
+					Int Rk;
+					SetupRoutine::edgeStep(Qk, Rk, Q, R, D, y - y1);
+					SetupRoutine::stepEdge(x, d, Qk, Rk, D);
+
+					Int Qs;
+					Int Rs;
+					SetupRoutine::edgeStep(Qs, Rs, Q, R, D, binSkip);
+
+					Do
+					{
+						Int binEnd = Min((y | (binHeight - 1)) + 1, y2);
+
+						Do
+						{
+							*Pointer<Short>(side + y * sizeof(Primitive::Span)) = Short(Clamp(x, xMin, xMax));
+
+							SetupRoutine::stepEdge(x, d, Q, R, D);
+
+							y++;
+						}
+						Until(y >= binEnd)
+
+						SetupRoutine::stepEdge(x, d, Qs, Rs, D);
+						y += binSkip;
+					}
+					Until(y >= y2)
+				}
+
+				edge += sizeof(Primitive::Edge);
+			}
+
+			if(state.multiSample == 1)
+			{
+				// Zero length spans above and below the polygon
+				Short xTop = *Pointer<Short>(span + yMin * sizeof(Primitive::Span) + OFFSET(Primitive::Span,left));
+				Short xBottom = *Pointer<Short>(span + (yMax - 1) * sizeof(Primitive::Span) + OFFSET(Primitive::Span,left));
+
+				*Pointer<Short>(span + (yMin - 1) * sizeof(Primitive::Span) + OFFSET(Primitive::Span,left)) = xTop;
+				*Pointer<Short>(span + (yMin - 1) * sizeof(Primitive::Span) + OFFSET(Primitive::Span,right)) = xTop;
+				*Pointer<Short>(span + yMax * sizeof(Primitive::Span) + OFFSET(Primitive::Span,left)) = xBottom;
+				*Pointer<Short>(span + yMax * sizeof(Primitive::Span) + OFFSET(Primitive::Span,right)) = xBottom;
+			}
+		}
+	}
+
 	void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 	{
 		Pointer<Byte> cBuffer[RENDERTARGETS];
@@ -114,31 +230,34 @@ namespace sw
 			sBuffer = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,stencilBuffer)) + yMin * *Pointer<Int>(data + OFFSET(DrawData,stencilPitchB));
 		}
 
+		Int binHeight = *Pointer<Int>(data + OFFSET(DrawData,binHeight));
+		Int binSkip = (*Pointer<Int>(data + OFFSET(DrawData,clusterCount)) - 1) * binHeight;   // Scanlines owned by other clusters
+
 		Int y = yMin;
 
 		Do
 		{
-			Int x0a = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->left) + (y + 0) * sizeof(Primitive::Span)));
-			Int x0b = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->left) + (y + 1) * sizeof(Primitive::Span)));
+			Int x0a = Int(*Pointer<Short>(outline + OFFSET(Outline,span->left) + (y + 0) * sizeof(Primitive::Span)));
+			Int x0b = Int(*Pointer<Short>(outline + OFFSET(Outline,span->left) + (y + 1) * sizeof(Primitive::Span)));
 			Int x0 = Min(x0a, x0b);
 
 			for(unsigned int q = 1; q < state.multiSample; q++)
 			{
-				x0a = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->left) + (y + 0) * sizeof(Primitive::Span)));
-				x0b = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->left) + (y + 1) * sizeof(Primitive::Span)));
+				x0a = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span->left) + (y + 0) * sizeof(Primitive::Span)));
+				x0b = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span->left) + (y + 1) * sizeof(Primitive::Span)));
 				x0 = Min(x0, Min(x0a, x0b));
 			}
 
 			x0 &= 0xFFFFFFFE;
 
-			Int x1a = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->right) + (y + 0) * sizeof(Primitive::Span)));
-			Int x1b = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->right) + (y + 1) * sizeof(Primitive::Span)));
+			Int x1a = Int(*Pointer<Short>(outline + OFFSET(Outline,span->right) + (y + 0) * sizeof(Primitive::Span)));
+			Int x1b = Int(*Pointer<Short>(outline + OFFSET(Outline,span->right) + (y + 1) * sizeof(Primitive::Span)));
 			Int x1 = Max(x1a, x1b);
 
 			for(unsigned int q = 1; q < state.multiSample; q++)
 			{
-				x1a = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->right) + (y + 0) * sizeof(Primitive::Span)));
-				x1b = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->right) + (y + 1) * sizeof(Primitive::Span)));
+				x1a = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span->right) + (y + 0) * sizeof(Primitive::Span)));
+				x1b = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span->right) + (y + 1) * sizeof(Primitive::Span)));
 				x1 = Max(x1, Max(x1a, x1b));
 			}
 
@@ -269,7 +388,7 @@ namespace sw
 
 				for(unsigned int q = 0; q < state.multiSample; q++)
 				{
-					xLeft[q] = *Pointer<Short4>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline) + y * sizeof(Primitive::Span));
+					xLeft[q] = *Pointer<Short4>(outline + q * sizeof(Outline) + OFFSET(Outline,span) + y * sizeof(Primitive::Span));
 					xRight[q] = xLeft[q];
 
 					xLeft[q] = Swizzle(xLeft[q], 0xA0) - Short4(1, 2, 1, 2);
@@ -291,27 +410,32 @@ namespace sw
 				}
 			}
 
-			int clusterCount = Renderer::getClusterCount();
+			Int step = 2;
+
+			If(((y + 2) & (binHeight - 1)) == 0)   // End of this cluster's bin
+			{
+				step += binSkip;
+			}
 
 			for(int index = 0; index < RENDERTARGETS; index++)
 			{
 				if(state.colorWriteActive(index))
 				{
-					cBuffer[index] += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index])) << (1 + sw::log2(clusterCount));   // FIXME: Precompute
+					cBuffer[index] += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index])) * step;
 				}
 			}
 
 			if(state.depthTestActive)
 			{
-				zBuffer += *Pointer<Int>(data + OFFSET(DrawData,depthPitchB)) << (1 + sw::log2(clusterCount));   // FIXME: Precompute
+				zBuffer += *Pointer<Int>(data + OFFSET(DrawData,depthPitchB)) * step;
 			}
 
 			if(state.stencilActive)
 			{
-				sBuffer += *Pointer<Int>(data + OFFSET(DrawData,stencilPitchB)) << (1 + sw::log2(clusterCount));   // FIXME: Precompute
+				sBuffer += *Pointer<Int>(data + OFFSET(DrawData,stencilPitchB)) * step;
 			}
 
-			y += 2 * clusterCount;
+			y += step;
 		}
 		Until(y >= yMax)
 	}
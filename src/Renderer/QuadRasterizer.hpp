@@ -32,6 +32,7 @@ namespace sw
 
 	protected:
 		Pointer<Byte> constants;
+		Pointer<Byte> outline;
 
 		Float4 Dz[4];
 		Float4 Dw;
@@ -54,6 +55,7 @@ namespace sw
 		const PixelShader *const shader;
 
 	private:
+		void walkEdges(Int &yMin, Int &yMax);
 		void rasterize(Int &yMin, Int &yMax);
 	};
 }
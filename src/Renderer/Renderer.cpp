@@ -31,6 +31,8 @@
 #include "Common/Timer.hpp"
 #include "Common/Debug.hpp"
 
+#include <string.h>
+
 #undef max
 
 bool disableServer = true;
@@ -56,15 +58,13 @@ namespace sw
 	extern bool exactColorRounding;
 	extern TransparencyAntialiasing transparencyAntialiasing;
 	extern bool forceClearRegisters;
+	extern bool shaderOptimization;
+	extern bool hierarchicalZCulling;
 
 	extern bool precacheVertex;
 	extern bool precacheSetup;
 	extern bool precachePixel;
-
-	static const int batchSize = 128;
-	AtomicInt threadCount(1);
-	AtomicInt Renderer::unitCount(1);
-	AtomicInt Renderer::clusterCount(1);
+	extern bool precacheBlitter;
 
 	TranscendentalPrecision logPrecision = ACCURATE;
 	TranscendentalPrecision expPrecision = ACCURATE;
@@ -78,6 +78,51 @@ namespace sw
 		int threadIndex;
 	};
 
+	// Tasks are passed through the work-stealing deques as a single integer
+	static inline int packTask(int type, int unit, int cluster)
+	{
+		return type | (unit << 4) | (cluster << 16);
+	}
+
+	// Compacts a batch's indices to its unique vertices, and returns their number
+	static unsigned int deduplicateVertices(VertexBatch &vertexBatch, const unsigned int *index, unsigned int count)
+	{
+		const unsigned int tableSize = 1024;   // Power of two, well above the batch size to keep probe sequences short
+		unsigned short table[tableSize];       // Unique vertex plus one, or zero when empty
+		static_assert(BATCH_SIZE * 3 <= tableSize / 2, "The hash table must stay sparse");
+		memset(table, 0, sizeof(table));
+
+		unsigned int uniqueCount = 0;
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			unsigned int slot = (index[i] * 0x9E3779B1) >> 22;   // Fibonacci hashing
+
+			while(table[slot] != 0 && vertexBatch.index[table[slot] - 1] != index[i])
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+
+			if(table[slot] == 0)
+			{
+				vertexBatch.index[uniqueCount] = index[i];
+				table[slot] = ++uniqueCount;
+			}
+
+			vertexBatch.corner[i] = table[slot] - 1;
+		}
+
+		vertexBatch.cornerCount = count;
+
+		// Fill the last group of four by repeating its first vertex
+		for(unsigned int i = uniqueCount; i % 4 != 0; i++)
+		{
+			vertexBatch.index[i] = vertexBatch.index[uniqueCount & ~3];
+		}
+
+		return uniqueCount;
+	}
+
 	DrawCall::DrawCall()
 	{
 		queries = 0;
@@ -117,24 +162,29 @@ namespace sw
 		setRenderTarget(0, 0);
 		clipper = new Clipper(symmetricNormalizedDepth);
 		blitter = new Blitter;
+		routineCompiler = nullptr;
 
 		updateViewMatrix = true;
 		updateBaseMatrix = true;
 		updateProjectionMatrix = true;
 		updateClipPlanes = true;
 
+		threadCount = 1;
+		vertexCacheStatistics = CacheStatistics();
+		unitCount = 1;
+		clusterCount = 1;
+		binHeight = 2;
+
 		#if PERF_HUD
 			resetTimers();
 		#endif
 
-		for(int i = 0; i < 16; i++)
-		{
-			vertexTask[i] = 0;
-
-			worker[i] = 0;
-			resume[i] = 0;
-			suspend[i] = 0;
-		}
+		vertexTask = 0;
+		worker = 0;
+		resume = 0;
+		suspend = 0;
+		task = 0;
+		taskDeque = 0;
 
 		threadsAwake = 0;
 		resumeApp = new Event();
@@ -142,14 +192,14 @@ namespace sw
 		currentDraw = 0;
 		nextDraw = 0;
 
-		qHead = 0;
-		qSize = 0;
+		scanning = 0;
+		scanRequests = 0;
 
-		for(int i = 0; i < 16; i++)
-		{
-			triangleBatch[i] = 0;
-			primitiveBatch[i] = 0;
-		}
+		triangleBatch = 0;
+		primitiveBatch = 0;
+		outline = 0;
+		primitiveProgress = 0;
+		pixelProgress = 0;
 
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
@@ -157,16 +207,6 @@ namespace sw
 			drawList[draw] = drawCall[draw];
 		}
 
-		for(int unit = 0; unit < 16; unit++)
-		{
-			primitiveProgress[unit].init();
-		}
-
-		for(int cluster = 0; cluster < 16; cluster++)
-		{
-			pixelProgress[cluster].init();
-		}
-
 		clipFlags = 0;
 
 		swiftConfig = new SwiftConfig(disableServer);
@@ -188,6 +228,9 @@ namespace sw
 		terminateThreads();
 		delete resumeApp;
 
+		delete routineCompiler;
+		routineCompiler = nullptr;
+
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
 			delete drawCall[draw];
@@ -248,7 +291,7 @@ namespace sw
 				pixelRoutine = PixelProcessor::routine(pixelState);
 			}
 
-			int batch = batchSize / ms;
+			int batch = BATCH_SIZE / ms;
 
 			int (Renderer::*setupPrimitives)(int batch, int count);
 
@@ -321,6 +364,9 @@ namespace sw
 
 			draw->drawType = drawType;
 			draw->batchSize = batch;
+			draw->deduplicateVertices = vertexState.deduplicate;
+			draw->vertexCacheSize = vertexState.vertexCacheSize;
+			draw->vertexCacheAssociativity = vertexState.vertexCacheAssociativity;
 
 			vertexRoutine->bind();
 			setupRoutine->bind();
@@ -340,6 +386,7 @@ namespace sw
 				draw->vertexStream[i] = context->input[i].resource;
 				data->input[i] = context->input[i].buffer;
 				data->stride[i] = context->input[i].stride;
+				data->divisor[i] = context->input[i].divisor;
 
 				if(draw->vertexStream[i])
 				{
@@ -447,11 +494,6 @@ namespace sw
 					draw->vsDirtyConstB = 0;
 				}
 
-				if(context->vertexShader->isInstanceIdDeclared())
-				{
-					data->instanceID = context->instanceID;
-				}
-
 				VertexProcessor::lockUniformBuffers(data->vs.u, draw->vUniformBuffers);
 				VertexProcessor::lockTransformFeedbackBuffers(data->vs.t, data->vs.reg, data->vs.row, data->vs.col, data->vs.str, draw->transformFeedbackBuffers);
 			}
@@ -514,6 +556,10 @@ namespace sw
 				else ASSERT(false);
 			}
 
+			data->clusterCount = clusterCount;
+			data->binHeight = binHeight;
+			data->outline = outline;
+
 			if(pixelState.occlusionEnabled)
 			{
 				for(int cluster = 0; cluster < clusterCount; cluster++)
@@ -626,6 +672,21 @@ namespace sw
 					data->depthSliceB = context->depthBuffer->getInternalSliceB();
 				}
 
+				draw->hierarchicalZ = nullptr;
+
+				if(draw->depthBuffer && draw->depthBuffer->getHierarchicalZ())
+				{
+					HierarchicalZ *hierarchicalZ = draw->depthBuffer->getHierarchicalZ();
+					bool cullable = pixelState.depthTestActive && !pixelState.depthOverride && !pixelState.stencilActive &&
+					                setupState.interpolateZ && ms == 1 && ss == 1;
+					bool exactCoverage = !context->alphaTestActive() && !pixelState.shaderContainsKill;
+
+					if(hierarchicalZ->beginDraw(draw->hierarchicalZTest, pixelState.depthCompareMode, pixelState.depthWriteEnable, cullable, exactCoverage))
+					{
+						draw->hierarchicalZ = hierarchicalZ;
+					}
+				}
+
 				if(draw->stencilBuffer)
 				{
 					unsigned int layer = context->stencilBufferLayer;
@@ -645,13 +706,15 @@ namespace sw
 			}
 
 			draw->primitive = 0;
-			draw->count = count;
+			// Instances are rendered as one sequence of primitives, but batches don't straddle instances
+			draw->count = count * context->instanceCount;
+			draw->instancePrimitives = count;
 
-			draw->references = (count + batch - 1) / batch;
+			draw->references = context->instanceCount * ((count + batch - 1) / batch);
 
-			schedulerMutex.lock();
+			sleepMutex.lock();
 			++nextDraw; // Atomic
-			schedulerMutex.unlock();
+			sleepMutex.unlock();
 
 			#ifndef NDEBUG
 			if(threadCount == 1)   // Use main thread for draw execution
@@ -666,12 +729,7 @@ namespace sw
 			{
 				if(!threadsAwake)
 				{
-					suspend[0]->wait();
-
-					threadsAwake = 1;
-					task[0].type = Task::RESUME;
-
-					resume[0]->signal();
+					wakeThreads(1);   // Also called by the routine compiler's threads
 				}
 			}
 		}
@@ -692,6 +750,11 @@ namespace sw
 		blitter->blit3D(source, dest);
 	}
 
+	void Renderer::downsample(Surface *const *sources, Surface *const *dests, int count, bool volume)
+	{
+		blitter->downsample(sources, dests, count, volume);
+	}
+
 	void Renderer::threadFunction(void *parameters)
 	{
 		Renderer *renderer = static_cast<Parameters*>(parameters)->renderer;
@@ -706,6 +769,21 @@ namespace sw
 		renderer->threadLoop(threadIndex);
 	}
 
+	void Renderer::routineCompiled(void *parameters)
+	{
+		Renderer *renderer = static_cast<Renderer*>(parameters);
+
+		// Threads which suspended because a draw call's routines weren't compiled yet did so
+		// while holding this lock, so after taking it they are either awake or counted as asleep.
+		renderer->sleepMutex.lock();
+		renderer->sleepMutex.unlock();
+
+		if(!renderer->threadsAwake)
+		{
+			renderer->wakeThreads(1);
+		}
+	}
+
 	void Renderer::threadLoop(int threadIndex)
 	{
 		while(!exitThreads)
@@ -726,8 +804,10 @@ namespace sw
 		}
 	}
 
-	void Renderer::findAvailableTasks()
+	int Renderer::findAvailableTasks(TaskDeque &deque)
 	{
+		int found = 0;
+
 		// Find pixel tasks
 		for(int cluster = 0; cluster < clusterCount; cluster++)
 		{
@@ -741,16 +821,11 @@ namespace sw
 						{
 							if(pixelProgress[cluster].processedPrimitives == primitiveProgress[unit].firstPrimitive)   // Previous primitives have been rendered
 							{
-								Task &task = taskQueue[qHead];
-								task.type = Task::PIXELS;
-								task.primitiveUnit = unit;
-								task.pixelCluster = cluster;
-
 								pixelProgress[cluster].executing = true;
 
 								// Commit to the task queue
-								qHead = (qHead + 1) & TASK_COUNT_BITS;
-								qSize++;
+								deque.push(packTask(Task::PIXELS, unit, cluster));
+								found++;
 
 								break;
 							}
@@ -763,7 +838,7 @@ namespace sw
 		// Find primitive tasks
 		if(currentDraw == nextDraw)
 		{
-			return;   // No more primitives to process
+			return found;   // No more primitives to process
 		}
 
 		for(int unit = 0; unit < unitCount; unit++)
@@ -779,79 +854,147 @@ namespace sw
 
 				if(currentDraw == nextDraw)
 				{
-					return;   // No more primitives to process
+					return found;   // No more primitives to process
 				}
 
 				draw = drawList[currentDraw & DRAW_COUNT_BITS];
 			}
 
+			if(!resolveRoutines(draw))
+			{
+				return found;   // Wait for the draw call's routines to be compiled
+			}
+
 			if(!primitiveProgress[unit].references)   // Task not already being executed and not still in use by a pixel unit
 			{
 				primitive = draw->primitive;
 				count = draw->count;
 				int batch = draw->batchSize;
 
+				int instanceEnd = (primitive / draw->instancePrimitives + 1) * draw->instancePrimitives;
+				int primitiveCount = instanceEnd - primitive >= batch ? batch : instanceEnd - primitive;
+
 				primitiveProgress[unit].drawCall = currentDraw;
 				primitiveProgress[unit].firstPrimitive = primitive;
-				primitiveProgress[unit].primitiveCount = count - primitive >= batch ? batch : count - primitive;
-
-				draw->primitive += batch;
+				primitiveProgress[unit].primitiveCount = primitiveCount;
 
-				Task &task = taskQueue[qHead];
-				task.type = Task::PRIMITIVES;
-				task.primitiveUnit = unit;
+				draw->primitive += primitiveCount;
 
 				primitiveProgress[unit].references = -1;
 
 				// Commit to the task queue
-				qHead = (qHead + 1) & TASK_COUNT_BITS;
-				qSize++;
+				deque.push(packTask(Task::PRIMITIVES, unit, 0));
+				found++;
 			}
 		}
+
+		return found;
 	}
 
-	void Renderer::scheduleTask(int threadIndex)
+	int Renderer::scanForTasks(int threadIndex)
 	{
-		schedulerMutex.lock();
+		int found = 0;
 
-		int curThreadsAwake = threadsAwake;
+		// Only one thread scans for new tasks at a time, and it only touches the progress
+		// state of units and clusters which are idle, so the ordering of pixel tasks is
+		// preserved without a global lock. A thread which finds another one already
+		// scanning leaves a request for it to scan again, so that tasks which became
+		// available after that scan started are not missed.
+		scanRequests = 1;
 
-		if((int)qSize < threadCount - curThreadsAwake + 1)
+		while(scanRequests && !scanning.exchange(1))
 		{
-			findAvailableTasks();
+			scanRequests = 0;
+			found += findAvailableTasks(*taskDeque[threadIndex]);
+			scanning.exchange(0);   // Read-modify-write, so the request check below can't be reordered before it
 		}
 
-		if(qSize != 0)
+		return found;
+	}
+
+	bool Renderer::dequeueTask(int threadIndex)
+	{
+		int packed;
+
+		if(!taskDeque[threadIndex]->pop(packed))
 		{
-			task[threadIndex] = taskQueue[(qHead - qSize) & TASK_COUNT_BITS];
-			qSize--;
+			bool stolen = false;
 
-			if(curThreadsAwake != threadCount)
+			for(int i = 1; i < threadCount && !stolen; i++)
 			{
-				int wakeup = qSize - curThreadsAwake + 1;
+				stolen = taskDeque[(threadIndex + i) % threadCount]->steal(packed);
+			}
 
-				for(int i = 0; i < threadCount && wakeup > 0; i++)
-				{
-					if(task[i].type == Task::SUSPEND)
-					{
-						suspend[i]->wait();
-						task[i].type = Task::RESUME;
-						resume[i]->signal();
+			if(!stolen)
+			{
+				return false;
+			}
+		}
 
-						++threadsAwake; // Atomic
-						wakeup--;
-					}
-				}
+		task[threadIndex].type = packed & 0xF;
+		task[threadIndex].primitiveUnit = (packed >> 4) & 0xFFF;
+		task[threadIndex].pixelCluster = packed >> 16;
+
+		return true;
+	}
+
+	void Renderer::wakeThreads(int count)
+	{
+		if(count <= 0 || threadsAwake == threadCount)
+		{
+			return;
+		}
+
+		sleepMutex.lock();
+
+		for(int i = 0; i < threadCount && count > 0; i++)
+		{
+			if(task[i].type == Task::SUSPEND)
+			{
+				suspend[i]->wait();
+				task[i].type = Task::RESUME;
+				resume[i]->signal();
+
+				++threadsAwake; // Atomic
+				count--;
 			}
 		}
-		else
+
+		sleepMutex.unlock();
+	}
+
+	void Renderer::scheduleTask(int threadIndex)
+	{
+		if(dequeueTask(threadIndex))
 		{
-			task[threadIndex].type = Task::SUSPEND;
+			return;
+		}
+
+		int found = scanForTasks(threadIndex);
+
+		if(!dequeueTask(threadIndex))
+		{
+			// Look once more while holding the lock which draw() takes to submit
+			// a draw call, so a thread can't suspend while new work goes unnoticed.
+			sleepMutex.lock();
+
+			found += scanForTasks(threadIndex);
+
+			if(!dequeueTask(threadIndex))
+			{
+				task[threadIndex].type = Task::SUSPEND;
+
+				--threadsAwake; // Atomic
+
+				sleepMutex.unlock();
 
-			--threadsAwake; // Atomic
+				return;
+			}
+
+			sleepMutex.unlock();
 		}
 
-		schedulerMutex.unlock();
+		wakeThreads(found - threadsAwake);   // This thread took one of the tasks itself
 	}
 
 	void Renderer::executeTask(int threadIndex)
@@ -871,7 +1014,7 @@ namespace sw
 				DrawCall *draw = drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
 				int (Renderer::*setupPrimitives)(int batch, int count) = draw->setupPrimitives;
 
-				processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
+				processPrimitiveVertices(unit, input, count, draw->instancePrimitives, threadIndex);
 
 				#if PERF_HUD
 					int64_t time = Timer::ticks();
@@ -886,6 +1029,19 @@ namespace sw
 					visible = (this->*setupPrimitives)(unit, count);
 				}
 
+				int yMin = 0x7FFFFFFF;
+				int yMax = 0;
+				int ms = draw->setupState.multiSample;
+
+				for(int i = 0; i < visible; i++)
+				{
+					const Primitive &primitive = primitiveBatch[unit][i * ms];
+					yMin = min(yMin, primitive.yMin);
+					yMax = max(yMax, primitive.yMax);
+				}
+
+				primitiveProgress[unit].yMin = yMin;
+				primitiveProgress[unit].yMax = yMax;
 				primitiveProgress[unit].visible = visible;
 				primitiveProgress[unit].references = clusterCount;
 
@@ -897,16 +1053,18 @@ namespace sw
 		case Task::PIXELS:
 			{
 				int unit = task[threadIndex].primitiveUnit;
+				int cluster = task[threadIndex].pixelCluster;
 				int visible = primitiveProgress[unit].visible;
 
-				if(visible > 0)
+				if(visible > 0 && clusterOverlaps(cluster, primitiveProgress[unit].yMin, primitiveProgress[unit].yMax))
 				{
-					int cluster = task[threadIndex].pixelCluster;
 					Primitive *primitive = primitiveBatch[unit];
 					DrawCall *draw = drawList[pixelProgress[cluster].drawCall & DRAW_COUNT_BITS];
 					DrawData *data = draw->data;
 					PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
 
+					materializeClears(*draw, primitiveProgress[unit].yMin, primitiveProgress[unit].yMax);
+
 					pixelRoutine(primitive, visible, cluster, data);
 				}
 
@@ -932,6 +1090,52 @@ namespace sw
 		sync->unlock();
 	}
 
+	bool Renderer::resolveRoutines(DrawCall *draw)
+	{
+		// Routines compiled in the background have no entry point until they are ready
+		if(!draw->vertexPointer) draw->vertexPointer = (VertexProcessor::RoutinePointer)draw->vertexRoutine->getEntry();
+		if(!draw->setupPointer) draw->setupPointer = (SetupProcessor::RoutinePointer)draw->setupRoutine->getEntry();
+		if(!draw->pixelPointer) draw->pixelPointer = (PixelProcessor::RoutinePointer)draw->pixelRoutine->getEntry();
+
+		return draw->vertexPointer && draw->setupPointer && draw->pixelPointer;
+	}
+
+	bool Renderer::clusterOverlaps(int cluster, int yMin, int yMax) const
+	{
+		if(yMin >= yMax)
+		{
+			return false;
+		}
+
+		int firstBin = yMin / binHeight;
+		int lastBin = (yMax - 1) / binHeight;
+
+		// Bins are assigned to clusters round-robin
+		return ((cluster - firstBin) & (clusterCount - 1)) <= lastBin - firstBin;
+	}
+
+	void Renderer::materializeClears(DrawCall &draw, int yMin, int yMax)
+	{
+		// Bands are shared by clusters, so whichever gets to a band first writes it
+		for(int i = 0; i < RENDERTARGETS; i++)
+		{
+			if(draw.renderTarget[i])
+			{
+				draw.renderTarget[i]->materializeClear(yMin, yMax);
+			}
+		}
+
+		if(draw.depthBuffer)
+		{
+			draw.depthBuffer->materializeClear(yMin, yMax);
+		}
+
+		if(draw.stencilBuffer)
+		{
+			draw.stencilBuffer->materializeStencilClear(yMin, yMax);
+		}
+	}
+
 	void Renderer::finishRendering(Task &pixelTask)
 	{
 		int unit = pixelTask.primitiveUnit;
@@ -1079,10 +1283,30 @@ namespace sw
 		const void *indices = data->indices;
 		VertexProcessor::RoutinePointer vertexRoutine = draw->vertexPointer;
 
-		if(task->vertexCache.drawCall != primitiveDrawCall)
+		unsigned int instanceID = start / loop;
+		unsigned int primitiveStart = start;
+		start -= instanceID * loop;   // First primitive within the instance
+
+		if(task->vertexCache.drawCall != primitiveDrawCall || task->instanceID != instanceID)
 		{
+			// The vertex routine indexes the cache with the geometry it was generated for
+			if(task->vertexCache.size != draw->vertexCacheSize || task->vertexCache.ways != draw->vertexCacheAssociativity)
+			{
+				task->vertexCache.deallocate();
+				task->vertexCache.allocate(draw->vertexCacheSize, draw->vertexCacheAssociativity);
+			}
+
 			task->vertexCache.clear();
 			task->vertexCache.drawCall = primitiveDrawCall;
+			task->instanceID = instanceID;
+
+			for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
+			{
+				if(data->divisor[i])
+				{
+					task->instanceInput[i] = (const char*)data->input[i] + (instanceID / data->divisor[i]) * data->stride[i];
+				}
+			}
 		}
 
 		unsigned int batch[128][3];   // FIXME: Adjust to dynamic batch size
@@ -1510,9 +1734,32 @@ namespace sw
 			return;
 		}
 
-		task->primitiveStart = start;
+		task->primitiveStart = primitiveStart;
+
+		if(draw->deduplicateVertices)
+		{
+			unsigned int vertexCount = triangleCount * 3;
+			unsigned int uniqueCount = deduplicateVertices(task->vertexBatch, &batch[0][0], vertexCount);
+
+			task->vertexCount = (uniqueCount + 3) & ~3;
+			vertexRoutine(&triangle->v0, task->vertexBatch.index, task, data);
+
+			task->vertexCacheStatistics.hits += vertexCount - uniqueCount;
+			task->vertexCacheStatistics.misses += uniqueCount;
+
+			return;
+		}
+
 		task->vertexCount = triangleCount * 3;
 		vertexRoutine(&triangle->v0, (unsigned int*)&batch, task, data);
+
+		// Accumulated per batch, so the routine's 32-bit counters can't overflow
+		VertexCache &cache = task->vertexCache;
+		task->vertexCacheStatistics.hits += triangleCount * 3 - cache.misses;
+		task->vertexCacheStatistics.misses += cache.misses;
+		task->vertexCacheStatistics.evictions += cache.evictions;
+		cache.misses = 0;
+		cache.evictions = 0;
 	}
 
 	int Renderer::setupSolidTriangles(int unit, int count)
@@ -1551,6 +1798,11 @@ namespace sw
 
 				if(setupRoutine(primitive, triangle, &polygon, data))
 				{
+					if(draw.hierarchicalZ && draw.hierarchicalZ->cull(*primitive, *triangle, polygon, *data, draw.hierarchicalZTest))
+					{
+						continue;
+					}
+
 					primitive += ms;
 					visible++;
 				}
@@ -1990,18 +2242,41 @@ namespace sw
 		unitCount = ceilPow2(threadCount);
 		clusterCount = ceilPow2(threadCount);
 
+		triangleBatch = new Triangle*[unitCount];
+		primitiveBatch = new Primitive*[unitCount];
+		primitiveProgress = new PrimitiveProgress[unitCount];
+
 		for(int i = 0; i < unitCount; i++)
 		{
-			triangleBatch[i] = (Triangle*)allocate(batchSize * sizeof(Triangle));
-			primitiveBatch[i] = (Primitive*)allocate(batchSize * sizeof(Primitive));
+			triangleBatch[i] = (Triangle*)allocate(BATCH_SIZE * sizeof(Triangle));
+			primitiveBatch[i] = (Primitive*)allocate(BATCH_SIZE * sizeof(Primitive));
+			primitiveProgress[i].init();
 		}
 
+		outline = (Outline*)allocate(clusterCount * 4 * sizeof(Outline));
+		pixelProgress = new PixelProgress[clusterCount];
+
+		for(int i = 0; i < clusterCount; i++)
+		{
+			pixelProgress[i].init();
+			pixelProgress[i].drawCall = nextDraw;   // Threads are only (re)started when all previous draws have been rendered
+		}
+
+		worker = new Thread*[threadCount];
+		resume = new Event*[threadCount];
+		suspend = new Event*[threadCount];
+		task = new Task[threadCount];
+		taskDeque = new TaskDeque*[threadCount];
+		vertexTask = new VertexTask*[threadCount];
+
 		for(int i = 0; i < threadCount; i++)
 		{
 			vertexTask[i] = (VertexTask*)allocate(sizeof(VertexTask));
-			vertexTask[i]->vertexCache.drawCall = -1;
+			vertexTask[i]->vertexCache.allocate(vertexCacheSize, vertexCacheAssociativity);
+			vertexTask[i]->vertexCacheStatistics = CacheStatistics();
 
 			task[i].type = Task::SUSPEND;
+			taskDeque[i] = new TaskDeque(ceilPow2(unitCount + clusterCount));
 
 			resume[i] = new Event();
 			suspend[i] = new Event();
@@ -2020,39 +2295,70 @@ namespace sw
 
 	void Renderer::terminateThreads()
 	{
+		if(routineCompiler)
+		{
+			routineCompiler->finish();   // Pending draw calls can't be rendered before this
+		}
+
 		while(threadsAwake != 0)
 		{
 			Thread::sleep(1);
 		}
 
+		if(!worker)
+		{
+			return;
+		}
+
 		for(int thread = 0; thread < threadCount; thread++)
 		{
-			if(worker[thread])
-			{
-				exitThreads = true;
-				resume[thread]->signal();
-				worker[thread]->join();
+			exitThreads = true;
+			resume[thread]->signal();
+			worker[thread]->join();
 
-				delete worker[thread];
-				worker[thread] = 0;
-				delete resume[thread];
-				resume[thread] = 0;
-				delete suspend[thread];
-				suspend[thread] = 0;
-			}
+			delete worker[thread];
+			delete resume[thread];
+			delete suspend[thread];
+			delete taskDeque[thread];
 
+			const CacheStatistics &statistics = vertexTask[thread]->vertexCacheStatistics;
+			vertexCacheStatistics.hits += statistics.hits;
+			vertexCacheStatistics.misses += statistics.misses;
+			vertexCacheStatistics.evictions += statistics.evictions;
+
+			vertexTask[thread]->vertexCache.deallocate();
 			deallocate(vertexTask[thread]);
-			vertexTask[thread] = 0;
 		}
 
-		for(int i = 0; i < 16; i++)
+		delete[] worker;
+		worker = 0;
+		delete[] resume;
+		resume = 0;
+		delete[] suspend;
+		suspend = 0;
+		delete[] task;
+		task = 0;
+		delete[] taskDeque;
+		taskDeque = 0;
+		delete[] vertexTask;
+		vertexTask = 0;
+
+		for(int i = 0; i < unitCount; i++)
 		{
 			deallocate(triangleBatch[i]);
-			triangleBatch[i] = 0;
-
 			deallocate(primitiveBatch[i]);
-			primitiveBatch[i] = 0;
 		}
+
+		delete[] triangleBatch;
+		triangleBatch = 0;
+		delete[] primitiveBatch;
+		primitiveBatch = 0;
+		deallocate(outline);
+		outline = 0;
+		delete[] primitiveProgress;
+		primitiveProgress = 0;
+		delete[] pixelProgress;
+		pixelProgress = 0;
 	}
 
 	void Renderer::loadConstants(const VertexShader *vertexShader)
@@ -2212,11 +2518,11 @@ namespace sw
 		context->texture[sampler] = resource;
 	}
 
-	void Renderer::setTextureLevel(unsigned int sampler, unsigned int face, unsigned int level, Surface *surface, TextureType type)
+	void Renderer::setTextureLevel(unsigned int sampler, unsigned int face, unsigned int level, Surface *surface, TextureType type, bool sampled)
 	{
 		ASSERT(sampler < TOTAL_IMAGE_UNITS && face < 6 && level < MIPMAP_LEVELS);
 
-		context->sampler[sampler].setTextureLevel(face, level, surface, type);
+		context->sampler[sampler].setTextureLevel(face, level, surface, type, sampled);
 	}
 
 	void Renderer::setTextureFilter(SamplerType type, int sampler, FilterType textureFilter)
@@ -2638,6 +2944,35 @@ namespace sw
 		queries.remove(query);
 	}
 
+	CacheStatistics Renderer::getVertexCacheStatistics() const
+	{
+		CacheStatistics statistics = vertexCacheStatistics;
+
+		for(int thread = 0; worker && thread < threadCount; thread++)
+		{
+			statistics.hits += vertexTask[thread]->vertexCacheStatistics.hits;
+			statistics.misses += vertexTask[thread]->vertexCacheStatistics.misses;
+			statistics.evictions += vertexTask[thread]->vertexCacheStatistics.evictions;
+		}
+
+		return statistics;
+	}
+
+	const CacheStatistics &Renderer::getVertexRoutineCacheStatistics() const
+	{
+		return VertexProcessor::getRoutineCacheStatistics();
+	}
+
+	const CacheStatistics &Renderer::getSetupRoutineCacheStatistics() const
+	{
+		return SetupProcessor::getRoutineCacheStatistics();
+	}
+
+	const CacheStatistics &Renderer::getPixelRoutineCacheStatistics() const
+	{
+		return PixelProcessor::getRoutineCacheStatistics();
+	}
+
 	#if PERF_HUD
 		int Renderer::getThreadCount()
 		{
@@ -2707,9 +3042,19 @@ namespace sw
 			SwiftConfig::Configuration configuration = {};
 			swiftConfig->getConfiguration(configuration);
 
-			precacheVertex = !newConfiguration && configuration.precache;
-			precacheSetup = !newConfiguration && configuration.precache;
-			precachePixel = !newConfiguration && configuration.precache;
+			// Archived routines are only reused when generated with the same settings
+			precacheVertex = configuration.precache;
+			precacheSetup = configuration.precache;
+			precachePixel = configuration.precache;
+			precacheBlitter = configuration.precache;
+
+			VertexProcessor::setVertexCache(configuration.vertexCacheSize, configuration.vertexCacheAssociativity);
+			vertexDeduplication = configuration.vertexDeduplication;
+
+			for(int i = 0; i < TOTAL_IMAGE_UNITS; i++)
+			{
+				context->sampler[i].setTextureTiling(configuration.textureTiling);
+			}
 
 			VertexProcessor::setRoutineCacheSize(configuration.vertexRoutineCacheSize);
 			PixelProcessor::setRoutineCacheSize(configuration.pixelRoutineCacheSize);
@@ -2786,6 +3131,40 @@ namespace sw
 			default: threadCount = configuration.threadCount; break;
 			}
 
+			threadCount = clamp(threadCount, 1, (int)MAX_THREADS);
+			blitter->setThreadCount(threadCount);
+			Surface::setThreadCount(threadCount);
+
+			// Clusters either interleave scanline pairs, or bin the render target into bands
+			// which stay resident in the cache of the thread rendering them.
+			binHeight = ceilPow2(clamp(configuration.binHeight, 2, 1024));
+			hierarchicalZCulling = configuration.hierarchicalZ;
+
+			// Debug builds render on the application thread when single-threaded, so
+			// there would be no worker to wake when a routine has been compiled.
+			bool asynchronousCompilation = configuration.asynchronousCompilation;
+
+			#ifndef NDEBUG
+				asynchronousCompilation = asynchronousCompilation && (threadCount != 1);
+			#endif
+
+			if(asynchronousCompilation && !routineCompiler)
+			{
+				routineCompiler = new RoutineCompiler(clamp(CPUID::coreCount() / 2, 1, 4), routineCompiled, this);
+			}
+			else if(!asynchronousCompilation)
+			{
+				delete routineCompiler;
+				routineCompiler = nullptr;
+			}
+
+			VertexProcessor::setRoutineCompiler(routineCompiler);
+			PixelProcessor::setRoutineCompiler(routineCompiler);
+			SetupProcessor::setRoutineCompiler(routineCompiler);
+
+			CPUID::setEnableAVX2(configuration.enableAVX);
+			CPUID::setEnableFMA(configuration.enableAVX);
+			CPUID::setEnableAVX(configuration.enableAVX);
 			CPUID::setEnableSSE4_1(configuration.enableSSE4_1);
 			CPUID::setEnableSSSE3(configuration.enableSSSE3);
 			CPUID::setEnableSSE3(configuration.enableSSE3);
@@ -2797,6 +3176,8 @@ namespace sw
 				optimization[pass] = configuration.optimization[pass];
 			}
 
+			shaderOptimization = configuration.shaderOptimization;
+
 			forceWindowed = configuration.forceWindowed;
 			complementaryDepthBuffer = configuration.complementaryDepthBuffer;
 			postBlendSRGB = configuration.postBlendSRGB;
@@ -2809,7 +3190,7 @@ namespace sw
 		#endif
 		}
 
-		if(!initialUpdate && !worker[0])
+		if(!initialUpdate && !worker)
 		{
 			initializeThreads();
 		}
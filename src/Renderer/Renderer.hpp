@@ -20,7 +20,9 @@
 #include "SetupProcessor.hpp"
 #include "Plane.hpp"
 #include "Blitter.hpp"
+#include "HierarchicalZ.hpp"
 #include "Common/MutexLock.hpp"
+#include "Common/TaskDeque.hpp"
 #include "Common/Thread.hpp"
 #include "Main/Config.hpp"
 
@@ -36,6 +38,7 @@ namespace sw
 	class Resource;
 	class Renderer;
 	struct Constants;
+	struct Outline;
 
 	enum TranscendentalPrecision
 	{
@@ -117,6 +120,7 @@ namespace sw
 
 		const void *input[MAX_VERTEX_INPUTS];
 		unsigned int stride[MAX_VERTEX_INPUTS];
+		unsigned int divisor[MAX_VERTEX_INPUTS];
 		Texture mipmap[TOTAL_IMAGE_UNITS];
 		const void *indices;
 
@@ -150,8 +154,6 @@ namespace sw
 
 		PS ps;
 
-		int instanceID;
-
 		VertexProcessor::PointSprite point;
 		float lineWidth;
 
@@ -159,10 +161,10 @@ namespace sw
 		PixelProcessor::Stencil stencilCCW;
 		PixelProcessor::Fog fog;
 		PixelProcessor::Factor factor;
-		unsigned int occlusion[16];   // Number of pixels passing depth test
+		unsigned int occlusion[MAX_THREADS];   // Number of pixels passing depth test, per cluster
 
 		#if PERF_PROFILE
-			int64_t cycles[PERF_TIMERS][16];
+			int64_t cycles[PERF_TIMERS][MAX_THREADS];
 		#endif
 
 		TextureStage::Uniforms textureStage[8];
@@ -181,6 +183,10 @@ namespace sw
 		float depthNear;
 		Plane clipPlane[6];
 
+		int clusterCount;
+		int binHeight;   // Scanlines per cluster bin, a power of two
+		Outline *outline;   // Per cluster, one for each sample
+
 		unsigned int *colorBuffer[RENDERTARGETS];
 		int colorPitchB[RENDERTARGETS];
 		int colorSliceB[RENDERTARGETS];
@@ -221,6 +227,11 @@ namespace sw
 
 		int (Renderer::*setupPrimitives)(int batch, int count);
 		SetupProcessor::State setupState;
+		bool deduplicateVertices;   // Vertex routine shades a VertexBatch
+		int vertexCacheSize;        // Geometry the vertex routine was generated for
+		int vertexCacheAssociativity;
+		HierarchicalZ *hierarchicalZ;   // Culls occluded triangles, if not null
+		HierarchicalZ::Test hierarchicalZTest;
 
 		Resource *vertexStream[MAX_VERTEX_INPUTS];
 		Resource *indexBuffer;
@@ -245,7 +256,8 @@ namespace sw
 		AtomicInt clipFlags;
 
 		AtomicInt primitive;    // Current primitive to enter pipeline
-		AtomicInt count;        // Number of primitives to render
+		AtomicInt count;        // Number of primitives to render, of all instances
+		AtomicInt instancePrimitives;   // Number of primitives per instance
 		AtomicInt references;   // Remaining references to this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
 
 		DrawData *data;
@@ -288,6 +300,8 @@ namespace sw
 				primitiveCount = 0;
 				visible = 0;
 				references = 0;
+				yMin = 0;
+				yMax = 0;
 			}
 
 			AtomicInt drawCall;
@@ -295,6 +309,8 @@ namespace sw
 			AtomicInt primitiveCount;
 			AtomicInt visible;
 			AtomicInt references;
+			AtomicInt yMin;   // Scanlines covered by the visible primitives
+			AtomicInt yMax;
 		};
 
 		struct PixelProgress
@@ -324,6 +340,7 @@ namespace sw
 		void clear(void *value, Format format, Surface *dest, const Rect &rect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRectF &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil = false, bool sRGBconversion = true);
 		void blit3D(Surface *source, Surface *dest);
+		void downsample(Surface *const *sources, Surface *const *dests, int count, bool volume);
 
 		void setIndexBuffer(Resource *indexBuffer);
 
@@ -331,7 +348,7 @@ namespace sw
 		void setTransparencyAntialiasing(TransparencyAntialiasing transparencyAntialiasing);
 
 		void setTextureResource(unsigned int sampler, Resource *resource);
-		void setTextureLevel(unsigned int sampler, unsigned int face, unsigned int level, Surface *surface, TextureType type);
+		void setTextureLevel(unsigned int sampler, unsigned int face, unsigned int level, Surface *surface, TextureType type, bool sampled = true);
 
 		void setTextureFilter(SamplerType type, int sampler, FilterType textureFilter);
 		void setMipmapFilter(SamplerType type, int sampler, MipmapType mipmapFilter);
@@ -392,6 +409,12 @@ namespace sw
 
 		void synchronize();
 
+		// Routine cache hits, misses and evictions, for tuning the cache sizes
+		CacheStatistics getVertexCacheStatistics() const;   // Post-transform vertex reuse
+		const CacheStatistics &getVertexRoutineCacheStatistics() const;
+		const CacheStatistics &getSetupRoutineCacheStatistics() const;
+		const CacheStatistics &getPixelRoutineCacheStatistics() const;
+
 		#if PERF_HUD
 			// Performance timers
 			int getThreadCount();
@@ -401,16 +424,21 @@ namespace sw
 			void resetTimers();
 		#endif
 
-		static int getClusterCount() { return clusterCount; }
-
 	private:
 		static void threadFunction(void *parameters);
+		static void routineCompiled(void *parameters);
 		void threadLoop(int threadIndex);
 		void taskLoop(int threadIndex);
-		void findAvailableTasks();
+		int findAvailableTasks(TaskDeque &deque);
+		int scanForTasks(int threadIndex);
+		bool dequeueTask(int threadIndex);
+		void wakeThreads(int count);
 		void scheduleTask(int threadIndex);
 		void executeTask(int threadIndex);
+		void materializeClears(DrawCall &draw, int yMin, int yMax);   // Writes deferred clears of the rows to be rendered
 		void finishRendering(Task &pixelTask);
+		bool clusterOverlaps(int cluster, int yMin, int yMax) const;
+		bool resolveRoutines(DrawCall *draw);
 
 		void processPrimitiveVertices(int unit, unsigned int start, unsigned int count, unsigned int loop, int thread);
 
@@ -435,12 +463,14 @@ namespace sw
 		Context *context;
 		Clipper *clipper;
 		Blitter *blitter;
+		RoutineCompiler *routineCompiler;   // Null unless compiling asynchronously
 		Viewport viewport;
 		Rect scissor;
 		int clipFlags;
 
-		Triangle *triangleBatch[16];
-		Primitive *primitiveBatch[16];
+		Triangle **triangleBatch;     // Per primitive unit
+		Primitive **primitiveBatch;   // Per primitive unit
+		Outline *outline;             // Per pixel cluster
 
 		// User-defined clipping planes
 		Plane userPlane[MAX_CLIP_PLANES];
@@ -449,14 +479,14 @@ namespace sw
 
 		AtomicInt exitThreads;
 		AtomicInt threadsAwake;
-		Thread *worker[16];
-		Event *resume[16];         // Events for resuming threads
-		Event *suspend[16];        // Events for suspending threads
+		Thread **worker;
+		Event **resume;            // Events for resuming threads
+		Event **suspend;           // Events for suspending threads
 		Event *resumeApp;          // Event for resuming the application thread
 
-		PrimitiveProgress primitiveProgress[16];
-		PixelProgress pixelProgress[16];
-		Task task[16];   // Current tasks for threads
+		PrimitiveProgress *primitiveProgress;   // Per primitive unit
+		PixelProgress *pixelProgress;           // Per pixel cluster
+		Task *task;                             // Current tasks for threads
 
 		enum {
 			DRAW_COUNT = 16,   // Number of draw calls buffered (must be power of 2)
@@ -468,26 +498,25 @@ namespace sw
 		AtomicInt currentDraw;
 		AtomicInt nextDraw;
 
-		enum {
-			TASK_COUNT = 32,   // Size of the task queue (must be power of 2)
-			TASK_COUNT_BITS = TASK_COUNT - 1,
-		};
-		Task taskQueue[TASK_COUNT];
-		AtomicInt qHead;
-		AtomicInt qSize;
+		TaskDeque **taskDeque;      // Per-thread work-stealing task queues
+		AtomicInt scanning;         // A thread is looking for available tasks
+		AtomicInt scanRequests;     // Tasks may have become available since the last scan started
 
-		static AtomicInt unitCount;
-		static AtomicInt clusterCount;
+		int threadCount;
+		CacheStatistics vertexCacheStatistics;   // Of terminated threads
+		int unitCount;      // Primitive processing units, each with its own batch of primitives
+		int clusterCount;   // Pixel processing clusters, each handling an interleaved subset of scanlines
+		int binHeight;      // Height of the bands of scanlines interleaved between clusters
 
-		MutexLock schedulerMutex;
+		MutexLock sleepMutex;   // Serializes suspending and resuming threads with draw call submission
 
 		#if PERF_HUD
-			int64_t vertexTime[16];
-			int64_t setupTime[16];
-			int64_t pixelTime[16];
+			int64_t vertexTime[MAX_THREADS];
+			int64_t setupTime[MAX_THREADS];
+			int64_t pixelTime[MAX_THREADS];
 		#endif
 
-		VertexTask *vertexTask[16];
+		VertexTask **vertexTask;   // Per thread
 
 		SwiftConfig *swiftConfig;
 
@@ -0,0 +1,412 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RoutineArchive.hpp"
+
+#if ROUTINE_ARCHIVE
+
+#include "Renderer.hpp"
+#include "Reactor/Nucleus.hpp"
+#include "Common/CPUID.hpp"
+#include "Common/Math.hpp"
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace sw
+{
+	extern bool halfIntegerCoordinates;
+	extern bool symmetricNormalizedDepth;
+	extern bool booleanFaceRegister;
+	extern bool fullPixelPositionRegister;
+	extern bool leadingVertexFirst;
+	extern bool secondaryColor;
+	extern bool colorsDefaultToZero;
+	extern bool quadLayoutEnabled;
+	extern bool veryEarlyDepthTest;
+	extern bool complementaryDepthBuffer;
+	extern bool postBlendSRGB;
+	extern bool exactColorRounding;
+	extern TransparencyAntialiasing transparencyAntialiasing;
+	extern bool forceClearRegisters;
+
+	extern TranscendentalPrecision logPrecision;
+	extern TranscendentalPrecision expPrecision;
+	extern TranscendentalPrecision rcpPrecision;
+	extern TranscendentalPrecision rsqPrecision;
+	extern bool perspectiveCorrection;
+
+	static const char magic[8] = {'S', 'W', 'R', 'O', 'U', 'T', 'I', 'N'};
+	static const uint32_t version = 8;   // Increment when the state structures or code generation change
+	static const long maxFileSize = 64 * 1024 * 1024;
+	static const uint32_t maxKeySize = 64 * 1024;
+	static const uint32_t maxImageSize = 16 * 1024 * 1024;
+
+	RoutineArchive::RoutineArchive(const char *name) : file(nullptr), addedSize(0)
+	{
+		std::string path = directory();
+
+		if(path.empty())
+		{
+			return;
+		}
+
+		fileName = path + name + ".cache";
+		file = fopen(fileName.c_str(), "rb");
+
+		if(file && read(file, index) == 0)
+		{
+			index.clear();
+			fclose(file);
+			file = nullptr;
+		}
+	}
+
+	RoutineArchive::~RoutineArchive()
+	{
+		if(file)
+		{
+			fclose(file);
+			file = nullptr;
+		}
+
+		save();
+	}
+
+	Routine *RoutineArchive::load(const std::vector<unsigned char> &key)
+	{
+		std::string id = identifier(key);
+		std::vector<unsigned char> image;
+
+		mutex.lock();
+
+		auto record = added.find(id);
+
+		if(record != added.end())
+		{
+			image = record->second;
+		}
+		else
+		{
+			auto entry = index.find(id);
+
+			if(entry != index.end())
+			{
+				std::vector<unsigned char> data(id.size() + entry->second.size);
+
+				if(fseek(file, entry->second.offset - static_cast<long>(id.size()), SEEK_SET) == 0 &&
+				   fread(&data[0], data.size(), 1, file) == 1 &&
+				   FNV_1a(&data[0], static_cast<int>(data.size())) == entry->second.checksum)
+				{
+					image.assign(data.begin() + id.size(), data.end());
+				}
+				else
+				{
+					index.erase(entry);
+				}
+			}
+		}
+
+		mutex.unlock();
+
+		if(image.empty())
+		{
+			return nullptr;
+		}
+
+		return Nucleus::loadRoutine(&image[0], image.size());
+	}
+
+	void RoutineArchive::store(const std::vector<unsigned char> &key, Routine *routine)
+	{
+		const void *image = nullptr;
+		size_t imageSize = 0;
+
+		if(fileName.empty() || !routine->getImage(image, imageSize) || imageSize > maxImageSize)
+		{
+			return;
+		}
+
+		std::string id = identifier(key);
+		long size = static_cast<long>(sizeof(Record) + id.size() + imageSize);
+
+		mutex.lock();
+
+		if(index.find(id) == index.end() && added.find(id) == added.end() && addedSize + size <= maxFileSize)
+		{
+			added[id].assign(static_cast<const unsigned char*>(image), static_cast<const unsigned char*>(image) + imageSize);
+			addedSize += size;
+		}
+
+		mutex.unlock();
+	}
+
+	std::string RoutineArchive::directory()
+	{
+		#if defined(_WIN32)
+			const char *base = getenv("LOCALAPPDATA");
+
+			if(!base || !*base)
+			{
+				return "";
+			}
+
+			std::string path = std::string(base) + "\\SwiftShader";
+			CreateDirectoryA(path.c_str(), nullptr);
+
+			DWORD attributes = GetFileAttributesA(path.c_str());
+
+			if(attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY))
+			{
+				return "";
+			}
+
+			return path + "\\";
+		#else
+			std::string path;
+
+			if(const char *cache = getenv("XDG_CACHE_HOME"))
+			{
+				path = cache;
+			}
+			else if(const char *home = getenv("HOME"))
+			{
+				path = std::string(home) + "/.cache";
+			}
+
+			if(path.empty() || path[0] != '/')
+			{
+				return "";
+			}
+
+			mkdir(path.c_str(), 0700);
+			path += "/swiftshader";
+			mkdir(path.c_str(), 0700);
+
+			// Routines get mapped as executable, so only use a directory which other users can't write to
+			struct stat status;
+
+			if(stat(path.c_str(), &status) != 0 || !S_ISDIR(status.st_mode) ||
+			   status.st_uid != geteuid() || (status.st_mode & (S_IWGRP | S_IWOTH)))
+			{
+				return "";
+			}
+
+			return path + "/";
+		#endif
+	}
+
+	std::string RoutineArchive::identifier(const std::vector<unsigned char> &key)
+	{
+		uint64_t print = fingerprint();
+
+		std::string id(reinterpret_cast<const char*>(&print), sizeof(print));
+		id.append(key.begin(), key.end());
+
+		return id;
+	}
+
+	uint64_t RoutineArchive::fingerprint()
+	{
+		// Everything besides the state which affects the generated code
+		const unsigned int words[] =
+		{
+			version,
+			sizeof(void*),
+			CPUID::supportsMMX(),
+			CPUID::supportsCMOV(),
+			CPUID::supportsMMX2(),
+			CPUID::supportsSSE(),
+			CPUID::supportsSSE2(),
+			CPUID::supportsSSE3(),
+			CPUID::supportsSSSE3(),
+			CPUID::supportsSSE4_1(),
+			CPUID::supportsAVX(),
+			CPUID::supportsAVX2(),
+			CPUID::supportsFMA(),
+			halfIntegerCoordinates,
+			symmetricNormalizedDepth,
+			booleanFaceRegister,
+			fullPixelPositionRegister,
+			leadingVertexFirst,
+			secondaryColor,
+			colorsDefaultToZero,
+			quadLayoutEnabled,
+			veryEarlyDepthTest,
+			complementaryDepthBuffer,
+			postBlendSRGB,
+			exactColorRounding,
+			transparencyAntialiasing,
+			forceClearRegisters,
+			logPrecision,
+			expPrecision,
+			rcpPrecision,
+			rsqPrecision,
+			perspectiveCorrection,
+			optimization[0], optimization[1], optimization[2], optimization[3], optimization[4],
+			optimization[5], optimization[6], optimization[7], optimization[8], optimization[9],
+		};
+
+		return FNV_1a(reinterpret_cast<const unsigned char*>(words), sizeof(words));
+	}
+
+	long RoutineArchive::read(FILE *file, Index &index)
+	{
+		char fileMagic[sizeof(magic)];
+		uint32_t fileVersion;
+
+		if(fseek(file, 0, SEEK_SET) != 0 ||
+		   fread(fileMagic, sizeof(fileMagic), 1, file) != 1 || memcmp(fileMagic, magic, sizeof(magic)) != 0 ||
+		   fread(&fileVersion, sizeof(fileVersion), 1, file) != 1 || fileVersion != version)
+		{
+			return 0;
+		}
+
+		long offset = ftell(file);
+
+		if(fseek(file, 0, SEEK_END) != 0)
+		{
+			return 0;
+		}
+
+		long fileSize = ftell(file);
+
+		// Index all complete records. Anything beyond them gets dropped when the file is rewritten.
+		while(fseek(file, offset, SEEK_SET) == 0)
+		{
+			Record record;
+
+			if(fread(&record, sizeof(Record), 1, file) != 1 ||
+			   record.keySize == 0 || record.keySize > maxKeySize || record.imageSize > maxImageSize ||
+			   offset + static_cast<long>(sizeof(Record) + record.keySize + record.imageSize) > fileSize)
+			{
+				break;
+			}
+
+			std::string id(record.keySize, '\0');
+
+			if(fread(&id[0], record.keySize, 1, file) != 1)
+			{
+				break;
+			}
+
+			Entry entry;
+			entry.offset = offset + static_cast<long>(sizeof(Record) + record.keySize);
+			entry.size = record.imageSize;
+			entry.checksum = record.checksum;
+
+			index[id] = entry;
+			offset = entry.offset + record.imageSize;
+		}
+
+		return offset;
+	}
+
+	void RoutineArchive::save()
+	{
+		if(added.empty())
+		{
+			return;
+		}
+
+		#if defined(_WIN32)
+			std::string tempName = fileName + "." + std::to_string(GetCurrentProcessId()) + ".tmp";
+		#else
+			std::string tempName = fileName + "." + std::to_string(getpid()) + ".tmp";
+		#endif
+
+		FILE *temp = fopen(tempName.c_str(), "wb");
+
+		if(!temp)
+		{
+			return;
+		}
+
+		bool success = fwrite(magic, sizeof(magic), 1, temp) == 1 && fwrite(&version, sizeof(version), 1, temp) == 1;
+		long size = ftell(temp);
+
+		// Keep the records of the current file, which may have been replaced by another process
+		Index current;
+		FILE *previous = fopen(fileName.c_str(), "rb");
+
+		if(previous)
+		{
+			long end = read(previous, current);
+			std::vector<unsigned char> data(64 * 1024);
+
+			for(long offset = size; success && offset < end; )
+			{
+				size_t count = static_cast<size_t>(std::min(end - offset, static_cast<long>(data.size())));
+
+				success = fseek(previous, offset, SEEK_SET) == 0 && fread(&data[0], count, 1, previous) == 1 && fwrite(&data[0], count, 1, temp) == 1;
+				offset += static_cast<long>(count);
+			}
+
+			size = std::max(size, end);
+			fclose(previous);
+		}
+
+		for(auto &record : added)
+		{
+			const std::string &id = record.first;
+			const std::vector<unsigned char> &image = record.second;
+			long recordSize = static_cast<long>(sizeof(Record) + id.size() + image.size());
+
+			if(!success || current.find(id) != current.end() || size + recordSize > maxFileSize)
+			{
+				continue;
+			}
+
+			std::vector<unsigned char> data(id.begin(), id.end());
+			data.insert(data.end(), image.begin(), image.end());
+
+			Record header;
+			header.keySize = static_cast<uint32_t>(id.size());
+			header.imageSize = static_cast<uint32_t>(image.size());
+			header.checksum = FNV_1a(&data[0], static_cast<int>(data.size()));
+
+			success = fwrite(&header, sizeof(Record), 1, temp) == 1 && fwrite(&data[0], data.size(), 1, temp) == 1;
+			size += recordSize;
+		}
+
+		success = (fclose(temp) == 0) && success;
+
+		#if defined(_WIN32)
+			success = success && MoveFileExA(tempName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+		#else
+			success = success && rename(tempName.c_str(), fileName.c_str()) == 0;
+		#endif
+
+		if(!success)
+		{
+			remove(tempName.c_str());
+		}
+
+		added.clear();
+		addedSize = 0;
+	}
+}
+
+#endif   // ROUTINE_ARCHIVE
@@ -0,0 +1,86 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_RoutineArchive_hpp
+#define sw_RoutineArchive_hpp
+
+#include "Main/Config.hpp"
+
+#if ROUTINE_ARCHIVE
+
+#include "Reactor/Routine.hpp"
+#include "Common/MutexLock.hpp"
+#include "Common/Types.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sw
+{
+	// Stores compiled routines in a file in the user's cache directory, so they can be
+	// reused when the application is restarted. Each routine is identified by the bytes
+	// of its key, combined with a fingerprint of the processor features and settings
+	// which affect code generation. Only back-ends which produce position-independent
+	// code images are supported.
+	// New routines are written out when the archive is destroyed. The file is replaced
+	// atomically, so other processes always see a complete archive.
+	class RoutineArchive
+	{
+	public:
+		explicit RoutineArchive(const char *name);
+
+		~RoutineArchive();
+
+		Routine *load(const std::vector<unsigned char> &key);   // Returns null if not archived
+		void store(const std::vector<unsigned char> &key, Routine *routine);
+
+	private:
+		struct Record
+		{
+			uint32_t keySize;
+			uint32_t imageSize;
+			uint64_t checksum;   // Of the key and image
+		};
+
+		struct Entry
+		{
+			long offset;   // Of the image
+			uint32_t size;
+			uint64_t checksum;
+		};
+
+		typedef std::unordered_map<std::string, Entry> Index;
+
+		static std::string directory();   // Empty if unavailable
+		static std::string identifier(const std::vector<unsigned char> &key);
+		static uint64_t fingerprint();
+		static long read(FILE *file, Index &index);   // Returns the end of the last valid record, or 0 if invalid
+
+		void save();
+
+		std::string fileName;
+		FILE *file;   // Read-only
+
+		MutexLock mutex;
+		Index index;
+		std::unordered_map<std::string, std::vector<unsigned char>> added;   // Records not written out yet
+		long addedSize;
+	};
+}
+
+#endif   // ROUTINE_ARCHIVE
+
+#endif   // sw_RoutineArchive_hpp
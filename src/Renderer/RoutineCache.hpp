@@ -25,18 +25,12 @@ namespace sw
 	class RoutineCache : public LRUCache<State, Routine>
 	{
 	public:
-		RoutineCache(int n, const char *precache = 0);
+		RoutineCache(int n);
 		~RoutineCache();
-
-	private:
-		const char *precache;
-		#if defined(_WIN32)
-		HMODULE precacheDLL;
-		#endif
 	};
 
 	template<class State>
-	RoutineCache<State>::RoutineCache(int n, const char *precache) : LRUCache<State, Routine>(n), precache(precache)
+	RoutineCache<State>::RoutineCache(int n) : LRUCache<State, Routine>(n)
 	{
 	}
 
@@ -0,0 +1,165 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RoutineCompiler.hpp"
+
+namespace sw
+{
+	DeferredRoutine::DeferredRoutine() : routine(nullptr)
+	{
+	}
+
+	DeferredRoutine::~DeferredRoutine()
+	{
+		Routine *compiled = routine.load();
+
+		if(compiled)
+		{
+			compiled->unbind();
+		}
+	}
+
+	const void *DeferredRoutine::getEntry()
+	{
+		Routine *compiled = routine.load(std::memory_order_acquire);
+
+		return compiled ? compiled->getEntry() : nullptr;
+	}
+
+	void DeferredRoutine::resolve(Routine *compiled)
+	{
+		compiled->bind();
+		routine.store(compiled, std::memory_order_release);
+	}
+
+	RoutineCompiler::Task::Task() : routine(new DeferredRoutine())
+	{
+		routine->bind();   // Kept alive until compiled, even if evicted from the cache
+	}
+
+	RoutineCompiler::Task::~Task()
+	{
+		routine->unbind();
+	}
+
+	RoutineCompiler::RoutineCompiler(int threadCount, void (*onCompiled)(void *parameters), void *parameters)
+		: onCompiled(onCompiled), parameters(parameters), threadCount(threadCount), outstanding(0), terminate(false)
+	{
+		thread = new Thread*[threadCount];
+
+		for(int i = 0; i < threadCount; i++)
+		{
+			thread[i] = new Thread(threadFunction, this);
+		}
+	}
+
+	RoutineCompiler::~RoutineCompiler()
+	{
+		finish();
+
+		mutex.lock();
+		terminate = true;
+		mutex.unlock();
+
+		wake.signal();
+
+		for(int i = 0; i < threadCount; i++)
+		{
+			thread[i]->join();
+			delete thread[i];
+		}
+
+		delete[] thread;
+	}
+
+	void RoutineCompiler::finish()
+	{
+		while(true)
+		{
+			mutex.lock();
+			int pending = outstanding;
+			mutex.unlock();
+
+			if(pending == 0)
+			{
+				return;
+			}
+
+			Thread::sleep(1);
+		}
+	}
+
+	Routine *RoutineCompiler::enqueue(Task *task)
+	{
+		Routine *routine = task->routine;
+		routine->bind();   // Reference for the caller
+
+		mutex.lock();
+		queue.push_back(task);
+		outstanding++;
+		mutex.unlock();
+
+		wake.signal();
+
+		return routine;
+	}
+
+	void RoutineCompiler::threadFunction(void *parameters)
+	{
+		static_cast<RoutineCompiler*>(parameters)->compileLoop();
+	}
+
+	void RoutineCompiler::compileLoop()
+	{
+		while(true)
+		{
+			mutex.lock();
+
+			if(queue.empty())
+			{
+				bool exit = terminate;
+				mutex.unlock();
+
+				if(exit)
+				{
+					wake.signal();   // Pass on to the next thread
+					return;
+				}
+
+				wake.wait();
+				continue;
+			}
+
+			Task *task = queue.front();
+			queue.pop_front();
+			bool more = !queue.empty();
+
+			mutex.unlock();
+
+			if(more)
+			{
+				wake.signal();   // Let another thread take the next task
+			}
+
+			task->routine->resolve(task->generate());
+			delete task;
+
+			onCompiled(parameters);
+
+			mutex.lock();
+			outstanding--;
+			mutex.unlock();
+		}
+	}
+}
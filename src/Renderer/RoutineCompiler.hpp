@@ -0,0 +1,146 @@
+// Copyright 2016 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_RoutineCompiler_hpp
+#define sw_RoutineCompiler_hpp
+
+#include "Reactor/Routine.hpp"
+#include "Common/MutexLock.hpp"
+#include "Common/Thread.hpp"
+
+#include <atomic>
+#include <deque>
+
+namespace sw
+{
+	// Stands in for a routine which is being compiled in the background.
+	// It has no entry point until the compilation has finished.
+	class DeferredRoutine : public Routine
+	{
+	public:
+		DeferredRoutine();
+
+		~DeferredRoutine() override;
+
+		const void *getEntry() override;   // Null while being compiled
+
+		void resolve(Routine *compiled);
+
+	private:
+		std::atomic<Routine*> routine;
+	};
+
+	// Compiles routines on background threads, so draw calls can be issued
+	// without waiting for them. Each task owns a copy of its shader, as the
+	// application is free to delete the original while the task is queued.
+	class RoutineCompiler
+	{
+	public:
+		RoutineCompiler(int threadCount, void (*onCompiled)(void *parameters), void *parameters);
+
+		~RoutineCompiler();
+
+		// The returned routine is bound on behalf of the caller, as the compilation may complete
+		// before the caller has stored it. It must be unbound once it's referenced elsewhere.
+		template<class State>
+		Routine *compile(Routine *(*generate)(const State &state), const State &state);
+
+		template<class State, class Shader>
+		Routine *compile(Routine *(*generate)(const State &state, const Shader *shader), const State &state, const Shader *shader);
+
+		void finish();   // Waits for all queued routines to be compiled
+
+	private:
+		struct Task
+		{
+			Task();
+
+			virtual ~Task();
+
+			virtual Routine *generate() = 0;
+
+			DeferredRoutine *const routine;
+		};
+
+		template<class State>
+		struct StateTask : Task
+		{
+			StateTask(Routine *(*generator)(const State &state), const State &state) : generator(generator), state(state)
+			{
+			}
+
+			Routine *generate() override
+			{
+				return generator(state);
+			}
+
+			Routine *(*const generator)(const State &state);
+			const State state;
+		};
+
+		template<class State, class Shader>
+		struct ShaderTask : Task
+		{
+			ShaderTask(Routine *(*generator)(const State &state, const Shader *shader), const State &state, const Shader *shader) :
+				generator(generator), state(state), shader(shader ? new Shader(shader) : nullptr)
+			{
+			}
+
+			~ShaderTask() override
+			{
+				delete shader;
+			}
+
+			Routine *generate() override
+			{
+				return generator(state, shader);
+			}
+
+			Routine *(*const generator)(const State &state, const Shader *shader);
+			const State state;
+			const Shader *const shader;
+		};
+
+		Routine *enqueue(Task *task);
+
+		static void threadFunction(void *parameters);
+		void compileLoop();
+
+		void (*const onCompiled)(void *parameters);
+		void *const parameters;
+
+		int threadCount;
+		Thread **thread;
+
+		Event wake;
+		MutexLock mutex;
+		std::deque<Task*> queue;
+		int outstanding;   // Queued or being compiled
+		bool terminate;
+	};
+
+	template<class State>
+	Routine *RoutineCompiler::compile(Routine *(*generate)(const State &state), const State &state)
+	{
+		return enqueue(new StateTask<State>(generate, state));
+	}
+
+	template<class State, class Shader>
+	Routine *RoutineCompiler::compile(Routine *(*generate)(const State &state, const Shader *shader), const State &state, const Shader *shader)
+	{
+		return enqueue(new ShaderTask<State, Shader>(generate, state, shader));
+	}
+}
+
+#endif   // sw_RoutineCompiler_hpp
@@ -27,6 +27,9 @@ namespace sw
 	FilterType Sampler::maximumTextureFilterQuality = FILTER_LINEAR;
 	MipmapType Sampler::maximumMipmapFilterQuality = MIPMAP_POINT;
 
+	// Smaller textures fit in the cache regardless of their layout
+	static const int minTiledSize = 256;
+
 	Sampler::State::State()
 	{
 		memset(this, 0, sizeof(State));
@@ -61,6 +64,8 @@ namespace sw
 		sRGB = false;
 		gather = false;
 		highPrecisionFiltering = false;
+		textureTiling = false;
+		tiled = false;
 		border = 0;
 
 		swizzleR = SWIZZLE_RED;
@@ -103,6 +108,7 @@ namespace sw
 			state.swizzleA = swizzleA;
 			state.highPrecisionFiltering = highPrecisionFiltering;
 			state.compare = getCompareFunc();
+			state.tiled = tiled;
 
 			#if PERF_PROFILE
 				state.compressedFormat = Surface::isCompressed(externalTextureFormat);
@@ -112,14 +118,27 @@ namespace sw
 		return state;
 	}
 
-	void Sampler::setTextureLevel(int face, int level, Surface *surface, TextureType type)
+	void Sampler::setTextureLevel(int face, int level, Surface *surface, TextureType type, bool sampled)
 	{
 		if(surface)
 		{
 			Mipmap &mipmap = texture.mipmap[level];
 
+			// Locking brings the internal buffer up to date, which can involve decoding it
 			border = surface->getBorder();
-			mipmap.buffer[face] = surface->lockInternal(-border, -border, 0, LOCK_UNLOCKED, PRIVATE);
+			mipmap.buffer[face] = sampled ? surface->lockInternal(-border, -border, 0, LOCK_UNLOCKED, PRIVATE) : nullptr;
+
+			// All levels share the layout, which is chosen based on the base level
+			if(level == 0 && face == 0)
+			{
+				tiled = textureTiling && type == TEXTURE_2D && surface->isTileable() &&
+				        surface->getWidth() >= minTiledSize && surface->getHeight() >= minTiledSize;
+			}
+
+			if(tiled && sampled)
+			{
+				mipmap.buffer[face] = surface->getTiledInternal();
+			}
 
 			if(face == 0)
 			{
@@ -129,8 +148,8 @@ namespace sw
 				int width = surface->getWidth();
 				int height = surface->getHeight();
 				int depth = surface->getDepth();
-				int pitchP = surface->getInternalPitchP();
-				int sliceP = surface->getInternalSliceP();
+				int pitchP = tiled ? surface->getTiledPitchP() : surface->getInternalPitchP();
+				int sliceP = tiled ? surface->getTiledSliceP() : surface->getInternalSliceP();
 
 				if(level == 0)
 				{
@@ -372,6 +391,11 @@ namespace sw
 		Sampler::maximumMipmapFilterQuality = maximumFilterQuality;
 	}
 
+	void Sampler::setTextureTiling(bool enable)
+	{
+		textureTiling = enable;
+	}
+
 	void Sampler::setMipmapLOD(float LOD)
 	{
 		texture.LOD = LOD;
@@ -160,6 +160,7 @@ namespace sw
 			SwizzleType swizzleA           : BITS(SWIZZLE_LAST);
 			bool highPrecisionFiltering    : 1;
 			CompareFunc compare            : BITS(COMPARE_LAST);
+			bool tiled                     : 1;   // Texels stored in 4x4 tiles
 
 			#if PERF_PROFILE
 			bool compressedFormat          : 1;
@@ -172,7 +173,7 @@ namespace sw
 
 		State samplerState() const;
 
-		void setTextureLevel(int face, int level, Surface *surface, TextureType type);
+		void setTextureLevel(int face, int level, Surface *surface, TextureType type, bool sampled = true);   // Unsampled levels only provide their dimensions
 
 		void setTextureFilter(FilterType textureFilter);
 		void setMipmapFilter(MipmapType mipmapFilter);
@@ -196,6 +197,7 @@ namespace sw
 
 		static void setFilterQuality(FilterType maximumFilterQuality);
 		static void setMipmapQuality(MipmapType maximumFilterQuality);
+		void setTextureTiling(bool enable);   // Large 2D textures get sampled from a tiled copy
 		void setMipmapLOD(float lod);
 
 		bool hasTexture() const;
@@ -226,6 +228,8 @@ namespace sw
 		bool sRGB;
 		bool gather;
 		bool highPrecisionFiltering;
+		bool textureTiling;
+		bool tiled;
 		int border;
 
 		SwizzleType swizzleR;
@@ -18,6 +18,7 @@
 #include "Polygon.hpp"
 #include "Context.hpp"
 #include "Renderer.hpp"
+#include "RoutineArchive.hpp"
 #include "Shader/SetupRoutine.hpp"
 #include "Shader/Constants.hpp"
 #include "Common/Debug.hpp"
@@ -29,17 +30,17 @@ namespace sw
 
 	bool precacheSetup = false;
 
-	unsigned int SetupProcessor::States::computeHash()
-	{
-		unsigned int *state = (unsigned int*)this;
-		unsigned int hash = 0;
-
-		for(unsigned int i = 0; i < sizeof(States) / 4; i++)
+	#if ROUTINE_ARCHIVE
+		static RoutineArchive &archive()
 		{
-			hash ^= state[i];
+			static RoutineArchive archive("sw-setup");   // Shared by all renderers
+			return archive;
 		}
+	#endif
 
-		return hash;
+	unsigned int SetupProcessor::States::computeHash()
+	{
+		return FNV_1a((const unsigned int*)this, sizeof(States) / 4);
 	}
 
 	SetupProcessor::State::State(int i)
@@ -61,6 +62,8 @@ namespace sw
 	{
 		routineCache = 0;
 		setRoutineCacheSize(1024);
+
+		routineCompiler = nullptr;
 	}
 
 	SetupProcessor::~SetupProcessor()
@@ -229,20 +232,71 @@ namespace sw
 
 		if(!routine)
 		{
-			SetupRoutine *generator = new SetupRoutine(state);
-			generator->generate();
-			routine = generator->getRoutine();
-			delete generator;
+			if(routineCompiler)
+			{
+				routine = routineCompiler->compile(generate, state);
+			}
+			else
+			{
+				routine = generate(state);
+			}
 
 			routineCache->add(state, routine);
+
+			if(routineCompiler)
+			{
+				routine->unbind();   // Now referenced by the cache
+			}
 		}
 
 		return routine;
 	}
 
+	Routine *SetupProcessor::generate(const State &state)
+	{
+		#if ROUTINE_ARCHIVE
+			std::vector<unsigned char> key;
+
+			if(precacheSetup)
+			{
+				const unsigned char *states = reinterpret_cast<const unsigned char*>(static_cast<const States*>(&state));
+				key.assign(states, states + sizeof(States));
+
+				if(Routine *routine = archive().load(key))
+				{
+					return routine;
+				}
+			}
+		#endif
+
+		SetupRoutine *generator = new SetupRoutine(state);
+		generator->generate();
+		Routine *routine = generator->getRoutine();
+		delete generator;
+
+		#if ROUTINE_ARCHIVE
+			if(precacheSetup)
+			{
+				archive().store(key, routine);
+			}
+		#endif
+
+		return routine;
+	}
+
 	void SetupProcessor::setRoutineCacheSize(int cacheSize)
 	{
 		delete routineCache;
-		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precacheSetup ? "sw-setup" : 0);
+		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536));
+	}
+
+	void SetupProcessor::setRoutineCompiler(RoutineCompiler *compiler)
+	{
+		routineCompiler = compiler;
+	}
+
+	const CacheStatistics &SetupProcessor::getRoutineCacheStatistics() const
+	{
+		return routineCache->getStatistics();
 	}
 }
@@ -17,6 +17,7 @@
 
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "RoutineCompiler.hpp"
 #include "Shader/VertexShader.hpp"
 #include "Shader/PixelShader.hpp"
 #include "Common/Types.hpp"
@@ -94,11 +95,16 @@ namespace sw
 		Routine *routine(const State &state);
 
 		void setRoutineCacheSize(int cacheSize);
+		void setRoutineCompiler(RoutineCompiler *compiler);
+		const CacheStatistics &getRoutineCacheStatistics() const;
 
 	private:
+		static Routine *generate(const State &state);
+
 		Context *const context;
 
 		RoutineCache<State> *routineCache;
+		RoutineCompiler *routineCompiler;   // Null unless compiling asynchronously
 	};
 }
 
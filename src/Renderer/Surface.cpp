@@ -16,18 +16,28 @@
 
 #include "Color.hpp"
 #include "Context.hpp"
+#include "DeferredClear.hpp"
 #include "ETC_Decoder.hpp"
+#include "HierarchicalZ.hpp"
 #include "Renderer.hpp"
 #include "Common/Half.hpp"
 #include "Common/Memory.hpp"
 #include "Common/CPUID.hpp"
 #include "Common/Resource.hpp"
+#include "Common/WorkerPool.hpp"
 #include "Common/Debug.hpp"
 #include "Reactor/Reactor.hpp"
 
 #if defined(__i386__) || defined(__x86_64__)
 	#include <xmmintrin.h>
 	#include <emmintrin.h>
+	#include <immintrin.h>
+
+	#if defined(__GNUC__)
+		#define AVX2_FUNCTION __attribute__((target("avx2")))
+	#else
+		#define AVX2_FUNCTION
+	#endif
 #endif
 
 #undef min
@@ -42,6 +52,48 @@ namespace sw
 	unsigned int *Surface::palette = 0;
 	unsigned int Surface::paletteID = 0;
 
+	static const int minResolveBandHeight = 32;   // Rows
+	static const int minResolveBandedArea = 256 * 256;   // Pixels, below which dispatching costs more than it saves
+
+	static const int minDecodeBandHeight = 16;   // Rows, a multiple of the block height
+	static const int minDecodeBandedArea = 256 * 256;   // Texels
+
+	static std::atomic<int> bandThreads(1);   // Limits the bands of work dispatched to the shared worker pool
+
+	struct Surface::DecodeBands
+	{
+		Buffer *destination;
+		Buffer *source;
+		int blockRows;
+		int count;   // Per slice
+	};
+
+	static bool hasFourRowBlocks(Format format)
+	{
+		switch(format)
+		{
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ATI1:
+		case FORMAT_ATI2:
+		case FORMAT_ETC1:
+		case FORMAT_R11_EAC:
+		case FORMAT_SIGNED_R11_EAC:
+		case FORMAT_RG11_EAC:
+		case FORMAT_SIGNED_RG11_EAC:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
+			return true;
+		default:
+			return false;
+		}
+	}
+
 	void Surface::Buffer::write(int x, int y, int z, const Color<float> &color)
 	{
 		byte *element = (byte*)buffer + (x + border) * bytes + (y + border) * pitchB + z * samples * sliceB;
@@ -101,6 +153,12 @@ namespace sw
 		case FORMAT_R16UI:
 			*(unsigned short*)element = ucast<16>(r);
 			break;
+		case FORMAT_R16_SNORM:
+			*(short*)element = snorm<16>(r);
+			break;
+		case FORMAT_R16:
+			*(unsigned short*)element = unorm<16>(r);
+			break;
 		case FORMAT_R32I:
 			*(int*)element = static_cast<int>(r);
 			break;
@@ -680,6 +738,12 @@ namespace sw
 		case FORMAT_R16UI:
 			r = *((unsigned short*)element);
 			break;
+		case FORMAT_R16_SNORM:
+			r = max((*(short*)element) * (1.0f / 0x7FFF), -1.0f);
+			break;
+		case FORMAT_R16:
+			r = *(unsigned short*)element * (1.0f / 0xFFFF);
+			break;
 		case FORMAT_G16R16I:
 			{
 				short* gr = (short*)element;
@@ -1266,7 +1330,7 @@ namespace sw
 		internal.height = height;
 		internal.depth = depth;
 		internal.samples = 1;
-		internal.format = selectInternalFormat(format);
+		internal.format = selectInternalFormat(format, 0);
 		internal.bytes = bytes(internal.format);
 		internal.pitchB = pitchB(internal.width, 0, internal.format, false);
 		internal.pitchP = pitchP(internal.width, 0, internal.format, false);
@@ -1293,6 +1357,14 @@ namespace sw
 
 		dirtyContents = true;
 		paletteUsed = 0;
+
+		hierarchicalZ = (isDepth(internal.format) && internal.samples == 1 && internal.depth == 1) ? new HierarchicalZ(width, height) : nullptr;
+		internalClear = nullptr;
+		stencilClear = nullptr;
+
+		tiled = nullptr;
+		internalVersion = 0;
+		tiledVersion = 0;
 	}
 
 	Surface::Surface(Resource *texture, int width, int height, int depth, int border, int samples, Format format, bool lockable, bool renderTarget, int pitchPprovided) : lockable(lockable), renderTarget(renderTarget)
@@ -1323,7 +1395,7 @@ namespace sw
 		internal.height = height;
 		internal.depth = depth;
 		internal.samples = (short)samples;
-		internal.format = selectInternalFormat(format);
+		internal.format = selectInternalFormat(format, border);
 		internal.bytes = bytes(internal.format);
 		internal.pitchB = !pitchPprovided ? pitchB(internal.width, border, internal.format, renderTarget) : pitchPprovided * internal.bytes;
 		internal.pitchP = !pitchPprovided ? pitchP(internal.width, border, internal.format, renderTarget) : pitchPprovided;
@@ -1350,6 +1422,14 @@ namespace sw
 
 		dirtyContents = true;
 		paletteUsed = 0;
+
+		hierarchicalZ = (isDepth(internal.format) && internal.samples == 1 && internal.depth == 1) ? new HierarchicalZ(width, height) : nullptr;
+		internalClear = (renderTarget && internal.depth == 1 && internal.border == 0) ? new DeferredClear(internal.height) : nullptr;
+		stencilClear = (renderTarget && stencil.format != FORMAT_NULL && stencil.depth == 1) ? new DeferredClear(stencil.height) : nullptr;
+
+		tiled = nullptr;
+		internalVersion = 0;
+		tiledVersion = 0;
 	}
 
 	Surface::~Surface()
@@ -1374,16 +1454,26 @@ namespace sw
 		}
 
 		deallocate(stencil.buffer);
+		deallocate(tiled);
+		delete hierarchicalZ;
+		delete internalClear;
+		delete stencilClear;
 
 		external.buffer = 0;
 		internal.buffer = 0;
 		stencil.buffer = 0;
+		tiled = nullptr;
 	}
 
 	void *Surface::lockExternal(int x, int y, int z, Lock lock, Accessor client)
 	{
 		resource->lock(client);
 
+		if(internalClear)
+		{
+			internalClear->materialize();
+		}
+
 		if(!external.buffer)
 		{
 			if(internal.buffer && identicalFormats())
@@ -1414,6 +1504,12 @@ namespace sw
 		case LOCK_READWRITE:
 		case LOCK_DISCARD:
 			dirtyContents = true;
+			internalVersion++;   // The buffers may be shared
+
+			if(hierarchicalZ)
+			{
+				hierarchicalZ->invalidate();
+			}
 			break;
 		default:
 			ASSERT(false);
@@ -1448,6 +1544,12 @@ namespace sw
 			}
 		}
 
+		// The renderer only writes pending clears to the rows it accesses
+		if(internalClear && client != MANAGED)
+		{
+			internalClear->materialize();
+		}
+
 		// FIXME: WHQL requires conversion to lower external precision and back
 		if(logPrecision >= WHQL)
 		{
@@ -1481,6 +1583,7 @@ namespace sw
 			}
 
 			external.dirty = false;
+			internalVersion++;
 			paletteUsed = Surface::paletteID;
 		}
 
@@ -1493,6 +1596,13 @@ namespace sw
 		case LOCK_READWRITE:
 		case LOCK_DISCARD:
 			dirtyContents = true;
+			internalVersion++;
+
+			// The renderer keeps it up to date when drawing
+			if(hierarchicalZ && client != MANAGED)
+			{
+				hierarchicalZ->invalidate();
+			}
 			break;
 		default:
 			ASSERT(false);
@@ -1527,6 +1637,11 @@ namespace sw
 			stencil.buffer = allocateBuffer(stencil.width, stencil.height, stencil.depth, stencil.border, stencil.samples, stencil.format);
 		}
 
+		if(stencilClear && client != MANAGED)
+		{
+			stencilClear->materialize();
+		}
+
 		return stencil.lockRect(x, y, front, LOCK_READWRITE);   // FIXME
 	}
 
@@ -1550,6 +1665,8 @@ namespace sw
 		case FORMAT_R3G3B2:				return 1;
 		case FORMAT_R16I:				return 2;
 		case FORMAT_R16UI:				return 2;
+		case FORMAT_R16_SNORM:			return 2;
+		case FORMAT_R16:				return 2;
 		case FORMAT_A8R3G3B2:			return 2;
 		case FORMAT_R5G6B5:				return 2;
 		case FORMAT_A1R5G5B5:			return 2;
@@ -1868,63 +1985,119 @@ namespace sw
 		{
 			ASSERT(source.dirty && !destination.dirty);
 
-			switch(source.format)
+			// Blocks are decoded independently, in bands of block rows of each slice
+			if(hasFourRowBlocks(source.format))
 			{
-			case FORMAT_R8G8B8:		decodeR8G8B8(destination, source);		break;   // FIXME: Check destination format
-			case FORMAT_X1R5G5B5:	decodeX1R5G5B5(destination, source);	break;   // FIXME: Check destination format
-			case FORMAT_A1R5G5B5:	decodeA1R5G5B5(destination, source);	break;   // FIXME: Check destination format
-			case FORMAT_X4R4G4B4:	decodeX4R4G4B4(destination, source);	break;   // FIXME: Check destination format
-			case FORMAT_A4R4G4B4:	decodeA4R4G4B4(destination, source);	break;   // FIXME: Check destination format
-			case FORMAT_P8:			decodeP8(destination, source);			break;   // FIXME: Check destination format
-			case FORMAT_DXT1:		decodeDXT1(destination, source);		break;   // FIXME: Check destination format
-			case FORMAT_DXT3:		decodeDXT3(destination, source);		break;   // FIXME: Check destination format
-			case FORMAT_DXT5:		decodeDXT5(destination, source);		break;   // FIXME: Check destination format
-			case FORMAT_ATI1:		decodeATI1(destination, source);		break;   // FIXME: Check destination format
-			case FORMAT_ATI2:		decodeATI2(destination, source);		break;   // FIXME: Check destination format
-			case FORMAT_R11_EAC:         decodeEAC(destination, source, 1, false); break; // FIXME: Check destination format
-			case FORMAT_SIGNED_R11_EAC:  decodeEAC(destination, source, 1, true);  break; // FIXME: Check destination format
-			case FORMAT_RG11_EAC:        decodeEAC(destination, source, 2, false); break; // FIXME: Check destination format
-			case FORMAT_SIGNED_RG11_EAC: decodeEAC(destination, source, 2, true);  break; // FIXME: Check destination format
-			case FORMAT_ETC1:
-			case FORMAT_RGB8_ETC2:                      decodeETC2(destination, source, 0, false); break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ETC2:                     decodeETC2(destination, source, 0, true);  break; // FIXME: Check destination format
-			case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:  decodeETC2(destination, source, 1, false); break; // FIXME: Check destination format
-			case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: decodeETC2(destination, source, 1, true);  break; // FIXME: Check destination format
-			case FORMAT_RGBA8_ETC2_EAC:                 decodeETC2(destination, source, 8, false); break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ETC2_EAC:          decodeETC2(destination, source, 8, true);  break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_4x4_KHR:           decodeASTC(destination, source, 4,  4,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_5x4_KHR:           decodeASTC(destination, source, 5,  4,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_5x5_KHR:           decodeASTC(destination, source, 5,  5,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_6x5_KHR:           decodeASTC(destination, source, 6,  5,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_6x6_KHR:           decodeASTC(destination, source, 6,  6,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_8x5_KHR:           decodeASTC(destination, source, 8,  5,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_8x6_KHR:           decodeASTC(destination, source, 8,  6,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_8x8_KHR:           decodeASTC(destination, source, 8,  8,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_10x5_KHR:          decodeASTC(destination, source, 10, 5,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_10x6_KHR:          decodeASTC(destination, source, 10, 6,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_10x8_KHR:          decodeASTC(destination, source, 10, 8,  1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_10x10_KHR:         decodeASTC(destination, source, 10, 10, 1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_12x10_KHR:         decodeASTC(destination, source, 12, 10, 1, false); break; // FIXME: Check destination format
-			case FORMAT_RGBA_ASTC_12x12_KHR:         decodeASTC(destination, source, 12, 12, 1, false); break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_4x4_KHR:   decodeASTC(destination, source, 4,  4,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_5x4_KHR:   decodeASTC(destination, source, 5,  4,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_5x5_KHR:   decodeASTC(destination, source, 5,  5,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_6x5_KHR:   decodeASTC(destination, source, 6,  5,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_6x6_KHR:   decodeASTC(destination, source, 6,  6,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_8x5_KHR:   decodeASTC(destination, source, 8,  5,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_8x6_KHR:   decodeASTC(destination, source, 8,  6,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_8x8_KHR:   decodeASTC(destination, source, 8,  8,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_10x5_KHR:  decodeASTC(destination, source, 10, 5,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_10x6_KHR:  decodeASTC(destination, source, 10, 6,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_10x8_KHR:  decodeASTC(destination, source, 10, 8,  1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_10x10_KHR: decodeASTC(destination, source, 10, 10, 1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_12x10_KHR: decodeASTC(destination, source, 12, 10, 1, true);  break; // FIXME: Check destination format
-			case FORMAT_SRGB8_ALPHA8_ASTC_12x12_KHR: decodeASTC(destination, source, 12, 12, 1, true);  break; // FIXME: Check destination format
-			default:				genericUpdate(destination, source);		break;
+				int blockRows = (source.height + 3) / 4;
+				int bands = 1;
+
+				if(source.width * source.height * source.depth >= minDecodeBandedArea)
+				{
+					bands = clamp(blockRows * 4 / minDecodeBandHeight, 1, (int)bandThreads);
+				}
+
+				if(bands > 1)
+				{
+					DecodeBands decodeBands = {&destination, &source, blockRows, bands};
+
+					WorkerPool::shared().run(decodeBand, &decodeBands, bands * source.depth);
+				}
+				else
+				{
+					decode(destination, source);
+				}
+			}
+			else
+			{
+				decode(destination, source);
 			}
 		}
 	}
 
+	void Surface::decodeBand(void *parameters, int index)
+	{
+		const DecodeBands &bands = *static_cast<DecodeBands*>(parameters);
+
+		int z = index / bands.count;
+		int band = index % bands.count;
+		int y0 = 4 * (bands.blockRows * band / bands.count);
+		int y1 = 4 * (bands.blockRows * (band + 1) / bands.count);
+
+		// Views of the band's rows, which the decoders treat as whole buffers
+		Buffer destination;
+		Buffer source;
+		destination = *bands.destination;
+		source = *bands.source;
+
+		destination.buffer = (unsigned char*)destination.buffer + z * destination.sliceB + y0 * destination.pitchB;
+		destination.height = min(y1, destination.height) - y0;
+		destination.depth = 1;
+
+		source.buffer = (unsigned char*)source.buffer + z * source.sliceB + (y0 / 4) * source.pitchB;
+		source.height = min(y1, source.height) - y0;
+		source.depth = 1;
+
+		decode(destination, source);
+	}
+
+	void Surface::decode(Buffer &destination, Buffer &source)
+	{
+		switch(source.format)
+		{
+		case FORMAT_R8G8B8:		decodeR8G8B8(destination, source);		break;   // FIXME: Check destination format
+		case FORMAT_X1R5G5B5:	decodeX1R5G5B5(destination, source);	break;   // FIXME: Check destination format
+		case FORMAT_A1R5G5B5:	decodeA1R5G5B5(destination, source);	break;   // FIXME: Check destination format
+		case FORMAT_X4R4G4B4:	decodeX4R4G4B4(destination, source);	break;   // FIXME: Check destination format
+		case FORMAT_A4R4G4B4:	decodeA4R4G4B4(destination, source);	break;   // FIXME: Check destination format
+		case FORMAT_P8:			decodeP8(destination, source);			break;   // FIXME: Check destination format
+		case FORMAT_DXT1:		decodeDXT1(destination, source);		break;   // FIXME: Check destination format
+		case FORMAT_DXT3:		decodeDXT3(destination, source);		break;   // FIXME: Check destination format
+		case FORMAT_DXT5:		decodeDXT5(destination, source);		break;   // FIXME: Check destination format
+		case FORMAT_ATI1:		decodeATI1(destination, source);		break;   // FIXME: Check destination format
+		case FORMAT_ATI2:		decodeATI2(destination, source);		break;   // FIXME: Check destination format
+		case FORMAT_R11_EAC:         decodeEAC(destination, source, 1, false); break; // FIXME: Check destination format
+		case FORMAT_SIGNED_R11_EAC:  decodeEAC(destination, source, 1, true);  break; // FIXME: Check destination format
+		case FORMAT_RG11_EAC:        decodeEAC(destination, source, 2, false); break; // FIXME: Check destination format
+		case FORMAT_SIGNED_RG11_EAC: decodeEAC(destination, source, 2, true);  break; // FIXME: Check destination format
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:                      decodeETC2(destination, source, 0, false); break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ETC2:                     decodeETC2(destination, source, 0, true);  break; // FIXME: Check destination format
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:  decodeETC2(destination, source, 1, false); break; // FIXME: Check destination format
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: decodeETC2(destination, source, 1, true);  break; // FIXME: Check destination format
+		case FORMAT_RGBA8_ETC2_EAC:                 decodeETC2(destination, source, 8, false); break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:          decodeETC2(destination, source, 8, true);  break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_4x4_KHR:           decodeASTC(destination, source, 4,  4,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_5x4_KHR:           decodeASTC(destination, source, 5,  4,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_5x5_KHR:           decodeASTC(destination, source, 5,  5,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_6x5_KHR:           decodeASTC(destination, source, 6,  5,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_6x6_KHR:           decodeASTC(destination, source, 6,  6,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_8x5_KHR:           decodeASTC(destination, source, 8,  5,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_8x6_KHR:           decodeASTC(destination, source, 8,  6,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_8x8_KHR:           decodeASTC(destination, source, 8,  8,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_10x5_KHR:          decodeASTC(destination, source, 10, 5,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_10x6_KHR:          decodeASTC(destination, source, 10, 6,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_10x8_KHR:          decodeASTC(destination, source, 10, 8,  1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_10x10_KHR:         decodeASTC(destination, source, 10, 10, 1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_12x10_KHR:         decodeASTC(destination, source, 12, 10, 1, false); break; // FIXME: Check destination format
+		case FORMAT_RGBA_ASTC_12x12_KHR:         decodeASTC(destination, source, 12, 12, 1, false); break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_4x4_KHR:   decodeASTC(destination, source, 4,  4,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_5x4_KHR:   decodeASTC(destination, source, 5,  4,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_5x5_KHR:   decodeASTC(destination, source, 5,  5,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_6x5_KHR:   decodeASTC(destination, source, 6,  5,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_6x6_KHR:   decodeASTC(destination, source, 6,  6,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_8x5_KHR:   decodeASTC(destination, source, 8,  5,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_8x6_KHR:   decodeASTC(destination, source, 8,  6,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_8x8_KHR:   decodeASTC(destination, source, 8,  8,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_10x5_KHR:  decodeASTC(destination, source, 10, 5,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_10x6_KHR:  decodeASTC(destination, source, 10, 6,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_10x8_KHR:  decodeASTC(destination, source, 10, 8,  1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_10x10_KHR: decodeASTC(destination, source, 10, 10, 1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_12x10_KHR: decodeASTC(destination, source, 12, 10, 1, true);  break; // FIXME: Check destination format
+		case FORMAT_SRGB8_ALPHA8_ASTC_12x12_KHR: decodeASTC(destination, source, 12, 12, 1, true);  break; // FIXME: Check destination format
+		default:				genericUpdate(destination, source);		break;
+		}
+	}
+
 	void Surface::genericUpdate(Buffer &destination, Buffer &source)
 	{
 		unsigned char *sourceSlice = (unsigned char*)source.lockRect(0, 0, 0, sw::LOCK_READONLY);
@@ -2294,7 +2467,7 @@ namespace sw
 					{
 						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 						{
-							dest[(x + i) + (y + j) * internal.width] = c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4];
+							dest[(x + i) + (y + j) * internal.pitchP] = c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4];
 						}
 					}
 
@@ -2344,7 +2517,7 @@ namespace sw
 							unsigned int a = (unsigned int)(source->a >> 4 * (i + j * 4)) & 0x0F;
 							unsigned int color = (c[(unsigned int)(source->lut >> 2 * (i + j * 4)) % 4] & 0x00FFFFFF) | ((a << 28) + (a << 24));
 
-							dest[(x + i) + (y + j) * internal.width] = color;
+							dest[(x + i) + (y + j) * internal.pitchP] = color;
 						}
 					}
 
@@ -2418,7 +2591,7 @@ namespace sw
 							unsigned int alpha = (unsigned int)a[(unsigned int)(source->alut >> (16 + 3 * (i + j * 4))) % 8] << 24;
 							unsigned int color = (c[(source->clut >> 2 * (i + j * 4)) % 4] & 0x00FFFFFF) | alpha;
 
-							dest[(x + i) + (y + j) * internal.width] = color;
+							dest[(x + i) + (y + j) * internal.pitchP] = color;
 						}
 					}
 
@@ -2474,7 +2647,7 @@ namespace sw
 					{
 						for(int i = 0; i < 4 && (x + i) < internal.width; i++)
 						{
-							dest[(x + i) + (y + j) * internal.width] = r[(unsigned int)(source->rlut >> (16 + 3 * (i + j * 4))) % 8];
+							dest[(x + i) + (y + j) * internal.pitchP] = r[(unsigned int)(source->rlut >> (16 + 3 * (i + j * 4))) % 8];
 						}
 					}
 
@@ -2557,7 +2730,7 @@ namespace sw
 							word r = X[(unsigned int)(source->xlut >> (16 + 3 * (i + j * 4))) % 8];
 							word g = Y[(unsigned int)(source->ylut >> (16 + 3 * (i + j * 4))) % 8];
 
-							dest[(x + i) + (y + j) * internal.width] = (g << 8) + r;
+							dest[(x + i) + (y + j) * internal.pitchP] = (g << 8) + r;
 						}
 					}
 
@@ -2581,16 +2754,19 @@ namespace sw
 
 		if(isSRGB)
 		{
-			static byte sRGBtoLinearTable[256];
-			static bool sRGBtoLinearTableDirty = true;
-			if(sRGBtoLinearTableDirty)
+			// Initialized once, also when bands get decoded concurrently
+			static const struct SRGBtoLinearTable
 			{
-				for(int i = 0; i < 256; i++)
+				SRGBtoLinearTable()
 				{
-					sRGBtoLinearTable[i] = static_cast<byte>(sRGBtoLinear(static_cast<float>(i) / 255.0f) * 255.0f + 0.5f);
+					for(int i = 0; i < 256; i++)
+					{
+						value[i] = static_cast<byte>(sRGBtoLinear(static_cast<float>(i) / 255.0f) * 255.0f + 0.5f);
+					}
 				}
-				sRGBtoLinearTableDirty = false;
-			}
+
+				byte value[256];
+			} sRGBtoLinearTable;
 
 			// Perform sRGB conversion in place after decoding
 			byte *src = (byte*)internal.lockRect(0, 0, 0, LOCK_READWRITE);
@@ -2602,7 +2778,7 @@ namespace sw
 					byte *srcPix = srcRow + x * internal.bytes;
 					for(int i = 0; i < 3; i++)
 					{
-						srcPix[i] = sRGBtoLinearTable[srcPix[i]];
+						srcPix[i] = sRGBtoLinearTable.value[srcPix[i]];
 					}
 				}
 			}
@@ -2614,28 +2790,10 @@ namespace sw
 	{
 		ASSERT(nbChannels == 1 || nbChannels == 2);
 
-		byte *src = (byte*)internal.lockRect(0, 0, 0, LOCK_READWRITE);
-		ETC_Decoder::Decode((const byte*)external.lockRect(0, 0, 0, LOCK_READONLY), src, external.width, external.height, internal.width, internal.height, internal.pitchB, internal.bytes,
+		// Decoded directly to 16-bit normalized values
+		ETC_Decoder::Decode((const byte*)external.lockRect(0, 0, 0, LOCK_READONLY), (byte*)internal.lockRect(0, 0, 0, LOCK_UPDATE), external.width, external.height, internal.width, internal.height, internal.pitchB, internal.bytes,
 		                    (nbChannels == 1) ? (isSigned ? ETC_Decoder::ETC_R_SIGNED : ETC_Decoder::ETC_R_UNSIGNED) : (isSigned ? ETC_Decoder::ETC_RG_SIGNED : ETC_Decoder::ETC_RG_UNSIGNED));
 		external.unlockRect();
-
-		// FIXME: We convert EAC data to float, until signed short internal formats are supported
-		//        This code can be removed if ETC2 images are decoded to internal 16 bit signed R/RG formats
-		const float normalization = isSigned ? (1.0f / (8.0f * 127.875f)) : (1.0f / (8.0f * 255.875f));
-		for(int y = 0; y < internal.height; y++)
-		{
-			byte* srcRow = src + y * internal.pitchB;
-			for(int x = internal.width - 1; x >= 0; x--)
-			{
-				int* srcPix = reinterpret_cast<int*>(srcRow + x * internal.bytes);
-				float* dstPix = reinterpret_cast<float*>(srcPix);
-				for(int c = nbChannels - 1; c >= 0; c--)
-				{
-					dstPix[c] = clamp(static_cast<float>(srcPix[c]) * normalization, -1.0f, 1.0f);
-				}
-			}
-		}
-
 		internal.unlockRect();
 	}
 
@@ -2857,6 +3015,8 @@ namespace sw
 		case FORMAT_A8B8G8R8_SNORM:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
+		case FORMAT_R16_SNORM:
+		case FORMAT_R16:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 		case FORMAT_G16R16:
@@ -2889,6 +3049,16 @@ namespace sw
 		case FORMAT_X32B32G32R32UI:
 		case FORMAT_A32B32G32R32I:
 		case FORMAT_A32B32G32R32UI:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return false;
 		case FORMAT_R16F:
 		case FORMAT_G16R16F:
@@ -2940,6 +3110,7 @@ namespace sw
 		case FORMAT_A2B10G10R10:
 		case FORMAT_A2B10G10R10UI:
 		case FORMAT_R16UI:
+		case FORMAT_R16:
 		case FORMAT_G16R16:
 		case FORMAT_G16R16UI:
 		case FORMAT_X16B16G16R16UI:
@@ -2970,6 +3141,16 @@ namespace sw
 		case FORMAT_YV12_BT601:
 		case FORMAT_YV12_BT709:
 		case FORMAT_YV12_JFIF:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return true;
 		case FORMAT_A8B8G8R8I:
 		case FORMAT_A16B16G16R16I:
@@ -2977,17 +3158,21 @@ namespace sw
 		case FORMAT_A8B8G8R8_SNORM:
 		case FORMAT_Q8W8V8U8:
 		case FORMAT_Q16W16V16U16:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_A32B32G32R32F:
 			return false;
+		case FORMAT_R16F:
 		case FORMAT_R32F:
 		case FORMAT_R8I:
 		case FORMAT_R16I:
 		case FORMAT_R32I:
 		case FORMAT_R8_SNORM:
+		case FORMAT_R16_SNORM:
 			return component >= 1;
 		case FORMAT_V8U8:
 		case FORMAT_X8L8V8U8:
 		case FORMAT_V16U16:
+		case FORMAT_G16R16F:
 		case FORMAT_G32R32F:
 		case FORMAT_G8R8I:
 		case FORMAT_G16R16I:
@@ -2995,6 +3180,8 @@ namespace sw
 		case FORMAT_G8R8_SNORM:
 			return component >= 2;
 		case FORMAT_A16W16V16U16:
+		case FORMAT_B16G16R16F:
+		case FORMAT_X16B16G16R16F:
 		case FORMAT_B32G32R32F:
 		case FORMAT_X32B32G32R32F:
 		case FORMAT_X8B8G8R8I:
@@ -3063,6 +3250,9 @@ namespace sw
 		{
 		case FORMAT_SRGB8_X8:
 		case FORMAT_SRGB8_A8:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return true;
 		default:
 			return false;
@@ -3227,6 +3417,10 @@ namespace sw
 		case FORMAT_V16U16:         return 2;
 		case FORMAT_A16W16V16U16:   return 4;
 		case FORMAT_Q16W16V16U16:   return 4;
+		case FORMAT_R16F:           return 1;
+		case FORMAT_G16R16F:        return 2;
+		case FORMAT_X16B16G16R16F:  return 3;
+		case FORMAT_A16B16G16R16F:  return 4;
 		case FORMAT_R32F:           return 1;
 		case FORMAT_G32R32F:        return 2;
 		case FORMAT_X32B32G32R32F:  return 3;
@@ -3243,6 +3437,8 @@ namespace sw
 		case FORMAT_R8:             return 1;
 		case FORMAT_R16I:           return 1;
 		case FORMAT_R16UI:          return 1;
+		case FORMAT_R16_SNORM:      return 1;
+		case FORMAT_R16:            return 1;
 		case FORMAT_R32I:           return 1;
 		case FORMAT_R32UI:          return 1;
 		case FORMAT_L8:             return 1;
@@ -3251,6 +3447,16 @@ namespace sw
 		case FORMAT_YV12_BT601:     return 3;
 		case FORMAT_YV12_BT709:     return 3;
 		case FORMAT_YV12_JFIF:      return 3;
+		case FORMAT_DXT1:           return 4;
+		case FORMAT_DXT3:           return 4;
+		case FORMAT_DXT5:           return 4;
+		case FORMAT_ETC1:           return 3;
+		case FORMAT_RGB8_ETC2:      return 3;
+		case FORMAT_SRGB8_ETC2:     return 3;
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:  return 4;
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: return 4;
+		case FORMAT_RGBA8_ETC2_EAC:                 return 4;
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:          return 4;
 		default:
 			ASSERT(false);
 		}
@@ -3376,7 +3582,17 @@ namespace sw
 		int x1 = x0 + width;
 		int y1 = y0 + height;
 
-		if(!hasQuadLayout(internal.format))
+		// Locking for writing invalidates the hierarchical Z buffer, but a clear keeps it exact
+		const bool hierarchicalZValid = hierarchicalZ && hierarchicalZ->isValid();
+		const float clearValue = depth;
+
+		if(entire && internalClear)
+		{
+			float pattern = (hasQuadLayout(internal.format) && complementaryDepthBuffer) ? 1 - depth : depth;
+
+			deferClear((unsigned int&)pattern);
+		}
+		else if(!hasQuadLayout(internal.format))
 		{
 			float *target = (float*)lockInternal(x0, y0, 0, lock, PUBLIC);
 
@@ -3475,6 +3691,11 @@ namespace sw
 
 			unlockInternal();
 		}
+
+		if(hierarchicalZ)
+		{
+			hierarchicalZ->clear(clearValue, x0, y0, x1, y1, entire || hierarchicalZValid);
+		}
 	}
 
 	void Surface::clearStencil(unsigned char s, unsigned char mask, int x0, int y0, int width, int height)
@@ -3506,6 +3727,22 @@ namespace sw
 		unsigned int fill = maskedS;
 		fill = fill | (fill << 8) | (fill << 16) | (fill << 24);
 
+		if(x0 == 0 && y0 == 0 && width == stencil.width && height == stencil.height && mask == 0xFF && stencilClear)
+		{
+			resource->lock(PUBLIC);
+
+			// Replaced without writing it first
+			stencilClear->discard();
+
+			void *buffer = lockStencil(0, 0, 0, PUBLIC);
+			stencilClear->defer(buffer, stencil.pitchB, stencil.sliceB, stencil.samples, fill);
+			unlockStencil();
+
+			resource->unlock();
+
+			return;
+		}
+
 		char *buffer = (char*)lockStencil(0, 0, 0, PUBLIC);
 
 		// Stencil buffers are assumed to use quad layout
@@ -3607,6 +3844,114 @@ namespace sw
 		}
 	}
 
+	bool Surface::deferClear(unsigned int pattern)
+	{
+		if(!internalClear)
+		{
+			return false;
+		}
+
+		resource->lock(PUBLIC);
+
+		// Replaced without writing it first
+		internalClear->discard();
+
+		void *buffer = lockInternal(0, 0, 0, LOCK_DISCARD, PUBLIC);
+		internalClear->defer(buffer, internal.pitchB, internal.sliceB, internal.samples, pattern);
+		unlockInternal();
+
+		resource->unlock();
+
+		return true;
+	}
+
+	void Surface::materializeClear(int y0, int y1)
+	{
+		if(internalClear)
+		{
+			internalClear->materialize(y0, y1);
+		}
+	}
+
+	void Surface::materializeStencilClear(int y0, int y1)
+	{
+		if(stencilClear)
+		{
+			stencilClear->materialize(y0, y1);
+		}
+	}
+
+	bool Surface::isTileable() const
+	{
+		// Surfaces without a parent texture may be backed by client memory which changes behind our back
+		if(!hasParent || internal.depth != 1 || internal.samples != 1 || internal.border != 0)
+		{
+			return false;
+		}
+
+		switch(internal.format)
+		{
+		case FORMAT_YV12_BT601:
+		case FORMAT_YV12_BT709:
+		case FORMAT_YV12_JFIF:
+			return false;   // Planar
+		default:
+			break;
+		}
+
+		return internal.bytes != 0 && !isCompressed(internal.format) && !isDepth(internal.format) && !isStencil(internal.format);
+	}
+
+	void *Surface::getTiledInternal()
+	{
+		ASSERT(isTileable());
+
+		tiledMutex.lock();
+
+		if(!tiled || tiledVersion != internalVersion || external.dirty)
+		{
+			// Waits for the renderer to finish writing the contents, and reading the previous copy
+			const void *source = lockInternal(0, 0, 0, LOCK_READONLY, PUBLIC);
+
+			if(!tiled)
+			{
+				size_t size = getTiledSliceP() * internal.bytes;
+				tiled = allocate(size, 64);   // Tiles of 32-bit texels fill cache lines
+				memset(tiled, 0, size);
+			}
+
+			tile(source);
+			tiledVersion = internalVersion;
+
+			unlockInternal();
+		}
+
+		void *buffer = tiled;
+		tiledMutex.unlock();
+
+		return buffer;
+	}
+
+	void Surface::tile(const void *source)
+	{
+		const int width = internal.width;
+		const int height = internal.height;
+		const int bytes = internal.bytes;
+		const int tilePitchB = getTiledPitchP() * 4 * bytes;   // One row of tiles
+		const int tileB = 16 * bytes;
+
+		for(int y = 0; y < height; y++)
+		{
+			const byte *sourceRow = (const byte*)source + y * internal.pitchB;
+			byte *tiledRow = (byte*)tiled + (y / 4) * tilePitchB + (y % 4) * 4 * bytes;
+
+			for(int x = 0; x < width; x += 4)
+			{
+				memcpy(tiledRow + (x / 4) * tileB, sourceRow + x * bytes, min(width - x, 4) * bytes);
+			}
+		}
+	}
+
 	void Surface::copyInternal(const Surface *source, int x, int y, float srcX, float srcY, bool filter)
 	{
 		ASSERT(internal.lock != LOCK_UNLOCKED && source && source->internal.lock != LOCK_UNLOCKED);
@@ -3765,7 +4110,7 @@ namespace sw
 		       external.samples == internal.samples;
 	}
 
-	Format Surface::selectInternalFormat(Format format) const
+	Format Surface::selectInternalFormat(Format format, int border) const
 	{
 		switch(format)
 		{
@@ -3791,6 +4136,10 @@ namespace sw
 			return FORMAT_R16I;
 		case FORMAT_R16UI:
 			return FORMAT_R16UI;
+		case FORMAT_R16_SNORM:
+			return FORMAT_R16_SNORM;
+		case FORMAT_R16:
+			return FORMAT_R16;
 		case FORMAT_R32I:
 			return FORMAT_R32I;
 		case FORMAT_R32UI:
@@ -3890,6 +4239,8 @@ namespace sw
 		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
 		case FORMAT_RGBA8_ETC2_EAC:
 		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
+			// The sampler decodes the blocks on the fly, but border texels can't be stored in them
+			return (border == 0) ? format : FORMAT_A8R8G8B8;
 		case FORMAT_SRGB8_ALPHA8_ASTC_4x4_KHR:
 		case FORMAT_SRGB8_ALPHA8_ASTC_5x4_KHR:
 		case FORMAT_SRGB8_ALPHA8_ASTC_5x5_KHR:
@@ -3924,17 +4275,19 @@ namespace sw
 		case FORMAT_ATI1:
 			return FORMAT_R8;
 		case FORMAT_R11_EAC:
+			return FORMAT_R16;
 		case FORMAT_SIGNED_R11_EAC:
-			return FORMAT_R32F; // FIXME: Signed 8bit format would be sufficient
+			return FORMAT_R16_SNORM;
 		case FORMAT_ATI2:
 			return FORMAT_G8R8;
 		case FORMAT_RG11_EAC:
+			return FORMAT_G16R16;
 		case FORMAT_SIGNED_RG11_EAC:
-			return FORMAT_G32R32F; // FIXME: Signed 8bit format would be sufficient
+			return FORMAT_V16U16;   // Signed 16-bit normalized
 		case FORMAT_ETC1:
 		case FORMAT_RGB8_ETC2:
 		case FORMAT_SRGB8_ETC2:
-			return FORMAT_X8R8G8B8;
+			return (border == 0) ? format : FORMAT_X8R8G8B8;
 		// Bumpmap formats
 		case FORMAT_V8U8:			return FORMAT_V8U8;
 		case FORMAT_L6V5U5:			return FORMAT_X8L8V8U8;
@@ -3944,12 +4297,12 @@ namespace sw
 		case FORMAT_A2W10V10U10:	return FORMAT_A16W16V16U16;
 		case FORMAT_Q16W16V16U16:	return FORMAT_Q16W16V16U16;
 		// Floating-point formats
-		case FORMAT_A16F:			return FORMAT_A32B32G32R32F;
-		case FORMAT_R16F:			return FORMAT_R32F;
-		case FORMAT_G16R16F:		return FORMAT_G32R32F;
-		case FORMAT_B16G16R16F:     return FORMAT_X32B32G32R32F;
-		case FORMAT_X16B16G16R16F:	return FORMAT_X32B32G32R32F;
-		case FORMAT_A16B16G16R16F:	return FORMAT_A32B32G32R32F;
+		case FORMAT_A16F:			return FORMAT_A16B16G16R16F;
+		case FORMAT_R16F:			return FORMAT_R16F;
+		case FORMAT_G16R16F:		return FORMAT_G16R16F;
+		case FORMAT_B16G16R16F:     return FORMAT_X16B16G16R16F;
+		case FORMAT_X16B16G16R16F:	return FORMAT_X16B16G16R16F;
+		case FORMAT_A16B16G16R16F:	return FORMAT_A16B16G16R16F;
 		case FORMAT_X16B16G16R16F_UNSIGNED: return FORMAT_X32B32G32R32F_UNSIGNED;
 		case FORMAT_A32F:			return FORMAT_A32B32G32R32F;
 		case FORMAT_R32F:			return FORMAT_R32F;
@@ -3963,8 +4316,8 @@ namespace sw
 		case FORMAT_A4L4:			return FORMAT_A8L8;
 		case FORMAT_L16:			return FORMAT_L16;
 		case FORMAT_A8L8:			return FORMAT_A8L8;
-		case FORMAT_L16F:           return FORMAT_X32B32G32R32F;
-		case FORMAT_A16L16F:        return FORMAT_A32B32G32R32F;
+		case FORMAT_L16F:           return FORMAT_X16B16G16R16F;
+		case FORMAT_A16L16F:        return FORMAT_A16B16G16R16F;
 		case FORMAT_L32F:           return FORMAT_X32B32G32R32F;
 		case FORMAT_A32L32F:        return FORMAT_A32B32G32R32F;
 		// Depth/stencil formats
@@ -4022,1815 +4375,409 @@ namespace sw
 		Surface::paletteID++;
 	}
 
-	void Surface::resolve()
+	// Averages of the samples, combined pairwise in the same order for every sample count and
+	// instruction set, so that all paths produce identical results
+	struct ResolveUnorm8
 	{
-		if(internal.samples <= 1 || !internal.dirty || !renderTarget || internal.format == FORMAT_NULL)
-		{
-			return;
-		}
+		typedef unsigned char Element;
 
-		ASSERT(internal.depth == 1);  // Unimplemented
+		static inline Element combine(Element x, Element y) { return (x + y + 1) >> 1; }
+		static inline Element finish(Element x, int samples) { return x; }
 
-		void *source = internal.lockRect(0, 0, 0, LOCK_READWRITE);
+		#if defined(__i386__) || defined(__x86_64__)
+			static inline __m128i combine(__m128i x, __m128i y) { return _mm_avg_epu8(x, y); }
+			static inline __m128i finish(__m128i x, int samples) { return x; }
 
-		int width = internal.width;
-		int height = internal.height;
-		int pitch = internal.pitchB;
-		int slice = internal.sliceB;
+			AVX2_FUNCTION static inline __m256i combine(__m256i x, __m256i y) { return _mm256_avg_epu8(x, y); }
+			AVX2_FUNCTION static inline __m256i finish(__m256i x, int samples) { return x; }
+		#endif
+	};
 
-		unsigned char *source0 = (unsigned char*)source;
-		unsigned char *source1 = source0 + slice;
-		unsigned char *source2 = source1 + slice;
-		unsigned char *source3 = source2 + slice;
-		unsigned char *source4 = source3 + slice;
-		unsigned char *source5 = source4 + slice;
-		unsigned char *source6 = source5 + slice;
-		unsigned char *source7 = source6 + slice;
-		unsigned char *source8 = source7 + slice;
-		unsigned char *source9 = source8 + slice;
-		unsigned char *sourceA = source9 + slice;
-		unsigned char *sourceB = sourceA + slice;
-		unsigned char *sourceC = sourceB + slice;
-		unsigned char *sourceD = sourceC + slice;
-		unsigned char *sourceE = sourceD + slice;
-		unsigned char *sourceF = sourceE + slice;
+	struct ResolveUnorm16
+	{
+		typedef unsigned short Element;
 
-		if(internal.format == FORMAT_X8R8G8B8 || internal.format == FORMAT_A8R8G8B8 ||
-		   internal.format == FORMAT_X8B8G8R8 || internal.format == FORMAT_A8B8G8R8 ||
-		   internal.format == FORMAT_SRGB8_X8 || internal.format == FORMAT_SRGB8_A8)
-		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 4) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
+		static inline Element combine(Element x, Element y) { return (x + y + 1) >> 1; }
+		static inline Element finish(Element x, int samples) { return x; }
 
-								c0 = _mm_avg_epu8(c0, c1);
+		#if defined(__i386__) || defined(__x86_64__)
+			static inline __m128i combine(__m128i x, __m128i y) { return _mm_avg_epu16(x, y); }
+			static inline __m128i finish(__m128i x, int samples) { return x; }
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+			AVX2_FUNCTION static inline __m256i combine(__m256i x, __m256i y) { return _mm256_avg_epu16(x, y); }
+			AVX2_FUNCTION static inline __m256i finish(__m256i x, int samples) { return x; }
+		#endif
+	};
 
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
+	struct ResolveFloat
+	{
+		typedef float Element;
 
-								c0 = _mm_avg_epu8(c0, c1);
-								c2 = _mm_avg_epu8(c2, c3);
-								c0 = _mm_avg_epu8(c0, c2);
+		static inline Element combine(Element x, Element y) { return x + y; }
+		static inline Element finish(Element x, int samples) { return x * (1.0f / samples); }
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+		#if defined(__i386__) || defined(__x86_64__)
+			static inline __m128i combine(__m128i x, __m128i y)
+			{
+				return _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(y)));
+			}
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-
-								c0 = _mm_avg_epu8(c0, c1);
-								c2 = _mm_avg_epu8(c2, c3);
-								c4 = _mm_avg_epu8(c4, c5);
-								c6 = _mm_avg_epu8(c6, c7);
-								c0 = _mm_avg_epu8(c0, c2);
-								c4 = _mm_avg_epu8(c4, c6);
-								c0 = _mm_avg_epu8(c0, c4);
+			static inline __m128i finish(__m128i x, int samples)
+			{
+				return _mm_castps_si128(_mm_mul_ps(_mm_castsi128_ps(x), _mm_set1_ps(1.0f / samples)));
+			}
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+			AVX2_FUNCTION static inline __m256i combine(__m256i x, __m256i y)
+			{
+				return _mm256_castps_si256(_mm256_add_ps(_mm256_castsi256_ps(x), _mm256_castsi256_ps(y)));
+			}
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 4 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 4 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 4 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 4 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 4 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 4 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 4 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 4 * x));
-
-								c0 = _mm_avg_epu8(c0, c1);
-								c2 = _mm_avg_epu8(c2, c3);
-								c4 = _mm_avg_epu8(c4, c5);
-								c6 = _mm_avg_epu8(c6, c7);
-								c8 = _mm_avg_epu8(c8, c9);
-								cA = _mm_avg_epu8(cA, cB);
-								cC = _mm_avg_epu8(cC, cD);
-								cE = _mm_avg_epu8(cE, cF);
-								c0 = _mm_avg_epu8(c0, c2);
-								c4 = _mm_avg_epu8(c4, c6);
-								c8 = _mm_avg_epu8(c8, cA);
-								cC = _mm_avg_epu8(cC, cE);
-								c0 = _mm_avg_epu8(c0, c4);
-								c8 = _mm_avg_epu8(c8, cC);
-								c0 = _mm_avg_epu8(c0, c8);
+			AVX2_FUNCTION static inline __m256i finish(__m256i x, int samples)
+			{
+				return _mm256_castps_si256(_mm256_mul_ps(_mm256_castsi256_ps(x), _mm256_set1_ps(1.0f / samples)));
+			}
+		#endif
+	};
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+	// Averaged pairwise, since the sums could overflow. Conversions use the same bit manipulation in
+	// every path, like the shaders' floatToHalf and halfToFloat, instead of the half class.
+	struct ResolveHalf
+	{
+		typedef unsigned short Element;
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
+		static inline float toFloat(Element x)
+		{
+			uint32_t expmant = x & 0x7FFF;
+			uint32_t bits = expmant << 13;
+			float f;
+			memcpy(&f, &bits, sizeof(f));
+			f *= 5.19229685853482763e+33f;   // 2^112
+			memcpy(&bits, &f, sizeof(bits));
+			bits |= (x ^ expmant) << 16;
+			bits |= (expmant > 0x7BFF) ? (255 << 23) : 0;
+			memcpy(&f, &bits, sizeof(f));
+			return f;
+		}
+
+		static inline Element toHalf(float x)
+		{
+			uint32_t bits;
+			memcpy(&bits, &x, sizeof(bits));
+			uint32_t sign = bits & 0x80000000u;
+			bits = (bits ^ sign) & ~0xFFFu;
+			float f;
+			memcpy(&f, &bits, sizeof(f));
+			f *= 1.92592994438723585e-34f;   // 2^-112
+			float clamp;
+			uint32_t clampBits = (31 << 23) - 0x1000;
+			memcpy(&clamp, &clampBits, sizeof(clamp));
+			f = (clamp < f) ? clamp : f;   // Keeps NaN, like minps
+			memcpy(&bits, &f, sizeof(bits));
+			return (Element)((((bits + 0x1000) >> 13) & 0x7FFF) | (sign >> 16));
+		}
+
+		static inline Element combine(Element x, Element y) { return toHalf((toFloat(x) + toFloat(y)) * 0.5f); }
+		static inline Element finish(Element x, int samples) { return x; }
+
+		#if defined(__i386__) || defined(__x86_64__)
+			static inline __m128 toFloat(__m128i x)   // Halves in the low 16 bits
 			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7F7F7F7F) + (((x) ^ (y)) & 0x01010101))
+				__m128i expmant = _mm_and_si128(x, _mm_set1_epi32(0x7FFF));
+				__m128 f = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), _mm_set1_ps(5.19229685853482763e+33f));
+				__m128i sign = _mm_slli_epi32(_mm_xor_si128(x, expmant), 16);
+				__m128i infnan = _mm_and_si128(_mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+				return _mm_or_ps(f, _mm_castsi128_ps(_mm_or_si128(sign, infnan)));
+			}
 
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
+			static inline __m128i toHalf(__m128 x)   // Sign extended, for packing with signed saturation
+			{
+				__m128i sign = _mm_and_si128(_mm_castps_si128(x), _mm_set1_epi32(0x80000000u));
+				__m128i absf = _mm_andnot_si128(_mm_set1_epi32(0xFFF), _mm_xor_si128(_mm_castps_si128(x), sign));
+				__m128 f = _mm_mul_ps(_mm_castsi128_ps(absf), _mm_set1_ps(1.92592994438723585e-34f));
+				f = _mm_min_ps(_mm_castsi128_ps(_mm_set1_epi32((31 << 23) - 0x1000)), f);
+				__m128i joined = _mm_and_si128(_mm_srli_epi32(_mm_add_epi32(_mm_castps_si128(f), _mm_set1_epi32(0x1000)), 13), _mm_set1_epi32(0x7FFF));
+				return _mm_or_si128(joined, _mm_srai_epi32(sign, 16));
+			}
 
-							c0 = AVERAGE(c0, c1);
+			static inline __m128i combine(__m128i x, __m128i y)
+			{
+				__m128i zero = _mm_setzero_si128();
+				__m128 half = _mm_set1_ps(0.5f);
+				__m128 low = _mm_mul_ps(_mm_add_ps(toFloat(_mm_unpacklo_epi16(x, zero)), toFloat(_mm_unpacklo_epi16(y, zero))), half);
+				__m128 high = _mm_mul_ps(_mm_add_ps(toFloat(_mm_unpackhi_epi16(x, zero)), toFloat(_mm_unpackhi_epi16(y, zero))), half);
+				return _mm_packs_epi32(toHalf(low), toHalf(high));
+			}
 
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
+			static inline __m128i finish(__m128i x, int samples) { return x; }
 
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
+			AVX2_FUNCTION static inline __m256 toFloat(__m256i x)
+			{
+				__m256i expmant = _mm256_and_si256(x, _mm256_set1_epi32(0x7FFF));
+				__m256 f = _mm256_mul_ps(_mm256_castsi256_ps(_mm256_slli_epi32(expmant, 13)), _mm256_set1_ps(5.19229685853482763e+33f));
+				__m256i sign = _mm256_slli_epi32(_mm256_xor_si256(x, expmant), 16);
+				__m256i infnan = _mm256_and_si256(_mm256_cmpgt_epi32(expmant, _mm256_set1_epi32(0x7BFF)), _mm256_set1_epi32(255 << 23));
+				return _mm256_or_ps(f, _mm256_castsi256_ps(_mm256_or_si256(sign, infnan)));
+			}
 
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
+			AVX2_FUNCTION static inline __m256i toHalf(__m256 x)
+			{
+				__m256i sign = _mm256_and_si256(_mm256_castps_si256(x), _mm256_set1_epi32(0x80000000u));
+				__m256i absf = _mm256_andnot_si256(_mm256_set1_epi32(0xFFF), _mm256_xor_si256(_mm256_castps_si256(x), sign));
+				__m256 f = _mm256_mul_ps(_mm256_castsi256_ps(absf), _mm256_set1_ps(1.92592994438723585e-34f));
+				f = _mm256_min_ps(_mm256_castsi256_ps(_mm256_set1_epi32((31 << 23) - 0x1000)), f);
+				__m256i joined = _mm256_and_si256(_mm256_srli_epi32(_mm256_add_epi32(_mm256_castps_si256(f), _mm256_set1_epi32(0x1000)), 13), _mm256_set1_epi32(0x7FFF));
+				return _mm256_or_si256(joined, _mm256_srai_epi32(sign, 16));
+			}
 
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
+			// Unpacking and packing both work within 128-bit lanes, so the order of the halves is kept
+			AVX2_FUNCTION static inline __m256i combine(__m256i x, __m256i y)
+			{
+				__m256i zero = _mm256_setzero_si256();
+				__m256 half = _mm256_set1_ps(0.5f);
+				__m256 low = _mm256_mul_ps(_mm256_add_ps(toFloat(_mm256_unpacklo_epi16(x, zero)), toFloat(_mm256_unpacklo_epi16(y, zero))), half);
+				__m256 high = _mm256_mul_ps(_mm256_add_ps(toFloat(_mm256_unpackhi_epi16(x, zero)), toFloat(_mm256_unpackhi_epi16(y, zero))), half);
+				return _mm256_packs_epi32(toHalf(low), toHalf(high));
+			}
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
+			AVX2_FUNCTION static inline __m256i finish(__m256i x, int samples) { return x; }
+		#endif
+	};
 
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
+	template<class Resolve, int samples>
+	static void resolveRow(unsigned char *row, int slice, int bytes)
+	{
+		typedef typename Resolve::Element Element;
 
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
+		for(int x = 0; x < bytes; x += sizeof(Element))
+		{
+			Element c[samples];
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
+			for(int s = 0; s < samples; s++)
+			{
+				c[s] = *(Element*)(row + s * slice + x);
+			}
+
+			for(int n = samples / 2; n >= 1; n /= 2)
+			{
+				for(int s = 0; s < n; s++)
 				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-							unsigned int c8 = *(unsigned int*)(source8 + 4 * x);
-							unsigned int c9 = *(unsigned int*)(source9 + 4 * x);
-							unsigned int cA = *(unsigned int*)(sourceA + 4 * x);
-							unsigned int cB = *(unsigned int*)(sourceB + 4 * x);
-							unsigned int cC = *(unsigned int*)(sourceC + 4 * x);
-							unsigned int cD = *(unsigned int*)(sourceD + 4 * x);
-							unsigned int cE = *(unsigned int*)(sourceE + 4 * x);
-							unsigned int cF = *(unsigned int*)(sourceF + 4 * x);
+					c[s] = Resolve::combine(c[2 * s], c[2 * s + 1]);
+				}
+			}
 
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
+			*(Element*)(row + x) = Resolve::finish(c[0], samples);
+		}
+	}
 
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
+	#if defined(__i386__) || defined(__x86_64__)
+		// Rows are only aligned to pairs of pixels, and any remainder is resolved by the narrower path
+		template<class Resolve, int samples>
+		static void resolveRowSSE2(unsigned char *row, int slice, int bytes)
+		{
+			int x = 0;
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
+			for(; x + 16 <= bytes; x += 16)
+			{
+				__m128i c[samples];
+
+				for(int s = 0; s < samples; s++)
+				{
+					c[s] = _mm_loadu_si128((__m128i*)(row + s * slice + x));
+				}
+
+				for(int n = samples / 2; n >= 1; n /= 2)
+				{
+					for(int s = 0; s < n; s++)
+					{
+						c[s] = Resolve::combine(c[2 * s], c[2 * s + 1]);
 					}
 				}
-				else ASSERT(false);
 
-				#undef AVERAGE
+				_mm_storeu_si128((__m128i*)(row + x), Resolve::finish(c[0], samples));
 			}
+
+			resolveRow<Resolve, samples>(row + x, slice, bytes - x);
 		}
-		else if(internal.format == FORMAT_G16R16)
+
+		template<class Resolve, int samples>
+		AVX2_FUNCTION static void resolveRowAVX2(unsigned char *row, int slice, int bytes)
 		{
+			int x = 0;
 
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 4) == 0)
+			for(; x + 32 <= bytes; x += 32)
+			{
+				__m256i c[samples];
+
+				for(int s = 0; s < samples; s++)
 				{
-					if(internal.samples == 2)
+					c[s] = _mm256_loadu_si256((__m256i*)(row + s * slice + x));
+				}
+
+				for(int n = samples / 2; n >= 1; n /= 2)
+				{
+					for(int s = 0; s < n; s++)
 					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
+						c[s] = Resolve::combine(c[2 * s], c[2 * s + 1]);
+					}
+				}
 
-								c0 = _mm_avg_epu16(c0, c1);
+				_mm256_storeu_si256((__m256i*)(row + x), Resolve::finish(c[0], samples));
+			}
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+			resolveRowSSE2<Resolve, samples>(row + x, slice, bytes - x);
+		}
+	#endif
 
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
+	typedef void (*ResolveRowFunction)(unsigned char *row, int slice, int bytes);
 
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c0 = _mm_avg_epu16(c0, c2);
+	template<class Resolve, int samples>
+	static ResolveRowFunction selectResolveRow()
+	{
+		#if defined(__i386__) || defined(__x86_64__)
+			if(CPUID::supportsAVX2())
+			{
+				return resolveRowAVX2<Resolve, samples>;
+			}
+			else if(CPUID::supportsSSE2())
+			{
+				return resolveRowSSE2<Resolve, samples>;
+			}
+		#endif
 
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+		return resolveRow<Resolve, samples>;
+	}
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c0 = _mm_avg_epu16(c0, c4);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
+	template<class Resolve>
+	static ResolveRowFunction selectResolveRow(int samples)
+	{
+		switch(samples)
+		{
+		case 2:  return selectResolveRow<Resolve, 2>();
+		case 4:  return selectResolveRow<Resolve, 4>();
+		case 8:  return selectResolveRow<Resolve, 8>();
+		case 16: return selectResolveRow<Resolve, 16>();
+		default: return nullptr;
+		}
+	}
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 4 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 4 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 4 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 4 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 4 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 4 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 4 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 4 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 4 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 4 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 4 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 4 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 4 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 4 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 4 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 4 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c8 = _mm_avg_epu16(c8, c9);
-								cA = _mm_avg_epu16(cA, cB);
-								cC = _mm_avg_epu16(cC, cD);
-								cE = _mm_avg_epu16(cE, cF);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c8 = _mm_avg_epu16(c8, cA);
-								cC = _mm_avg_epu16(cC, cE);
-								c0 = _mm_avg_epu16(c0, c4);
-								c8 = _mm_avg_epu16(c8, cC);
-								c0 = _mm_avg_epu16(c0, c8);
-
-								_mm_store_si128((__m128i*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7FFF7FFF) + (((x) ^ (y)) & 0x00010001))
-
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-							unsigned int c8 = *(unsigned int*)(source8 + 4 * x);
-							unsigned int c9 = *(unsigned int*)(source9 + 4 * x);
-							unsigned int cA = *(unsigned int*)(sourceA + 4 * x);
-							unsigned int cB = *(unsigned int*)(sourceB + 4 * x);
-							unsigned int cC = *(unsigned int*)(sourceC + 4 * x);
-							unsigned int cD = *(unsigned int*)(sourceD + 4 * x);
-							unsigned int cE = *(unsigned int*)(sourceE + 4 * x);
-							unsigned int cF = *(unsigned int*)(sourceF + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-
-				#undef AVERAGE
-			}
-		}
-		else if(internal.format == FORMAT_A16B16G16R16)
-		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE2() && (width % 2) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c0 = _mm_avg_epu16(c0, c2);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 8 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 8 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 8 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c0 = _mm_avg_epu16(c0, c4);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128i c0 = _mm_load_si128((__m128i*)(source0 + 8 * x));
-								__m128i c1 = _mm_load_si128((__m128i*)(source1 + 8 * x));
-								__m128i c2 = _mm_load_si128((__m128i*)(source2 + 8 * x));
-								__m128i c3 = _mm_load_si128((__m128i*)(source3 + 8 * x));
-								__m128i c4 = _mm_load_si128((__m128i*)(source4 + 8 * x));
-								__m128i c5 = _mm_load_si128((__m128i*)(source5 + 8 * x));
-								__m128i c6 = _mm_load_si128((__m128i*)(source6 + 8 * x));
-								__m128i c7 = _mm_load_si128((__m128i*)(source7 + 8 * x));
-								__m128i c8 = _mm_load_si128((__m128i*)(source8 + 8 * x));
-								__m128i c9 = _mm_load_si128((__m128i*)(source9 + 8 * x));
-								__m128i cA = _mm_load_si128((__m128i*)(sourceA + 8 * x));
-								__m128i cB = _mm_load_si128((__m128i*)(sourceB + 8 * x));
-								__m128i cC = _mm_load_si128((__m128i*)(sourceC + 8 * x));
-								__m128i cD = _mm_load_si128((__m128i*)(sourceD + 8 * x));
-								__m128i cE = _mm_load_si128((__m128i*)(sourceE + 8 * x));
-								__m128i cF = _mm_load_si128((__m128i*)(sourceF + 8 * x));
-
-								c0 = _mm_avg_epu16(c0, c1);
-								c2 = _mm_avg_epu16(c2, c3);
-								c4 = _mm_avg_epu16(c4, c5);
-								c6 = _mm_avg_epu16(c6, c7);
-								c8 = _mm_avg_epu16(c8, c9);
-								cA = _mm_avg_epu16(cA, cB);
-								cC = _mm_avg_epu16(cC, cD);
-								cE = _mm_avg_epu16(cE, cF);
-								c0 = _mm_avg_epu16(c0, c2);
-								c4 = _mm_avg_epu16(c4, c6);
-								c8 = _mm_avg_epu16(c8, cA);
-								cC = _mm_avg_epu16(cC, cE);
-								c0 = _mm_avg_epu16(c0, c4);
-								c8 = _mm_avg_epu16(c8, cC);
-								c0 = _mm_avg_epu16(c0, c8);
-
-								_mm_store_si128((__m128i*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				#define AVERAGE(x, y) (((x) & (y)) + ((((x) ^ (y)) >> 1) & 0x7FFF7FFF) + (((x) ^ (y)) & 0x00010001))
-
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c0 = AVERAGE(c0, c2);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c0 = AVERAGE(c0, c4);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							unsigned int c0 = *(unsigned int*)(source0 + 4 * x);
-							unsigned int c1 = *(unsigned int*)(source1 + 4 * x);
-							unsigned int c2 = *(unsigned int*)(source2 + 4 * x);
-							unsigned int c3 = *(unsigned int*)(source3 + 4 * x);
-							unsigned int c4 = *(unsigned int*)(source4 + 4 * x);
-							unsigned int c5 = *(unsigned int*)(source5 + 4 * x);
-							unsigned int c6 = *(unsigned int*)(source6 + 4 * x);
-							unsigned int c7 = *(unsigned int*)(source7 + 4 * x);
-							unsigned int c8 = *(unsigned int*)(source8 + 4 * x);
-							unsigned int c9 = *(unsigned int*)(source9 + 4 * x);
-							unsigned int cA = *(unsigned int*)(sourceA + 4 * x);
-							unsigned int cB = *(unsigned int*)(sourceB + 4 * x);
-							unsigned int cC = *(unsigned int*)(sourceC + 4 * x);
-							unsigned int cD = *(unsigned int*)(sourceD + 4 * x);
-							unsigned int cE = *(unsigned int*)(sourceE + 4 * x);
-							unsigned int cF = *(unsigned int*)(sourceF + 4 * x);
-
-							c0 = AVERAGE(c0, c1);
-							c2 = AVERAGE(c2, c3);
-							c4 = AVERAGE(c4, c5);
-							c6 = AVERAGE(c6, c7);
-							c8 = AVERAGE(c8, c9);
-							cA = AVERAGE(cA, cB);
-							cC = AVERAGE(cC, cD);
-							cE = AVERAGE(cE, cF);
-							c0 = AVERAGE(c0, c2);
-							c4 = AVERAGE(c4, c6);
-							c8 = AVERAGE(c8, cA);
-							cC = AVERAGE(cC, cE);
-							c0 = AVERAGE(c0, c4);
-							c8 = AVERAGE(c8, cC);
-							c0 = AVERAGE(c0, c8);
-
-							*(unsigned int*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-
-				#undef AVERAGE
-			}
-		}
-		else if(internal.format == FORMAT_R32F)
-		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE() && (width % 4) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c0 = _mm_add_ps(c0, c2);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 4 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 4 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 4 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c0 = _mm_add_ps(c0, c4);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 4)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 4 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 4 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 4 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 4 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 4 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 4 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 4 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 4 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 4 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 4 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 4 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 4 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 4 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 4 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 4 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 4 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c8 = _mm_add_ps(c8, c9);
-								cA = _mm_add_ps(cA, cB);
-								cC = _mm_add_ps(cC, cD);
-								cE = _mm_add_ps(cE, cF);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c8 = _mm_add_ps(c8, cA);
-								cC = _mm_add_ps(cC, cE);
-								c0 = _mm_add_ps(c0, c4);
-								c8 = _mm_add_ps(c8, cC);
-								c0 = _mm_add_ps(c0, c8);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
-
-								_mm_store_ps((float*)(source0 + 4 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-
-							c0 = c0 + c1;
-							c0 *= 1.0f / 2.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c0 = c0 + c2;
-							c0 *= 1.0f / 4.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c0 = c0 + c4;
-							c0 *= 1.0f / 8.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-							float c8 = *(float*)(source8 + 4 * x);
-							float c9 = *(float*)(source9 + 4 * x);
-							float cA = *(float*)(sourceA + 4 * x);
-							float cB = *(float*)(sourceB + 4 * x);
-							float cC = *(float*)(sourceC + 4 * x);
-							float cD = *(float*)(sourceD + 4 * x);
-							float cE = *(float*)(sourceE + 4 * x);
-							float cF = *(float*)(sourceF + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c8 = c8 + c9;
-							cA = cA + cB;
-							cC = cC + cD;
-							cE = cE + cF;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c8 = c8 + cA;
-							cC = cC + cE;
-							c0 = c0 + c4;
-							c8 = c8 + cC;
-							c0 = c0 + c8;
-							c0 *= 1.0f / 16.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-			}
-		}
-		else if(internal.format == FORMAT_G32R32F)
+	static ResolveRowFunction selectResolveRow(Format format, int samples)
+	{
+		switch(format)
 		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE() && (width % 2) == 0)
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c0 = _mm_add_ps(c0, c2);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 8 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 8 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 8 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c0 = _mm_add_ps(c0, c4);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x += 2)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 8 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 8 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 8 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 8 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 8 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 8 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 8 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 8 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 8 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 8 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 8 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 8 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 8 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 8 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 8 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 8 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c8 = _mm_add_ps(c8, c9);
-								cA = _mm_add_ps(cA, cB);
-								cC = _mm_add_ps(cC, cD);
-								cE = _mm_add_ps(cE, cF);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c8 = _mm_add_ps(c8, cA);
-								cC = _mm_add_ps(cC, cE);
-								c0 = _mm_add_ps(c0, c4);
-								c8 = _mm_add_ps(c8, cC);
-								c0 = _mm_add_ps(c0, c8);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
-
-								_mm_store_ps((float*)(source0 + 8 * x), c0);
-							}
-
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
-			{
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
+		case FORMAT_X8R8G8B8:
+		case FORMAT_A8R8G8B8:
+		case FORMAT_X8B8G8R8:
+		case FORMAT_A8B8G8R8:
+		case FORMAT_SRGB8_X8:
+		case FORMAT_SRGB8_A8:
+			return selectResolveRow<ResolveUnorm8>(samples);
+		case FORMAT_G16R16:
+		case FORMAT_A16B16G16R16:
+			return selectResolveRow<ResolveUnorm16>(samples);
+		case FORMAT_R32F:
+		case FORMAT_G32R32F:
+		case FORMAT_A32B32G32R32F:
+		case FORMAT_X32B32G32R32F:
+		case FORMAT_X32B32G32R32F_UNSIGNED:
+			return selectResolveRow<ResolveFloat>(samples);
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_A16B16G16R16F:
+		case FORMAT_X16B16G16R16F:
+			return selectResolveRow<ResolveHalf>(samples);
+		default:
+			return nullptr;
+		}
+	}
 
-							c0 = c0 + c1;
-							c0 *= 1.0f / 2.0f;
+	struct ResolveBands
+	{
+		Surface *surface;
+		unsigned char *source;
+		int pitch;
+		int height;
+		int count;
+	};
 
-							*(float*)(source0 + 4 * x) = c0;
-						}
+	void Surface::setThreadCount(int threadCount)
+	{
+		bandThreads = threadCount;
+	}
 
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
+	void Surface::resolve()
+	{
+		if(internal.samples <= 1 || !internal.dirty || !renderTarget || internal.format == FORMAT_NULL)
+		{
+			return;
+		}
 
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c0 = c0 + c2;
-							c0 *= 1.0f / 4.0f;
+		ASSERT(internal.depth == 1);  // Unimplemented
 
-							*(float*)(source0 + 4 * x) = c0;
-						}
+		unsigned char *source = (unsigned char*)internal.lockRect(0, 0, 0, LOCK_READWRITE);
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c0 = c0 + c4;
-							c0 *= 1.0f / 8.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+		int width = internal.width;
+		int height = internal.height;
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 2 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-							float c8 = *(float*)(source8 + 4 * x);
-							float c9 = *(float*)(source9 + 4 * x);
-							float cA = *(float*)(sourceA + 4 * x);
-							float cB = *(float*)(sourceB + 4 * x);
-							float cC = *(float*)(sourceC + 4 * x);
-							float cD = *(float*)(sourceD + 4 * x);
-							float cE = *(float*)(sourceE + 4 * x);
-							float cF = *(float*)(sourceF + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c8 = c8 + c9;
-							cA = cA + cB;
-							cC = cC + cD;
-							cE = cE + cF;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c8 = c8 + cA;
-							cC = cC + cE;
-							c0 = c0 + c4;
-							c8 = c8 + cC;
-							c0 = c0 + c8;
-							c0 *= 1.0f / 16.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+		int count = min((int)bandThreads, height / minResolveBandHeight);
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-			}
-		}
-		else if(internal.format == FORMAT_A32B32G32R32F ||
-		        internal.format == FORMAT_X32B32G32R32F ||
-		        internal.format == FORMAT_X32B32G32R32F_UNSIGNED)
+		if(count > 1 && width * height >= minResolveBandedArea)
 		{
-			#if defined(__i386__) || defined(__x86_64__)
-				if(CPUID::supportsSSE())
-				{
-					if(internal.samples == 2)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
+			ResolveBands bands = {this, source, internal.pitchB, height, count};
 
-								c0 = _mm_add_ps(c0, c1);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 2.0f));
-
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
+			WorkerPool::shared().run(resolveBand, &bands, count);
+		}
+		else
+		{
+			resolve(source, height);
+		}
+	}
 
-							source0 += pitch;
-							source1 += pitch;
-						}
-					}
-					else if(internal.samples == 4)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
+	void Surface::resolveBand(void *parameters, int index)
+	{
+		const ResolveBands &bands = *static_cast<ResolveBands*>(parameters);
 
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c0 = _mm_add_ps(c0, c2);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 4.0f));
+		int y0 = bands.height * index / bands.count;
+		int y1 = bands.height * (index + 1) / bands.count;
 
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
+		bands.surface->resolve(bands.source + y0 * bands.pitch, y1 - y0);
+	}
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-						}
-					}
-					else if(internal.samples == 8)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 16 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 16 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 16 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 16 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c0 = _mm_add_ps(c0, c4);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 8.0f));
-
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
+	void Surface::resolve(void *source, int height)
+	{
+		int width = internal.width;
+		int pitch = internal.pitchB;
+		int slice = internal.sliceB;
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-						}
-					}
-					else if(internal.samples == 16)
-					{
-						for(int y = 0; y < height; y++)
-						{
-							for(int x = 0; x < width; x++)
-							{
-								__m128 c0 = _mm_load_ps((float*)(source0 + 16 * x));
-								__m128 c1 = _mm_load_ps((float*)(source1 + 16 * x));
-								__m128 c2 = _mm_load_ps((float*)(source2 + 16 * x));
-								__m128 c3 = _mm_load_ps((float*)(source3 + 16 * x));
-								__m128 c4 = _mm_load_ps((float*)(source4 + 16 * x));
-								__m128 c5 = _mm_load_ps((float*)(source5 + 16 * x));
-								__m128 c6 = _mm_load_ps((float*)(source6 + 16 * x));
-								__m128 c7 = _mm_load_ps((float*)(source7 + 16 * x));
-								__m128 c8 = _mm_load_ps((float*)(source8 + 16 * x));
-								__m128 c9 = _mm_load_ps((float*)(source9 + 16 * x));
-								__m128 cA = _mm_load_ps((float*)(sourceA + 16 * x));
-								__m128 cB = _mm_load_ps((float*)(sourceB + 16 * x));
-								__m128 cC = _mm_load_ps((float*)(sourceC + 16 * x));
-								__m128 cD = _mm_load_ps((float*)(sourceD + 16 * x));
-								__m128 cE = _mm_load_ps((float*)(sourceE + 16 * x));
-								__m128 cF = _mm_load_ps((float*)(sourceF + 16 * x));
-
-								c0 = _mm_add_ps(c0, c1);
-								c2 = _mm_add_ps(c2, c3);
-								c4 = _mm_add_ps(c4, c5);
-								c6 = _mm_add_ps(c6, c7);
-								c8 = _mm_add_ps(c8, c9);
-								cA = _mm_add_ps(cA, cB);
-								cC = _mm_add_ps(cC, cD);
-								cE = _mm_add_ps(cE, cF);
-								c0 = _mm_add_ps(c0, c2);
-								c4 = _mm_add_ps(c4, c6);
-								c8 = _mm_add_ps(c8, cA);
-								cC = _mm_add_ps(cC, cE);
-								c0 = _mm_add_ps(c0, c4);
-								c8 = _mm_add_ps(c8, cC);
-								c0 = _mm_add_ps(c0, c8);
-								c0 = _mm_mul_ps(c0, _mm_set1_ps(1.0f / 16.0f));
-
-								_mm_store_ps((float*)(source0 + 16 * x), c0);
-							}
+		ResolveRowFunction resolveFunction = selectResolveRow(internal.format, internal.samples);
 
-							source0 += pitch;
-							source1 += pitch;
-							source2 += pitch;
-							source3 += pitch;
-							source4 += pitch;
-							source5 += pitch;
-							source6 += pitch;
-							source7 += pitch;
-							source8 += pitch;
-							source9 += pitch;
-							sourceA += pitch;
-							sourceB += pitch;
-							sourceC += pitch;
-							sourceD += pitch;
-							sourceE += pitch;
-							sourceF += pitch;
-						}
-					}
-					else ASSERT(false);
-				}
-				else
-			#endif
+		if(resolveFunction)
+		{
+			for(int y = 0; y < height; y++)
 			{
-				if(internal.samples == 2)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-
-							c0 = c0 + c1;
-							c0 *= 1.0f / 2.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
-
-						source0 += pitch;
-						source1 += pitch;
-					}
-				}
-				else if(internal.samples == 4)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c0 = c0 + c2;
-							c0 *= 1.0f / 4.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+				resolveFunction((unsigned char*)source + y * pitch, slice, width * internal.bytes);
+			}
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-					}
-				}
-				else if(internal.samples == 8)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c0 = c0 + c4;
-							c0 *= 1.0f / 8.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+			return;
+		}
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-					}
-				}
-				else if(internal.samples == 16)
-				{
-					for(int y = 0; y < height; y++)
-					{
-						for(int x = 0; x < 4 * width; x++)
-						{
-							float c0 = *(float*)(source0 + 4 * x);
-							float c1 = *(float*)(source1 + 4 * x);
-							float c2 = *(float*)(source2 + 4 * x);
-							float c3 = *(float*)(source3 + 4 * x);
-							float c4 = *(float*)(source4 + 4 * x);
-							float c5 = *(float*)(source5 + 4 * x);
-							float c6 = *(float*)(source6 + 4 * x);
-							float c7 = *(float*)(source7 + 4 * x);
-							float c8 = *(float*)(source8 + 4 * x);
-							float c9 = *(float*)(source9 + 4 * x);
-							float cA = *(float*)(sourceA + 4 * x);
-							float cB = *(float*)(sourceB + 4 * x);
-							float cC = *(float*)(sourceC + 4 * x);
-							float cD = *(float*)(sourceD + 4 * x);
-							float cE = *(float*)(sourceE + 4 * x);
-							float cF = *(float*)(sourceF + 4 * x);
-
-							c0 = c0 + c1;
-							c2 = c2 + c3;
-							c4 = c4 + c5;
-							c6 = c6 + c7;
-							c8 = c8 + c9;
-							cA = cA + cB;
-							cC = cC + cD;
-							cE = cE + cF;
-							c0 = c0 + c2;
-							c4 = c4 + c6;
-							c8 = c8 + cA;
-							cC = cC + cE;
-							c0 = c0 + c4;
-							c8 = c8 + cC;
-							c0 = c0 + c8;
-							c0 *= 1.0f / 16.0f;
-
-							*(float*)(source0 + 4 * x) = c0;
-						}
+		unsigned char *source0 = (unsigned char*)source;
+		unsigned char *source1 = source0 + slice;
+		unsigned char *source2 = source1 + slice;
+		unsigned char *source3 = source2 + slice;
+		unsigned char *source4 = source3 + slice;
+		unsigned char *source5 = source4 + slice;
+		unsigned char *source6 = source5 + slice;
+		unsigned char *source7 = source6 + slice;
+		unsigned char *source8 = source7 + slice;
+		unsigned char *source9 = source8 + slice;
+		unsigned char *sourceA = source9 + slice;
+		unsigned char *sourceB = sourceA + slice;
+		unsigned char *sourceC = sourceB + slice;
+		unsigned char *sourceD = sourceC + slice;
+		unsigned char *sourceE = sourceD + slice;
+		unsigned char *sourceF = sourceE + slice;
 
-						source0 += pitch;
-						source1 += pitch;
-						source2 += pitch;
-						source3 += pitch;
-						source4 += pitch;
-						source5 += pitch;
-						source6 += pitch;
-						source7 += pitch;
-						source8 += pitch;
-						source9 += pitch;
-						sourceA += pitch;
-						sourceB += pitch;
-						sourceC += pitch;
-						sourceD += pitch;
-						sourceE += pitch;
-						sourceF += pitch;
-					}
-				}
-				else ASSERT(false);
-			}
-		}
-		else if(internal.format == FORMAT_R5G6B5)
+		if(internal.format == FORMAT_R5G6B5)
 		{
 			#if defined(__i386__) || defined(__x86_64__)
 				if(CPUID::supportsSSE2() && (width % 8) == 0)
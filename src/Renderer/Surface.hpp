@@ -18,10 +18,13 @@
 #include "Color.hpp"
 #include "Main/Config.hpp"
 #include "Common/Resource.hpp"
+#include "Common/MutexLock.hpp"
 
 namespace sw
 {
 	class Resource;
+	class HierarchicalZ;
+	class DeferredClear;
 
 	template <typename T> struct RectT
 	{
@@ -71,6 +74,8 @@ namespace sw
 		FORMAT_R8,
 		FORMAT_R16I,
 		FORMAT_R16UI,
+		FORMAT_R16_SNORM,
+		FORMAT_R16,
 		FORMAT_R32I,
 		FORMAT_R32UI,
 		FORMAT_R3G3B2,
@@ -330,9 +335,23 @@ namespace sw
 		bool isEntire(const Rect& rect) const;
 		Rect getRect() const;
 		void clearDepth(float depth, int x0, int y0, int width, int height);
+		inline HierarchicalZ *getHierarchicalZ() const;   // Null if not a single-sample 2D depth buffer
 		void clearStencil(unsigned char stencil, unsigned char mask, int x0, int y0, int width, int height);
 		void fill(const Color<float> &color, int x0, int y0, int width, int height);
 
+		// Clears the entire internal buffer to a repeating pattern, written to rows once they're accessed.
+		// Returns false if it can't be deferred. The renderer writes the rows its draw calls touch.
+		bool deferClear(unsigned int pattern);
+		void materializeClear(int y0, int y1);
+		void materializeStencilClear(int y0, int y1);
+
+		// Copy of the internal buffer stored in 4x4 texel tiles, which the sampler reads instead of the linear
+		// layout. It's rebuilt when the contents have changed since, so readback and blits are unaffected.
+		bool isTileable() const;
+		void *getTiledInternal();
+		inline int getTiledPitchP() const;
+		inline int getTiledSliceP() const;
+
 		Color<float> readExternal(int x, int y, int z) const;
 		Color<float> readExternal(int x, int y) const;
 		Color<float> sampleExternal(float x, float y, float z) const;
@@ -382,6 +401,7 @@ namespace sw
 		static int componentCount(Format format);
 
 		static void setTexturePalette(unsigned int *palette);
+		static void setThreadCount(int threadCount);   // Large multisample resolves and compressed texture decodes are split into row bands, processed in parallel
 
 	private:
 		sw::Resource *resource;
@@ -481,14 +501,21 @@ namespace sw
 		static void decodeASTC(Buffer &internal, Buffer &external, int xSize, int ySize, int zSize, bool isSRGB);
 
 		static void update(Buffer &destination, Buffer &source);
+		static void decode(Buffer &destination, Buffer &source);
+		static void decodeBand(void *parameters, int index);
+		struct DecodeBands;
 		static void genericUpdate(Buffer &destination, Buffer &source);
 		static void *allocateBuffer(int width, int height, int depth, int border, int samples, Format format);
 		static void memfill4(void *buffer, int pattern, int bytes);
 
 		bool identicalFormats() const;
-		Format selectInternalFormat(Format format) const;
+		Format selectInternalFormat(Format format, int border) const;
 
 		void resolve();
+		void resolve(void *source, int height);   // Rows starting at the source
+		static void resolveBand(void *parameters, int index);
+
+		void tile(const void *source);
 
 		Buffer external;
 		Buffer internal;
@@ -500,6 +527,16 @@ namespace sw
 		bool dirtyContents;   // Sibling surfaces need updating (mipmaps / cube borders).
 		unsigned int paletteUsed;
 
+		HierarchicalZ *hierarchicalZ;
+
+		DeferredClear *internalClear;   // Null unless a single-layer render target without border
+		DeferredClear *stencilClear;
+
+		void *tiled;
+		unsigned int internalVersion;   // Incremented when the internal contents may have changed
+		unsigned int tiledVersion;
+		MutexLock tiledMutex;           // Contexts sharing the surface may update the tiled copy concurrently
+
 		static unsigned int *palette;   // FIXME: Not multi-device safe
 		static unsigned int paletteID;
 
@@ -513,6 +550,22 @@ namespace sw
 
 namespace sw
 {
+	HierarchicalZ *Surface::getHierarchicalZ() const
+	{
+		return hierarchicalZ;
+	}
+
+	int Surface::getTiledPitchP() const
+	{
+		// An odd number of tiles per row keeps vertically adjacent tiles from mapping to the same cache sets
+		return 4 * (((internal.width + 3) / 4) | 1);
+	}
+
+	int Surface::getTiledSliceP() const
+	{
+		return getTiledPitchP() * align(internal.height, 4);
+	}
+
 	void *Surface::lock(int x, int y, int z, Lock lock, Accessor client, bool internal)
 	{
 		return internal ? lockInternal(x, y, z, lock, client) : lockExternal(x, y, z, lock, client);
@@ -14,12 +14,14 @@
 
 #include "VertexProcessor.hpp"
 
+#include "RoutineArchive.hpp"
 #include "Shader/VertexPipeline.hpp"
 #include "Shader/VertexProgram.hpp"
 #include "Shader/VertexShader.hpp"
 #include "Shader/PixelShader.hpp"
 #include "Shader/Constants.hpp"
 #include "Common/Math.hpp"
+#include "Common/Memory.hpp"
 #include "Common/Debug.hpp"
 
 #include <string.h>
@@ -28,25 +30,69 @@ namespace sw
 {
 	bool precacheVertex = false;
 
-	void VertexCache::clear()
-	{
-		for(int i = 0; i < 16; i++)
+	#if ROUTINE_ARCHIVE
+		static RoutineArchive &archive()
 		{
-			tag[i] = 0x80000000;
+			static RoutineArchive archive("sw-vertex");   // Shared by all renderers
+			return archive;
+		}
+
+		static std::vector<unsigned char> archiveKey(const VertexProcessor::State &state, const VertexShader *shader)
+		{
+			std::vector<unsigned char> key(sizeof(VertexProcessor::States) + sizeof(uint64_t));
+
+			VertexProcessor::States &states = *reinterpret_cast<VertexProcessor::States*>(&key[0]);
+			memcpy(&states, static_cast<const VertexProcessor::States*>(&state), sizeof(VertexProcessor::States));
+			states.shaderID = 0;   // Only unique within the process
+
+			uint64_t shaderHash = shader ? shader->getContentHash() : 0;
+			memcpy(&key[sizeof(VertexProcessor::States)], &shaderHash, sizeof(uint64_t));
+
+			return key;
 		}
+	#endif
+
+	void VertexCache::allocate(int size, int ways)
+	{
+		int lines = size / 4;
+
+		this->size = size;
+		this->ways = ways;
+
+		vertex = (Vertex*)sw::allocate(size * sizeof(Vertex));
+		tag = new unsigned int[lines];
+		victim = new unsigned int[lines / ways];
+
+		drawCall = -1;
+		misses = 0;
+		evictions = 0;
 	}
 
-	unsigned int VertexProcessor::States::computeHash()
+	void VertexCache::deallocate()
 	{
-		unsigned int *state = (unsigned int*)this;
-		unsigned int hash = 0;
+		sw::deallocate(vertex);
+		delete[] tag;
+		delete[] victim;
+	}
 
-		for(unsigned int i = 0; i < sizeof(States) / 4; i++)
+	void VertexCache::clear()
+	{
+		int lines = size / 4;
+
+		for(int i = 0; i < lines; i++)
+		{
+			tag[i] = 0x80000000;
+		}
+
+		for(int i = 0; i < lines / ways; i++)
 		{
-			hash ^= state[i];
+			victim[i] = 0;
 		}
+	}
 
-		return hash;
+	unsigned int VertexProcessor::States::computeHash()
+	{
+		return FNV_1a((const unsigned int*)this, sizeof(States) / 4);
 	}
 
 	VertexProcessor::State::State()
@@ -120,6 +166,12 @@ namespace sw
 
 		routineCache = 0;
 		setRoutineCacheSize(1024);
+
+		routineCompiler = nullptr;
+
+		vertexCacheSize = 64;
+		vertexCacheAssociativity = 1;
+		vertexDeduplication = true;
 	}
 
 	VertexProcessor::~VertexProcessor()
@@ -354,9 +406,9 @@ namespace sw
 		context->vertexFogMode = fogMode;
 	}
 
-	void VertexProcessor::setInstanceID(int instanceID)
+	void VertexProcessor::setInstanceCount(int instanceCount)
 	{
-		context->instanceID = instanceID;
+		context->instanceCount = instanceCount;
 	}
 
 	void VertexProcessor::setColorVertexEnable(bool colorVertexEnable)
@@ -890,7 +942,23 @@ namespace sw
 	void VertexProcessor::setRoutineCacheSize(int cacheSize)
 	{
 		delete routineCache;
-		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536), precacheVertex ? "sw-vertex" : 0);
+		routineCache = new RoutineCache<State>(clamp(cacheSize, 1, 65536));
+	}
+
+	void VertexProcessor::setVertexCache(int size, int associativity)
+	{
+		vertexCacheSize = clamp(ceilPow2(size), 16, 1024);
+		vertexCacheAssociativity = clamp(ceilPow2(associativity), 1, vertexCacheSize / 4);
+	}
+
+	void VertexProcessor::setRoutineCompiler(RoutineCompiler *compiler)
+	{
+		routineCompiler = compiler;
+	}
+
+	const CacheStatistics &VertexProcessor::getRoutineCacheStatistics() const
+	{
+		return routineCache->getStatistics();
 	}
 
 	const VertexProcessor::State VertexProcessor::update(DrawType drawType)
@@ -971,11 +1039,20 @@ namespace sw
 		DrawType type = static_cast<DrawType>(static_cast<unsigned int>(drawType) & 0xF);
 		state.verticesPerPrimitive = 1 + (type >= DRAW_LINELIST) + (type >= DRAW_TRIANGLELIST);
 
+		// Strips and fans reference consecutive indices, which the vertex cache already handles well. Transform feedback
+		// needs every corner processed in order, and shaders which sample textures process one vertex at a time.
+		bool indexed = (static_cast<unsigned int>(drawType) & 0xF0) != DRAW_NONINDEXED;
+		state.deduplicate = vertexDeduplication && indexed && type == DRAW_TRIANGLELIST && !state.transformFeedbackEnabled && !state.textureSampling;
+
+		state.vertexCacheSize = vertexCacheSize;
+		state.vertexCacheAssociativity = vertexCacheAssociativity;
+
 		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
 		{
 			state.input[i].type = context->input[i].type;
 			state.input[i].count = context->input[i].count;
 			state.input[i].normalized = context->input[i].normalized;
+			state.input[i].instanced = context->input[i].divisor != 0;
 			state.input[i].attribType = context->vertexShader ? context->vertexShader->getAttribType(i) : VertexShader::ATTRIBTYPE_FLOAT;
 		}
 
@@ -1086,24 +1163,66 @@ namespace sw
 
 		if(!routine)   // Create one
 		{
-			VertexRoutine *generator = nullptr;
+			const VertexShader *shader = state.fixedFunction ? nullptr : context->vertexShader;
 
-			if(state.fixedFunction)
+			if(routineCompiler)
 			{
-				generator = new VertexPipeline(state);
+				routine = routineCompiler->compile(generate, state, shader);
 			}
 			else
 			{
-				generator = new VertexProgram(state, context->vertexShader);
+				routine = generate(state, shader);
 			}
 
-			generator->generate();
-			routine = (*generator)(L"VertexRoutine_%0.8X", state.shaderID);
-			delete generator;
-
 			routineCache->add(state, routine);
+
+			if(routineCompiler)
+			{
+				routine->unbind();   // Now referenced by the cache
+			}
+		}
+
+		return routine;
+	}
+
+	Routine *VertexProcessor::generate(const State &state, const VertexShader *shader)
+	{
+		#if ROUTINE_ARCHIVE
+			std::vector<unsigned char> key;
+
+			if(precacheVertex)
+			{
+				key = archiveKey(state, shader);
+
+				if(Routine *routine = archive().load(key))
+				{
+					return routine;
+				}
+			}
+		#endif
+
+		VertexRoutine *generator = nullptr;
+
+		if(state.fixedFunction)
+		{
+			generator = new VertexPipeline(state);
+		}
+		else
+		{
+			generator = new VertexProgram(state, shader);
 		}
 
+		generator->generate();
+		Routine *routine = (*generator)(L"VertexRoutine_%0.8X", state.shaderID);
+		delete generator;
+
+		#if ROUTINE_ARCHIVE
+			if(precacheVertex)
+			{
+				archive().store(key, routine);
+			}
+		#endif
+
 		return routine;
 	}
 }
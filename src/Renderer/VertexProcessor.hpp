@@ -18,27 +18,56 @@
 #include "Matrix.hpp"
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "RoutineCompiler.hpp"
 #include "Shader/VertexShader.hpp"
 
 namespace sw
 {
 	struct DrawData;
 
-	struct VertexCache   // FIXME: Variable size
+
+	// Set-associative cache of shaded vertices. Lines hold the four vertices which are
+	// processed together, and ways get replaced round-robin on a miss.
+	struct VertexCache
 	{
+		void allocate(int size, int ways);
+		void deallocate();
 		void clear();
 
-		Vertex vertex[16][4];
-		unsigned int tag[16];
+		int size;   // Vertices, a power of two
+		int ways;   // Per set, a power of two
+
+		Vertex *vertex;         // [size]
+		unsigned int *tag;      // [size / 4], index of the line's first vertex
+		unsigned int *victim;   // [sets], way to replace next
 
 		int drawCall;
+
+		unsigned int misses;      // Updated by the vertex routine
+		unsigned int evictions;
+	};
+
+	// Batch of primitives compacted to its unique vertices. These get shaded four at
+	// a time, and then copied to the corners of the primitives which reference them.
+	struct VertexBatch
+	{
+		Vertex vertex[BATCH_SIZE * 3];         // Shaded unique vertices
+		unsigned int index[BATCH_SIZE * 3];    // Of the unique vertices, padded to a multiple of four
+		unsigned int corner[BATCH_SIZE * 3];   // Unique vertex of each primitive corner
+		unsigned int cornerCount;
 	};
 
+	static_assert((BATCH_SIZE * 3) % 4 == 0, "Padding the unique vertices to a multiple of four must not overflow the batch");
+
 	struct VertexTask
 	{
 		unsigned int vertexCount;
 		unsigned int primitiveStart;
+		unsigned int instanceID;
+		const void *instanceInput[MAX_VERTEX_INPUTS];   // Element of each instanced stream for this instance
 		VertexCache vertexCache;
+		CacheStatistics vertexCacheStatistics;
+		VertexBatch vertexBatch;
 	};
 
 	class VertexProcessor
@@ -81,6 +110,10 @@ namespace sw
 			bool preTransformed : 1;
 			bool superSampling  : 1;
 			bool multiSampling  : 1;
+			bool deduplicate    : 1;   // Vertices are shaded from a VertexBatch
+
+			unsigned int vertexCacheSize          : 11;   // Vertices, a power of two
+			unsigned int vertexCacheAssociativity : 9;    // Ways per set, a power of two
 
 			struct TextureState
 			{
@@ -103,6 +136,7 @@ namespace sw
 				StreamType type    : BITS(STREAMTYPE_LAST);
 				unsigned int count : 3;
 				bool normalized    : 1;
+				bool instanced     : 1;
 				unsigned int attribType : BITS(VertexShader::ATTRIBTYPE_LAST);
 			};
 
@@ -220,7 +254,7 @@ namespace sw
 		void setLightAttenuation(unsigned int light, float constant, float linear, float quadratic);
 		void setLightRange(unsigned int light, float lightRange);
 
-		void setInstanceID(int instanceID);
+		void setInstanceCount(int instanceCount);
 
 		void setFogEnable(bool fogEnable);
 		void setVertexFogMode(FogMode fogMode);
@@ -288,6 +322,9 @@ namespace sw
 
 		bool isFixedFunction();
 		void setRoutineCacheSize(int cacheSize);
+		void setRoutineCompiler(RoutineCompiler *compiler);
+		const CacheStatistics &getRoutineCacheStatistics() const;
+		void setVertexCache(int size, int associativity);
 
 		// Shader constants
 		float4 c[VERTEX_UNIFORM_VECTORS + 1];   // One extra for indices out of range, c[VERTEX_UNIFORM_VECTORS] = {0, 0, 0, 0}
@@ -297,6 +334,12 @@ namespace sw
 		PointSprite point;
 		FixedFunction ff;
 
+		// Geometry of the vertex caches, which routines are specialized for
+		int vertexCacheSize;
+		int vertexCacheAssociativity;
+
+		bool vertexDeduplication;   // Shade the unique vertices of indexed triangle lists once per batch
+
 	private:
 		struct UniformBufferInfo
 		{
@@ -325,9 +368,12 @@ namespace sw
 		void setCameraTransform(const Matrix &M, int i);
 		void setNormalTransform(const Matrix &M, int i);
 
+		static Routine *generate(const State &state, const VertexShader *shader);
+
 		Context *const context;
 
 		RoutineCache<State> *routineCache;
+		RoutineCompiler *routineCompiler;   // Null unless compiling asynchronously
 
 	protected:
 		Matrix M[12];      // Model/Geometry/World matrix
@@ -74,6 +74,8 @@ namespace sw
 		unsigned short linearToSRGB12_16[4096];
 		unsigned short sRGBtoLinear12_16[4096];
 
+		int alphaModifierEAC[16][8];   // ETC2 alpha blocks, indexed by table and pixel index
+
 		// Centroid parameters
 		float4 sampleX[4][16];
 		float4 sampleY[4][16];
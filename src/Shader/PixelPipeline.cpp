@@ -352,6 +352,10 @@ namespace sw
 				}
 			}
 			break;
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_X32B32G32R32F:
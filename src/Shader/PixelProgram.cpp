@@ -633,6 +633,10 @@ namespace sw
 					}
 				}
 				break;
+			case FORMAT_R16F:
+			case FORMAT_G16R16F:
+			case FORMAT_X16B16G16R16F:
+			case FORMAT_A16B16G16R16F:
 			case FORMAT_R32F:
 			case FORMAT_G32R32F:
 			case FORMAT_X32B32G32R32F:
@@ -754,6 +758,10 @@ namespace sw
 				oC[index].z = Max(oC[index].z, Float4(0.0f)); oC[index].z = Min(oC[index].z, Float4(1.0f));
 				oC[index].w = Max(oC[index].w, Float4(0.0f)); oC[index].w = Min(oC[index].w, Float4(1.0f));
 				break;
+			case FORMAT_R16F:
+			case FORMAT_G16R16F:
+			case FORMAT_X16B16G16R16F:
+			case FORMAT_A16B16G16R16F:
 			case FORMAT_R32F:
 			case FORMAT_G32R32F:
 			case FORMAT_X32B32G32R32F:
@@ -2039,6 +2039,7 @@ namespace sw
 		Vector4s color;
 		Short4 c01;
 		Short4 c23;
+		Int2 halfBits;
 
 		Float4 one;
 		if(Surface::isFloatFormat(state.targetFormat[index]))
@@ -2078,6 +2079,39 @@ namespace sw
 			pixel.y = pixel.z;
 			pixel.z = pixel.w = one;
 			break;
+		case FORMAT_R16F:
+			buffer = cBuffer;
+			halfBits = Insert(halfBits, *Pointer<Int>(buffer + 2 * x), 0);
+			buffer += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index]));
+			halfBits = Insert(halfBits, *Pointer<Int>(buffer + 2 * x), 1);
+			pixel.x = halfToFloat(Int4(As<UShort4>(halfBits)));
+			pixel.y = pixel.z = pixel.w = one;
+			break;
+		case FORMAT_G16R16F:
+			buffer = cBuffer;
+			pixel.x = halfToFloat(Int4(*Pointer<UShort4>(buffer + 4 * x)));
+			buffer += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index]));
+			pixel.y = halfToFloat(Int4(*Pointer<UShort4>(buffer + 4 * x)));
+			pixel.z = pixel.x;
+			pixel.x = ShuffleLowHigh(pixel.x, pixel.y, 0x88);
+			pixel.z = ShuffleLowHigh(pixel.z, pixel.y, 0xDD);
+			pixel.y = pixel.z;
+			pixel.z = pixel.w = one;
+			break;
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
+			buffer = cBuffer;
+			pixel.x = halfToFloat(Int4(*Pointer<UShort4>(buffer + 8 * x)));
+			pixel.y = halfToFloat(Int4(*Pointer<UShort4>(buffer + 8 * x + 8)));
+			buffer += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index]));
+			pixel.z = halfToFloat(Int4(*Pointer<UShort4>(buffer + 8 * x)));
+			pixel.w = halfToFloat(Int4(*Pointer<UShort4>(buffer + 8 * x + 8)));
+			transpose4x4(pixel.x, pixel.y, pixel.z, pixel.w);
+			if(state.targetFormat[index] == FORMAT_X16B16G16R16F)
+			{
+				pixel.w = Float4(1.0f);
+			}
+			break;
 		case FORMAT_X32B32G32R32F:
 		case FORMAT_A32B32G32R32F:
 		case FORMAT_X32B32G32R32F_UNSIGNED:
@@ -2219,8 +2253,27 @@ namespace sw
 
 	void PixelRoutine::writeColor(int index, Pointer<Byte> &cBuffer, Int &x, Vector4f &oC, Int &sMask, Int &zMask, Int &cMask)
 	{
+		// Half-precision formats get stored like 16-bit integers, after conversion to their bit patterns
+		switch(state.targetFormat[index])
+		{
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
+			oC.w = As<Float4>(floatToHalf(oC.w));
+			oC.z = As<Float4>(floatToHalf(oC.z));
+			// Fall through to FORMAT_G16R16F.
+		case FORMAT_G16R16F:
+			oC.y = As<Float4>(floatToHalf(oC.y));
+			// Fall through to FORMAT_R16F.
+		case FORMAT_R16F:
+			oC.x = As<Float4>(floatToHalf(oC.x));
+			break;
+		default:
+			break;
+		}
+
 		switch(state.targetFormat[index])
 		{
+		case FORMAT_R16F:
 		case FORMAT_R32F:
 		case FORMAT_R32I:
 		case FORMAT_R32UI:
@@ -2229,6 +2282,7 @@ namespace sw
 		case FORMAT_R8I:
 		case FORMAT_R8UI:
 			break;
+		case FORMAT_G16R16F:
 		case FORMAT_G32R32F:
 		case FORMAT_G32R32I:
 		case FORMAT_G32R32UI:
@@ -2241,6 +2295,8 @@ namespace sw
 			oC.z = UnpackHigh(oC.z, oC.y);
 			oC.y = oC.z;
 			break;
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_X32B32G32R32F:
 		case FORMAT_A32B32G32R32F:
 		case FORMAT_X32B32G32R32F_UNSIGNED:
@@ -2311,6 +2367,7 @@ namespace sw
 				*Pointer<Float>(buffer + 4) = oC.x.y;
 			}
 			break;
+		case FORMAT_R16F:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
 			if(rgbaWriteMask & 0x00000001)
@@ -2343,7 +2400,7 @@ namespace sw
 					component = oC.x.y;
 					*Pointer<Short>(buffer + 2) = Short(As<Int>(component));
 				}
-				else // FORMAT_R16UI
+				else   // FORMAT_R16UI, FORMAT_R16F
 				{
 					Float component = oC.x.z;
 					*Pointer<UShort>(buffer + 0) = UShort(As<Int>(component));
@@ -2429,6 +2486,7 @@ namespace sw
 			oC.y = As<Float4>(As<Int4>(oC.y) | As<Int4>(value));
 			*Pointer<Float4>(buffer) = oC.y;
 			break;
+		case FORMAT_G16R16F:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 			if((rgbaWriteMask & 0x00000003) != 0x0)
@@ -2572,6 +2630,8 @@ namespace sw
 				*Pointer<Float4>(buffer + 16, 16) = oC.w;
 			}
 			break;
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_A16B16G16R16I:
 		case FORMAT_A16B16G16R16UI:
 			if((rgbaWriteMask & 0x0000000F) != 0x0)
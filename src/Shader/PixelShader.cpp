@@ -22,6 +22,7 @@ namespace sw
 {
 	PixelShader::PixelShader(const PixelShader *ps) : Shader()
 	{
+		shaderType = SHADER_PIXEL;
 		shaderModel = 0x0300;
 		vPosDeclared = false;
 		vFaceDeclared = false;
@@ -34,6 +35,7 @@ namespace sw
 				append(new sw::Shader::Instruction(*ps->getInstruction(i)));
 			}
 
+			shaderModel = ps->shaderModel;
 			memcpy(input, ps->input, sizeof(input));
 			vPosDeclared = ps->vPosDeclared;
 			vFaceDeclared = ps->vFaceDeclared;
@@ -60,6 +62,26 @@ namespace sw
 	{
 	}
 
+	void PixelShader::serialize(std::vector<unsigned int> &words) const
+	{
+		Shader::serialize(words);
+
+		for(int i = 0; i < MAX_FRAGMENT_INPUTS; i++)
+		{
+			for(int component = 0; component < 4; component++)
+			{
+				const Semantic &semantic = input[i][component];
+				words.push_back(semantic.usage | semantic.index << 8 | semantic.centroid << 16 | semantic.flat << 17);
+			}
+		}
+
+		words.push_back(vPosDeclared);
+		words.push_back(vFaceDeclared);
+		words.push_back(zOverride);
+		words.push_back(kill);
+		words.push_back(centroid);
+	}
+
 	int PixelShader::validate(const unsigned long *const token)
 	{
 		if(!token)
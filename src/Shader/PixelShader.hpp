@@ -50,6 +50,8 @@ namespace sw
 		void analyzeKill();
 		void analyzeInterpolants();
 
+		void serialize(std::vector<unsigned int> &words) const override;
+
 		Semantic input[MAX_FRAGMENT_INPUTS][4];
 
 		bool vPosDeclared;
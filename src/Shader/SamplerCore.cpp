@@ -46,6 +46,18 @@ namespace
 		default: ASSERT(false);
 		}
 	}
+
+	// Bits [shift, shift + count) of each element
+	sw::Int4 bitfield(const sw::UInt4 &word, unsigned char shift, int count)
+	{
+		return sw::As<sw::Int4>((word >> shift) & sw::UInt4((1 << count) - 1));
+	}
+
+	// Expands a color component to 8 bits by replicating its most significant bits
+	sw::Int4 extend(const sw::Int4 &component, unsigned char bits)
+	{
+		return (component << (8 - bits)) | (component >> (2 * bits - 8));
+	}
 }
 
 namespace sw
@@ -181,6 +193,8 @@ namespace sw
 					case FORMAT_A8B8G8R8UI:
 					case FORMAT_R16I:
 					case FORMAT_R16UI:
+					case FORMAT_R16_SNORM:
+					case FORMAT_R16:
 					case FORMAT_G16R16:
 					case FORMAT_G16R16I:
 					case FORMAT_G16R16UI:
@@ -212,6 +226,16 @@ namespace sw
 					case FORMAT_YV12_BT601:
 					case FORMAT_YV12_BT709:
 					case FORMAT_YV12_JFIF:
+					case FORMAT_DXT1:
+					case FORMAT_DXT3:
+					case FORMAT_DXT5:
+					case FORMAT_ETC1:
+					case FORMAT_RGB8_ETC2:
+					case FORMAT_SRGB8_ETC2:
+					case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+					case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+					case FORMAT_RGBA8_ETC2_EAC:
+					case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 						if(componentCount < 2) c.y = Short4(defaultColorValue);
 						if(componentCount < 3) c.z = Short4(defaultColorValue);
 						if(componentCount < 4) c.w = Short4(0x1000);
@@ -233,13 +257,17 @@ namespace sw
 						c.y = c.x;
 						c.z = c.x;
 						break;
+					case FORMAT_R16F:
 					case FORMAT_R32F:
 						c.y = Short4(defaultColorValue);
+					case FORMAT_G16R16F:
 					case FORMAT_G32R32F:
 						c.z = Short4(defaultColorValue);
+					case FORMAT_X16B16G16R16F:
 					case FORMAT_X32B32G32R32F:
 					case FORMAT_X32B32G32R32F_UNSIGNED:
 						c.w = Short4(0x1000);
+					case FORMAT_A16B16G16R16F:
 					case FORMAT_A32B32G32R32F:
 						break;
 					case FORMAT_D32F:
@@ -425,6 +453,8 @@ namespace sw
 				case FORMAT_R8:
 				case FORMAT_R5G6B5:
 				case FORMAT_G8R8:
+				case FORMAT_R16_SNORM:
+				case FORMAT_R16:
 				case FORMAT_G16R16:
 				case FORMAT_A16B16G16R16:
 				case FORMAT_X8R8G8B8:
@@ -442,6 +472,16 @@ namespace sw
 				case FORMAT_YV12_BT601:
 				case FORMAT_YV12_BT709:
 				case FORMAT_YV12_JFIF:
+				case FORMAT_DXT1:
+				case FORMAT_DXT3:
+				case FORMAT_DXT5:
+				case FORMAT_ETC1:
+				case FORMAT_RGB8_ETC2:
+				case FORMAT_SRGB8_ETC2:
+				case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+				case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+				case FORMAT_RGBA8_ETC2_EAC:
+				case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 					if(componentCount < 2) c.y = Float4(defaultColorValue);
 					if(componentCount < 3) c.z = Float4(defaultColorValue);
 					if(componentCount < 4) c.w = Float4(1.0f);
@@ -463,13 +503,17 @@ namespace sw
 					c.y = c.x;
 					c.z = c.x;
 					break;
+				case FORMAT_R16F:
 				case FORMAT_R32F:
 					c.y = Float4(defaultColorValue);
+				case FORMAT_G16R16F:
 				case FORMAT_G32R32F:
 					c.z = Float4(defaultColorValue);
+				case FORMAT_X16B16G16R16F:
 				case FORMAT_X32B32G32R32F:
 				case FORMAT_X32B32G32R32F_UNSIGNED:
 					c.w = Float4(1.0f);
+				case FORMAT_A16B16G16R16F:
 				case FORMAT_A32B32G32R32F:
 					break;
 				case FORMAT_D32F:
@@ -769,10 +813,52 @@ namespace sw
 			Short4 uuuu1 = offsetSample(uuuu, mipmap, OFFSET(Mipmap,uHalf), state.addressingModeU == ADDRESSING_WRAP, gather ? 2 : +1, lod);
 			Short4 vvvv1 = offsetSample(vvvv, mipmap, OFFSET(Mipmap,vHalf), state.addressingModeV == ADDRESSING_WRAP, gather ? 2 : +1, lod);
 
-			Vector4s c0 = sampleTexel(uuuu0, vvvv0, wwww, offset, mipmap, buffer, function);
-			Vector4s c1 = sampleTexel(uuuu1, vvvv0, wwww, offset, mipmap, buffer, function);
-			Vector4s c2 = sampleTexel(uuuu0, vvvv1, wwww, offset, mipmap, buffer, function);
-			Vector4s c3 = sampleTexel(uuuu1, vvvv1, wwww, offset, mipmap, buffer, function);
+			Vector4s c0;
+			Vector4s c1;
+			Vector4s c2;
+			Vector4s c3;
+
+			if(hasCompressedTextureFormat())
+			{
+				// Block decoding generates a lot of code, so the four texels share a single copy of it
+				Array<Short4> uuuuN(4);
+				Array<Short4> vvvvN(4);
+				Array<Short4> texels(16);   // Four components of each texel
+
+				uuuuN[0] = uuuu0; vvvvN[0] = vvvv0;
+				uuuuN[1] = uuuu1; vvvvN[1] = vvvv0;
+				uuuuN[2] = uuuu0; vvvvN[2] = vvvv1;
+				uuuuN[3] = uuuu1; vvvvN[3] = vvvv1;
+
+				For(Int i = 0, i < 4, i++)
+				{
+					Short4 uuuuI = uuuuN[i];
+					Short4 vvvvI = vvvvN[i];
+					Vector4s cI = sampleTexel(uuuuI, vvvvI, wwww, offset, mipmap, buffer, function);
+
+					texels[i * 4 + 0] = cI.x;
+					texels[i * 4 + 1] = cI.y;
+					texels[i * 4 + 2] = cI.z;
+					texels[i * 4 + 3] = cI.w;
+				}
+
+				Vector4s *cN[4] = {&c0, &c1, &c2, &c3};
+
+				for(int i = 0; i < 4; i++)
+				{
+					cN[i]->x = texels[i * 4 + 0];
+					cN[i]->y = texels[i * 4 + 1];
+					cN[i]->z = texels[i * 4 + 2];
+					cN[i]->w = texels[i * 4 + 3];
+				}
+			}
+			else
+			{
+				c0 = sampleTexel(uuuu0, vvvv0, wwww, offset, mipmap, buffer, function);
+				c1 = sampleTexel(uuuu1, vvvv0, wwww, offset, mipmap, buffer, function);
+				c2 = sampleTexel(uuuu0, vvvv1, wwww, offset, mipmap, buffer, function);
+				c3 = sampleTexel(uuuu1, vvvv1, wwww, offset, mipmap, buffer, function);
+			}
 
 			if(!gather)   // Blend
 			{
@@ -1230,11 +1316,38 @@ namespace sw
 		address(w, z0, z0, fv, mipmap, offset.z, filter, OFFSET(Mipmap, depth), state.addressingModeW, function);
 
 		Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
-		y0 *= pitchP;
+
+		if(state.tiled)
+		{
+			// Separable like the linear layout: x selects the tile and the column within it, y the row of tiles and the row within the tile
+			x0 = ((x0 & Int4(~3)) << 2) | (x0 & Int4(3));
+			x1 = ((x1 & Int4(~3)) << 2) | (x1 & Int4(3));
+			y0 = ((y0 & Int4(~3)) * pitchP) | ((y0 & Int4(3)) << 2);
+			y1 = ((y1 & Int4(~3)) * pitchP) | ((y1 & Int4(3)) << 2);
+		}
+		else if(hasCompressedTextureFormat())
+		{
+			// Four times the texel's index in a layout of 4-texel columns, plus its row within the column
+			x0 = x0 << 2;
+			x1 = x1 << 2;
+			y0 = ((y0 & Int4(~3)) * pitchP) | (y0 & Int4(3));
+			y1 = ((y1 & Int4(~3)) * pitchP) | (y1 & Int4(3));
+		}
+		else
+		{
+			y0 *= pitchP;
+			y1 *= pitchP;
+		}
+
 		if(hasThirdCoordinate())
 		{
 			Int4 sliceP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP), 16);
 			z0 *= sliceP;
+
+			if(hasCompressedTextureFormat())
+			{
+				z0 = z0 << 2;
+			}
 		}
 
 		if(state.textureFilter == FILTER_POINT || (function == Fetch))
@@ -1243,8 +1356,6 @@ namespace sw
 		}
 		else
 		{
-			y1 *= pitchP;
-
 			Vector4f c0 = sampleTexel(x0, y0, z0, q, mipmap, buffer, function);
 			Vector4f c1 = sampleTexel(x1, y0, z0, q, mipmap, buffer, function);
 			Vector4f c2 = sampleTexel(x0, y1, z0, q, mipmap, buffer, function);
@@ -1300,7 +1411,22 @@ namespace sw
 
 		Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
 		Int4 sliceP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP), 16);
-		y0 *= pitchP;
+
+		if(hasCompressedTextureFormat())
+		{
+			// Four times the texel's index in a layout of 4-texel columns, plus its row within the column
+			x0 = x0 << 2;
+			x1 = x1 << 2;
+			y0 = ((y0 & Int4(~3)) * pitchP) | (y0 & Int4(3));
+			y1 = ((y1 & Int4(~3)) * pitchP) | (y1 & Int4(3));
+			sliceP = sliceP << 2;
+		}
+		else
+		{
+			y0 *= pitchP;
+			y1 *= pitchP;
+		}
+
 		z0 *= sliceP;
 
 		if(state.textureFilter == FILTER_POINT || (function == Fetch))
@@ -1309,7 +1435,6 @@ namespace sw
 		}
 		else
 		{
-			y1 *= pitchP;
 			z1 *= sliceP;
 
 			Vector4f c0 = sampleTexel(x0, y0, z0, w, mipmap, buffer, function);
@@ -1675,6 +1800,19 @@ namespace sw
 			vvvv = applyOffset(vvvv, offset.y, Int4(h), texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeV);
 		}
 
+		if(state.tiled)
+		{
+			// Texels are stored in 4x4 tiles. The offset within the row of tiles fits in 16 bits for sizes up to 8192.
+			uuuu = ((uuuu << 2) & Short4(0xFFF0u)) | (uuuu & Short4(0x0003)) | ((vvvv & Short4(0x0003)) << 2);
+			vvvv &= Short4(0xFFFCu);
+		}
+		else if(hasCompressedTextureFormat())
+		{
+			// Four times the texel's index in a layout of 4-texel columns, which the 4x4 blocks consist of, plus its row within the column
+			uuuu = (uuuu << 2) | (vvvv & Short4(0x0003));
+			vvvv &= Short4(0xFFFCu);
+		}
+
 		Short4 uuu2 = uuuu;
 		uuuu = As<Short4>(UnpackLow(uuuu, vvvv));
 		uuu2 = As<Short4>(UnpackHigh(uuu2, vvvv));
@@ -1698,7 +1836,14 @@ namespace sw
 			}
 
 			UInt4 uv(As<UInt2>(uuuu), As<UInt2>(uuu2));
-			uv += As<UInt4>(Int4(As<UShort4>(wwww))) * *Pointer<UInt4>(mipmap + OFFSET(Mipmap, sliceP));
+			UInt4 slice = As<UInt4>(Int4(As<UShort4>(wwww))) * *Pointer<UInt4>(mipmap + OFFSET(Mipmap, sliceP));
+
+			if(hasCompressedTextureFormat())
+			{
+				slice = slice << 2;
+			}
+
+			uv += slice;
 
 			index[0] = Extract(As<Int4>(uv), 0);
 			index[1] = Extract(As<Int4>(uv), 1);
@@ -1720,6 +1865,10 @@ namespace sw
 			{
 				size *= Int(*Pointer<Short>(mipmap + OFFSET(Mipmap, depth)));
 			}
+			if(hasCompressedTextureFormat())
+			{
+				size = size << 2;
+			}
 			UInt min = 0;
 			UInt max = size - 1;
 
@@ -1754,7 +1903,29 @@ namespace sw
 		int f2 = state.textureType == TEXTURE_CUBE ? 2 : 0;
 		int f3 = state.textureType == TEXTURE_CUBE ? 3 : 0;
 
-		if(has16bitTextureFormat())
+		if(hasCompressedTextureFormat())
+		{
+			switch(state.textureFormat)
+			{
+			case FORMAT_DXT1:
+			case FORMAT_DXT3:
+			case FORMAT_DXT5:
+				c = decodeDXT(index, buffer);
+				break;
+			case FORMAT_ETC1:
+			case FORMAT_RGB8_ETC2:
+			case FORMAT_SRGB8_ETC2:
+			case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+			case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+			case FORMAT_RGBA8_ETC2_EAC:
+			case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
+				c = decodeETC2(index, buffer);
+				break;
+			default:
+				ASSERT(false);
+			}
+		}
+		else if(has16bitTextureFormat())
 		{
 			c.x = Insert(c.x, Pointer<Short>(buffer[f0])[index[0]], 0);
 			c.x = Insert(c.x, Pointer<Short>(buffer[f1])[index[1]], 1);
@@ -2006,6 +2177,313 @@ namespace sw
 		return c;
 	}
 
+	Vector4s SamplerCore::decodeDXT(UInt index[4], Pointer<Byte> buffer[4])
+	{
+		bool dxt1 = (state.textureFormat == FORMAT_DXT1);
+		int blockSize = dxt1 ? 8 : 16;
+		int colorOffset = dxt1 ? 0 : 8;   // Alpha comes first
+
+		Int4 colors;          // Endpoints in 5:6:5 format
+		Int4 selector;        // 2-bit color index
+		Int4 alpha;           // 4-bit alpha for DXT3, endpoints for DXT5
+		Int4 alphaSelector;   // 3-bit alpha index for DXT5
+
+		for(int i = 0; i < 4; i++)
+		{
+			int f = state.textureType == TEXTURE_CUBE ? i : 0;
+
+			// The index holds four times the texel's column, plus its row within the block
+			Pointer<Byte> block = buffer[f] + (index[i] >> 4) * blockSize;
+			UInt texel = ((index[i] >> 2) & 3u) | ((index[i] & 3u) << 2);   // Row-major
+
+			colors = Insert(colors, *Pointer<Int>(block + colorOffset), i);
+			selector = Insert(selector, Int((*Pointer<UInt>(block + colorOffset + 4) >> (texel << 1)) & 3u), i);
+
+			if(state.textureFormat == FORMAT_DXT3)
+			{
+				UInt nibbles = *Pointer<UInt>(block + Int((texel >> 3) << 2));
+				alpha = Insert(alpha, Int((nibbles >> ((texel & 7u) << 2)) & 0xFu), i);
+			}
+			else if(state.textureFormat == FORMAT_DXT5)
+			{
+				UInt bit = texel * 3u;
+				UInt bits = UInt(*Pointer<UShort>(block + 2 + Int(bit >> 3)));
+				alpha = Insert(alpha, Int(*Pointer<UShort>(block)), i);
+				alphaSelector = Insert(alphaSelector, Int((bits >> (bit & 7u)) & 7u), i);
+			}
+		}
+
+		Int4 c0 = colors & Int4(0xFFFF);
+		Int4 c1 = As<Int4>(As<UInt4>(colors) >> 16);
+
+		Int4 r0 = ((c0 & Int4(0xF800)) >> 8) | ((c0 & Int4(0xE000)) >> 13);
+		Int4 g0 = ((c0 & Int4(0x07E0)) >> 3) | ((c0 & Int4(0x0600)) >> 9);
+		Int4 b0 = ((c0 & Int4(0x001F)) << 3) | ((c0 & Int4(0x001C)) >> 2);
+		Int4 r1 = ((c1 & Int4(0xF800)) >> 8) | ((c1 & Int4(0xE000)) >> 13);
+		Int4 g1 = ((c1 & Int4(0x07E0)) >> 3) | ((c1 & Int4(0x0600)) >> 9);
+		Int4 b1 = ((c1 & Int4(0x001F)) << 3) | ((c1 & Int4(0x001C)) >> 2);
+
+		// DXT1 blocks with c0 <= c1 have three colors and transparent black
+		Int4 fourColors = Int4(-1);
+
+		if(dxt1)
+		{
+			fourColors = CmpNLE(c0, c1);
+		}
+
+		// Endpoint weights in thirds, or halves for three colors, as nibbles indexed by the selector
+		Int4 shift = selector << 2;
+		Int4 w0 = (((fourColors & Int4(0x1203)) | (~fourColors & Int4(0x0102))) >> shift) & Int4(0xF);
+		Int4 w1 = (((fourColors & Int4(0x2130)) | (~fourColors & Int4(0x0120))) >> shift) & Int4(0xF);
+		Int4 rounding = fourColors & Int4(1);
+		Int4 reciprocal = (fourColors & Int4(0xAAAB)) | (~fourColors & Int4(0x10000));   // 2^17 / 3 and 2^17 / 2
+
+		Int4 r = ((w0 * r0 + w1 * r1 + rounding) * reciprocal) >> 17;
+		Int4 g = ((w0 * g0 + w1 * g1 + rounding) * reciprocal) >> 17;
+		Int4 b = ((w0 * b0 + w1 * b1 + rounding) * reciprocal) >> 17;
+		Int4 a;
+
+		switch(state.textureFormat)
+		{
+		case FORMAT_DXT1:
+			a = ~(~fourColors & CmpEQ(selector, Int4(3))) & Int4(0xFF);
+			break;
+		case FORMAT_DXT3:
+			a = (alpha << 4) | alpha;
+			break;
+		case FORMAT_DXT5:
+			{
+				Int4 a0 = alpha & Int4(0xFF);
+				Int4 a1 = alpha >> 8;
+
+				// Blocks with a0 <= a1 interpolate four values and add 0 and 255
+				Int4 eightAlphas = CmpNLE(a0, a1);
+
+				Int4 alphaShift = alphaSelector << 2;
+				Int4 aw0 = (((eightAlphas & Int4(0x12345607)) | (~eightAlphas & Int4(0x00123405))) >> alphaShift) & Int4(0xF);
+				Int4 aw1 = (((eightAlphas & Int4(0x65432170)) | (~eightAlphas & Int4(0x00432150))) >> alphaShift) & Int4(0xF);
+				Int4 alphaRounding = (eightAlphas & Int4(3)) | (~eightAlphas & Int4(2));
+				Int4 alphaReciprocal = (eightAlphas & Int4(18725)) | (~eightAlphas & Int4(26215));   // 2^17 / 7 and 2^17 / 5
+
+				a = ((aw0 * a0 + aw1 * a1 + alphaRounding) * alphaReciprocal) >> 17;
+				a = a | (~eightAlphas & CmpEQ(alphaSelector, Int4(7)) & Int4(0xFF));
+			}
+			break;
+		default:
+			ASSERT(false);
+		}
+
+		Vector4s c;
+
+		c.x = Short4((r << 8) | r);
+		c.y = Short4((g << 8) | g);
+		c.z = Short4((b << 8) | b);
+		c.w = Short4((a << 8) | a);
+
+		return c;
+	}
+
+	Vector4s SamplerCore::decodeETC2(UInt index[4], Pointer<Byte> buffer[4])
+	{
+		bool punchThroughAlpha = (state.textureFormat == FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2) ||
+		                         (state.textureFormat == FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2);
+		bool alphaBlock = (state.textureFormat == FORMAT_RGBA8_ETC2_EAC) ||
+		                  (state.textureFormat == FORMAT_SRGB8_ALPHA8_ETC2_EAC);
+		int blockSize = alphaBlock ? 16 : 8;
+		int colorOffset = alphaBlock ? 8 : 0;   // Alpha comes first
+
+		Int4 high;    // Base colors, modifier tables and mode bits
+		Int4 low;     // Pixel indices
+		Int4 texel;   // Column-major
+		Int4 alpha = Int4(0xFF);
+
+		for(int i = 0; i < 4; i++)
+		{
+			int f = state.textureType == TEXTURE_CUBE ? i : 0;
+
+			// The index holds four times the texel's column, plus its row within the block
+			Pointer<Byte> block = buffer[f] + (index[i] >> 4) * blockSize;
+
+			high = Insert(high, *Pointer<Int>(block + colorOffset), i);
+			low = Insert(low, *Pointer<Int>(block + colorOffset + 4), i);
+			texel = Insert(texel, Int(index[i] & 0xFu), i);
+
+			if(alphaBlock)
+			{
+				// Big-endian 3-bit pixel indices follow the base value and the multiplier and table nibbles
+				Int bit = Int(index[i] & 0xFu) * 3;
+				Pointer<Byte> indices = block + 2 + (bit >> 3);
+				Int bits = (Int(*Pointer<Byte>(indices)) << 8) | Int(*Pointer<Byte>(indices + 1));
+				Int pixelIndex = (bits >> (13 - (bit & 7))) & 7;
+
+				Int base = Int(*Pointer<Byte>(block));
+				Int table = Int(*Pointer<Byte>(block + 1));
+				Int modifier = *Pointer<Int>(constants + OFFSET(Constants, alphaModifierEAC) + ((table & 0xF) * 8 + pixelIndex) * 4);
+
+				alpha = Insert(alpha, base + modifier * (table >> 4), i);
+			}
+		}
+
+		alpha = Min(Max(alpha, Int4(0)), Int4(0xFF));
+
+		// The blocks are stored in big-endian order
+		UInt4 H = As<UInt4>(high);
+		UInt4 L = As<UInt4>(low);
+		H = (H << 24) | ((H & UInt4(0xFF00)) << 8) | ((H >> 8) & UInt4(0xFF00)) | (H >> 24);
+		L = (L << 24) | ((L & UInt4(0xFF00)) << 8) | ((L >> 8) & UInt4(0xFF00)) | (L >> 24);
+
+		Int4 x = texel >> 2;
+		Int4 y = texel & Int4(3);
+		Int4 lsb = As<Int4>(L >> As<UInt4>(texel)) & Int4(1);
+		Int4 msb = As<Int4>(L >> As<UInt4>(texel + Int4(16))) & Int4(1);
+		Int4 pixelIndex = (msb << 1) | lsb;
+
+		// Differential mode colors which overflow select the T, H and planar modes
+		Int4 R = bitfield(H, 27, 5);
+		Int4 G = bitfield(H, 19, 5);
+		Int4 B = bitfield(H, 11, 5);
+		Int4 dR = As<Int4>(H << 5) >> 29;
+		Int4 dG = As<Int4>(H << 13) >> 29;
+		Int4 dB = As<Int4>(H << 21) >> 29;
+
+		Int4 differential = CmpEQ(bitfield(H, 1, 1), Int4(1));
+		Int4 opaque = differential;
+
+		if(punchThroughAlpha)
+		{
+			differential = Int4(-1);   // The bit indicates opaque blocks instead
+		}
+
+		Int4 overflowR = As<Int4>(CmpNLE(As<UInt4>(R + dR), UInt4(31)));
+		Int4 overflowG = As<Int4>(CmpNLE(As<UInt4>(G + dG), UInt4(31)));
+		Int4 overflowB = As<Int4>(CmpNLE(As<UInt4>(B + dB), UInt4(31)));
+
+		Int4 modeT = differential & overflowR;
+		Int4 modeH = differential & ~overflowR & overflowG;
+		Int4 modePlanar = differential & ~overflowR & ~overflowG & overflowB;
+		Int4 modeIndividual = ~differential;
+
+		// Individual and differential modes: two subblocks with a base color and modifier table each
+		Int4 flip = CmpEQ(bitfield(H, 0, 1), Int4(1));
+		Int4 secondSubblock = CmpNLE((flip & y) | (~flip & x), Int4(1));
+
+		Int4 r1 = (modeIndividual & extend(bitfield(H, 28, 4), 4)) | (~modeIndividual & extend(R, 5));
+		Int4 g1 = (modeIndividual & extend(bitfield(H, 20, 4), 4)) | (~modeIndividual & extend(G, 5));
+		Int4 b1 = (modeIndividual & extend(bitfield(H, 12, 4), 4)) | (~modeIndividual & extend(B, 5));
+		Int4 r2 = (modeIndividual & extend(bitfield(H, 24, 4), 4)) | (~modeIndividual & extend(R + dR, 5));
+		Int4 g2 = (modeIndividual & extend(bitfield(H, 16, 4), 4)) | (~modeIndividual & extend(G + dG, 5));
+		Int4 b2 = (modeIndividual & extend(bitfield(H, 8, 4), 4)) | (~modeIndividual & extend(B + dB, 5));
+
+		Int4 table = (secondSubblock & bitfield(H, 2, 3)) | (~secondSubblock & bitfield(H, 5, 3));
+		Int4 tableShift = (table & Int4(3)) << 3;
+		Int4 upperTables = CmpNLE(table, Int4(3));
+		Int4 smallModifier = (((upperTables & Int4(0x2F211812)) | (~upperTables & Int4(0x0D090502))) >> tableShift) & Int4(0xFF);
+		Int4 largeModifier = (((upperTables & Int4((int)0xB76A503C)) | (~upperTables & Int4(0x2A1D1108))) >> tableShift) & Int4(0xFF);
+		Int4 large = CmpEQ(pixelIndex & Int4(1), Int4(1));
+		Int4 negative = CmpNLE(pixelIndex, Int4(1));
+		Int4 modifier = (large & largeModifier) | (~large & smallModifier);
+
+		if(punchThroughAlpha)
+		{
+			modifier &= opaque | large;
+		}
+
+		modifier = (modifier ^ negative) - negative;
+
+		Int4 r = ((secondSubblock & r2) | (~secondSubblock & r1)) + modifier;
+		Int4 g = ((secondSubblock & g2) | (~secondSubblock & g1)) + modifier;
+		Int4 b = ((secondSubblock & b2) | (~secondSubblock & b1)) + modifier;
+
+		// T mode: one color, and a second one with a distance added or subtracted
+		{
+			Int4 distanceIndex = (bitfield(H, 2, 2) << 1) | bitfield(H, 0, 1);
+			Int4 upperDistances = CmpNLE(distanceIndex, Int4(3));
+			Int4 distance = (((upperDistances & Int4(0x40292017)) | (~upperDistances & Int4(0x100B0603))) >> ((distanceIndex & Int4(3)) << 3)) & Int4(0xFF);
+
+			Int4 first = CmpEQ(pixelIndex, Int4(0));
+			Int4 offset = (CmpEQ(pixelIndex, Int4(1)) & distance) - (CmpEQ(pixelIndex, Int4(3)) & distance);
+
+			Int4 tR = (first & extend((bitfield(H, 27, 2) << 2) | bitfield(H, 24, 2), 4)) | (~first & (extend(bitfield(H, 12, 4), 4) + offset));
+			Int4 tG = (first & extend(bitfield(H, 20, 4), 4)) | (~first & (extend(bitfield(H, 8, 4), 4) + offset));
+			Int4 tB = (first & extend(bitfield(H, 16, 4), 4)) | (~first & (extend(bitfield(H, 4, 4), 4) + offset));
+
+			r = (modeT & tR) | (~modeT & r);
+			g = (modeT & tG) | (~modeT & g);
+			b = (modeT & tB) | (~modeT & b);
+		}
+
+		// H mode: two colors, each with a distance added or subtracted
+		{
+			Int4 hR1 = extend(bitfield(H, 27, 4), 4);
+			Int4 hG1 = extend((bitfield(H, 24, 3) << 1) | bitfield(H, 20, 1), 4);
+			Int4 hB1 = extend((bitfield(H, 19, 1) << 3) | (bitfield(H, 16, 2) << 1) | bitfield(H, 15, 1), 4);
+			Int4 hR2 = extend(bitfield(H, 11, 4), 4);
+			Int4 hG2 = extend((bitfield(H, 8, 3) << 1) | bitfield(H, 7, 1), 4);
+			Int4 hB2 = extend(bitfield(H, 3, 4), 4);
+
+			Int4 ordered = ~CmpLT((hR1 << 16) | (hG1 << 8) | hB1, (hR2 << 16) | (hG2 << 8) | hB2) & Int4(1);
+			Int4 distanceIndex = (bitfield(H, 2, 1) << 2) | (bitfield(H, 0, 1) << 1) | ordered;
+			Int4 upperDistances = CmpNLE(distanceIndex, Int4(3));
+			Int4 distance = (((upperDistances & Int4(0x40292017)) | (~upperDistances & Int4(0x100B0603))) >> ((distanceIndex & Int4(3)) << 3)) & Int4(0xFF);
+
+			Int4 second = CmpNLE(pixelIndex, Int4(1));
+			Int4 subtract = CmpEQ(pixelIndex & Int4(1), Int4(1));
+			Int4 offset = (distance ^ subtract) - subtract;
+
+			Int4 hR = ((second & hR2) | (~second & hR1)) + offset;
+			Int4 hG = ((second & hG2) | (~second & hG1)) + offset;
+			Int4 hB = ((second & hB2) | (~second & hB1)) + offset;
+
+			r = (modeH & hR) | (~modeH & r);
+			g = (modeH & hG) | (~modeH & g);
+			b = (modeH & hB) | (~modeH & b);
+		}
+
+		// Planar mode: colors at the origin and at four texels horizontally and vertically, interpolated
+		{
+			Int4 oR = extend(bitfield(H, 25, 6), 6);
+			Int4 oG = extend((bitfield(H, 24, 1) << 6) | bitfield(H, 17, 6), 7);
+			Int4 oB = extend((bitfield(H, 16, 1) << 5) | (bitfield(H, 11, 2) << 3) | (bitfield(H, 8, 2) << 1) | bitfield(H, 7, 1), 6);
+			Int4 hR = extend((bitfield(H, 2, 5) << 1) | bitfield(H, 0, 1), 6);
+			Int4 hG = extend(bitfield(L, 25, 7), 7);
+			Int4 hB = extend((bitfield(L, 24, 1) << 5) | bitfield(L, 19, 5), 6);
+			Int4 vR = extend((bitfield(L, 16, 3) << 3) | bitfield(L, 13, 3), 6);
+			Int4 vG = extend((bitfield(L, 8, 5) << 2) | bitfield(L, 6, 2), 7);
+			Int4 vB = extend(bitfield(L, 0, 6), 6);
+
+			Int4 pR = ((x * (hR - oR) + y * (vR - oR) + Int4(2)) >> 2) + oR;
+			Int4 pG = ((x * (hG - oG) + y * (vG - oG) + Int4(2)) >> 2) + oG;
+			Int4 pB = ((x * (hB - oB) + y * (vB - oB) + Int4(2)) >> 2) + oB;
+
+			r = (modePlanar & pR) | (~modePlanar & r);
+			g = (modePlanar & pG) | (~modePlanar & g);
+			b = (modePlanar & pB) | (~modePlanar & b);
+		}
+
+		r = Min(Max(r, Int4(0)), Int4(0xFF));
+		g = Min(Max(g, Int4(0)), Int4(0xFF));
+		b = Min(Max(b, Int4(0)), Int4(0xFF));
+
+		if(punchThroughAlpha)
+		{
+			Int4 transparent = ~opaque & ~modePlanar & CmpEQ(pixelIndex, Int4(2));
+
+			r &= ~transparent;
+			g &= ~transparent;
+			b &= ~transparent;
+			alpha &= ~transparent;
+		}
+
+		Vector4s c;
+
+		c.x = Short4((r << 8) | r);
+		c.y = Short4((g << 8) | g);
+		c.z = Short4((b << 8) | b);
+		c.w = Short4((alpha << 8) | alpha);
+
+		return c;
+	}
+
 	Vector4s SamplerCore::sampleTexel(Short4 &uuuu, Short4 &vvvv, Short4 &wwww, Vector4f &offset, Pointer<Byte> &mipmap, Pointer<Byte> buffer[4], SamplerFunction function)
 	{
 		Vector4s c;
@@ -2130,41 +2608,77 @@ namespace sw
 			int f3 = state.textureType == TEXTURE_CUBE ? 3 : 0;
 
 			// Read texels
-			switch(textureComponentCount())
+			if(has16bitFloatTextureComponents())
 			{
-			case 4:
-				c.x = *Pointer<Float4>(buffer[f0] + index[0] * 16, 16);
-				c.y = *Pointer<Float4>(buffer[f1] + index[1] * 16, 16);
-				c.z = *Pointer<Float4>(buffer[f2] + index[2] * 16, 16);
-				c.w = *Pointer<Float4>(buffer[f3] + index[3] * 16, 16);
-				transpose4x4(c.x, c.y, c.z, c.w);
-				break;
-			case 3:
-				c.x = *Pointer<Float4>(buffer[f0] + index[0] * 16, 16);
-				c.y = *Pointer<Float4>(buffer[f1] + index[1] * 16, 16);
-				c.z = *Pointer<Float4>(buffer[f2] + index[2] * 16, 16);
-				c.w = *Pointer<Float4>(buffer[f3] + index[3] * 16, 16);
-				transpose4x3(c.x, c.y, c.z, c.w);
-				break;
-			case 2:
-				// FIXME: Optimal shuffling?
-				c.x.xy = *Pointer<Float4>(buffer[f0] + index[0] * 8);
-				c.x.zw = *Pointer<Float4>(buffer[f1] + index[1] * 8 - 8);
-				c.z.xy = *Pointer<Float4>(buffer[f2] + index[2] * 8);
-				c.z.zw = *Pointer<Float4>(buffer[f3] + index[3] * 8 - 8);
-				c.y = c.x;
-				c.x = Float4(c.x.xz, c.z.xz);
-				c.y = Float4(c.y.yw, c.z.yw);
-				break;
-			case 1:
-				// FIXME: Optimal shuffling?
-				c.x.x = *Pointer<Float>(buffer[f0] + index[0] * 4);
-				c.x.y = *Pointer<Float>(buffer[f1] + index[1] * 4);
-				c.x.z = *Pointer<Float>(buffer[f2] + index[2] * 4);
-				c.x.w = *Pointer<Float>(buffer[f3] + index[3] * 4);
-				break;
-			default:
-				ASSERT(false);
+				Int4 halfBits;
+
+				switch(textureComponentCount())
+				{
+				case 4:
+				case 3:
+					c.x = halfToFloat(Int4(*Pointer<UShort4>(buffer[f0] + index[0] * 8)));
+					c.y = halfToFloat(Int4(*Pointer<UShort4>(buffer[f1] + index[1] * 8)));
+					c.z = halfToFloat(Int4(*Pointer<UShort4>(buffer[f2] + index[2] * 8)));
+					c.w = halfToFloat(Int4(*Pointer<UShort4>(buffer[f3] + index[3] * 8)));
+					transpose4xN(c.x, c.y, c.z, c.w, textureComponentCount());
+					break;
+				case 2:
+					halfBits = Insert(halfBits, *Pointer<Int>(buffer[f0] + index[0] * 4), 0);
+					halfBits = Insert(halfBits, *Pointer<Int>(buffer[f1] + index[1] * 4), 1);
+					halfBits = Insert(halfBits, *Pointer<Int>(buffer[f2] + index[2] * 4), 2);
+					halfBits = Insert(halfBits, *Pointer<Int>(buffer[f3] + index[3] * 4), 3);
+					c.x = halfToFloat(halfBits & Int4(0x0000FFFF));
+					c.y = halfToFloat(As<Int4>(As<UInt4>(halfBits) >> 16));
+					break;
+				case 1:
+					halfBits = Insert(halfBits, Int(*Pointer<UShort>(buffer[f0] + index[0] * 2)), 0);
+					halfBits = Insert(halfBits, Int(*Pointer<UShort>(buffer[f1] + index[1] * 2)), 1);
+					halfBits = Insert(halfBits, Int(*Pointer<UShort>(buffer[f2] + index[2] * 2)), 2);
+					halfBits = Insert(halfBits, Int(*Pointer<UShort>(buffer[f3] + index[3] * 2)), 3);
+					c.x = halfToFloat(halfBits);
+					break;
+				default:
+					ASSERT(false);
+				}
+			}
+			else
+			{
+				switch(textureComponentCount())
+				{
+				case 4:
+					c.x = *Pointer<Float4>(buffer[f0] + index[0] * 16, 16);
+					c.y = *Pointer<Float4>(buffer[f1] + index[1] * 16, 16);
+					c.z = *Pointer<Float4>(buffer[f2] + index[2] * 16, 16);
+					c.w = *Pointer<Float4>(buffer[f3] + index[3] * 16, 16);
+					transpose4x4(c.x, c.y, c.z, c.w);
+					break;
+				case 3:
+					c.x = *Pointer<Float4>(buffer[f0] + index[0] * 16, 16);
+					c.y = *Pointer<Float4>(buffer[f1] + index[1] * 16, 16);
+					c.z = *Pointer<Float4>(buffer[f2] + index[2] * 16, 16);
+					c.w = *Pointer<Float4>(buffer[f3] + index[3] * 16, 16);
+					transpose4x3(c.x, c.y, c.z, c.w);
+					break;
+				case 2:
+					// FIXME: Optimal shuffling?
+					c.x.xy = *Pointer<Float4>(buffer[f0] + index[0] * 8);
+					c.x.zw = *Pointer<Float4>(buffer[f1] + index[1] * 8 - 8);
+					c.z.xy = *Pointer<Float4>(buffer[f2] + index[2] * 8);
+					c.z.zw = *Pointer<Float4>(buffer[f3] + index[3] * 8 - 8);
+					c.y = c.x;
+					c.x = Float4(c.x.xz, c.z.xz);
+					c.y = Float4(c.y.yw, c.z.yw);
+					break;
+				case 1:
+					// FIXME: Optimal shuffling?
+					c.x.x = *Pointer<Float>(buffer[f0] + index[0] * 4);
+					c.x.y = *Pointer<Float>(buffer[f1] + index[1] * 4);
+					c.x.z = *Pointer<Float>(buffer[f2] + index[2] * 4);
+					c.x.w = *Pointer<Float>(buffer[f3] + index[3] * 4);
+					break;
+				default:
+					ASSERT(false);
+				}
 			}
 
 			if(state.compare != COMPARE_BYPASS)
@@ -2626,6 +3140,10 @@ namespace sw
 		case FORMAT_V8U8:
 		case FORMAT_Q8W8V8U8:
 		case FORMAT_X8L8V8U8:
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_X32B32G32R32F:
@@ -2649,6 +3167,8 @@ namespace sw
 		case FORMAT_Q16W16V16U16:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
+		case FORMAT_R16_SNORM:
+		case FORMAT_R16:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 		case FORMAT_X16B16G16R16I:
@@ -2658,6 +3178,16 @@ namespace sw
 		case FORMAT_YV12_BT601:
 		case FORMAT_YV12_BT709:
 		case FORMAT_YV12_JFIF:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return false;
 		default:
 			ASSERT(false);
@@ -2698,6 +3228,10 @@ namespace sw
 		case FORMAT_A8B8G8R8UI:
 			return true;
 		case FORMAT_R5G6B5:
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_X32B32G32R32F:
@@ -2725,6 +3259,8 @@ namespace sw
 		case FORMAT_A32B32G32R32UI:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
+		case FORMAT_R16_SNORM:
+		case FORMAT_R16:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 		case FORMAT_X16B16G16R16I:
@@ -2734,6 +3270,16 @@ namespace sw
 		case FORMAT_YV12_BT601:
 		case FORMAT_YV12_BT709:
 		case FORMAT_YV12_JFIF:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return false;
 		default:
 			ASSERT(false);
@@ -2777,6 +3323,10 @@ namespace sw
 		case FORMAT_V8U8:
 		case FORMAT_Q8W8V8U8:
 		case FORMAT_X8L8V8U8:
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_X32B32G32R32F:
@@ -2795,12 +3345,24 @@ namespace sw
 		case FORMAT_YV12_BT601:
 		case FORMAT_YV12_BT709:
 		case FORMAT_YV12_JFIF:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return false;
 		case FORMAT_L16:
 		case FORMAT_G16R16:
 		case FORMAT_A16B16G16R16:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
+		case FORMAT_R16_SNORM:
+		case FORMAT_R16:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 		case FORMAT_X16B16G16R16I:
@@ -2850,6 +3412,8 @@ namespace sw
 		case FORMAT_A16B16G16R16:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
+		case FORMAT_R16_SNORM:
+		case FORMAT_R16:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 		case FORMAT_X16B16G16R16I:
@@ -2859,6 +3423,10 @@ namespace sw
 		case FORMAT_V16U16:
 		case FORMAT_A16W16V16U16:
 		case FORMAT_Q16W16V16U16:
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_X32B32G32R32F:
@@ -2877,6 +3445,16 @@ namespace sw
 		case FORMAT_YV12_BT601:
 		case FORMAT_YV12_BT709:
 		case FORMAT_YV12_JFIF:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return false;
 		case FORMAT_R32I:
 		case FORMAT_R32UI:
@@ -2894,6 +3472,25 @@ namespace sw
 		return false;
 	}
 
+	bool SamplerCore::has16bitFloatTextureComponents() const
+	{
+		switch(state.textureFormat)
+		{
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool SamplerCore::hasCompressedTextureFormat() const
+	{
+		return Surface::isCompressed(state.textureFormat);
+	}
+
 	bool SamplerCore::hasYuvFormat() const
 	{
 		switch(state.textureFormat)
@@ -2933,6 +3530,10 @@ namespace sw
 		case FORMAT_V8U8:
 		case FORMAT_Q8W8V8U8:
 		case FORMAT_X8L8V8U8:
+		case FORMAT_R16F:
+		case FORMAT_G16R16F:
+		case FORMAT_X16B16G16R16F:
+		case FORMAT_A16B16G16R16F:
 		case FORMAT_R32F:
 		case FORMAT_G32R32F:
 		case FORMAT_X32B32G32R32F:
@@ -2953,6 +3554,8 @@ namespace sw
 		case FORMAT_A16B16G16R16:
 		case FORMAT_R16I:
 		case FORMAT_R16UI:
+		case FORMAT_R16_SNORM:
+		case FORMAT_R16:
 		case FORMAT_G16R16I:
 		case FORMAT_G16R16UI:
 		case FORMAT_X16B16G16R16I:
@@ -2962,6 +3565,16 @@ namespace sw
 		case FORMAT_V16U16:
 		case FORMAT_A16W16V16U16:
 		case FORMAT_Q16W16V16U16:
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+		case FORMAT_DXT5:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_SRGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		case FORMAT_RGBA8_ETC2_EAC:
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:
 			return false;
 		default:
 			ASSERT(false);
@@ -3005,6 +3618,10 @@ namespace sw
 		case FORMAT_V8U8:           return false;
 		case FORMAT_Q8W8V8U8:       return false;
 		case FORMAT_X8L8V8U8:       return false;
+		case FORMAT_R16F:           return component < 1;
+		case FORMAT_G16R16F:        return component < 2;
+		case FORMAT_X16B16G16R16F:  return component < 3;
+		case FORMAT_A16B16G16R16F:  return component < 3;
 		case FORMAT_R32F:           return component < 1;
 		case FORMAT_G32R32F:        return component < 2;
 		case FORMAT_X32B32G32R32F:  return component < 3;
@@ -3025,6 +3642,8 @@ namespace sw
 		case FORMAT_A16B16G16R16:   return component < 3;
 		case FORMAT_R16I:           return component < 1;
 		case FORMAT_R16UI:          return component < 1;
+		case FORMAT_R16_SNORM:      return component < 1;
+		case FORMAT_R16:            return component < 1;
 		case FORMAT_G16R16I:        return component < 2;
 		case FORMAT_G16R16UI:       return component < 2;
 		case FORMAT_X16B16G16R16I:  return component < 3;
@@ -3037,6 +3656,16 @@ namespace sw
 		case FORMAT_YV12_BT601:     return component < 3;
 		case FORMAT_YV12_BT709:     return component < 3;
 		case FORMAT_YV12_JFIF:      return component < 3;
+		case FORMAT_DXT1:           return component < 3;
+		case FORMAT_DXT3:           return component < 3;
+		case FORMAT_DXT5:           return component < 3;
+		case FORMAT_ETC1:           return component < 3;
+		case FORMAT_RGB8_ETC2:      return component < 3;
+		case FORMAT_SRGB8_ETC2:     return component < 3;
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:  return component < 3;
+		case FORMAT_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: return component < 3;
+		case FORMAT_RGBA8_ETC2_EAC:                 return component < 3;
+		case FORMAT_SRGB8_ALPHA8_ETC2_EAC:          return component < 3;
 		default:
 			ASSERT(false);
 		}
@@ -166,6 +166,8 @@ namespace sw
 			// Vertical range
 			Int yMin = Y[0];
 			Int yMax = Y[0];
+			Int xMin = X[0];
+			Int xMax = X[0];
 
 			Int i = 1;
 
@@ -173,11 +175,25 @@ namespace sw
 			{
 				yMin = Min(Y[i], yMin);
 				yMax = Max(Y[i], yMax);
+				xMin = Min(X[i], xMin);
+				xMax = Max(X[i], xMax);
 
 				i++;
 			}
 			Until(i >= n)
 
+			if(state.multiSample == 1)
+			{
+				// Spans get clamped to the scissor rectangle, so they are all empty when the primitive is beside it
+				xMin = (xMin + 0x0F) >> 4;
+				xMax = (xMax + 0x0F) >> 4;
+
+				If(xMax <= *Pointer<Int>(data + OFFSET(DrawData,scissorX0)) || xMin >= *Pointer<Int>(data + OFFSET(DrawData,scissorX1)))
+				{
+					Return(false);
+				}
+			}
+
 			if(state.multiSample > 1)
 			{
 				yMin = (yMin + 0x0A) >> 4;
@@ -219,26 +235,20 @@ namespace sw
 				}
 				Until(i >= n)
 
-				Pointer<Byte> leftEdge = Pointer<Byte>(primitive + OFFSET(Primitive,outline->left)) + q * sizeof(Primitive);
-				Pointer<Byte> rightEdge = Pointer<Byte>(primitive + OFFSET(Primitive,outline->right)) + q * sizeof(Primitive);
+				*Pointer<Int>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,edgeCount)) = 0;
 
 				if(state.multiSample > 1)
 				{
 					Int xMin = *Pointer<Int>(data + OFFSET(DrawData, scissorX0));
 					Int xMax = *Pointer<Int>(data + OFFSET(DrawData, scissorX1));
-					Short x = Short(Clamp((X[0] + 0xF) >> 4, xMin, xMax));
 
-					For(Int y = yMin - 1, y < yMax + 1, y++)
-					{
-						*Pointer<Short>(leftEdge + y * sizeof(Primitive::Span)) = x;
-						*Pointer<Short>(rightEdge + y * sizeof(Primitive::Span)) = x;
-					}
+					*Pointer<Int>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,xFill)) = Clamp((X[0] + 0xF) >> 4, xMin, xMax);
 				}
 
 				Xq[n] = Xq[0];
 				Yq[n] = Yq[0];
 
-				// Rasterize
+				// Edges
 				{
 					Int i = 0;
 
@@ -250,28 +260,38 @@ namespace sw
 					}
 					Until(i >= n)
 				}
+			}
+
+			if(state.multiSample == 1)
+			{
+				// Trim empty scanlines at the top and bottom
+				Bool empty = true;
 
-				if(state.multiSample == 1)
+				While(empty && yMin < yMax)
 				{
-					For(, yMin < yMax && *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span)) == *Pointer<Short>(rightEdge + yMin * sizeof(Primitive::Span)), yMin++)
-					{
-						// Increments yMin
-					}
+					empty = emptySpan(primitive, data, yMin);
 
-					For(, yMax > yMin && *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span)) == *Pointer<Short>(rightEdge + (yMax - 1) * sizeof(Primitive::Span)), yMax--)
+					If(empty)
 					{
-						// Decrements yMax
+						yMin++;
 					}
+				}
 
-					If(yMin == yMax)
+				empty = Bool(true);
+
+				While(empty && yMax > yMin)
+				{
+					empty = emptySpan(primitive, data, yMax - 1);
+
+					If(empty)
 					{
-						Return(false);
+						yMax--;
 					}
+				}
 
-					*Pointer<Short>(leftEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-					*Pointer<Short>(rightEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-					*Pointer<Short>(leftEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
-					*Pointer<Short>(rightEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
+				If(yMin == yMax)
+				{
+					Return(false);
 				}
 			}
 
@@ -573,12 +593,9 @@ namespace sw
 
 			If(y1 < y2)
 			{
-				Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
-				Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
-
-				Pointer<Byte> leftEdge = primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->left);
-				Pointer<Byte> rightEdge = primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->right);
-				Pointer<Byte> edge = IfThenElse(swap, rightEdge, leftEdge);
+				Pointer<Byte> edges = primitive + q * sizeof(Primitive);
+				Int edgeCount = *Pointer<Int>(edges + OFFSET(Primitive,edgeCount));
+				Pointer<Byte> edge = edges + OFFSET(Primitive,edge) + edgeCount * sizeof(Primitive::Edge);
 
 				// Deltas
 				Int DX12 = X2 - X1;
@@ -600,26 +617,108 @@ namespace sw
 				Q += floor;
 				R += floor & FDY12;
 
-				Int D = FDY12;   // Error-overflow
-				Int y = y1;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,y1)) = y1;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,y2)) = y2;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,x)) = x;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,d)) = d;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,Q)) = Q;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,R)) = R;
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,D)) = FDY12;   // Error-overflow
+				*Pointer<Int>(edge + OFFSET(Primitive::Edge,side)) = IfThenElse(swap, Int(OFFSET(Primitive::Span,right)), Int(OFFSET(Primitive::Span,left)));
 
-				Do
-				{
-					*Pointer<Short>(edge + y * sizeof(Primitive::Span)) = Short(Clamp(x, xMin, xMax));
+				*Pointer<Int>(edges + OFFSET(Primitive,edgeCount)) = edgeCount + 1;
+			}
+		}
+	}
 
-					x += Q;
-					d += R;
+	Bool SetupRoutine::emptySpan(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &y)
+	{
+		Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
+		Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
+
+		Int left = xMin;
+		Int right = xMin;
 
-					Int overflow = -d >> 31;
+		Int edgeCount = *Pointer<Int>(primitive + OFFSET(Primitive,edgeCount));
+		Pointer<Byte> edge = primitive + OFFSET(Primitive,edge);
 
-					d -= D & overflow;
-					x -= overflow;
+		For(Int i = 0, i < edgeCount, i++)
+		{
+			Int y1 = *Pointer<Int>(edge + OFFSET(Primitive::Edge,y1));
+			Int y2 = *Pointer<Int>(edge + OFFSET(Primitive::Edge,y2));
 
-					y++;
+			If(y >= y1 && y < y2)
+			{
+				Int x = *Pointer<Int>(edge + OFFSET(Primitive::Edge,x));
+				Int d = *Pointer<Int>(edge + OFFSET(Primitive::Edge,d));
+				Int D = *Pointer<Int>(edge + OFFSET(Primitive::Edge,D));
+
+				Int Qk;
+				Int Rk;
+				edgeStep(Qk, Rk, *Pointer<Int>(edge + OFFSET(Primitive::Edge,Q)), *Pointer<Int>(edge + OFFSET(Primitive::Edge,R)), D, y - y1);
+				stepEdge(x, d, Qk, Rk, D);
+
+				x = Clamp(x, xMin, xMax);
+
+				If(*Pointer<Int>(edge + OFFSET(Primitive::Edge,side)) == Int(OFFSET(Primitive::Span,left)))
+				{
+					left = x;
+				}
+				Else
+				{
+					right = x;
 				}
-				Until(y >= y2)
 			}
+
+			edge += sizeof(Primitive::Edge);
 		}
+
+		return left == right;
+	}
+
+	void SetupRoutine::edgeStep(Int &Qk, Int &Rk, const Int &Q, const Int &R, const Int &D, Int k)
+	{
+		// Composes single scanline steps by repeated doubling
+		Int Qp = Q;
+		Int Rp = R;
+
+		Qk = 0;
+		Rk = 0;
+
+		While(k != 0)
+		{
+			If((k & 1) != 0)
+			{
+				Qk += Qp;
+				Rk += Rp;
+
+				Int overflow = (D - 1 - Rk) >> 31;
+
+				Rk -= D & overflow;
+				Qk -= overflow;
+			}
+
+			Qp += Qp;
+			Rp += Rp;
+
+			Int overflow = (D - 1 - Rp) >> 31;
+
+			Rp -= D & overflow;
+			Qp -= overflow;
+
+			k = k >> 1;
+		}
+	}
+
+	void SetupRoutine::stepEdge(Int &x, Int &d, const Int &Q, const Int &R, const Int &D)
+	{
+		x += Q;
+		d += R;
+
+		Int overflow = -d >> 31;
+
+		d -= D & overflow;
+		x -= overflow;
 	}
 
 	void SetupRoutine::conditionalRotate1(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2)
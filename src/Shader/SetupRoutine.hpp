@@ -32,9 +32,14 @@ namespace sw
 		void generate();
 		Routine *getRoutine();
 
+		// Combined step of a Primitive::Edge across k scanlines, with the error-step kept below D
+		static void edgeStep(Int &Qk, Int &Rk, const Int &Q, const Int &R, const Int &D, Int k);
+		static void stepEdge(Int &x, Int &d, const Int &Q, const Int &R, const Int &D);
+
 	private:
 		void setupGradient(Pointer<Byte> &primitive, Pointer<Byte> &triangle, Float4 &w012, Float4 (&m)[3], Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2, int attribute, int planeEquation, bool flatShading, bool sprite, bool perspective, bool wrap, int component);
 		void edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &q);
+		Bool emptySpan(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &y);
 		void conditionalRotate1(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2);
 		void conditionalRotate2(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2);
 
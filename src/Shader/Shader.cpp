@@ -19,13 +19,20 @@
 #include "Common/Math.hpp"
 #include "Common/Debug.hpp"
 
+#include <algorithm>
+#include <map>
 #include <set>
 #include <fstream>
 #include <sstream>
 #include <stdarg.h>
+#include <float.h>
+#include <string.h>
+#include <cmath>
 
 namespace sw
 {
+	bool shaderOptimization = true;   // Register level optimization of the instructions, set by SwiftConfig
+
 	volatile int Shader::serialCounter = 1;
 
 	Shader::Opcode Shader::OPCODE_DP(int i)
@@ -1132,6 +1139,7 @@ namespace sw
 	Shader::Shader() : serialID(serialCounter++)
 	{
 		usedSamplers = 0;
+		statistics = OptimizerStatistics();
 	}
 
 	Shader::~Shader()
@@ -1428,6 +1436,14 @@ namespace sw
 		return serialID;
 	}
 
+	uint64_t Shader::getContentHash() const
+	{
+		std::vector<unsigned int> words;
+		serialize(words);
+
+		return FNV_1a(reinterpret_cast<const unsigned char*>(words.data()), static_cast<int>(words.size() * sizeof(unsigned int)));
+	}
+
 	size_t Shader::getLength() const
 	{
 		return instruction.size();
@@ -1487,13 +1503,377 @@ namespace sw
 		return instruction[i];
 	}
 
+	// Operations which only write their destination register, computed from their sources
+	static bool isPureOperation(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_MOV:
+		case Shader::OPCODE_NEG:
+		case Shader::OPCODE_INEG:
+		case Shader::OPCODE_F2B:
+		case Shader::OPCODE_B2F:
+		case Shader::OPCODE_F2I:
+		case Shader::OPCODE_I2F:
+		case Shader::OPCODE_F2U:
+		case Shader::OPCODE_U2F:
+		case Shader::OPCODE_I2B:
+		case Shader::OPCODE_B2I:
+		case Shader::OPCODE_ADD:
+		case Shader::OPCODE_IADD:
+		case Shader::OPCODE_SUB:
+		case Shader::OPCODE_ISUB:
+		case Shader::OPCODE_MUL:
+		case Shader::OPCODE_IMUL:
+		case Shader::OPCODE_MAD:
+		case Shader::OPCODE_IMAD:
+		case Shader::OPCODE_CMP0:
+		case Shader::OPCODE_ICMP:
+		case Shader::OPCODE_UCMP:
+		case Shader::OPCODE_SELECT:
+		case Shader::OPCODE_FRC:
+		case Shader::OPCODE_TRUNC:
+		case Shader::OPCODE_FLOOR:
+		case Shader::OPCODE_ROUND:
+		case Shader::OPCODE_ROUNDEVEN:
+		case Shader::OPCODE_CEIL:
+		case Shader::OPCODE_EXP2:
+		case Shader::OPCODE_LOG2:
+		case Shader::OPCODE_EXP:
+		case Shader::OPCODE_LOG:
+		case Shader::OPCODE_DIV:
+		case Shader::OPCODE_IDIV:
+		case Shader::OPCODE_UDIV:
+		case Shader::OPCODE_MOD:
+		case Shader::OPCODE_IMOD:
+		case Shader::OPCODE_UMOD:
+		case Shader::OPCODE_SHL:
+		case Shader::OPCODE_ISHR:
+		case Shader::OPCODE_USHR:
+		case Shader::OPCODE_SQRT:
+		case Shader::OPCODE_RSQ:
+		case Shader::OPCODE_MIN:
+		case Shader::OPCODE_IMIN:
+		case Shader::OPCODE_UMIN:
+		case Shader::OPCODE_MAX:
+		case Shader::OPCODE_IMAX:
+		case Shader::OPCODE_UMAX:
+		case Shader::OPCODE_LRP:
+		case Shader::OPCODE_STEP:
+		case Shader::OPCODE_SMOOTH:
+		case Shader::OPCODE_ISINF:
+		case Shader::OPCODE_ISNAN:
+		case Shader::OPCODE_FLOATBITSTOINT:
+		case Shader::OPCODE_FLOATBITSTOUINT:
+		case Shader::OPCODE_INTBITSTOFLOAT:
+		case Shader::OPCODE_UINTBITSTOFLOAT:
+		case Shader::OPCODE_POW:
+		case Shader::OPCODE_SGN:
+		case Shader::OPCODE_ISGN:
+		case Shader::OPCODE_ABS:
+		case Shader::OPCODE_IABS:
+		case Shader::OPCODE_COS:
+		case Shader::OPCODE_SIN:
+		case Shader::OPCODE_TAN:
+		case Shader::OPCODE_ACOS:
+		case Shader::OPCODE_ASIN:
+		case Shader::OPCODE_ATAN:
+		case Shader::OPCODE_ATAN2:
+		case Shader::OPCODE_COSH:
+		case Shader::OPCODE_SINH:
+		case Shader::OPCODE_TANH:
+		case Shader::OPCODE_ACOSH:
+		case Shader::OPCODE_ASINH:
+		case Shader::OPCODE_ATANH:
+		case Shader::OPCODE_CMP:
+		case Shader::OPCODE_NOT:
+		case Shader::OPCODE_OR:
+		case Shader::OPCODE_XOR:
+		case Shader::OPCODE_AND:
+		case Shader::OPCODE_EQ:
+		case Shader::OPCODE_NE:
+		case Shader::OPCODE_RCPX:
+		case Shader::OPCODE_RSQX:
+		case Shader::OPCODE_EXP2X:
+		case Shader::OPCODE_LOG2X:
+		case Shader::OPCODE_POWX:
+		case Shader::OPCODE_DP1:
+		case Shader::OPCODE_DP2:
+		case Shader::OPCODE_DP3:
+		case Shader::OPCODE_DP4:
+		case Shader::OPCODE_DP2ADD:
+		case Shader::OPCODE_DET2:
+		case Shader::OPCODE_DET3:
+		case Shader::OPCODE_DET4:
+		case Shader::OPCODE_CRS:
+		case Shader::OPCODE_NRM2:
+		case Shader::OPCODE_NRM3:
+		case Shader::OPCODE_NRM4:
+		case Shader::OPCODE_LEN2:
+		case Shader::OPCODE_LEN3:
+		case Shader::OPCODE_LEN4:
+		case Shader::OPCODE_DIST1:
+		case Shader::OPCODE_DIST2:
+		case Shader::OPCODE_DIST3:
+		case Shader::OPCODE_DIST4:
+		case Shader::OPCODE_ALL:
+		case Shader::OPCODE_ANY:
+		case Shader::OPCODE_FORWARD1:
+		case Shader::OPCODE_FORWARD2:
+		case Shader::OPCODE_FORWARD3:
+		case Shader::OPCODE_FORWARD4:
+		case Shader::OPCODE_REFLECT1:
+		case Shader::OPCODE_REFLECT2:
+		case Shader::OPCODE_REFLECT3:
+		case Shader::OPCODE_REFLECT4:
+		case Shader::OPCODE_REFRACT1:
+		case Shader::OPCODE_REFRACT2:
+		case Shader::OPCODE_REFRACT3:
+		case Shader::OPCODE_REFRACT4:
+		case Shader::OPCODE_PACKSNORM2x16:
+		case Shader::OPCODE_PACKUNORM2x16:
+		case Shader::OPCODE_PACKHALF2x16:
+		case Shader::OPCODE_UNPACKSNORM2x16:
+		case Shader::OPCODE_UNPACKUNORM2x16:
+		case Shader::OPCODE_UNPACKHALF2x16:
+		case Shader::OPCODE_EXTRACT:
+		case Shader::OPCODE_INSERT:
+		case Shader::OPCODE_M4X4:
+		case Shader::OPCODE_M4X3:
+		case Shader::OPCODE_M3X4:
+		case Shader::OPCODE_M3X3:
+		case Shader::OPCODE_M3X2:
+		case Shader::OPCODE_TEX:
+		case Shader::OPCODE_TEXOFFSET:
+		case Shader::OPCODE_TEXBIAS:
+		case Shader::OPCODE_TEXOFFSETBIAS:
+		case Shader::OPCODE_TEXLOD:
+		case Shader::OPCODE_TEXLODOFFSET:
+		case Shader::OPCODE_TEXLDL:
+		case Shader::OPCODE_TEXLDD:
+		case Shader::OPCODE_TEXELFETCH:
+		case Shader::OPCODE_TEXELFETCHOFFSET:
+		case Shader::OPCODE_TEXGRAD:
+		case Shader::OPCODE_TEXGRADOFFSET:
+		case Shader::OPCODE_TEXSIZE:
+		case Shader::OPCODE_DFDX:
+		case Shader::OPCODE_DFDY:
+		case Shader::OPCODE_FWIDTH:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Pure operations of which each destination component only reads the same components of the sources
+	static bool isComponentwise(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_RCPX:
+		case Shader::OPCODE_RSQX:
+		case Shader::OPCODE_EXP2X:
+		case Shader::OPCODE_LOG2X:
+		case Shader::OPCODE_POWX:
+		case Shader::OPCODE_DP1:
+		case Shader::OPCODE_DP2:
+		case Shader::OPCODE_DP3:
+		case Shader::OPCODE_DP4:
+		case Shader::OPCODE_DP2ADD:
+		case Shader::OPCODE_DET2:
+		case Shader::OPCODE_DET3:
+		case Shader::OPCODE_DET4:
+		case Shader::OPCODE_CRS:
+		case Shader::OPCODE_NRM2:
+		case Shader::OPCODE_NRM3:
+		case Shader::OPCODE_NRM4:
+		case Shader::OPCODE_LEN2:
+		case Shader::OPCODE_LEN3:
+		case Shader::OPCODE_LEN4:
+		case Shader::OPCODE_DIST1:
+		case Shader::OPCODE_DIST2:
+		case Shader::OPCODE_DIST3:
+		case Shader::OPCODE_DIST4:
+		case Shader::OPCODE_ALL:
+		case Shader::OPCODE_ANY:
+		case Shader::OPCODE_FORWARD1:
+		case Shader::OPCODE_FORWARD2:
+		case Shader::OPCODE_FORWARD3:
+		case Shader::OPCODE_FORWARD4:
+		case Shader::OPCODE_REFLECT1:
+		case Shader::OPCODE_REFLECT2:
+		case Shader::OPCODE_REFLECT3:
+		case Shader::OPCODE_REFLECT4:
+		case Shader::OPCODE_REFRACT1:
+		case Shader::OPCODE_REFRACT2:
+		case Shader::OPCODE_REFRACT3:
+		case Shader::OPCODE_REFRACT4:
+		case Shader::OPCODE_PACKSNORM2x16:
+		case Shader::OPCODE_PACKUNORM2x16:
+		case Shader::OPCODE_PACKHALF2x16:
+		case Shader::OPCODE_UNPACKSNORM2x16:
+		case Shader::OPCODE_UNPACKUNORM2x16:
+		case Shader::OPCODE_UNPACKHALF2x16:
+		case Shader::OPCODE_EXTRACT:
+		case Shader::OPCODE_INSERT:
+		case Shader::OPCODE_M4X4:
+		case Shader::OPCODE_M4X3:
+		case Shader::OPCODE_M3X4:
+		case Shader::OPCODE_M3X3:
+		case Shader::OPCODE_M3X2:
+		case Shader::OPCODE_TEX:
+		case Shader::OPCODE_TEXOFFSET:
+		case Shader::OPCODE_TEXBIAS:
+		case Shader::OPCODE_TEXOFFSETBIAS:
+		case Shader::OPCODE_TEXLOD:
+		case Shader::OPCODE_TEXLODOFFSET:
+		case Shader::OPCODE_TEXLDL:
+		case Shader::OPCODE_TEXLDD:
+		case Shader::OPCODE_TEXELFETCH:
+		case Shader::OPCODE_TEXELFETCHOFFSET:
+		case Shader::OPCODE_TEXGRAD:
+		case Shader::OPCODE_TEXGRADOFFSET:
+		case Shader::OPCODE_TEXSIZE:
+		case Shader::OPCODE_DFDX:
+		case Shader::OPCODE_DFDY:
+		case Shader::OPCODE_FWIDTH:
+			return false;
+		default:
+			return isPureOperation(opcode);
+		}
+	}
+
+	// Operations which depend on the source values of neighboring pixels (explicitly or through implicit derivatives)
+	static bool readsNeighbors(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_TEX:
+		case Shader::OPCODE_TEXOFFSET:
+		case Shader::OPCODE_TEXBIAS:
+		case Shader::OPCODE_TEXOFFSETBIAS:
+		case Shader::OPCODE_DFDX:
+		case Shader::OPCODE_DFDY:
+		case Shader::OPCODE_FWIDTH:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Number of consecutive registers read by a source operand
+	static int sourceRegisters(const Shader::Instruction *instruction, int i)
+	{
+		if(i != 1)
+		{
+			return 1;
+		}
+
+		switch(instruction->opcode)
+		{
+		case Shader::OPCODE_M4X4: return 4;
+		case Shader::OPCODE_M4X3: return 3;
+		case Shader::OPCODE_M3X4: return 4;
+		case Shader::OPCODE_M3X3: return 3;
+		case Shader::OPCODE_M3X2: return 2;
+		default:                  return 1;
+		}
+	}
+
+	// Parameters of these types store a literal or label in place of the register index and relative addressing
+	static bool isRegister(Shader::ParameterType type)
+	{
+		switch(type)
+		{
+		case Shader::PARAMETER_VOID:
+		case Shader::PARAMETER_LABEL:
+		case Shader::PARAMETER_FLOAT4LITERAL:
+		case Shader::PARAMETER_BOOL1LITERAL:
+		case Shader::PARAMETER_INT4LITERAL:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	// Components of the source register read by the given destination components
+	static int readComponents(unsigned int swizzle, int mask)
+	{
+		int components = 0;
+
+		for(int i = 0; i < 4; i++)
+		{
+			if(mask & (1 << i))
+			{
+				components |= 1 << ((swizzle >> (2 * i)) & 3);
+			}
+		}
+
+		return components;
+	}
+
+	static bool isDenormal(float value)
+	{
+		return value != 0.0f && std::abs(value) < FLT_MIN;
+	}
+
 	void Shader::optimize()
 	{
+		statistics = OptimizerStatistics();
+		statistics.instructions = (unsigned int)instruction.size();
+
 		optimizeLeave();
 		optimizeCall();
+
+		// Register level optimizations need all temporaries to be statically addressed
+		bool staticTemporaries = true;
+
+		for(const auto &inst : instruction)
+		{
+			if(inst->opcode == OPCODE_NULL)
+			{
+				continue;
+			}
+
+			if(inst->dst.type == PARAMETER_TEMP && inst->dst.rel.type != PARAMETER_VOID)
+			{
+				staticTemporaries = false;
+			}
+
+			for(int i = 0; i < 5; i++)
+			{
+				if(inst->src[i].type == PARAMETER_TEMP && inst->src[i].rel.type != PARAMETER_VOID)
+				{
+					staticTemporaries = false;
+				}
+			}
+		}
+
+		if(shaderOptimization && shaderModel >= 0x0300 && staticTemporaries)
+		{
+			for(int pass = 0; pass < 4; pass++)
+			{
+				bool propagated = propagateCopies();
+				bool folded = foldConstants();
+
+				if(!propagated && !folded)
+				{
+					break;
+				}
+			}
+
+			removeRedundantMoves();
+			eliminateDeadCode();
+		}
+
 		removeNull();
 	}
 
+	const Shader::OptimizerStatistics &Shader::getOptimizerStatistics() const
+	{
+		return statistics;
+	}
+
 	void Shader::optimizeLeave()
 	{
 		// A return (leave) right before the end of a function or the shader can be removed
@@ -1572,6 +1952,644 @@ namespace sw
 		}
 	}
 
+	bool Shader::propagateCopies()
+	{
+		// Forward the source of register copies to subsequent reads within the same basic block
+		bool changed = false;
+
+		for(size_t i = 0; i < instruction.size(); i++)
+		{
+			const Instruction *copy = instruction[i];
+			const DestinationParameter &dst = copy->dst;
+			const SourceParameter &src = copy->src[0];
+
+			if(copy->opcode != OPCODE_MOV || copy->predicate || dst.saturate || dst.shift != 0 ||
+			   dst.type != PARAMETER_TEMP || src.modifier != MODIFIER_NONE)
+			{
+				continue;
+			}
+
+			switch(src.type)
+			{
+			case PARAMETER_TEMP:
+				if(src.index == dst.index)
+				{
+					continue;
+				}
+				// Fall through
+			case PARAMETER_INPUT:
+			case PARAMETER_CONST:
+				if(src.rel.type != PARAMETER_VOID)
+				{
+					continue;
+				}
+				break;
+			case PARAMETER_FLOAT4LITERAL:
+				break;
+			default:
+				continue;
+			}
+
+			int valid = dst.mask;   // Components still holding the copied values
+
+			for(size_t j = i + 1; j < instruction.size() && valid; j++)
+			{
+				Instruction *inst = instruction[j];
+
+				if(inst->opcode == OPCODE_NULL)
+				{
+					continue;
+				}
+
+				if(!isPureOperation(inst->opcode))
+				{
+					break;
+				}
+
+				if(!readsNeighbors(inst->opcode))
+				{
+					int slots = isComponentwise(inst->opcode) ? inst->dst.mask : 0xF;
+
+					for(int k = 0; k < 5; k++)
+					{
+						SourceParameter &use = inst->src[k];
+
+						if(use.type != PARAMETER_TEMP || use.index != dst.index || sourceRegisters(inst, k) != 1)
+						{
+							continue;
+						}
+
+						if(readComponents(use.swizzle, slots) & ~valid)
+						{
+							continue;
+						}
+
+						unsigned int swizzle = 0;
+						int first = -1;
+
+						for(int c = 0; c < 4; c++)
+						{
+							if(slots & (1 << c))
+							{
+								int component = (src.swizzle >> (2 * ((use.swizzle >> (2 * c)) & 3))) & 3;
+								swizzle |= component << (2 * c);
+
+								if(first < 0)
+								{
+									first = component;
+								}
+							}
+						}
+
+						for(int c = 0; c < 4; c++)
+						{
+							if(!(slots & (1 << c)))
+							{
+								swizzle |= first << (2 * c);
+							}
+						}
+
+						Modifier modifier = use.modifier;
+						use = src;
+						use.swizzle = swizzle;
+						use.modifier = modifier;
+
+						statistics.propagatedCopies++;
+						changed = true;
+					}
+				}
+
+				if(inst->dst.type == PARAMETER_TEMP)
+				{
+					if(src.type == PARAMETER_TEMP && inst->dst.index == src.index)
+					{
+						break;
+					}
+
+					if(inst->dst.index == dst.index)
+					{
+						valid &= ~inst->dst.mask;
+					}
+				}
+			}
+		}
+
+		return changed;
+	}
+
+	bool Shader::foldConstants()
+	{
+		bool changed = false;
+
+		for(auto &inst : instruction)
+		{
+			int sources = 0;
+			bool integer = false;
+
+			switch(inst->opcode)
+			{
+			case OPCODE_I2F:
+				sources = 1;
+				integer = true;
+				break;
+			case OPCODE_ADD:
+			case OPCODE_SUB:
+			case OPCODE_MUL:
+			case OPCODE_DIV:
+			case OPCODE_MIN:
+			case OPCODE_MAX:
+				sources = 2;
+				break;
+			case OPCODE_IADD:
+			case OPCODE_ISUB:
+			case OPCODE_IMUL:
+				sources = 2;
+				integer = true;
+				break;
+			default:
+				continue;
+			}
+
+			if(inst->dst.saturate || inst->dst.shift != 0)
+			{
+				continue;
+			}
+
+			bool literals = true;
+
+			for(int i = 0; i < sources; i++)
+			{
+				const SourceParameter &src = inst->src[i];
+
+				if(src.type != PARAMETER_FLOAT4LITERAL || !(src.modifier == MODIFIER_NONE || (src.modifier == MODIFIER_NEGATE && !integer)))
+				{
+					literals = false;
+				}
+			}
+
+			if(!literals)
+			{
+				// Multiplication or division by one is a copy
+				if((inst->opcode == OPCODE_MUL || inst->opcode == OPCODE_DIV) && !inst->dst.saturate && inst->dst.shift == 0)
+				{
+					for(int i = (inst->opcode == OPCODE_MUL) ? 0 : 1; i < 2; i++)
+					{
+						const SourceParameter &one = inst->src[i];
+
+						if(one.type != PARAMETER_FLOAT4LITERAL || one.modifier != MODIFIER_NONE)
+						{
+							continue;
+						}
+
+						bool identity = true;
+
+						for(int c = 0; c < 4; c++)
+						{
+							if((inst->dst.mask & (1 << c)) && one.value[(one.swizzle >> (2 * c)) & 3] != 1.0f)
+							{
+								identity = false;
+							}
+						}
+
+						if(identity)
+						{
+							inst->opcode = OPCODE_MOV;
+							inst->src[0] = inst->src[1 - i];
+							inst->src[1] = SourceParameter();
+
+							statistics.simplifiedOperations++;
+							changed = true;
+							break;
+						}
+					}
+				}
+
+				continue;
+			}
+
+			float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			bool exact = true;
+
+			for(int c = 0; c < 4; c++)
+			{
+				if(!(inst->dst.mask & (1 << c)))
+				{
+					continue;
+				}
+
+				float a[2];
+				int i[2];
+
+				for(int s = 0; s < sources; s++)
+				{
+					const SourceParameter &src = inst->src[s];
+					int component = (src.swizzle >> (2 * c)) & 3;
+
+					a[s] = src.value[component];
+					i[s] = src.integer[component];
+
+					if(src.modifier == MODIFIER_NEGATE)
+					{
+						a[s] = -a[s];
+					}
+
+					// Leave denormal and NaN handling to the hardware
+					if(!integer && (isDenormal(a[s]) || a[s] != a[s]))
+					{
+						exact = false;
+					}
+				}
+
+				switch(inst->opcode)
+				{
+				case OPCODE_ADD: value[c] = a[0] + a[1];               break;
+				case OPCODE_SUB: value[c] = a[0] - a[1];               break;
+				case OPCODE_MUL: value[c] = a[0] * a[1];               break;
+				case OPCODE_DIV: value[c] = a[0] / a[1];               break;
+				case OPCODE_MIN: value[c] = (a[0] < a[1]) ? a[0] : a[1]; break;
+				case OPCODE_MAX: value[c] = (a[0] > a[1]) ? a[0] : a[1]; break;
+				case OPCODE_I2F: value[c] = (float)i[0];               break;
+				case OPCODE_IADD: i[0] = (int)((unsigned int)i[0] + (unsigned int)i[1]); memcpy(&value[c], &i[0], sizeof(float)); break;
+				case OPCODE_ISUB: i[0] = (int)((unsigned int)i[0] - (unsigned int)i[1]); memcpy(&value[c], &i[0], sizeof(float)); break;
+				case OPCODE_IMUL: i[0] = (int)((unsigned int)i[0] * (unsigned int)i[1]); memcpy(&value[c], &i[0], sizeof(float)); break;
+				default: ASSERT(false);
+				}
+
+				bool result = inst->opcode == OPCODE_I2F || !integer;
+
+				if(result && (isDenormal(value[c]) || value[c] != value[c]))
+				{
+					exact = false;
+				}
+			}
+
+			if(!exact)
+			{
+				continue;
+			}
+
+			inst->opcode = OPCODE_MOV;
+			inst->src[0] = SourceParameter();
+			inst->src[0].type = PARAMETER_FLOAT4LITERAL;
+
+			for(int c = 0; c < 4; c++)
+			{
+				inst->src[0].value[c] = value[c];
+			}
+
+			inst->src[1] = SourceParameter();
+
+			statistics.foldedConstants++;
+			changed = true;
+		}
+
+		return changed;
+	}
+
+	void Shader::removeRedundantMoves()
+	{
+		// Moves of a register's components onto themselves
+		for(auto &inst : instruction)
+		{
+			const DestinationParameter &dst = inst->dst;
+			const SourceParameter &src = inst->src[0];
+
+			if(inst->opcode != OPCODE_MOV || dst.saturate || dst.shift != 0 || dst.type != PARAMETER_TEMP ||
+			   src.type != PARAMETER_TEMP || src.index != dst.index || src.modifier != MODIFIER_NONE)
+			{
+				continue;
+			}
+
+			bool identity = true;
+
+			for(int c = 0; c < 4; c++)
+			{
+				if((dst.mask & (1 << c)) && ((src.swizzle >> (2 * c)) & 3) != (unsigned int)c)
+				{
+					identity = false;
+				}
+			}
+
+			if(identity)
+			{
+				inst->opcode = OPCODE_NULL;
+				statistics.redundantMoves++;
+			}
+		}
+	}
+
+	void Shader::eliminateDeadCode()
+	{
+		// Remove pure operations of which no result component is read before being overwritten,
+		// using a liveness analysis of the temporary registers over the structured control flow
+		const int count = (int)instruction.size();
+
+		std::vector<int> match(count, -1);         // Matching end and start of blocks, end of ELSE
+		std::vector<int> alternative(count, -1);   // ELSE of IF blocks, TEST of loops
+		std::vector<int> enclosing(count, -1);     // Loop or switch exited by BREAK and CONTINUE
+		std::vector<int> function(count, -1);      // Label of the function containing the instruction
+		std::map<unsigned int, int> labelPosition;
+		std::map<unsigned int, std::vector<int>> returnPosition;
+		std::vector<int> block;
+		unsigned int temporaries = 0;
+		int label = -1;
+
+		for(int i = 0; i < count; i++)
+		{
+			const Instruction *inst = instruction[i];
+
+			if(inst->opcode == OPCODE_NULL)
+			{
+				continue;
+			}
+
+			if(inst->dst.type == PARAMETER_TEMP)
+			{
+				temporaries = std::max(temporaries, inst->dst.index + 1);
+			}
+
+			if(isRegister(inst->dst.type) && inst->dst.rel.type == PARAMETER_TEMP)
+			{
+				temporaries = std::max(temporaries, inst->dst.rel.index + 1);
+			}
+
+			for(int k = 0; k < 5; k++)
+			{
+				const SourceParameter &src = inst->src[k];
+
+				if(src.type == PARAMETER_TEMP)
+				{
+					temporaries = std::max(temporaries, src.index + sourceRegisters(inst, k));
+				}
+
+				if(isRegister(src.type) && src.rel.type == PARAMETER_TEMP)
+				{
+					temporaries = std::max(temporaries, src.rel.index + 1);
+				}
+			}
+
+			switch(inst->opcode)
+			{
+			case OPCODE_LABEL:
+				label = inst->dst.label;
+				labelPosition[inst->dst.label] = i;
+				break;
+			case OPCODE_CALL:
+			case OPCODE_CALLNZ:
+				returnPosition[inst->dst.label].push_back(i + 1);
+				break;
+			case OPCODE_IF:
+			case OPCODE_IFC:
+			case OPCODE_LOOP:
+			case OPCODE_REP:
+			case OPCODE_WHILE:
+			case OPCODE_SWITCH:
+				block.push_back(i);
+				break;
+			case OPCODE_ELSE:
+				if(block.empty() || !instruction[block.back()]->isBranch())
+				{
+					return;
+				}
+				alternative[block.back()] = i;
+				break;
+			case OPCODE_ENDIF:
+			case OPCODE_ENDLOOP:
+			case OPCODE_ENDREP:
+			case OPCODE_ENDWHILE:
+			case OPCODE_ENDSWITCH:
+				if(block.empty())
+				{
+					return;
+				}
+				match[block.back()] = i;
+				match[i] = block.back();
+				if(alternative[block.back()] >= 0 && instruction[block.back()]->isBranch())
+				{
+					match[alternative[block.back()]] = i;
+				}
+				block.pop_back();
+				break;
+			case OPCODE_BREAK:
+			case OPCODE_BREAKC:
+			case OPCODE_BREAKP:
+			case OPCODE_CONTINUE:
+			case OPCODE_TEST:
+				for(auto b = block.rbegin(); b != block.rend(); b++)
+				{
+					Opcode opcode = instruction[*b]->opcode;
+					bool exit = (opcode == OPCODE_SWITCH) && (inst->opcode != OPCODE_CONTINUE) && (inst->opcode != OPCODE_TEST);
+
+					if(opcode == OPCODE_LOOP || opcode == OPCODE_REP || opcode == OPCODE_WHILE || exit)
+					{
+						enclosing[i] = *b;
+						break;
+					}
+				}
+				if(enclosing[i] < 0)
+				{
+					return;
+				}
+				if(inst->opcode == OPCODE_TEST)
+				{
+					alternative[enclosing[i]] = i;
+				}
+				break;
+			default:
+				break;
+			}
+
+			function[i] = label;
+		}
+
+		if(!block.empty() || temporaries == 0)
+		{
+			return;
+		}
+
+		for(const auto &call : returnPosition)
+		{
+			if(labelPosition.find(call.first) == labelPosition.end())
+			{
+				return;
+			}
+		}
+
+		auto successors = [&](int i, std::vector<int> &next)
+		{
+			const Instruction *inst = instruction[i];
+			next.clear();
+
+			switch(inst->opcode)
+			{
+			case OPCODE_IF:
+			case OPCODE_IFC:
+				next.push_back(i + 1);
+				next.push_back((alternative[i] >= 0) ? alternative[i] + 1 : match[i]);
+				break;
+			case OPCODE_ELSE:
+				next.push_back(match[i]);
+				break;
+			case OPCODE_LOOP:
+			case OPCODE_REP:
+			case OPCODE_WHILE:
+				next.push_back(i + 1);
+				next.push_back(match[i] + 1);
+				break;
+			case OPCODE_ENDLOOP:
+			case OPCODE_ENDREP:
+			case OPCODE_ENDWHILE:
+				next.push_back(match[i]);
+				next.push_back(i + 1);
+				break;
+			case OPCODE_SWITCH:
+				next.push_back(i + 1);
+				next.push_back(match[i]);
+				break;
+			case OPCODE_BREAKC:
+			case OPCODE_BREAKP:
+				next.push_back(i + 1);
+				// Fall through
+			case OPCODE_BREAK:
+				next.push_back(match[enclosing[i]] + 1);
+				break;
+			case OPCODE_CONTINUE:
+				next.push_back((alternative[enclosing[i]] >= 0) ? alternative[enclosing[i]] : match[enclosing[i]]);
+				break;
+			case OPCODE_CALLNZ:
+				next.push_back(i + 1);
+				// Fall through
+			case OPCODE_CALL:
+				next.push_back(labelPosition[inst->dst.label]);
+				break;
+			case OPCODE_RET:
+			case OPCODE_LEAVE:
+				if(function[i] >= 0)
+				{
+					next = returnPosition[function[i]];
+				}
+				break;
+			case OPCODE_END:
+				break;
+			default:
+				next.push_back(i + 1);
+				break;
+			}
+		};
+
+		// Components of each temporary register live at the start of each instruction
+		std::vector<unsigned char> live((size_t)count * temporaries, 0);
+		std::vector<unsigned char> out(temporaries);
+		std::vector<int> next;
+
+		auto liveOut = [&](int i)
+		{
+			std::fill(out.begin(), out.end(), 0);
+			successors(i, next);
+
+			for(int s : next)
+			{
+				if(s < count)
+				{
+					const unsigned char *in = &live[(size_t)s * temporaries];
+
+					for(unsigned int t = 0; t < temporaries; t++)
+					{
+						out[t] |= in[t];
+					}
+				}
+			}
+		};
+
+		auto isRemovable = [&](const Instruction *inst)
+		{
+			return isPureOperation(inst->opcode) && inst->dst.type == PARAMETER_TEMP;
+		};
+
+		bool changed = true;
+
+		while(changed)
+		{
+			changed = false;
+
+			for(int i = count - 1; i >= 0; i--)
+			{
+				const Instruction *inst = instruction[i];
+				liveOut(i);
+
+				if(inst->opcode != OPCODE_NULL)
+				{
+					bool pure = isPureOperation(inst->opcode);
+					const DestinationParameter &dst = inst->dst;
+
+					if(!isRemovable(inst) || (out[dst.index] & dst.mask))
+					{
+						if(pure && dst.type == PARAMETER_TEMP && !inst->predicate)
+						{
+							out[dst.index] &= ~dst.mask;
+						}
+
+						int slots = isComponentwise(inst->opcode) ? dst.mask : 0xF;
+
+						for(int k = 0; k < 5; k++)
+						{
+							const SourceParameter &src = inst->src[k];
+
+							if(isRegister(src.type) && src.rel.type == PARAMETER_TEMP)
+							{
+								out[src.rel.index] = 0xF;
+							}
+
+							if(src.type == PARAMETER_TEMP)
+							{
+								int registers = sourceRegisters(inst, k);
+
+								for(int r = 0; r < registers; r++)
+								{
+									out[src.index + r] |= (pure && registers == 1) ? readComponents(src.swizzle, slots) : 0xF;
+								}
+							}
+						}
+
+						if(isRegister(dst.type) && dst.rel.type == PARAMETER_TEMP)
+						{
+							out[dst.rel.index] = 0xF;
+						}
+
+						if(!pure && dst.type == PARAMETER_TEMP)
+						{
+							out[dst.index] = 0xF;   // E.g. TEXKILL reads its destination operand
+						}
+					}
+				}
+
+				unsigned char *in = &live[(size_t)i * temporaries];
+
+				if(!std::equal(out.begin(), out.end(), in))
+				{
+					std::copy(out.begin(), out.end(), in);
+					changed = true;
+				}
+			}
+		}
+
+		for(int i = 0; i < count; i++)
+		{
+			Instruction *inst = instruction[i];
+
+			if(inst->opcode != OPCODE_NULL && isRemovable(inst))
+			{
+				liveOut(i);
+
+				if(!(out[inst->dst.index] & inst->dst.mask))
+				{
+					inst->opcode = OPCODE_NULL;
+					statistics.deadInstructions++;
+				}
+			}
+		}
+	}
+
 	void Shader::removeNull()
 	{
 		size_t size = 0;
@@ -1927,4 +2945,79 @@ namespace sw
 			}
 		}
 	}
+
+	void Shader::serialize(std::vector<unsigned int> &words) const
+	{
+		// Only named fields are serialized, as the unions and bit fields contain undefined bits
+		auto parameter = [&](const Parameter &parameter, Opcode opcode)
+		{
+			words.push_back(parameter.type);
+
+			switch(parameter.type)
+			{
+			case PARAMETER_FLOAT4LITERAL:
+			case PARAMETER_INT4LITERAL:
+				words.insert(words.end(), parameter.integer, parameter.integer + 4);
+				break;
+			case PARAMETER_BOOL1LITERAL:
+				words.push_back(parameter.boolean[0]);
+				break;
+			case PARAMETER_LABEL:
+				words.push_back(parameter.label);
+				words.push_back((opcode == OPCODE_CALL || opcode == OPCODE_CALLNZ) ? parameter.callSite : 0);
+				break;
+			default:
+				words.push_back(parameter.index);
+				words.push_back(parameter.rel.type);
+				words.push_back(parameter.rel.index);
+				words.push_back(parameter.rel.swizzle);
+				words.push_back(parameter.rel.scale);
+				words.push_back(parameter.rel.deterministic);
+			}
+		};
+
+		words.push_back(shaderType);
+		words.push_back(shaderModel);
+		words.push_back(usedSamplers);
+		words.push_back(dirtyConstantsF);
+		words.push_back(dirtyConstantsI);
+		words.push_back(dirtyConstantsB);
+		words.push_back(dynamicallyIndexedTemporaries);
+		words.push_back(dynamicallyIndexedInput);
+		words.push_back(dynamicallyIndexedOutput);
+		words.push_back(dynamicBranching);
+		words.push_back(containsBreak);
+		words.push_back(containsContinue);
+		words.push_back(containsLeave);
+		words.push_back(containsDefine);
+
+		for(const Instruction *inst : instruction)
+		{
+			words.push_back(inst->opcode);
+			words.push_back(inst->control);
+			words.push_back(inst->predicate);
+			words.push_back(inst->predicateNot);
+			words.push_back(inst->predicateSwizzle);
+			words.push_back(inst->coissue);
+			words.push_back(inst->samplerType);
+			words.push_back(inst->usage);
+			words.push_back(inst->usageIndex);
+			words.push_back(inst->analysis);
+
+			parameter(inst->dst, inst->opcode);
+			words.push_back(inst->dst.mask);
+			words.push_back(inst->dst.saturate);
+			words.push_back(inst->dst.partialPrecision);
+			words.push_back(inst->dst.centroid);
+			words.push_back(inst->dst.shift);
+
+			for(const SourceParameter &src : inst->src)
+			{
+				parameter(src, inst->opcode);
+				words.push_back(src.swizzle);
+				words.push_back(src.modifier);
+				words.push_back(src.bufferIndex);
+			}
+		}
+	}
 }
@@ -558,6 +558,7 @@ namespace sw
 		virtual ~Shader();
 
 		int getSerialID() const;
+		uint64_t getContentHash() const;   // Identifies the generated code across processes, unlike the serial ID
 		size_t getLength() const;
 		ShaderType getShaderType() const;
 		unsigned short getShaderModel() const;
@@ -605,7 +606,18 @@ namespace sw
 			bool flat;
 		};
 
+		struct OptimizerStatistics
+		{
+			unsigned int instructions;   // Before optimization
+			unsigned int propagatedCopies;
+			unsigned int foldedConstants;
+			unsigned int simplifiedOperations;
+			unsigned int redundantMoves;
+			unsigned int deadInstructions;
+		};
+
 		void optimize();
+		const OptimizerStatistics &getOptimizerStatistics() const;
 
 		// FIXME: Private
 		unsigned int dirtyConstantsF;
@@ -621,6 +633,10 @@ namespace sw
 
 		void optimizeLeave();
 		void optimizeCall();
+		bool propagateCopies();
+		bool foldConstants();
+		void removeRedundantMoves();
+		void eliminateDeadCode();
 		void removeNull();
 
 		void analyzeDirtyConstants();
@@ -630,6 +646,8 @@ namespace sw
 		void analyzeDynamicIndexing();
 		void markFunctionAnalysis(unsigned int functionLabel, Analysis flag);
 
+		virtual void serialize(std::vector<unsigned int> &words) const;
+
 		ShaderType shaderType;
 
 		union
@@ -656,6 +674,8 @@ namespace sw
 		bool containsContinue;
 		bool containsLeave;
 		bool containsDefine;
+
+		OptimizerStatistics statistics;
 	};
 }
 
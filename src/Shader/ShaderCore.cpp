@@ -561,6 +561,41 @@ namespace sw
 		}
 	}
 
+	Float4 halfToFloat(RValue<Int4> halfBits)
+	{
+		static const uint32_t mask_nosign = 0x7FFF;
+		static const uint32_t magic = (254 - 15) << 23;
+		static const uint32_t was_infnan = 0x7BFF;
+		static const uint32_t exp_infnan = 255 << 23;
+
+		UInt4 expmant = As<UInt4>(halfBits) & UInt4(mask_nosign);
+
+		return As<Float4>(As<UInt4>(As<Float4>(expmant << 13) * As<Float4>(UInt4(magic))) |
+		                  ((As<UInt4>(halfBits) ^ UInt4(expmant)) << 16) |
+		                  (As<UInt4>(CmpNLE(As<Int4>(expmant), Int4(was_infnan))) & UInt4(exp_infnan)));
+	}
+
+	Int4 floatToHalf(RValue<Float4> x)
+	{
+		static const uint32_t mask_sign = 0x80000000u;
+		static const uint32_t mask_round = ~0xfffu;
+		static const uint32_t c_magic = 15 << 23;
+		static const uint32_t c_clamp = (31 << 23) - 0x1000;
+
+		Int4 justsign = Int4(mask_sign) & As<Int4>(x);
+		Int4 absf = As<Int4>(x) ^ justsign;
+
+		// Note: this version doesn't round to the nearest even in case of a tie as defined by IEEE 754-2008, it rounds to +inf
+		//       instead of nearest even, since that's fine for GLSL ES 3.0's needs (see section 2.1.1 Floating-Point Computation)
+		// Values too large for half precision, including infinity, get clamped to the rounding boundary of infinity.
+		// NaN is kept by minps returning its second operand. Only signaling NaNs with their payload in the low bits,
+		// which arithmetic doesn't produce, get converted to infinity.
+		Int4 joined = ((As<Int4>(Min(As<Float4>(Int4(c_clamp)), As<Float4>(absf & Int4(mask_round)) * As<Float4>(Int4(c_magic)))) -
+		               Int4(mask_round)) >> 13) & Int4(0x7FFF);
+
+		return joined | As<Int4>(As<UInt4>(justsign) >> 16);
+	}
+
 	void ShaderCore::mov(Vector4f &dst, const Vector4f &src, bool integerDestination)
 	{
 		if(integerDestination)
@@ -1122,39 +1157,21 @@ namespace sw
 
 	void ShaderCore::floatToHalfBits(Float4& dst, const Float4& floatBits, bool storeInUpperBits)
 	{
-		static const uint32_t mask_sign = 0x80000000u;
-		static const uint32_t mask_round = ~0xfffu;
-		static const uint32_t c_f32infty = 255 << 23;
-		static const uint32_t c_magic = 15 << 23;
-		static const uint32_t c_nanbit = 0x200;
-		static const uint32_t c_infty_as_fp16 = 0x7c00;
-		static const uint32_t c_clamp = (31 << 23) - 0x1000;
+		UInt4 halfBits = As<UInt4>(floatToHalf(floatBits));
 
-		UInt4 justsign = UInt4(mask_sign) & As<UInt4>(floatBits);
-		UInt4 absf = As<UInt4>(floatBits) ^ justsign;
-		UInt4 b_isnormal = CmpNLE(UInt4(c_f32infty), absf);
-
-		// Note: this version doesn't round to the nearest even in case of a tie as defined by IEEE 754-2008, it rounds to +inf
-		//       instead of nearest even, since that's fine for GLSL ES 3.0's needs (see section 2.1.1 Floating-Point Computation)
-		UInt4 joined = ((((As<UInt4>(Min(As<Float4>(absf & UInt4(mask_round)) * As<Float4>(UInt4(c_magic)),
-		                                 As<Float4>(UInt4(c_clamp))))) - UInt4(mask_round)) >> 13) & b_isnormal) |
-		               ((b_isnormal ^ UInt4(0xFFFFFFFF)) & ((CmpNLE(absf, UInt4(c_f32infty)) & UInt4(c_nanbit)) |
-		               UInt4(c_infty_as_fp16)));
-
-		dst = As<Float4>(storeInUpperBits ? As<UInt4>(dst) | ((joined << 16) | justsign) : joined | (justsign >> 16));
+		if(storeInUpperBits)
+		{
+			dst = As<Float4>(As<UInt4>(dst) | (halfBits << 16));
+		}
+		else
+		{
+			dst = As<Float4>(halfBits);
+		}
 	}
 
 	void ShaderCore::halfToFloatBits(Float4& dst, const Float4& halfBits)
 	{
-		static const uint32_t mask_nosign = 0x7FFF;
-		static const uint32_t magic = (254 - 15) << 23;
-		static const uint32_t was_infnan = 0x7BFF;
-		static const uint32_t exp_infnan = 255 << 23;
-
-		UInt4 expmant = As<UInt4>(halfBits) & UInt4(mask_nosign);
-		dst = As<Float4>(As<UInt4>(As<Float4>(expmant << 13) * As<Float4>(UInt4(magic))) |
-		                 ((As<UInt4>(halfBits) ^ UInt4(expmant)) << 16) |
-		                 (CmpNLE(As<UInt4>(expmant), UInt4(was_infnan)) & UInt4(exp_infnan)));
+		dst = halfToFloat(As<Int4>(halfBits));
 	}
 
 	void ShaderCore::packHalf2x16(Vector4f &d, const Vector4f &s0)
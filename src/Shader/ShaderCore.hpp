@@ -90,6 +90,9 @@ namespace sw
 	void transpose2x4(Float4 &row0, Float4 &row1, Float4 &row2, Float4 &row3);
 	void transpose4xN(Float4 &row0, Float4 &row1, Float4 &row2, Float4 &row3, int N);
 
+	Float4 halfToFloat(RValue<Int4> halfBits);   // Half-precision values in the low 16 bits
+	Int4 floatToHalf(RValue<Float4> x);          // Rounds ties away from zero, overflows to infinity
+
 	class Register
 	{
 	public:
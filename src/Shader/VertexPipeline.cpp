@@ -158,7 +158,7 @@ namespace sw
 		return dst;
 	}
 
-	void VertexPipeline::pipeline(UInt &index)
+	void VertexPipeline::pipeline(UInt index[4])
 	{
 		Vector4f position;
 		Vector4f normal;
@@ -51,7 +51,7 @@ namespace sw
 
 		if(shader->isInstanceIdDeclared())
 		{
-			instanceID = *Pointer<Int>(data + OFFSET(DrawData,instanceID));
+			instanceID = *Pointer<Int>(task + OFFSET(VertexTask,instanceID));
 		}
 	}
 
@@ -59,7 +59,7 @@ namespace sw
 	{
 	}
 
-	void VertexProgram::pipeline(UInt& index)
+	void VertexProgram::pipeline(UInt index[4])
 	{
 		if(!state.preTransformed)
 		{
@@ -71,7 +71,7 @@ namespace sw
 		}
 	}
 
-	void VertexProgram::program(UInt& index)
+	void VertexProgram::program(UInt index[4])
 	{
 	//	shader->print("VertexShader-%0.8X.txt", state.shaderID);
 
@@ -87,17 +87,10 @@ namespace sw
 
 		if(shader->isVertexIdDeclared())
 		{
-			if(state.textureSampling)
-			{
-				vertexID = Int4(index);
-			}
-			else
-			{
-				vertexID = Insert(vertexID, As<Int>(index), 0);
-				vertexID = Insert(vertexID, As<Int>(index + 1), 1);
-				vertexID = Insert(vertexID, As<Int>(index + 2), 2);
-				vertexID = Insert(vertexID, As<Int>(index + 3), 3);
-			}
+			vertexID = Insert(vertexID, As<Int>(index[0]), 0);
+			vertexID = Insert(vertexID, As<Int>(index[1]), 1);
+			vertexID = Insert(vertexID, As<Int>(index[2]), 2);
+			vertexID = Insert(vertexID, As<Int>(index[3]), 3);
 		}
 
 		// Create all call site return blocks up front
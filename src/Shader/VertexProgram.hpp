@@ -63,8 +63,8 @@ namespace sw
 		typedef Shader::Control Control;
 		typedef Shader::Usage Usage;
 
-		void pipeline(UInt &index) override;
-		void program(UInt &index);
+		void pipeline(UInt index[4]) override;
+		void program(UInt index[4]);
 		void passThrough();
 
 		Vector4f fetchRegister(const Src &src, unsigned int offset = 0);
@@ -39,11 +39,22 @@ namespace sw
 
 	void VertexRoutine::generate()
 	{
+		if(state.deduplicate)
+		{
+			generateDeduplicated();
+			return;
+		}
+
 		const bool textureSampling = state.textureSampling;
 
+		// The cache geometry is fixed for the lifetime of the routine
+		const int ways = state.vertexCacheAssociativity;
+		const int sets = state.vertexCacheSize / 4 / ways;
+
 		Pointer<Byte> cache = task + OFFSET(VertexTask,vertexCache);
-		Pointer<Byte> vertexCache = cache + OFFSET(VertexCache,vertex);
-		Pointer<Byte> tagCache = cache + OFFSET(VertexCache,tag);
+		Pointer<Byte> vertexCache = *Pointer<Pointer<Byte>>(cache + OFFSET(VertexCache,vertex));
+		Pointer<Byte> tagCache = *Pointer<Pointer<Byte>>(cache + OFFSET(VertexCache,tag));
+		Pointer<Byte> victimCache = *Pointer<Pointer<Byte>>(cache + OFFSET(VertexCache,victim));
 
 		UInt vertexCount = *Pointer<UInt>(task + OFFSET(VertexTask,vertexCount));
 		UInt primitiveNumber = *Pointer<UInt>(task + OFFSET(VertexTask, primitiveStart));
@@ -54,24 +65,53 @@ namespace sw
 		Do
 		{
 			UInt index = *Pointer<UInt>(batch);
-			UInt tagIndex = index & 0x0000003C;
 			UInt indexQ = !textureSampling ? UInt(index & 0xFFFFFFFC) : index;   // FIXME: TEXLDL hack to have independent LODs, hurts performance.
+			UInt set = (index >> 2) & UInt(sets - 1);
+			UInt line = set * UInt(ways);
+			Bool hit = *Pointer<UInt>(tagCache + line * 4) == indexQ;
 
-			If(*Pointer<UInt>(tagCache + tagIndex) != indexQ)
+			for(int way = 1; way < ways; way++)
 			{
-				*Pointer<UInt>(tagCache + tagIndex) = indexQ;
+				If(!hit && *Pointer<UInt>(tagCache + (line + UInt(way)) * 4) == indexQ)
+				{
+					line += UInt(way);
+					hit = Bool(true);
+				}
+			}
+
+			If(!hit)
+			{
+				if(ways > 1)
+				{
+					UInt victim = *Pointer<UInt>(victimCache + set * 4);
+					*Pointer<UInt>(victimCache + set * 4) = (victim + 1) & UInt(ways - 1);
+					line += victim;
+				}
 
-				readInput(indexQ);
-				pipeline(indexQ);
+				If(*Pointer<UInt>(tagCache + line * 4) != UInt(0x80000000))
+				{
+					*Pointer<UInt>(cache + OFFSET(VertexCache,evictions)) += 1;
+				}
+
+				*Pointer<UInt>(cache + OFFSET(VertexCache,misses)) += 1;
+				*Pointer<UInt>(tagCache + line * 4) = indexQ;
+
+				UInt vertexIndex[4];   // Of each lane
+				vertexIndex[0] = indexQ;
+				vertexIndex[1] = !textureSampling ? UInt(indexQ + 1) : indexQ;
+				vertexIndex[2] = !textureSampling ? UInt(indexQ + 2) : indexQ;
+				vertexIndex[3] = !textureSampling ? UInt(indexQ + 3) : indexQ;
+
+				readInput(vertexIndex);
+				pipeline(vertexIndex);
 				postTransform();
 				computeClipFlags();
 
-				Pointer<Byte> cacheLine0 = vertexCache + tagIndex * UInt((int)sizeof(Vertex));
+				Pointer<Byte> cacheLine0 = vertexCache + line * UInt((int)sizeof(Vertex) * 4);
 				writeCache(cacheLine0);
 			}
 
-			UInt cacheIndex = index & 0x0000003F;
-			Pointer<Byte> cacheLine = vertexCache + cacheIndex * UInt((int)sizeof(Vertex));
+			Pointer<Byte> cacheLine = vertexCache + (line * 4 + (index & 3)) * UInt((int)sizeof(Vertex));
 			writeVertex(vertex, cacheLine);
 
 			if(state.transformFeedbackEnabled != 0)
@@ -95,14 +135,71 @@ namespace sw
 		Return();
 	}
 
-	void VertexRoutine::readInput(UInt &index)
+	void VertexRoutine::generateDeduplicated()
+	{
+		Pointer<Byte> vertexBatch = task + OFFSET(VertexTask,vertexBatch);
+		Pointer<Byte> shaded = vertexBatch + OFFSET(VertexBatch,vertex);
+
+		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
+
+		// The batch argument holds the unique indices, four per iteration
+		UInt uniqueCount = *Pointer<UInt>(task + OFFSET(VertexTask,vertexCount));
+
+		Do
+		{
+			UInt vertexIndex[4];
+			vertexIndex[0] = *Pointer<UInt>(batch + 0);
+			vertexIndex[1] = *Pointer<UInt>(batch + 4);
+			vertexIndex[2] = *Pointer<UInt>(batch + 8);
+			vertexIndex[3] = *Pointer<UInt>(batch + 12);
+
+			readInput(vertexIndex);
+			pipeline(vertexIndex);
+			postTransform();
+			computeClipFlags();
+			writeCache(shaded);
+
+			shaded += 4 * sizeof(Vertex);
+			batch += 4 * sizeof(unsigned int);
+			uniqueCount -= 4;
+		}
+		Until(uniqueCount == 0)
+
+		Pointer<Byte> corner = vertexBatch + OFFSET(VertexBatch,corner);
+		UInt cornerCount = *Pointer<UInt>(vertexBatch + OFFSET(VertexBatch,cornerCount));
+
+		Do
+		{
+			Pointer<Byte> unique = vertexBatch + OFFSET(VertexBatch,vertex) + *Pointer<UInt>(corner) * UInt((int)sizeof(Vertex));
+			writeVertex(vertex, unique);
+
+			vertex += sizeof(Vertex);
+			corner += sizeof(unsigned int);
+			cornerCount--;
+		}
+		Until(cornerCount == 0)
+
+		Return();
+	}
+
+	void VertexRoutine::readInput(UInt index[4])
 	{
 		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
 		{
-			Pointer<Byte> input = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,input) + sizeof(void*) * i);
-			UInt stride = *Pointer<UInt>(data + OFFSET(DrawData,stride) + sizeof(unsigned int) * i);
+			if(state.input[i].instanced)   // Same element for all vertices of the instance
+			{
+				Pointer<Byte> input = *Pointer<Pointer<Byte>>(task + OFFSET(VertexTask,instanceInput) + sizeof(void*) * i);
+				UInt stride = 0;
+
+				v[i] = readStream(input, stride, state.input[i], index);
+			}
+			else
+			{
+				Pointer<Byte> input = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,input) + sizeof(void*) * i);
+				UInt stride = *Pointer<UInt>(data + OFFSET(DrawData,stride) + sizeof(unsigned int) * i);
 
-			v[i] = readStream(input, stride, state.input[i], index);
+				v[i] = readStream(input, stride, state.input[i], index);
+			}
 		}
 	}
 
@@ -137,16 +234,14 @@ namespace sw
 		}
 	}
 
-	Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const UInt &index)
+	Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, UInt index[4])
 	{
-		const bool textureSampling = state.textureSampling;
-
 		Vector4f v;
 
-		Pointer<Byte> source0 = buffer + index * stride;
-		Pointer<Byte> source1 = source0 + (!textureSampling ? stride : 0);
-		Pointer<Byte> source2 = source1 + (!textureSampling ? stride : 0);
-		Pointer<Byte> source3 = source2 + (!textureSampling ? stride : 0);
+		Pointer<Byte> source0 = buffer + index[0] * stride;
+		Pointer<Byte> source1 = buffer + index[1] * stride;
+		Pointer<Byte> source2 = buffer + index[2] * stride;
+		Pointer<Byte> source3 = buffer + index[3] * stride;
 
 		bool isNativeFloatAttrib = (stream.attribType == VertexShader::ATTRIBTYPE_FLOAT) || stream.normalized;
 
@@ -54,12 +54,14 @@ namespace sw
 		const VertexProcessor::State &state;
 
 	private:
-		virtual void pipeline(UInt &index) = 0;
+		virtual void pipeline(UInt index[4]) = 0;
 
 		typedef VertexProcessor::State::Input Stream;
 
-		Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const UInt &index);
-		void readInput(UInt &index);
+		void generateDeduplicated();
+
+		Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, UInt index[4]);
+		void readInput(UInt index[4]);
 		void computeClipFlags();
 		void postTransform();
 		void writeCache(Pointer<Byte> &cacheLine);
@@ -17,12 +17,14 @@
 #include "Renderer/Vertex.hpp"
 #include "Common/Debug.hpp"
 
+#include <algorithm>
 #include <string.h>
 
 namespace sw
 {
 	VertexShader::VertexShader(const VertexShader *vs) : Shader()
 	{
+		shaderType = SHADER_VERTEX;
 		shaderModel = 0x0300;
 		positionRegister = Pos;
 		pointSizeRegister = Unused;
@@ -43,6 +45,7 @@ namespace sw
 				append(new sw::Shader::Instruction(*vs->getInstruction(i)));
 			}
 
+			shaderModel = vs->shaderModel;
 			memcpy(output, vs->output, sizeof(output));
 			memcpy(input, vs->input, sizeof(input));
 			memcpy(attribType, vs->attribType, sizeof(attribType));
@@ -81,6 +84,36 @@ namespace sw
 	{
 	}
 
+	void VertexShader::serialize(std::vector<unsigned int> &words) const
+	{
+		Shader::serialize(words);
+
+		auto semantic = [&](const Semantic &semantic)
+		{
+			words.push_back(semantic.usage | semantic.index << 8 | semantic.centroid << 16 | semantic.flat << 17);
+		};
+
+		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
+		{
+			semantic(input[i]);
+			words.push_back(attribType[i]);
+		}
+
+		for(int i = 0; i < MAX_VERTEX_OUTPUTS; i++)
+		{
+			for(int component = 0; component < 4; component++)
+			{
+				semantic(output[i][component]);
+			}
+		}
+
+		words.push_back(positionRegister);
+		words.push_back(pointSizeRegister);
+		words.push_back(instanceIdDeclared);
+		words.push_back(vertexIdDeclared);
+		words.push_back(textureSampling);
+	}
+
 	int VertexShader::validate(const unsigned long *const token)
 	{
 		if(!token)
@@ -198,6 +231,81 @@ namespace sw
 		return output[outputIdx][component];
 	}
 
+	void VertexShader::removeUnusedOutputs()
+	{
+		// Outputs without a semantic are neither interpolated nor captured. Compute them into
+		// temporaries instead, so the optimizer can eliminate the operations producing them.
+		if(shaderModel < 0x0300 || dynamicallyIndexedOutput || dynamicallyIndexedTemporaries)
+		{
+			return;
+		}
+
+		unsigned int temporaries = 0;
+
+		for(const auto &inst : instruction)
+		{
+			if(inst->dst.type == PARAMETER_TEMP)
+			{
+				temporaries = std::max(temporaries, inst->dst.index + 1);
+			}
+
+			for(int i = 0; i < 5; i++)
+			{
+				if(inst->src[i].type == PARAMETER_TEMP)
+				{
+					temporaries = std::max(temporaries, inst->src[i].index + 4);   // Matrix operands read up to 4 registers
+				}
+			}
+		}
+
+		bool unused[MAX_VERTEX_OUTPUTS];
+		int temporary[MAX_VERTEX_OUTPUTS];
+		bool removed = false;
+
+		for(int i = 0; i < MAX_VERTEX_OUTPUTS; i++)
+		{
+			unused[i] = (i != positionRegister) && (i != pointSizeRegister);
+
+			for(int component = 0; component < 4; component++)
+			{
+				unused[i] = unused[i] && !output[i][component].active();
+			}
+
+			temporary[i] = -1;
+		}
+
+		auto remap = [&](Parameter &parameter)
+		{
+			if(parameter.type == PARAMETER_OUTPUT && parameter.index < MAX_VERTEX_OUTPUTS && unused[parameter.index])
+			{
+				if(temporary[parameter.index] < 0)
+				{
+					temporary[parameter.index] = temporaries++;
+				}
+
+				parameter.type = PARAMETER_TEMP;
+				parameter.index = temporary[parameter.index];
+				removed = true;
+			}
+		};
+
+		for(auto &inst : instruction)
+		{
+			remap(inst->dst);
+
+			for(int i = 0; i < 5; i++)
+			{
+				remap(inst->src[i]);
+			}
+		}
+
+		if(removed)
+		{
+			optimize();
+			analyze();
+		}
+	}
+
 	void VertexShader::analyze()
 	{
 		analyzeInput();
@@ -55,12 +55,16 @@ namespace sw
 		bool isInstanceIdDeclared() const { return instanceIdDeclared; }
 		bool isVertexIdDeclared() const { return vertexIdDeclared; }
 
+		void removeUnusedOutputs();
+
 	private:
 		void analyze();
 		void analyzeInput();
 		void analyzeOutput();
 		void analyzeTextureSampling();
 
+		void serialize(std::vector<unsigned int> &words) const override;
+
 		Semantic input[MAX_VERTEX_INPUTS];
 		Semantic output[MAX_VERTEX_OUTPUTS][4];
 
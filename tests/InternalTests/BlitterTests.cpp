@@ -0,0 +1,370 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Renderer/Blitter.hpp"
+#include "Renderer/Surface.hpp"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace sw;
+
+namespace
+{
+	const Format formats[] =
+	{
+		FORMAT_A8B8G8R8,
+		FORMAT_SRGB8_A8,
+		FORMAT_A32B32G32R32F,
+		FORMAT_A16B16G16R16F,
+	};
+
+	class Random
+	{
+	public:
+		explicit Random(unsigned int seed) : state(seed) {}
+
+		unsigned int next()
+		{
+			state = state * 1103515245 + 12345;
+			return state >> 8;
+		}
+
+	private:
+		unsigned int state;
+	};
+
+	// Components of the internal format, as raw values which compare in the same order as the colors they
+	// represent. Float components stay within [0, 1], where their bit patterns are ordered too.
+	int componentBytes(Format format)
+	{
+		switch(format)
+		{
+		case FORMAT_A32B32G32R32F: return 4;
+		case FORMAT_A16B16G16R16F: return 2;
+		default:                   return 1;
+		}
+	}
+
+	unsigned int randomComponent(Format format, Random &random)
+	{
+		switch(format)
+		{
+		case FORMAT_A32B32G32R32F:
+			{
+				float value = (float)(random.next() & 0xFFFF) / 0xFFFF;
+				unsigned int bits;
+				memcpy(&bits, &value, sizeof(bits));
+				return bits;
+			}
+		case FORMAT_A16B16G16R16F:
+			return random.next() % 0x3C01;   // Half-precision 0.0 to 1.0
+		default:
+			return random.next() & 0xFF;
+		}
+	}
+
+	unsigned int getComponent(const unsigned char *component, int bytes)
+	{
+		unsigned int value = 0;
+		memcpy(&value, component, bytes);
+		return value;
+	}
+
+	void setComponent(unsigned char *component, int bytes, unsigned int value)
+	{
+		memcpy(component, &value, bytes);
+	}
+
+	Surface *createSurface(int width, int height, int depth, Format format)
+	{
+		return Surface::create(nullptr, width, height, depth, 0, 1, format, true, false);
+	}
+
+	// Visits every component of every texel in the internal buffer
+	template<class Visitor>
+	void forEachComponent(Surface *surface, Lock lock, Visitor visit)
+	{
+		Format format = surface->getInternalFormat();
+		int bytes = componentBytes(format);
+		int count = Surface::bytes(format) / bytes;
+		unsigned char *buffer = (unsigned char*)surface->lockInternal(0, 0, 0, lock, PUBLIC);
+
+		for(int z = 0; z < surface->getDepth(); z++)
+		{
+			for(int y = 0; y < surface->getHeight(); y++)
+			{
+				unsigned char *texel = buffer + z * surface->getInternalSliceB() + y * surface->getInternalPitchB();
+
+				for(int x = 0; x < surface->getWidth() * count; x++)
+				{
+					visit(texel + x * bytes, bytes, x / count, y, z);
+				}
+			}
+		}
+
+		surface->unlockInternal();
+	}
+
+	void fillSurface(Surface *surface, unsigned int seed)
+	{
+		Format format = surface->getInternalFormat();
+		Random random(seed);
+
+		forEachComponent(surface, LOCK_WRITEONLY, [&](unsigned char *component, int bytes, int, int, int)
+		{
+			setComponent(component, bytes, randomComponent(format, random));
+		});
+	}
+
+	std::vector<unsigned int> readSurface(Surface *surface)
+	{
+		std::vector<unsigned int> components;
+
+		forEachComponent(surface, LOCK_READONLY, [&](unsigned char *component, int bytes, int, int, int)
+		{
+			components.push_back(getComponent(component, bytes));
+		});
+
+		return components;
+	}
+
+	// Filters each slice on its own, the way mipmaps were generated before the dedicated routine
+	Surface *blitSlices(Blitter &blitter, Surface *source, int width, int height, int depth, int sourceSliceStep, int sourceSliceOffset)
+	{
+		Surface *dest = createSurface(width, height, depth, source->getFormat());
+
+		for(int z = 0; z < depth; z++)
+		{
+			SliceRectF sRect(0.0f, 0.0f, (float)source->getWidth(), (float)source->getHeight(), z * sourceSliceStep + sourceSliceOffset);
+			SliceRect dRect(0, 0, width, height, z);
+
+			blitter.blit(source, sRect, dest, dRect, {true, false, true});
+		}
+
+		return dest;
+	}
+
+	void expectEqual(Surface *expected, Surface *actual, const char *description)
+	{
+		std::vector<unsigned int> reference = readSurface(expected);
+		std::vector<unsigned int> result = readSurface(actual);
+
+		ASSERT_EQ(reference.size(), result.size());
+
+		int mismatches = 0;
+
+		for(size_t i = 0; i < reference.size() && mismatches < 8; i++)
+		{
+			if(reference[i] != result[i])
+			{
+				ADD_FAILURE() << description << " component " << i << ": expected 0x" << std::hex << reference[i] << ", got 0x" << result[i];
+				mismatches++;
+			}
+		}
+	}
+
+	// Downsamples an array of slices, and compares it to the per-slice blits
+	void testLevel(Blitter &blitter, Format format, int width, int height, int slices, int dWidth, int dHeight)
+	{
+		Surface *source = createSurface(width, height, slices, format);
+		Surface *dest = createSurface(dWidth, dHeight, slices, format);
+		fillSurface(source, width * 131 + height * 17 + slices);
+
+		blitter.downsample(&source, &dest, 1, false);
+
+		Surface *reference = blitSlices(blitter, source, dWidth, dHeight, slices, 1, 0);
+
+		std::string description = std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(slices) +
+		                          " format " + std::to_string(format);
+		expectEqual(reference, dest, description.c_str());
+
+		delete reference;
+		delete dest;
+		delete source;
+	}
+
+	// Downsamples every level of a mipmap chain from the previous one
+	void testChain(Blitter &blitter, Format format, int width, int height)
+	{
+		Surface *source = createSurface(width, height, 1, format);
+		fillSurface(source, width + height * 7);
+
+		while(width > 1 || height > 1)
+		{
+			int dWidth = width > 1 ? width / 2 : 1;
+			int dHeight = height > 1 ? height / 2 : 1;
+
+			Surface *dest = createSurface(dWidth, dHeight, 1, format);
+			blitter.downsample(&source, &dest, 1, false);
+
+			Surface *reference = blitSlices(blitter, source, dWidth, dHeight, 1, 1, 0);
+
+			std::string description = std::to_string(width) + "x" + std::to_string(height) + " to " +
+			                          std::to_string(dWidth) + "x" + std::to_string(dHeight) + " format " + std::to_string(format);
+			expectEqual(reference, dest, description.c_str());
+
+			delete reference;
+			delete source;
+
+			source = dest;
+			width = dWidth;
+			height = dHeight;
+		}
+
+		delete source;
+	}
+}
+
+TEST(BlitterTest, DownsamplePowerOfTwo)
+{
+	Blitter blitter;
+
+	for(Format format : formats)
+	{
+		testLevel(blitter, format, 16, 8, 1, 8, 4);
+		testLevel(blitter, format, 8, 32, 1, 4, 16);
+	}
+}
+
+// Dimensions which aren't halved exactly fall back to the regular filtered blit routine
+TEST(BlitterTest, DownsampleNonPowerOfTwo)
+{
+	Blitter blitter;
+
+	for(Format format : formats)
+	{
+		testLevel(blitter, format, 13, 7, 1, 6, 3);
+		testLevel(blitter, format, 16, 5, 1, 8, 2);
+		testLevel(blitter, format, 3, 1, 1, 1, 1);
+	}
+}
+
+TEST(BlitterTest, DownsampleChains)
+{
+	Blitter blitter;
+
+	for(Format format : formats)
+	{
+		testChain(blitter, format, 1, 32);
+		testChain(blitter, format, 32, 1);
+		testChain(blitter, format, 16, 4);
+		testChain(blitter, format, 12, 10);
+	}
+}
+
+TEST(BlitterTest, DownsampleArray)
+{
+	Blitter blitter;
+
+	for(Format format : formats)
+	{
+		testLevel(blitter, format, 16, 16, 3, 8, 8);
+		testLevel(blitter, format, 10, 6, 3, 5, 3);
+	}
+}
+
+// Cube faces are separate surfaces, downsampled in a single call
+TEST(BlitterTest, DownsampleMultipleSurfaces)
+{
+	Blitter blitter;
+	Surface *sources[6];
+	Surface *dests[6];
+
+	for(int face = 0; face < 6; face++)
+	{
+		sources[face] = createSurface(16, 16, 1, FORMAT_SRGB8_A8);
+		dests[face] = createSurface(8, 8, 1, FORMAT_SRGB8_A8);
+		fillSurface(sources[face], face);
+	}
+
+	blitter.downsample(sources, dests, 6, false);
+
+	for(int face = 0; face < 6; face++)
+	{
+		Surface *reference = blitSlices(blitter, sources[face], 8, 8, 1, 1, 0);
+		expectEqual(reference, dests[face], ("face " + std::to_string(face)).c_str());
+
+		delete reference;
+		delete dests[face];
+		delete sources[face];
+	}
+}
+
+// Volumes average pairs of slices, each filtered like a 2D level, and round the result once
+TEST(BlitterTest, DownsampleVolume)
+{
+	Blitter blitter;
+
+	for(Format format : {FORMAT_A8B8G8R8, FORMAT_A32B32G32R32F})
+	{
+		Surface *source = createSurface(8, 4, 6, format);
+		Surface *dest = createSurface(4, 2, 3, format);
+		fillSurface(source, 3);
+
+		blitter.downsample(&source, &dest, 1, true);
+
+		Surface *even = blitSlices(blitter, source, 4, 2, 3, 2, 0);
+		Surface *odd = blitSlices(blitter, source, 4, 2, 3, 2, 1);
+
+		std::vector<unsigned int> evenSlices = readSurface(even);
+		std::vector<unsigned int> oddSlices = readSurface(odd);
+		std::vector<unsigned int> result = readSurface(dest);
+
+		ASSERT_EQ(evenSlices.size(), result.size());
+
+		for(size_t i = 0; i < result.size(); i++)
+		{
+			if(format == FORMAT_A32B32G32R32F)
+			{
+				float e, o, r;
+				memcpy(&e, &evenSlices[i], sizeof(float));
+				memcpy(&o, &oddSlices[i], sizeof(float));
+				memcpy(&r, &result[i], sizeof(float));
+
+				EXPECT_EQ(e * 0.5f + o * 0.5f, r) << "component " << i;
+			}
+			else
+			{
+				// The per-slice blits each rounded to 8-bit
+				int average = (int)(evenSlices[i] + oddSlices[i]);
+				EXPECT_LE(abs(2 * (int)result[i] - average), 2) << "component " << i;
+			}
+		}
+
+		delete odd;
+		delete even;
+		delete dest;
+		delete source;
+	}
+}
+
+// Large levels get split into row bands, which are processed by the worker pool
+TEST(BlitterTest, DownsampleBands)
+{
+	Blitter blitter;
+	blitter.setThreadCount(4);
+
+	for(Format format : {FORMAT_A8B8G8R8, FORMAT_A16B16G16R16F})
+	{
+		testLevel(blitter, format, 512, 512, 1, 256, 256);
+		testLevel(blitter, format, 256, 512, 3, 128, 256);
+		testLevel(blitter, format, 300, 500, 1, 150, 250);
+		testLevel(blitter, format, 301, 501, 1, 150, 250);
+	}
+}
@@ -0,0 +1,544 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Renderer/HierarchicalZ.hpp"
+#include "Renderer/Polygon.hpp"
+#include "Renderer/Primitive.hpp"
+#include "Renderer/Renderer.hpp"
+#include "Renderer/Surface.hpp"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <memory>
+
+namespace sw
+{
+	extern bool hierarchicalZCulling;
+	extern bool complementaryDepthBuffer;
+}
+
+using namespace sw;
+
+namespace
+{
+	const int width = 36;    // Partial last column of tiles
+	const int height = 28;   // Partial last row of tiles
+	const int tile = HierarchicalZ::TILE_SIZE;
+
+	const float lessMargin = 1.0f / (1 << 20);       // Interpolation error
+	const float lessEqualMargin = 1.0f / (1 << 15);   // 16-bit depth quantization
+}
+
+class HierarchicalZTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		hierarchicalZ.reset(new HierarchicalZ(width, height));
+		data.reset(new DrawData());
+		setScissor(0, width);
+
+		data->Wx16 = replicate(16.0f);   // Reprojected vertices are in pixels
+		data->Hx16 = replicate(16.0f);
+		data->X0x16 = replicate(0.0f);
+		data->Y0x16 = replicate(0.0f);
+	}
+
+	void TearDown() override
+	{
+		hierarchicalZCulling = true;
+		complementaryDepthBuffer = false;
+	}
+
+	void setScissor(int x0, int x1)
+	{
+		data->scissorX0 = x0;
+		data->scissorX1 = x1;
+	}
+
+	HierarchicalZ::Test draw(bool lessEqual = false, bool update = false)
+	{
+		HierarchicalZ::Test test;
+		test.serial = HierarchicalZ::newSerial();
+		test.lessEqual = lessEqual;
+		test.update = update;
+
+		return test;
+	}
+
+	// Culls a triangle with vertices in pixels, and depth z + dzdx * x + dzdy * y
+	bool cull(const HierarchicalZ::Test &test, float x0, float y0, float x1, float y1, float x2, float y2,
+	          float z, float dzdx = 0.0f, float dzdy = 0.0f, Primitive *result = nullptr)
+	{
+		Triangle triangle;
+		triangle.v0.X = (int)(x0 * 16);
+		triangle.v0.Y = (int)(y0 * 16);
+		triangle.v1.X = (int)(x1 * 16);
+		triangle.v1.Y = (int)(y1 * 16);
+		triangle.v2.X = (int)(x2 * 16);
+		triangle.v2.Y = (int)(y2 * 16);
+
+		float4 P[3] = {};
+		Polygon polygon(&P[0], &P[1], &P[2]);
+
+		Primitive primitive = plane(rows(min(min(y0, y1), y2)), rows(max(max(y0, y1), y2)) + 1, z, dzdx, dzdy);
+		bool culled = hierarchicalZ->cull(primitive, triangle, polygon, *data, test);
+
+		if(result)
+		{
+			*result = primitive;
+		}
+
+		return culled;
+	}
+
+	// Culls a polygon produced by clipping, which gets reprojected from its homogeneous vertices
+	bool cullClipped(const HierarchicalZ::Test &test, const float (*vertices)[2], int n, float z)
+	{
+		Triangle triangle = {};   // Unused for clipped polygons
+		float4 P[16];
+		float yMin = vertices[0][1];
+		float yMax = vertices[0][1];
+
+		for(int i = 0; i < n; i++)
+		{
+			const float w = 2.0f;
+			P[i] = {vertices[i][0] * w, vertices[i][1] * w, z * w, w};
+			yMin = min(yMin, vertices[i][1]);
+			yMax = max(yMax, vertices[i][1]);
+		}
+
+		Polygon polygon(P, n);
+
+		for(int i = 0; i < n; i++)
+		{
+			polygon.P[1][i] = &P[i];
+		}
+
+		polygon.i = 1;
+
+		Primitive primitive = plane(rows(yMin), rows(yMax) + 1, z, 0.0f, 0.0f);
+
+		return hierarchicalZ->cull(primitive, triangle, polygon, *data, test);
+	}
+
+	// Whether a constant depth primitive covering the entire tile, and only that tile, gets culled
+	bool occludes(int tx, int ty, float z, const HierarchicalZ::Test &test)
+	{
+		int x0 = tx * tile;
+		int y0 = ty * tile;
+		int x1 = min(x0 + tile, width);
+		int y1 = min(y0 + tile, height);
+
+		Triangle triangle;
+		triangle.v0.X = (x0 - 1) * 16;
+		triangle.v0.Y = (y0 - 1) * 16;
+		triangle.v1.X = (x1 + 2 * tile) * 16;
+		triangle.v1.Y = (y0 - 1) * 16;
+		triangle.v2.X = (x0 - 1) * 16;
+		triangle.v2.Y = (y1 + 2 * tile) * 16;
+
+		float4 P[3] = {};
+		Polygon polygon(&P[0], &P[1], &P[2]);
+		Primitive primitive = plane(y0, y1, z, 0.0f, 0.0f);
+
+		int scissorX0 = data->scissorX0;
+		int scissorX1 = data->scissorX1;
+		setScissor(x0, x1);
+
+		bool culled = hierarchicalZ->cull(primitive, triangle, polygon, *data, test);
+
+		setScissor(scissorX0, scissorX1);
+
+		return culled;
+	}
+
+	bool occludes(int tx, int ty, float z, bool lessEqual = false)
+	{
+		return occludes(tx, ty, z, draw(lessEqual));
+	}
+
+	// Draws a right triangle with legs of the given length along the axes, from the corner at (x, y)
+	bool cullCorner(const HierarchicalZ::Test &test, float x, float y, float length, float z)
+	{
+		return cull(test, x, y, x + length, y, x, y + length, z);
+	}
+
+	std::unique_ptr<HierarchicalZ> hierarchicalZ;
+	std::unique_ptr<DrawData> data;
+
+private:
+	static int rows(float y)
+	{
+		return (int)ceilf(y);
+	}
+
+	Primitive plane(int yMin, int yMax, float z, float dzdx, float dzdy)
+	{
+		Primitive primitive = {};
+		primitive.yMin = max(yMin, 0);
+		primitive.yMax = min(yMax, height);
+		primitive.xQuad = replicate(0.0f);
+		primitive.yQuad = replicate(0.0f);
+		primitive.z.A = replicate(dzdx);
+		primitive.z.B = replicate(dzdy);
+		primitive.z.C = replicate(z);
+
+		return primitive;
+	}
+};
+
+TEST_F(HierarchicalZTest, InvalidUntilCleared)
+{
+	HierarchicalZ::Test test;
+
+	EXPECT_FALSE(hierarchicalZ->isValid());
+	EXPECT_FALSE(hierarchicalZ->beginDraw(test, DEPTH_LESS, true, true, true));
+
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	EXPECT_TRUE(hierarchicalZ->isValid());
+	EXPECT_TRUE(hierarchicalZ->beginDraw(test, DEPTH_LESS, true, true, true));
+}
+
+TEST_F(HierarchicalZTest, ExactClearValue)
+{
+	hierarchicalZ->clear(0.5f, 0, 0, width, height, true);
+
+	for(int ty = 0; ty * tile < height; ty++)
+	{
+		for(int tx = 0; tx * tile < width; tx++)
+		{
+			EXPECT_FALSE(occludes(tx, ty, 0.5f)) << tx << "," << ty;
+			EXPECT_TRUE(occludes(tx, ty, 0.5f + 2 * lessMargin)) << tx << "," << ty;
+		}
+	}
+}
+
+TEST_F(HierarchicalZTest, PartialClears)
+{
+	hierarchicalZ->clear(0.25f, 0, 0, width, height, true);
+
+	// Tiles partially covered by a clear to a greater depth take the greater one
+	hierarchicalZ->clear(0.75f, 4, 4, 12, 12, true);
+
+	EXPECT_FALSE(occludes(0, 0, 0.5f));
+	EXPECT_FALSE(occludes(1, 1, 0.5f));
+	EXPECT_TRUE(occludes(2, 2, 0.5f));
+	EXPECT_TRUE(occludes(2, 0, 0.5f));
+
+	// Tiles partially covered by a clear to a lower depth keep their value
+	hierarchicalZ->clear(0.125f, 0, 0, 12, 12, true);
+
+	EXPECT_TRUE(occludes(0, 0, 0.25f));   // Entirely cleared
+	EXPECT_FALSE(occludes(1, 1, 0.5f));
+	EXPECT_TRUE(occludes(1, 1, 0.75f + 2 * lessMargin));
+
+	// Tiles at the right and bottom edges are covered entirely by clears to the edge
+	hierarchicalZ->clear(0.125f, 32, 24, width, height, true);
+
+	EXPECT_TRUE(occludes(4, 3, 0.25f));
+	EXPECT_FALSE(occludes(3, 3, 0.25f));
+}
+
+TEST_F(HierarchicalZTest, ScissoredClearKeepsValidity)
+{
+	hierarchicalZ->clear(1.0f, 8, 8, 16, 16, false);   // Scissored clears of an invalid buffer don't validate it
+	EXPECT_FALSE(hierarchicalZ->isValid());
+
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+	hierarchicalZ->clear(0.25f, 8, 8, 16, 16, hierarchicalZ->isValid());
+
+	EXPECT_TRUE(hierarchicalZ->isValid());
+	EXPECT_TRUE(occludes(1, 1, 0.5f));
+	EXPECT_FALSE(occludes(0, 0, 0.5f));
+	EXPECT_FALSE(occludes(2, 1, 0.5f));
+}
+
+TEST_F(HierarchicalZTest, LessEqualMargin)
+{
+	hierarchicalZ->clear(0.5f, 0, 0, width, height, true);
+
+	float z = 0.5f + 2 * lessMargin;
+
+	EXPECT_TRUE(occludes(1, 1, z, false));
+	EXPECT_FALSE(occludes(1, 1, z, true));   // Could be equal after 16-bit quantization
+	EXPECT_FALSE(occludes(1, 1, 0.5f + lessEqualMargin / 2, true));
+	EXPECT_TRUE(occludes(1, 1, 0.5f + 2 * lessEqualMargin, true));
+}
+
+TEST_F(HierarchicalZTest, SlopedDepthUsesTileMinimum)
+{
+	hierarchicalZ->clear(0.5f, 0, 0, width, height, true);
+	setScissor(8, 16);
+
+	// Increasing depth only reaches the tiles' value at their left column
+	float z = 0.5f - 0.0125f * 8;
+	EXPECT_FALSE(cull(draw(), 0, 0, 64, 0, 0, 64, z, 0.0125f, 0.0f));
+	EXPECT_TRUE(cull(draw(), 0, 0, 64, 0, 0, 64, z + 0.0125f, 0.0125f, 0.0f));
+
+	// Decreasing depth only reaches it at their right column
+	z = 0.5f + 0.0125f * 15;
+	EXPECT_FALSE(cull(draw(), 0, 0, 64, 0, 0, 64, z, -0.0125f, 0.0f));
+	EXPECT_TRUE(cull(draw(), 0, 0, 64, 0, 0, 64, z + 0.0125f, -0.0125f, 0.0f));
+
+	// Depth clamping keeps values above 1 at 1, which still gets culled
+	EXPECT_TRUE(cullCorner(draw(), 0, 0, 64, 1.5f));
+}
+
+TEST_F(HierarchicalZTest, OccludedRowsAreTrimmed)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+	hierarchicalZ->clear(0.25f, 0, 0, width, 16, true);
+
+	Primitive primitive;
+	EXPECT_FALSE(cull(draw(), 0, 0, 64, 0, 0, 64, 0.5f, 0.0f, 0.0f, &primitive));
+	EXPECT_EQ(16, primitive.yMin);
+	EXPECT_EQ(height, primitive.yMax);
+
+	EXPECT_TRUE(cullCorner(draw(), 0, 0, 15, 0.5f));
+}
+
+TEST_F(HierarchicalZTest, CoveredTilesAreLowered)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	// Covers the pixels with (x - 6.5) + (y - 7.5) < 40, right of 6.5 and below 7.5
+	cullCorner(draw(false, true), 6.5f, 7.5f, 40.0f, 0.25f);
+
+	const bool lowered[4][5] =
+	{
+		{false, false, false, false, false},
+		{false, true,  true,  true,  false},   // The last column is only partially inside the render target
+		{false, true,  true,  false, false},   // The bottom right pixel of (3,2) is on the edge
+		{false, false, false, false, false},   // Partially inside the render target
+	};
+
+	for(int ty = 0; ty < 4; ty++)
+	{
+		for(int tx = 0; tx < 5; tx++)
+		{
+			EXPECT_EQ(lowered[ty][tx], occludes(tx, ty, 0.5f)) << tx << "," << ty;
+		}
+	}
+
+	// Tiles get lowered to just above the primitive's maximum depth over the tile
+	EXPECT_FALSE(occludes(1, 1, 0.25f));
+	EXPECT_TRUE(occludes(1, 1, 0.25f + 4 * lessMargin));
+}
+
+TEST_F(HierarchicalZTest, PartialCoverageDoesNotLower)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	// The hypotenuse passes exactly through the bottom right pixel of tile (1,1)
+	cullCorner(draw(false, true), 7.5f, 7.5f, 15.0f, 0.25f);
+	EXPECT_FALSE(occludes(1, 1, 0.5f));
+
+	cullCorner(draw(false, true), 7.5f, 7.5f, 15.0f + 1.0f / 16, 0.25f);
+	EXPECT_TRUE(occludes(1, 1, 0.5f));
+
+	// A vertex inside the tile
+	cullCorner(draw(false, true), 17.0f, 8.0f - 1.0f / 16, 40.0f, 0.25f);
+	EXPECT_FALSE(occludes(2, 1, 0.5f));
+	EXPECT_TRUE(occludes(3, 1, 0.5f));
+}
+
+TEST_F(HierarchicalZTest, OnlyDepthWritesLower)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	cullCorner(draw(false, false), -1, -1, 100, 0.25f);
+	EXPECT_FALSE(occludes(1, 1, 0.5f));
+
+	cullCorner(draw(false, true), -1, -1, 100, 0.25f);
+	EXPECT_TRUE(occludes(1, 1, 0.5f));
+}
+
+TEST_F(HierarchicalZTest, ScissorEdgeIsNotCrossed)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	// The scissor rectangle splits the second and fourth column of tiles
+	setScissor(12, 28);
+	cullCorner(draw(false, true), -1, -1, 100, 0.25f);
+	setScissor(0, width);
+
+	for(int ty = 0; ty < 3; ty++)
+	{
+		EXPECT_FALSE(occludes(0, ty, 0.5f)) << ty;
+		EXPECT_FALSE(occludes(1, ty, 0.5f)) << ty;
+		EXPECT_TRUE(occludes(2, ty, 0.5f)) << ty;
+		EXPECT_FALSE(occludes(3, ty, 0.5f)) << ty;
+		EXPECT_FALSE(occludes(4, ty, 0.5f)) << ty;
+	}
+}
+
+TEST_F(HierarchicalZTest, OnlyEarlierDrawsOcclude)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	HierarchicalZ::Test earlier = draw();
+	HierarchicalZ::Test lowering = draw(false, true);
+
+	cullCorner(lowering, -1, -1, 100, 0.25f);
+
+	HierarchicalZ::Test later = draw();
+
+	// Primitives of the same draw call, or of ones issued before it, may get rasterized before the ones which lowered the tiles
+	EXPECT_FALSE(occludes(1, 1, 0.5f, lowering));
+	EXPECT_FALSE(occludes(1, 1, 0.5f, earlier));
+	EXPECT_TRUE(occludes(1, 1, 0.5f, later));
+
+	// Clears wait for all draw calls to finish, so every draw call can use the cleared tiles
+	hierarchicalZ->clear(0.125f, 0, 0, width, height, true);
+
+	EXPECT_TRUE(occludes(1, 1, 0.5f, lowering));
+	EXPECT_TRUE(occludes(1, 1, 0.5f, earlier));
+}
+
+TEST_F(HierarchicalZTest, ClippedPolygonsAreReprojected)
+{
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	// The right edge is one sixteenth of a pixel past the last column of tile (1,1). The exact vertices
+	// cover that column, but reprojection may round differently, so a clipped polygon doesn't.
+	const float right = 15.0f + 1.0f / 16;
+	const float triangle[3][2] = {{right, -100.0f}, {right, 100.0f}, {-100.0f, 0.0f}};
+
+	cullClipped(draw(false, true), triangle, 3, 0.25f);
+	EXPECT_TRUE(occludes(0, 1, 0.5f));
+	EXPECT_FALSE(occludes(1, 1, 0.5f));
+
+	cull(draw(false, true), triangle[0][0], triangle[0][1], triangle[1][0], triangle[1][1], triangle[2][0], triangle[2][1], 0.25f);
+	EXPECT_TRUE(occludes(1, 1, 0.5f));
+
+	// Clipped polygons with more vertices
+	const float pentagon[5][2] = {{-4.0f, -4.0f}, {20.0f, -4.0f}, {26.0f, 8.0f}, {20.0f, 20.0f}, {-4.0f, 20.0f}};
+
+	cullClipped(draw(false, true), pentagon, 5, 0.125f);
+	EXPECT_TRUE(occludes(0, 0, 0.25f));
+	EXPECT_TRUE(occludes(1, 0, 0.25f));
+	EXPECT_FALSE(occludes(2, 0, 0.25f));
+	EXPECT_FALSE(occludes(2, 1, 0.25f));
+
+	// Occluded clipped polygons get culled
+	const float square[4][2] = {{8.5f, 8.5f}, {14.5f, 8.5f}, {14.5f, 14.5f}, {8.5f, 14.5f}};
+
+	EXPECT_TRUE(cullClipped(draw(), square, 4, 0.75f));
+	EXPECT_FALSE(cullClipped(draw(), square, 4, 0.125f));
+}
+
+TEST_F(HierarchicalZTest, DepthRaisingDrawsInvalidate)
+{
+	const DepthCompareMode raising[] = {DEPTH_GREATER, DEPTH_GREATEREQUAL, DEPTH_ALWAYS, DEPTH_NOTEQUAL};
+
+	for(DepthCompareMode mode : raising)
+	{
+		HierarchicalZ::Test test;
+		hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+		EXPECT_FALSE(hierarchicalZ->beginDraw(test, mode, false, true, true)) << mode;
+		EXPECT_TRUE(hierarchicalZ->isValid()) << mode;
+
+		EXPECT_FALSE(hierarchicalZ->beginDraw(test, mode, true, true, true)) << mode;
+		EXPECT_FALSE(hierarchicalZ->isValid()) << mode;
+	}
+
+	const DepthCompareMode decreasing[] = {DEPTH_LESS, DEPTH_LESSEQUAL, DEPTH_EQUAL, DEPTH_NEVER};
+
+	for(DepthCompareMode mode : decreasing)
+	{
+		HierarchicalZ::Test test;
+		hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+		hierarchicalZ->beginDraw(test, mode, true, true, true);
+		EXPECT_TRUE(hierarchicalZ->isValid()) << mode;
+
+		// Reversed depth raises the stored values
+		complementaryDepthBuffer = true;
+		EXPECT_FALSE(hierarchicalZ->beginDraw(test, mode, true, true, true)) << mode;
+		EXPECT_FALSE(hierarchicalZ->isValid()) << mode;
+		complementaryDepthBuffer = false;
+	}
+}
+
+TEST_F(HierarchicalZTest, BeginDraw)
+{
+	HierarchicalZ::Test test;
+	hierarchicalZ->clear(1.0f, 0, 0, width, height, true);
+
+	EXPECT_TRUE(hierarchicalZ->beginDraw(test, DEPTH_LESSEQUAL, true, true, true));
+	EXPECT_TRUE(test.lessEqual);
+	EXPECT_TRUE(test.update);
+
+	unsigned int serial = test.serial;
+
+	EXPECT_TRUE(hierarchicalZ->beginDraw(test, DEPTH_LESS, true, true, false));
+	EXPECT_FALSE(test.lessEqual);
+	EXPECT_FALSE(test.update);   // Alpha test or discard
+	EXPECT_GT((int)(test.serial - serial), 0);
+
+	EXPECT_TRUE(hierarchicalZ->beginDraw(test, DEPTH_LESS, false, true, true));
+	EXPECT_FALSE(test.update);
+
+	EXPECT_FALSE(hierarchicalZ->beginDraw(test, DEPTH_LESS, true, false, true));
+	EXPECT_FALSE(hierarchicalZ->beginDraw(test, DEPTH_EQUAL, false, true, true));
+
+	hierarchicalZCulling = false;
+	EXPECT_FALSE(hierarchicalZ->beginDraw(test, DEPTH_LESS, true, true, true));
+	EXPECT_TRUE(hierarchicalZ->isValid());
+
+	EXPECT_FALSE(hierarchicalZ->beginDraw(test, DEPTH_GREATER, true, true, true));
+	EXPECT_FALSE(hierarchicalZ->isValid());   // Also kept up to date when culling is disabled
+}
+
+TEST_F(HierarchicalZTest, SurfaceLocks)
+{
+	Surface *surface = Surface::create(nullptr, width, height, 1, 0, 1, FORMAT_D32F_LOCKABLE, true, false);
+	HierarchicalZ *depthTiles = surface->getHierarchicalZ();
+	ASSERT_NE(depthTiles, nullptr);
+
+	EXPECT_FALSE(depthTiles->isValid());
+
+	surface->clearDepth(1.0f, 0, 0, width, height);
+	EXPECT_TRUE(depthTiles->isValid());
+
+	// Scissored clears keep it valid
+	surface->clearDepth(0.5f, 4, 4, 8, 8);
+	EXPECT_TRUE(depthTiles->isValid());
+
+	// The renderer keeps it up to date itself
+	surface->lockInternal(0, 0, 0, LOCK_READWRITE, MANAGED);
+	surface->unlockInternal();
+	EXPECT_TRUE(depthTiles->isValid());
+
+	surface->lockInternal(0, 0, 0, LOCK_READONLY, PUBLIC);
+	surface->unlockInternal();
+	EXPECT_TRUE(depthTiles->isValid());
+
+	surface->lockInternal(0, 0, 0, LOCK_WRITEONLY, PUBLIC);
+	surface->unlockInternal();
+	EXPECT_FALSE(depthTiles->isValid());
+
+	surface->clearDepth(1.0f, 0, 0, width, height);
+	EXPECT_TRUE(depthTiles->isValid());
+
+	surface->lockExternal(0, 0, 0, LOCK_READWRITE, PUBLIC);
+	surface->unlockExternal();
+	EXPECT_FALSE(depthTiles->isValid());
+
+	delete surface;
+}
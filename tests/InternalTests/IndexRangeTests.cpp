@@ -0,0 +1,219 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "OpenGL/libGLESv2/IndexRange.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using es2::computeRange;
+
+namespace
+{
+	const int maxOffset = 16;   // Elements, so every misalignment of a 16 byte vector is covered
+
+	struct Range
+	{
+		GLuint minIndex;
+		GLuint maxIndex;
+		std::vector<GLsizei> restartIndices;
+	};
+
+	template<class IndexType>
+	Range referenceRange(const IndexType *indices, GLsizei count, bool primitiveRestart)
+	{
+		Range range = {0xFFFFFFFF, 0};
+
+		for(GLsizei i = 0; i < count; i++)
+		{
+			if(primitiveRestart && indices[i] == IndexType(-1))
+			{
+				range.restartIndices.push_back(i);
+			}
+			else
+			{
+				range.minIndex = std::min(range.minIndex, (GLuint)indices[i]);
+				range.maxIndex = std::max(range.maxIndex, (GLuint)indices[i]);
+			}
+		}
+
+		return range;
+	}
+
+	template<class IndexType>
+	Range scanRange(const IndexType *indices, GLsizei count, bool primitiveRestart)
+	{
+		Range range = {0xFFFFFFFF, 0};
+		computeRange(indices, count, &range.minIndex, &range.maxIndex, primitiveRestart ? &range.restartIndices : nullptr);
+
+		return range;
+	}
+
+	// Compares the vectorized and the scalar scans to a plain loop, with and without primitive restart
+	template<class IndexType>
+	void compareScans(const IndexType *indices, GLsizei count)
+	{
+		for(bool primitiveRestart : {false, true})
+		{
+			Range expected = referenceRange(indices, count, primitiveRestart);
+
+			for(bool sse2 : {true, false})
+			{
+				sw::CPUID::setEnableSSE2(sse2);
+				Range actual = scanRange(indices, count, primitiveRestart);
+				sw::CPUID::setEnableSSE2(true);
+
+				EXPECT_EQ(expected.minIndex, actual.minIndex) << "count " << count << (sse2 ? " SSE2" : "") << (primitiveRestart ? " restart" : "");
+				EXPECT_EQ(expected.maxIndex, actual.maxIndex) << "count " << count << (sse2 ? " SSE2" : "") << (primitiveRestart ? " restart" : "");
+				EXPECT_EQ(expected.restartIndices, actual.restartIndices) << "count " << count;
+			}
+		}
+	}
+
+	template<class IndexType>
+	std::vector<IndexType> randomIndices(int count, unsigned int seed)
+	{
+		std::vector<IndexType> indices(count);
+
+		for(IndexType &index : indices)
+		{
+			seed = seed * 1103515245 + 12345;
+			index = (IndexType)(((seed >> 8) * 0x9E3779B9u) ^ seed);
+		}
+
+		return indices;
+	}
+
+	// Every count up to a few vectors, starting at every offset from a vector boundary
+	template<class IndexType>
+	void testCountsAndOffsets()
+	{
+		const int width = 16 / sizeof(IndexType);
+		std::vector<IndexType> indices = randomIndices<IndexType>(maxOffset + 4 * width + 1, 1);
+
+		for(int offset = 0; offset < maxOffset; offset++)
+		{
+			for(int count = 0; count <= 4 * width + 1; count++)
+			{
+				compareScans(&indices[offset], count);
+			}
+		}
+	}
+
+	// The extremes in each lane of the vectors and in the scalar remainder
+	template<class IndexType>
+	void testExtremePositions()
+	{
+		const int width = 16 / sizeof(IndexType);
+		const int count = 3 * width + width / 2;
+		const IndexType middle = IndexType(-1) / 2;
+
+		for(int offset = 0; offset < 4; offset++)
+		{
+			for(int position = 0; position < count; position++)
+			{
+				std::vector<IndexType> indices(offset + count, middle);
+
+				indices[offset + position] = 1;
+				compareScans(&indices[offset], count);
+
+				indices[offset + position] = IndexType(-2);
+				compareScans(&indices[offset], count);
+
+				indices[offset + (position + 1) % count] = 1;
+				compareScans(&indices[offset], count);
+			}
+		}
+	}
+
+	// Values next to the primitive restart index, and at the bias which makes wider indices signed
+	template<class IndexType>
+	void testSpecialValues()
+	{
+		const int width = 16 / sizeof(IndexType);
+		const IndexType signBit = IndexType(1) << (8 * sizeof(IndexType) - 1);
+		const IndexType values[] = {0, 1, IndexType(signBit - 1), signBit, IndexType(signBit + 1), IndexType(-2), IndexType(-1)};
+		const int valueCount = sizeof(values) / sizeof(values[0]);
+
+		for(int first = 0; first < valueCount; first++)
+		{
+			for(int second = first; second < valueCount; second++)
+			{
+				for(int count : {width, 2 * width + 1, 4 * width - 1})
+				{
+					std::vector<IndexType> indices(count + 1);
+
+					for(int i = 0; i < count + 1; i++)
+					{
+						indices[i] = (i % 3 == 0) ? values[second] : values[first];
+					}
+
+					compareScans(&indices[0], count);
+					compareScans(&indices[1], count);
+				}
+			}
+		}
+
+		// Only restart indices, which leave the range empty when primitive restart is enabled
+		std::vector<IndexType> restarts(3 * width + 1, IndexType(-1));
+		compareScans(&restarts[0], (GLsizei)restarts.size());
+		compareScans(&restarts[1], (GLsizei)restarts.size() - 1);
+	}
+}
+
+TEST(IndexRangeTest, UnsignedByteCountsAndOffsets)
+{
+	testCountsAndOffsets<GLubyte>();
+}
+
+TEST(IndexRangeTest, UnsignedShortCountsAndOffsets)
+{
+	testCountsAndOffsets<GLushort>();
+}
+
+TEST(IndexRangeTest, UnsignedIntCountsAndOffsets)
+{
+	testCountsAndOffsets<GLuint>();
+}
+
+TEST(IndexRangeTest, UnsignedByteExtremePositions)
+{
+	testExtremePositions<GLubyte>();
+}
+
+TEST(IndexRangeTest, UnsignedShortExtremePositions)
+{
+	testExtremePositions<GLushort>();
+}
+
+TEST(IndexRangeTest, UnsignedIntExtremePositions)
+{
+	testExtremePositions<GLuint>();
+}
+
+TEST(IndexRangeTest, UnsignedByteSpecialValues)
+{
+	testSpecialValues<GLubyte>();
+}
+
+TEST(IndexRangeTest, UnsignedShortSpecialValues)
+{
+	testSpecialValues<GLushort>();
+}
+
+TEST(IndexRangeTest, UnsignedIntSpecialValues)
+{
+	testSpecialValues<GLuint>();
+}
@@ -0,0 +1,243 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Renderer/LRUCache.hpp"
+
+#include "gtest/gtest.h"
+
+namespace
+{
+	struct Key
+	{
+		Key() : Key(0, 0) {}
+		Key(int value, unsigned int hash) : value(value), hash(hash) {}
+		explicit Key(int value) : Key(value, value) {}
+
+		bool operator==(const Key &key) const
+		{
+			return value == key.value;
+		}
+
+		int value;
+		unsigned int hash;
+	};
+
+	struct Data
+	{
+		void bind() { references++; }
+		void unbind() { references--; }
+
+		int references = 0;
+	};
+
+	using Cache = sw::LRUCache<Key, Data>;
+}
+
+TEST(LRUCacheTests, SizeIsRoundedUpToPowerOfTwo)
+{
+	Cache cache(5);
+
+	EXPECT_EQ(8, cache.getSize());
+}
+
+TEST(LRUCacheTests, QueryFindsAddedEntries)
+{
+	Cache cache(4);
+	Data a, b;
+
+	EXPECT_EQ(nullptr, cache.query(Key(1)));
+
+	EXPECT_EQ(&a, cache.add(Key(1), &a));
+	cache.add(Key(2), &b);
+
+	EXPECT_EQ(&a, cache.query(Key(1)));
+	EXPECT_EQ(&b, cache.query(Key(2)));
+	EXPECT_EQ(nullptr, cache.query(Key(3)));
+}
+
+TEST(LRUCacheTests, EvictsLeastRecentlyAdded)
+{
+	Cache cache(4);
+	Data data[5];
+
+	for(int i = 0; i < 5; i++)
+	{
+		cache.add(Key(i), &data[i]);
+	}
+
+	EXPECT_EQ(nullptr, cache.query(Key(0)));
+	EXPECT_EQ(0, data[0].references);
+
+	for(int i = 1; i < 5; i++)
+	{
+		EXPECT_EQ(&data[i], cache.query(Key(i)));
+		EXPECT_EQ(1, data[i].references);
+	}
+}
+
+TEST(LRUCacheTests, QueryMakesEntryMostRecentlyUsed)
+{
+	Cache cache(4);
+	Data data[6];
+
+	for(int i = 0; i < 4; i++)
+	{
+		cache.add(Key(i), &data[i]);
+	}
+
+	// Order from least recently used: 1, 2, 0, 3
+	cache.query(Key(0));
+	cache.query(Key(3));
+
+	cache.add(Key(4), &data[4]);
+	EXPECT_EQ(nullptr, cache.query(Key(1)));
+
+	cache.add(Key(5), &data[5]);
+	EXPECT_EQ(nullptr, cache.query(Key(2)));
+
+	EXPECT_EQ(&data[0], cache.query(Key(0)));
+	EXPECT_EQ(&data[3], cache.query(Key(3)));
+	EXPECT_EQ(&data[4], cache.query(Key(4)));
+	EXPECT_EQ(&data[5], cache.query(Key(5)));
+}
+
+TEST(LRUCacheTests, HashCollisionsAreResolvedByEquality)
+{
+	Cache cache(4);
+	Data data[4];
+
+	for(int i = 0; i < 4; i++)
+	{
+		cache.add(Key(i, 0x12345670), &data[i]);   // All in one bucket
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		EXPECT_EQ(&data[i], cache.query(Key(i, 0x12345670)));
+	}
+
+	EXPECT_EQ(nullptr, cache.query(Key(4, 0x12345670)));
+}
+
+TEST(LRUCacheTests, EvictionUnlinksCollidingEntries)
+{
+	Cache cache(4);
+	Data data[8];
+
+	// Keys 0 and 4, 1 and 5, ... share buckets, and each eviction removes an entry from the middle or end of a chain
+	for(int i = 0; i < 8; i++)
+	{
+		cache.add(Key(i, i & 1), &data[i]);
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		EXPECT_EQ(nullptr, cache.query(Key(i, i & 1)));
+		EXPECT_EQ(0, data[i].references);
+	}
+
+	for(int i = 4; i < 8; i++)
+	{
+		EXPECT_EQ(&data[i], cache.query(Key(i, i & 1)));
+	}
+}
+
+TEST(LRUCacheTests, ReinsertionReplacesData)
+{
+	Cache cache(4);
+	Data a, b;
+
+	cache.add(Key(1), &a);
+	cache.add(Key(1), &b);
+
+	EXPECT_EQ(&b, cache.query(Key(1)));
+	EXPECT_EQ(0, a.references);
+	EXPECT_EQ(1, b.references);
+	EXPECT_EQ(0u, cache.getStatistics().evictions);
+}
+
+TEST(LRUCacheTests, ReinsertionMakesEntryMostRecentlyUsed)
+{
+	Cache cache(4);
+	Data data[5];
+	Data replacement;
+
+	for(int i = 0; i < 4; i++)
+	{
+		cache.add(Key(i), &data[i]);
+	}
+
+	cache.add(Key(0), &replacement);
+	cache.add(Key(4), &data[4]);
+
+	EXPECT_EQ(&replacement, cache.query(Key(0)));
+	EXPECT_EQ(nullptr, cache.query(Key(1)));
+}
+
+TEST(LRUCacheTests, ReinsertionAfterEviction)
+{
+	Cache cache(2);
+	Data data[3];
+
+	cache.add(Key(0), &data[0]);
+	cache.add(Key(1), &data[1]);
+	cache.add(Key(2), &data[2]);   // Evicts 0
+	cache.add(Key(0), &data[0]);   // Evicts 1
+
+	EXPECT_EQ(&data[0], cache.query(Key(0)));
+	EXPECT_EQ(nullptr, cache.query(Key(1)));
+	EXPECT_EQ(&data[2], cache.query(Key(2)));
+	EXPECT_EQ(1, data[0].references);
+	EXPECT_EQ(0, data[1].references);
+}
+
+TEST(LRUCacheTests, Statistics)
+{
+	Cache cache(2);
+	Data data[4];
+
+	cache.query(Key(0));
+	cache.add(Key(0), &data[0]);
+	cache.query(Key(0));
+	cache.query(Key(0));
+	cache.add(Key(1), &data[1]);
+	cache.add(Key(2), &data[2]);
+	cache.add(Key(3), &data[3]);
+	cache.query(Key(1));
+
+	const sw::CacheStatistics &statistics = cache.getStatistics();
+
+	EXPECT_EQ(2u, statistics.hits);
+	EXPECT_EQ(2u, statistics.misses);
+	EXPECT_EQ(2u, statistics.evictions);
+}
+
+TEST(LRUCacheTests, DestructorUnbindsEntries)
+{
+	Data data[3];
+
+	{
+		Cache cache(2);
+
+		for(int i = 0; i < 3; i++)
+		{
+			cache.add(Key(i), &data[i]);
+		}
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		EXPECT_EQ(0, data[i].references);
+	}
+}
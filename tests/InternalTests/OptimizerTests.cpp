@@ -0,0 +1,524 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Shader/PixelShader.hpp"
+
+#include "gtest/gtest.h"
+
+#include <limits.h>
+
+namespace sw
+{
+	extern bool shaderOptimization;
+}
+
+using sw::Shader;
+
+namespace
+{
+	Shader::SourceParameter source(Shader::ParameterType type, unsigned int index, unsigned int swizzle = 0xE4)
+	{
+		Shader::SourceParameter parameter;
+		parameter.type = type;
+		parameter.index = index;
+		parameter.swizzle = swizzle;
+
+		return parameter;
+	}
+
+	Shader::SourceParameter temp(unsigned int index, unsigned int swizzle = 0xE4)
+	{
+		return source(Shader::PARAMETER_TEMP, index, swizzle);
+	}
+
+	Shader::SourceParameter input(unsigned int index)
+	{
+		return source(Shader::PARAMETER_INPUT, index);
+	}
+
+	Shader::SourceParameter constant(unsigned int index)
+	{
+		return source(Shader::PARAMETER_CONST, index);
+	}
+
+	Shader::SourceParameter literal(float x, float y, float z, float w)
+	{
+		Shader::SourceParameter parameter;
+		parameter.type = Shader::PARAMETER_FLOAT4LITERAL;
+		parameter.value[0] = x;
+		parameter.value[1] = y;
+		parameter.value[2] = z;
+		parameter.value[3] = w;
+
+		return parameter;
+	}
+
+	Shader::SourceParameter integers(int x, int y, int z, int w)
+	{
+		Shader::SourceParameter parameter;
+		parameter.type = Shader::PARAMETER_FLOAT4LITERAL;   // Integer literals share the storage of float ones
+		parameter.integer[0] = x;
+		parameter.integer[1] = y;
+		parameter.integer[2] = z;
+		parameter.integer[3] = w;
+
+		return parameter;
+	}
+
+	class OptimizerTest : public testing::Test
+	{
+	protected:
+		void TearDown() override
+		{
+			sw::shaderOptimization = true;
+		}
+
+		Shader::Instruction *emit(Shader::Opcode opcode)
+		{
+			Shader::Instruction *instruction = new Shader::Instruction(opcode);
+			shader.append(instruction);
+
+			return instruction;
+		}
+
+		Shader::Instruction *emit(Shader::Opcode opcode, unsigned int dst, int mask, const Shader::SourceParameter &src0, const Shader::SourceParameter &src1 = Shader::SourceParameter())
+		{
+			Shader::Instruction *instruction = emit(opcode);
+			instruction->dst.type = Shader::PARAMETER_TEMP;
+			instruction->dst.index = dst;
+			instruction->dst.mask = mask;
+			instruction->src[0] = src0;
+			instruction->src[1] = src1;
+
+			return instruction;
+		}
+
+		Shader::Instruction *mov(unsigned int dst, const Shader::SourceParameter &src)
+		{
+			return emit(Shader::OPCODE_MOV, dst, 0xF, src);
+		}
+
+		// Writes the color output, which keeps the computations it depends on live
+		Shader::Instruction *output(const Shader::SourceParameter &src)
+		{
+			Shader::Instruction *instruction = emit(Shader::OPCODE_MOV, 0, 0xF, src);
+			instruction->dst.type = Shader::PARAMETER_COLOROUT;
+
+			return instruction;
+		}
+
+		Shader::Instruction *branch(Shader::Opcode opcode, unsigned int index = 0)
+		{
+			Shader::Instruction *instruction = emit(opcode);
+
+			if(opcode == Shader::OPCODE_IF)
+			{
+				instruction->src[0] = source(Shader::PARAMETER_CONSTBOOL, index);
+			}
+			else if(opcode == Shader::OPCODE_LOOP)
+			{
+				instruction->src[0] = source(Shader::PARAMETER_LOOP, 0);
+				instruction->src[1] = source(Shader::PARAMETER_CONSTINT, index);
+			}
+
+			return instruction;
+		}
+
+		Shader::Instruction *label(Shader::Opcode opcode, unsigned int label)
+		{
+			Shader::Instruction *instruction = emit(opcode);
+			instruction->dst.type = Shader::PARAMETER_LABEL;
+			instruction->dst.label = label;
+
+			return instruction;
+		}
+
+		int count(Shader::Opcode opcode) const
+		{
+			int n = 0;
+
+			for(size_t i = 0; i < shader.getLength(); i++)
+			{
+				n += (shader.getInstruction(i)->opcode == opcode) ? 1 : 0;
+			}
+
+			return n;
+		}
+
+		// Instructions which write the given temporary register
+		int writes(unsigned int index) const
+		{
+			int n = 0;
+
+			for(size_t i = 0; i < shader.getLength(); i++)
+			{
+				const Shader::Instruction *instruction = shader.getInstruction(i);
+				n += (instruction->dst.type == Shader::PARAMETER_TEMP && instruction->dst.index == index) ? 1 : 0;
+			}
+
+			return n;
+		}
+
+		const Shader::Instruction *last() const
+		{
+			return shader.getInstruction(shader.getLength() - 1);
+		}
+
+		sw::PixelShader shader;
+	};
+}
+
+TEST_F(OptimizerTest, CopiesPropagateWithinBasicBlock)
+{
+	mov(0, input(0));
+	emit(Shader::OPCODE_ADD, 1, 0xF, temp(0), constant(0));
+	output(temp(1));
+
+	shader.optimize();
+
+	ASSERT_EQ(2u, shader.getLength());
+	EXPECT_EQ(Shader::OPCODE_ADD, shader.getInstruction(0)->opcode);
+	EXPECT_EQ(Shader::PARAMETER_INPUT, shader.getInstruction(0)->src[0].type);
+	EXPECT_EQ(1u, shader.getOptimizerStatistics().propagatedCopies);
+	EXPECT_EQ(1u, shader.getOptimizerStatistics().deadInstructions);
+}
+
+TEST_F(OptimizerTest, CopiesComposeSwizzles)
+{
+	mov(0, source(Shader::PARAMETER_INPUT, 0, 0x1B));   // v0.wzyx
+	emit(Shader::OPCODE_ADD, 1, 0xF, temp(0, 0x00), constant(0));   // r0.xxxx
+	output(temp(1));
+
+	shader.optimize();
+
+	ASSERT_EQ(2u, shader.getLength());
+	EXPECT_EQ(Shader::PARAMETER_INPUT, shader.getInstruction(0)->src[0].type);
+	EXPECT_EQ(0xFFu, shader.getInstruction(0)->src[0].swizzle);   // v0.wwww
+}
+
+TEST_F(OptimizerTest, CopiesDoNotPropagateAfterSourceIsOverwritten)
+{
+	mov(0, temp(1));
+	emit(Shader::OPCODE_ADD, 1, 0xF, temp(1), constant(0));
+	emit(Shader::OPCODE_ADD, 2, 0xF, temp(0), temp(1));
+	output(temp(2));
+
+	shader.optimize();
+
+	ASSERT_EQ(4u, shader.getLength());
+	EXPECT_EQ(Shader::PARAMETER_TEMP, shader.getInstruction(2)->src[0].type);
+	EXPECT_EQ(0u, shader.getInstruction(2)->src[0].index);
+}
+
+TEST_F(OptimizerTest, CopiesDoNotPropagateIntoIf)
+{
+	mov(0, input(0));
+	branch(Shader::OPCODE_IF);
+		emit(Shader::OPCODE_ADD, 0, 0xF, temp(0), constant(0));
+	branch(Shader::OPCODE_ENDIF);
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(5u, shader.getLength());
+	EXPECT_EQ(Shader::OPCODE_MOV, shader.getInstruction(0)->opcode);
+	EXPECT_EQ(Shader::PARAMETER_TEMP, shader.getInstruction(2)->src[0].type);
+	EXPECT_EQ(Shader::PARAMETER_TEMP, last()->src[0].type);
+}
+
+TEST_F(OptimizerTest, WritesInBothBranchesKillEarlierValue)
+{
+	mov(0, constant(0));   // Dead
+	branch(Shader::OPCODE_IF);
+		mov(0, input(0));
+	branch(Shader::OPCODE_ELSE);
+		mov(0, input(1));
+	branch(Shader::OPCODE_ENDIF);
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(6u, shader.getLength());
+	EXPECT_EQ(Shader::OPCODE_IF, shader.getInstruction(0)->opcode);
+	EXPECT_EQ(2, writes(0));
+	EXPECT_EQ(Shader::PARAMETER_TEMP, last()->src[0].type);
+}
+
+TEST_F(OptimizerTest, WriteInOneBranchKeepsEarlierValue)
+{
+	mov(0, constant(0));
+	branch(Shader::OPCODE_IF);
+		mov(0, input(0));
+	branch(Shader::OPCODE_ENDIF);
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(5u, shader.getLength());
+	EXPECT_EQ(2, writes(0));
+}
+
+TEST_F(OptimizerTest, LoopCarriedValuesStayLive)
+{
+	mov(0, constant(0));
+	branch(Shader::OPCODE_LOOP);
+		mov(1, input(0));   // Dead, overwritten before being read
+		mov(1, constant(1));
+		emit(Shader::OPCODE_ADD, 0, 0xF, temp(0), temp(1));
+	branch(Shader::OPCODE_ENDLOOP);
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(0, writes(1));
+	EXPECT_EQ(2, writes(0));
+	ASSERT_EQ(5u, shader.getLength());
+
+	const Shader::Instruction *add = shader.getInstruction(2);
+	EXPECT_EQ(Shader::OPCODE_ADD, add->opcode);
+	EXPECT_EQ(Shader::PARAMETER_TEMP, add->src[0].type);
+	EXPECT_EQ(Shader::PARAMETER_CONST, add->src[1].type);
+}
+
+TEST_F(OptimizerTest, BreakKeepsValueLive)
+{
+	branch(Shader::OPCODE_LOOP);
+		mov(0, constant(1));   // Only read after breaking out of the loop
+		branch(Shader::OPCODE_IF);
+			emit(Shader::OPCODE_BREAK);
+		branch(Shader::OPCODE_ENDIF);
+		mov(0, constant(2));
+	branch(Shader::OPCODE_ENDLOOP);
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(2, writes(0));
+	EXPECT_EQ(0u, shader.getOptimizerStatistics().deadInstructions);
+}
+
+TEST_F(OptimizerTest, ContinueKeepsValueLive)
+{
+	branch(Shader::OPCODE_LOOP);
+		mov(0, constant(1));   // Only read after continuing to the end of the loop
+		branch(Shader::OPCODE_IF);
+			emit(Shader::OPCODE_CONTINUE);
+		branch(Shader::OPCODE_ENDIF);
+		mov(0, constant(2));
+	branch(Shader::OPCODE_ENDLOOP);
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(2, writes(0));
+	EXPECT_EQ(0u, shader.getOptimizerStatistics().deadInstructions);
+}
+
+TEST_F(OptimizerTest, WithoutBreakValueIsDead)
+{
+	branch(Shader::OPCODE_LOOP);
+		mov(0, constant(1));
+		branch(Shader::OPCODE_IF);
+			mov(1, constant(3));
+		branch(Shader::OPCODE_ENDIF);
+		mov(0, constant(2));
+	branch(Shader::OPCODE_ENDLOOP);
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(1, writes(0));
+	EXPECT_EQ(0, writes(1));
+}
+
+TEST_F(OptimizerTest, PredicatedWritesDoNotKill)
+{
+	mov(0, constant(0));
+	mov(0, constant(1))->predicate = true;
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(3u, shader.getLength());
+	EXPECT_FALSE(shader.getInstruction(0)->predicate);
+	EXPECT_TRUE(shader.getInstruction(1)->predicate);
+	EXPECT_EQ(Shader::PARAMETER_TEMP, last()->src[0].type);
+}
+
+TEST_F(OptimizerTest, PredicatedMovesAreNotCopies)
+{
+	mov(0, input(0))->predicate = true;
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(2u, shader.getLength());
+	EXPECT_EQ(Shader::PARAMETER_TEMP, last()->src[0].type);
+}
+
+TEST_F(OptimizerTest, MatrixOperandsStayLive)
+{
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		mov(1 + i, constant(4 + i));
+	}
+
+	mov(5, input(0));
+	emit(Shader::OPCODE_M4X4, 0, 0xF, temp(5), temp(1));
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(6u, shader.getLength());
+
+	const Shader::Instruction *m4x4 = shader.getInstruction(4);
+	EXPECT_EQ(Shader::OPCODE_M4X4, m4x4->opcode);
+	EXPECT_EQ(Shader::PARAMETER_INPUT, m4x4->src[0].type);   // Single register operand
+	EXPECT_EQ(Shader::PARAMETER_TEMP, m4x4->src[1].type);    // Reads r1 to r4
+	EXPECT_EQ(1u, m4x4->src[1].index);
+
+	for(unsigned int i = 1; i <= 4; i++)
+	{
+		EXPECT_EQ(1, writes(i));
+	}
+}
+
+TEST_F(OptimizerTest, FoldsIntegerArithmetic)
+{
+	emit(Shader::OPCODE_IADD, 0, 0xF, integers(2, 3, 0x7FFFFFFF, -7), integers(40, -3, 4, 1));
+	emit(Shader::OPCODE_IMUL, 1, 0xF, temp(0), integers(2, 5, 1, -1));
+	output(temp(1));
+
+	shader.optimize();
+
+	ASSERT_EQ(1u, shader.getLength());
+
+	const Shader::SourceParameter &result = shader.getInstruction(0)->src[0];
+	EXPECT_EQ(Shader::PARAMETER_FLOAT4LITERAL, result.type);
+	EXPECT_EQ(84, result.integer[0]);
+	EXPECT_EQ(0, result.integer[1]);
+	EXPECT_EQ(INT_MIN + 3, result.integer[2]);   // Wraps around
+	EXPECT_EQ(6, result.integer[3]);
+	EXPECT_EQ(2u, shader.getOptimizerStatistics().foldedConstants);
+}
+
+TEST_F(OptimizerTest, FoldsIntegerToFloatConversion)
+{
+	emit(Shader::OPCODE_I2F, 0, 0xF, integers(-2, 0, 7, 1 << 24));
+	output(temp(0));
+
+	shader.optimize();
+
+	ASSERT_EQ(1u, shader.getLength());
+
+	const Shader::SourceParameter &result = shader.getInstruction(0)->src[0];
+	EXPECT_EQ(-2.0f, result.value[0]);
+	EXPECT_EQ(0.0f, result.value[1]);
+	EXPECT_EQ(7.0f, result.value[2]);
+	EXPECT_EQ(16777216.0f, result.value[3]);
+}
+
+TEST_F(OptimizerTest, DoesNotFoldNegatedIntegers)
+{
+	Shader::Instruction *iadd = emit(Shader::OPCODE_IADD, 0, 0xF, integers(1, 2, 3, 4), integers(1, 1, 1, 1));
+	iadd->src[1].modifier = Shader::MODIFIER_NEGATE;
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(1, count(Shader::OPCODE_IADD));
+	EXPECT_EQ(0u, shader.getOptimizerStatistics().foldedConstants);
+}
+
+TEST_F(OptimizerTest, DoesNotFoldDenormals)
+{
+	emit(Shader::OPCODE_MUL, 0, 0xF, literal(1e-30f, 1.0f, 1.0f, 1.0f), literal(1e-10f, 1.0f, 1.0f, 1.0f));
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(1, count(Shader::OPCODE_MUL));
+}
+
+TEST_F(OptimizerTest, SimplifiesMultiplicationByOne)
+{
+	emit(Shader::OPCODE_MUL, 0, 0x3, input(0), literal(1.0f, 1.0f, 5.0f, 5.0f));   // Only x and y are written
+	output(temp(0));
+
+	shader.optimize();
+
+	EXPECT_EQ(0, count(Shader::OPCODE_MUL));
+	EXPECT_EQ(1u, shader.getOptimizerStatistics().simplifiedOperations);
+}
+
+TEST_F(OptimizerTest, RemovesUncalledFunctionsAndEntryCall)
+{
+	label(Shader::OPCODE_CALL, 1);
+	emit(Shader::OPCODE_RET);
+	label(Shader::OPCODE_LABEL, 1);
+		output(constant(0));
+	emit(Shader::OPCODE_RET);
+	label(Shader::OPCODE_LABEL, 2);   // Never called
+		output(constant(1));
+	emit(Shader::OPCODE_RET);
+
+	shader.optimize();
+
+	ASSERT_EQ(1u, shader.getLength());
+	EXPECT_EQ(Shader::OPCODE_MOV, shader.getInstruction(0)->opcode);
+	EXPECT_EQ(0u, shader.getInstruction(0)->src[0].index);
+}
+
+TEST_F(OptimizerTest, CallsKeepFunctionsAndTheirResults)
+{
+	mov(0, constant(0));   // Dead, overwritten by the function
+	label(Shader::OPCODE_CALL, 1);
+	output(temp(0));
+	emit(Shader::OPCODE_RET);
+	label(Shader::OPCODE_LABEL, 1);
+		mov(0, constant(1));
+		emit(Shader::OPCODE_LEAVE);   // Redundant before the return
+	emit(Shader::OPCODE_RET);
+	label(Shader::OPCODE_LABEL, 2);   // Never called
+		mov(1, constant(2));
+	emit(Shader::OPCODE_RET);
+
+	shader.optimize();
+
+	ASSERT_EQ(6u, shader.getLength());
+	EXPECT_EQ(Shader::OPCODE_CALL, shader.getInstruction(0)->opcode);
+	EXPECT_EQ(1, count(Shader::OPCODE_LABEL));
+	EXPECT_EQ(2, count(Shader::OPCODE_RET));
+	EXPECT_EQ(0, count(Shader::OPCODE_LEAVE));
+	EXPECT_EQ(1, writes(0));
+	EXPECT_EQ(0, writes(1));
+}
+
+TEST_F(OptimizerTest, CanBeDisabled)
+{
+	sw::shaderOptimization = false;
+
+	mov(0, input(0));
+	emit(Shader::OPCODE_ADD, 1, 0xF, literal(1.0f, 2.0f, 3.0f, 4.0f), literal(1.0f, 1.0f, 1.0f, 1.0f));
+	emit(Shader::OPCODE_ADD, 2, 0xF, temp(0), temp(1));
+	output(temp(2));
+
+	shader.optimize();
+
+	ASSERT_EQ(4u, shader.getLength());
+	EXPECT_EQ(Shader::PARAMETER_TEMP, shader.getInstruction(2)->src[0].type);
+	EXPECT_EQ(Shader::OPCODE_ADD, shader.getInstruction(1)->opcode);
+	EXPECT_EQ(0u, shader.getOptimizerStatistics().propagatedCopies);
+	EXPECT_EQ(0u, shader.getOptimizerStatistics().foldedConstants);
+}
@@ -0,0 +1,731 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Shader/SamplerCore.hpp"
+#include "Shader/Constants.hpp"
+#include "Renderer/Sampler.hpp"
+#include "Renderer/Surface.hpp"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+using namespace sw;
+
+namespace
+{
+	const int size = 16;   // Texture width and height, four by four blocks
+	const int blockCount = (size / 4) * (size / 4);
+
+	enum ETC2Mode
+	{
+		ETC2_INDIVIDUAL,
+		ETC2_DIFFERENTIAL,
+		ETC2_T,
+		ETC2_H,
+		ETC2_PLANAR
+	};
+
+	struct Texel
+	{
+		int r;
+		int g;
+		int b;
+		int a;
+	};
+
+	int blockSize(Format format)
+	{
+		switch(format)
+		{
+		case FORMAT_DXT1:
+		case FORMAT_ETC1:
+		case FORMAT_RGB8_ETC2:
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+			return 8;
+		default:
+			return 16;
+		}
+	}
+
+	bool hasAlpha(Format format)
+	{
+		return format != FORMAT_ETC1 && format != FORMAT_RGB8_ETC2;
+	}
+
+	// Deterministic block contents, so failures can be reproduced
+	class Random
+	{
+	public:
+		explicit Random(unsigned int seed) : state(seed) {}
+
+		unsigned char byte()
+		{
+			state = state * 1103515245 + 12345;
+			return (unsigned char)(state >> 16);
+		}
+
+		void fill(unsigned char *data, int count)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				data[i] = byte();
+			}
+		}
+
+	private:
+		unsigned int state;
+	};
+
+	// Classifies an ETC2 color block the way the decoders do. Punch-through blocks
+	// reuse the differential bit as the opaque bit and have no individual mode.
+	ETC2Mode etc2Mode(const unsigned char *color, bool punchThroughAlpha)
+	{
+		if(!punchThroughAlpha && !(color[3] & 0x02))
+		{
+			return ETC2_INDIVIDUAL;
+		}
+
+		for(int channel = 0; channel < 3; channel++)
+		{
+			int base = color[channel] >> 3;
+			int delta = (color[channel] & 0x04) ? (color[channel] & 0x03) - 4 : (color[channel] & 0x03);
+
+			if(base + delta < 0 || base + delta > 31)
+			{
+				return (ETC2Mode)(ETC2_T + channel);
+			}
+		}
+
+		return ETC2_DIFFERENTIAL;
+	}
+
+	struct Color
+	{
+		float r;
+		float g;
+		float b;
+		float a;
+	};
+
+	struct Coordinate
+	{
+		float u;
+		float v;
+		float w;   // Array layer
+	};
+
+	int blocksWide(int width)
+	{
+		return (width + 3) / 4;
+	}
+
+	int blocksHigh(int height)
+	{
+		return (height + 3) / 4;
+	}
+
+	// Stores the blocks of each slice, in rows of blocks
+	void fillSurface(Surface *surface, const std::vector<unsigned char> &blocks, Format format)
+	{
+		int rowSize = blocksWide(surface->getWidth()) * blockSize(format);
+		int rows = blocksHigh(surface->getHeight());
+		unsigned char *slice = (unsigned char*)surface->lockExternal(0, 0, 0, LOCK_WRITEONLY, PUBLIC);
+
+		for(int z = 0; z < surface->getDepth(); z++)
+		{
+			unsigned char *row = slice;
+
+			for(int y = 0; y < rows; y++)
+			{
+				memcpy(row, &blocks[(z * rows + y) * rowSize], rowSize);
+				row += surface->getExternalPitchB();
+			}
+
+			slice += surface->getExternalSliceB();
+		}
+
+		surface->unlockExternal();
+	}
+
+	// Samples the texture with the sampler's JIT routine, four coordinates at a time. High precision
+	// filtering computes the texel addresses and filter weights in the floating-point path instead.
+	std::vector<Color> sampleJIT(Surface *surface, TextureType type, FilterType filter, AddressingMode addressing, bool highPrecision,
+	                             const std::vector<Coordinate> &coordinates)
+	{
+		Sampler sampler;
+		sampler.setTextureLevel(0, 0, surface, type);
+		sampler.setTextureFilter(filter);
+		sampler.setAddressingModeU(addressing);
+		sampler.setAddressingModeV(addressing);
+		sampler.setHighPrecisionFiltering(highPrecision);
+
+		Sampler::State state = sampler.samplerState();   // SamplerCore keeps a reference
+		Routine *routine = nullptr;
+
+		{
+			Function<Void(Pointer<Byte>, Pointer<Byte>, Pointer<Float4>, Pointer<Float4>)> function;
+			{
+				Pointer<Byte> texture = function.Arg<0>();
+				Pointer<Byte> constants = function.Arg<1>();
+				Pointer<Float4> uvw = function.Arg<2>();
+				Pointer<Float4> color = function.Arg<3>();
+
+				Float4 u = uvw[0];
+				Float4 v = uvw[1];
+				Float4 w = uvw[2];
+				Float4 q = Float4(0.0f);
+				Float4 lod = Float4(0.0f);
+				Vector4f dsx(0.0f, 0.0f, 0.0f, 0.0f);
+				Vector4f dsy(0.0f, 0.0f, 0.0f, 0.0f);
+				Vector4f offset(0.0f, 0.0f, 0.0f, 0.0f);
+
+				SamplerCore core(constants, state);
+				Vector4f c = core.sampleTexture(texture, u, v, w, q, lod, dsx, dsy, offset, SamplerFunction(Lod));
+
+				color[0] = c.x;
+				color[1] = c.y;
+				color[2] = c.z;
+				color[3] = c.w;
+			}
+
+			routine = function(L"SamplerCoreTest");
+		}
+
+		typedef void (*SampleFunction)(const void *texture, const void *constants, const float *uvw, float *color);
+		SampleFunction sample = (SampleFunction)routine->getEntry();
+
+		std::vector<Color> colors(coordinates.size());
+
+		for(size_t i = 0; i < coordinates.size(); i += 4)
+		{
+			float uvw[3][4];
+			float color[4][4];
+
+			for(size_t j = 0; j < 4; j++)
+			{
+				const Coordinate &coordinate = coordinates[min(i + j, coordinates.size() - 1)];
+
+				uvw[0][j] = coordinate.u;
+				uvw[1][j] = coordinate.v;
+				uvw[2][j] = coordinate.w;
+			}
+
+			sample(&sampler.getTextureData(), &constants, &uvw[0][0], &color[0][0]);
+
+			for(size_t j = 0; j < 4 && i + j < coordinates.size(); j++)
+			{
+				colors[i + j].r = color[0][j];
+				colors[i + j].g = color[1][j];
+				colors[i + j].b = color[2][j];
+				colors[i + j].a = color[3][j];
+			}
+		}
+
+		delete routine;
+
+		return colors;
+	}
+
+	// The center of every texel
+	std::vector<Coordinate> texelCenters(int width, int height, float layer)
+	{
+		std::vector<Coordinate> coordinates;
+
+		for(int y = 0; y < height; y++)
+		{
+			for(int x = 0; x < width; x++)
+			{
+				coordinates.push_back({(x + 0.5f) / width, (y + 0.5f) / height, layer});
+			}
+		}
+
+		return coordinates;
+	}
+
+	// Four points around the center of every texel, each with a bilinear footprint which straddles
+	// the texel's edges, and the edges of the 4x4 blocks at their first and last columns and rows
+	std::vector<Coordinate> texelQuarters(int width, int height, float layer)
+	{
+		std::vector<Coordinate> coordinates;
+
+		for(int y = 0; y < height; y++)
+		{
+			for(int x = 0; x < width; x++)
+			{
+				for(float fy : {0.25f, 0.75f})
+				{
+					for(float fx : {0.25f, 0.75f})
+					{
+						coordinates.push_back({(x + fx) / width, (y + fy) / height, layer});
+					}
+				}
+			}
+		}
+
+		return coordinates;
+	}
+
+	// Point samples every texel with the block decoders emitted by the sampler
+	std::vector<Texel> sampleJIT(Format format, const std::vector<unsigned char> &blocks, int width = size, int height = size)
+	{
+		Surface *surface = Surface::create(nullptr, width, height, 1, 0, 1, format, true, false);
+		fillSurface(surface, blocks, format);
+		EXPECT_EQ(surface->getInternalFormat(), format);
+
+		std::vector<Color> colors = sampleJIT(surface, TEXTURE_2D, FILTER_POINT, ADDRESSING_CLAMP, false, texelCenters(width, height, 0.0f));
+		std::vector<Texel> texels(width * height);
+
+		for(int i = 0; i < width * height; i++)
+		{
+			texels[i].r = (int)roundf(colors[i].r * 255.0f);
+			texels[i].g = (int)roundf(colors[i].g * 255.0f);
+			texels[i].b = (int)roundf(colors[i].b * 255.0f);
+			texels[i].a = (int)roundf(colors[i].a * 255.0f);
+		}
+
+		delete surface;
+
+		return texels;
+	}
+
+	// Decodes the blocks of a single slice on upload with the CPU decoders, which a border forces
+	std::vector<Texel> decodeCPU(Format format, const unsigned char *blocks, int width = size, int height = size)
+	{
+		Surface *surface = Surface::create(nullptr, width, height, 1, 1, 1, format, true, false);
+		fillSurface(surface, std::vector<unsigned char>(blocks, blocks + blocksWide(width) * blocksHigh(height) * blockSize(format)), format);
+		EXPECT_NE(surface->getInternalFormat(), format);
+
+		std::vector<Texel> texels(width * height);
+		const unsigned char *row = (const unsigned char*)surface->lockInternal(0, 0, 0, LOCK_READONLY, PUBLIC);
+
+		for(int y = 0; y < height; y++)
+		{
+			for(int x = 0; x < width; x++)
+			{
+				const unsigned char *bgra = &row[4 * x];   // A8R8G8B8 or X8R8G8B8
+
+				texels[x + y * width].r = bgra[2];
+				texels[x + y * width].g = bgra[1];
+				texels[x + y * width].b = bgra[0];
+				texels[x + y * width].a = hasAlpha(format) ? bgra[3] : 0xFF;
+			}
+
+			row += surface->getInternalPitchB();
+		}
+
+		surface->unlockInternal();
+		delete surface;
+
+		return texels;
+	}
+
+	void compareDecoders(Format format, const std::vector<unsigned char> &blocks, int width = size, int height = size)
+	{
+		std::vector<Texel> expected = decodeCPU(format, blocks.data(), width, height);
+		std::vector<Texel> actual = sampleJIT(format, blocks, width, height);
+
+		for(int i = 0; i < width * height; i++)
+		{
+			int x = i % width;
+			int y = i / width;
+
+			EXPECT_EQ(expected[i].r, actual[i].r) << "red at " << x << "," << y;
+			EXPECT_EQ(expected[i].g, actual[i].g) << "green at " << x << "," << y;
+			EXPECT_EQ(expected[i].b, actual[i].b) << "blue at " << x << "," << y;
+			EXPECT_EQ(expected[i].a, actual[i].a) << "alpha at " << x << "," << y;
+		}
+	}
+
+	// Samples the compressed texture, and an uncompressed one holding the CPU decoded texels of each slice,
+	// in the same way. Filtering operates on the same 16-bit components, so the results must be identical.
+	void compareSampling(Format format, const std::vector<unsigned char> &blocks, int width, int height, int depth, float layer)
+	{
+		TextureType type = (depth > 1) ? TEXTURE_2D_ARRAY : TEXTURE_2D;
+
+		Surface *compressed = Surface::create(nullptr, width, height, depth, 0, 1, format, true, false);
+		fillSurface(compressed, blocks, format);
+		EXPECT_EQ(compressed->getInternalFormat(), format);
+
+		Format decodedFormat = hasAlpha(format) ? FORMAT_A8R8G8B8 : FORMAT_X8R8G8B8;   // Without alpha, which is then exactly 1
+		Surface *decoded = Surface::create(nullptr, width, height, depth, 0, 1, decodedFormat, true, false);
+		unsigned char *slice = (unsigned char*)decoded->lockInternal(0, 0, 0, LOCK_WRITEONLY, PUBLIC);
+		int sliceBlocks = blocksWide(width) * blocksHigh(height) * blockSize(format);
+
+		for(int z = 0; z < depth; z++)
+		{
+			std::vector<Texel> texels = decodeCPU(format, &blocks[z * sliceBlocks], width, height);
+
+			for(int y = 0; y < height; y++)
+			{
+				unsigned char *row = slice + y * decoded->getInternalPitchB();
+
+				for(int x = 0; x < width; x++)
+				{
+					const Texel &texel = texels[x + y * width];
+
+					row[4 * x + 0] = texel.b;
+					row[4 * x + 1] = texel.g;
+					row[4 * x + 2] = texel.r;
+					row[4 * x + 3] = texel.a;
+				}
+			}
+
+			slice += decoded->getInternalSliceB();
+		}
+
+		decoded->unlockInternal();
+
+		std::vector<Coordinate> coordinates = texelQuarters(width, height, layer);
+
+		for(FilterType filter : {FILTER_POINT, FILTER_LINEAR})
+		{
+			for(AddressingMode addressing : {ADDRESSING_CLAMP, ADDRESSING_WRAP})
+			{
+				for(bool highPrecision : {false, true})
+				{
+					std::vector<Color> expected = sampleJIT(decoded, type, filter, addressing, highPrecision, coordinates);
+					std::vector<Color> actual = sampleJIT(compressed, type, filter, addressing, highPrecision, coordinates);
+
+					int mismatches = 0;
+
+					for(size_t i = 0; i < coordinates.size() && mismatches < 8; i++)
+					{
+						if(memcmp(&expected[i], &actual[i], sizeof(Color)) != 0)
+						{
+							ADD_FAILURE() << "format " << (int)format << " " << width << "x" << height << " layer " << layer <<
+							                 (filter == FILTER_LINEAR ? " bilinear" : " point") << (addressing == ADDRESSING_WRAP ? " wrap" : " clamp") <<
+							                 (highPrecision ? " high precision" : "") << " at (" << coordinates[i].u * width << "," << coordinates[i].v * height <<
+							                 "): expected (" << expected[i].r << "," << expected[i].g << "," << expected[i].b << "," << expected[i].a <<
+							                 "), got (" << actual[i].r << "," << actual[i].g << "," << actual[i].b << "," << actual[i].a << ")";
+							mismatches++;
+						}
+					}
+				}
+			}
+		}
+
+		delete decoded;
+		delete compressed;
+	}
+
+	// Random DXT blocks, with the endpoint order of every block forced to select the decoding mode
+	std::vector<unsigned char> dxtBlocks(Format format, bool fourColors, bool eightAlphas, unsigned int seed, int count = blockCount)
+	{
+		Random random(seed);
+		int stride = blockSize(format);
+		std::vector<unsigned char> blocks(count * stride);
+		random.fill(blocks.data(), (int)blocks.size());
+
+		for(int i = 0; i < count; i++)
+		{
+			unsigned char *block = &blocks[i * stride];
+			unsigned char *color = (format == FORMAT_DXT1) ? block : block + 8;
+
+			if(i == 0)
+			{
+				color[2] = color[0];   // Equal endpoints use the three color mode
+				color[3] = color[1];
+			}
+
+			if(fourColors && color[0] == color[2] && color[1] == color[3])
+			{
+				color[2] ^= 0x01;
+			}
+
+			unsigned short c0 = color[0] | (color[1] << 8);
+			unsigned short c1 = color[2] | (color[3] << 8);
+
+			if((c0 > c1) != fourColors && c0 != c1)
+			{
+				std::swap(color[0], color[2]);
+				std::swap(color[1], color[3]);
+			}
+
+			if(format == FORMAT_DXT5 && (block[0] > block[1]) != eightAlphas)
+			{
+				std::swap(block[0], block[1]);
+			}
+		}
+
+		return blocks;
+	}
+
+	// Random ETC2 blocks, regenerated until their color part decodes in the requested mode
+	std::vector<unsigned char> etc2Blocks(Format format, ETC2Mode mode, bool opaque, unsigned int seed, int count = blockCount)
+	{
+		Random random(seed);
+		int stride = blockSize(format);
+		int colorOffset = (format == FORMAT_RGBA8_ETC2_EAC) ? 8 : 0;
+		bool punchThroughAlpha = (format == FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2);
+		std::vector<unsigned char> blocks(count * stride);
+
+		for(int i = 0; i < count; i++)
+		{
+			unsigned char *block = &blocks[i * stride];
+
+			do
+			{
+				random.fill(block, stride);
+
+				unsigned char &modeBits = block[colorOffset + 3];
+				modeBits = (mode == ETC2_INDIVIDUAL || (punchThroughAlpha && !opaque)) ? (modeBits & ~0x02) : (modeBits | 0x02);
+			}
+			while(etc2Mode(block + colorOffset, punchThroughAlpha) != mode);
+
+			if(colorOffset && i == 0)
+			{
+				block[1] &= 0x0F;   // A zero alpha multiplier makes all texels the base alpha
+			}
+		}
+
+		return blocks;
+	}
+
+	// Interleaves blocks of every decoding mode of the format
+	std::vector<unsigned char> mixedBlocks(Format format, int count, unsigned int seed)
+	{
+		std::vector<std::vector<unsigned char>> modes;
+
+		switch(format)
+		{
+		case FORMAT_DXT1:
+		case FORMAT_DXT3:
+			modes.push_back(dxtBlocks(format, true, false, seed, count));
+			modes.push_back(dxtBlocks(format, false, false, seed + 1, count));
+			break;
+		case FORMAT_DXT5:
+			modes.push_back(dxtBlocks(format, true, true, seed, count));
+			modes.push_back(dxtBlocks(format, false, false, seed + 1, count));
+			break;
+		case FORMAT_ETC1:
+			modes.push_back(etc2Blocks(format, ETC2_INDIVIDUAL, true, seed, count));
+			modes.push_back(etc2Blocks(format, ETC2_DIFFERENTIAL, true, seed + 1, count));
+			break;
+		case FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+			for(ETC2Mode mode : {ETC2_DIFFERENTIAL, ETC2_T, ETC2_H, ETC2_PLANAR})
+			{
+				modes.push_back(etc2Blocks(format, mode, true, seed + 2 * mode, count));
+				modes.push_back(etc2Blocks(format, mode, false, seed + 2 * mode + 1, count));
+			}
+			break;
+		default:
+			for(ETC2Mode mode : {ETC2_INDIVIDUAL, ETC2_DIFFERENTIAL, ETC2_T, ETC2_H, ETC2_PLANAR})
+			{
+				modes.push_back(etc2Blocks(format, mode, true, seed + mode, count));
+			}
+		}
+
+		int stride = blockSize(format);
+		std::vector<unsigned char> blocks(count * stride);
+
+		for(int i = 0; i < count; i++)
+		{
+			const std::vector<unsigned char> &mode = modes[(i + i / modes.size()) % modes.size()];
+			memcpy(&blocks[i * stride], &mode[i * stride], stride);
+		}
+
+		return blocks;
+	}
+
+	// Alpha blocks with the extreme values and every modifier table, which exercise the rounding and clamping
+	std::vector<unsigned char> alphaBlocks(Format format, int count, unsigned int seed)
+	{
+		std::vector<unsigned char> blocks = mixedBlocks(format, count, seed);
+
+		for(int i = 0; i < count; i++)
+		{
+			unsigned char *alpha = &blocks[i * 16];
+
+			switch(format)
+			{
+			case FORMAT_DXT3:
+				{
+					static const unsigned char patterns[4][2] = {{0x00, 0x00}, {0xFF, 0xFF}, {0x10, 0x32}, {0xF0, 0x0F}};
+
+					for(int j = 0; j < 8; j++)
+					{
+						alpha[j] = patterns[i % 4][j & 1] + ((i % 4 == 2) ? 0x44 * (j >> 1) : 0);   // All 16 values in the third pattern
+					}
+				}
+				break;
+			case FORMAT_DXT5:
+				{
+					static const unsigned char endpoints[6][2] = {{0, 255}, {255, 0}, {255, 254}, {0, 1}, {128, 128}, {1, 0}};
+
+					alpha[0] = endpoints[i % 6][0];
+					alpha[1] = endpoints[i % 6][1];
+				}
+				break;
+			case FORMAT_RGBA8_ETC2_EAC:
+				{
+					static const unsigned char bases[4] = {0, 255, 3, 250};
+					static const unsigned char multipliers[4] = {15, 0, 1, 8};
+
+					alpha[0] = bases[i % 4];
+					alpha[1] = (multipliers[(i / 4) % 4] << 4) | (i % 16);
+				}
+				break;
+			default:
+				ASSERT(false);
+			}
+		}
+
+		return blocks;
+	}
+}
+
+TEST(SamplerCoreTest, DXT1FourColors)
+{
+	compareDecoders(FORMAT_DXT1, dxtBlocks(FORMAT_DXT1, true, false, 1));
+}
+
+TEST(SamplerCoreTest, DXT1ThreeColors)
+{
+	// The fourth color is transparent black, so this also covers the punch-through alpha
+	compareDecoders(FORMAT_DXT1, dxtBlocks(FORMAT_DXT1, false, false, 2));
+}
+
+TEST(SamplerCoreTest, DXT3)
+{
+	compareDecoders(FORMAT_DXT3, dxtBlocks(FORMAT_DXT3, true, false, 3));
+	compareDecoders(FORMAT_DXT3, dxtBlocks(FORMAT_DXT3, false, false, 4));
+}
+
+TEST(SamplerCoreTest, DXT5EightAlphas)
+{
+	compareDecoders(FORMAT_DXT5, dxtBlocks(FORMAT_DXT5, true, true, 5));
+}
+
+TEST(SamplerCoreTest, DXT5SixAlphas)
+{
+	compareDecoders(FORMAT_DXT5, dxtBlocks(FORMAT_DXT5, false, false, 6));
+}
+
+TEST(SamplerCoreTest, ETC1)
+{
+	compareDecoders(FORMAT_ETC1, etc2Blocks(FORMAT_ETC1, ETC2_INDIVIDUAL, true, 7));
+	compareDecoders(FORMAT_ETC1, etc2Blocks(FORMAT_ETC1, ETC2_DIFFERENTIAL, true, 8));
+}
+
+TEST(SamplerCoreTest, ETC2Individual)
+{
+	compareDecoders(FORMAT_RGB8_ETC2, etc2Blocks(FORMAT_RGB8_ETC2, ETC2_INDIVIDUAL, true, 9));
+}
+
+TEST(SamplerCoreTest, ETC2Differential)
+{
+	compareDecoders(FORMAT_RGB8_ETC2, etc2Blocks(FORMAT_RGB8_ETC2, ETC2_DIFFERENTIAL, true, 10));
+}
+
+TEST(SamplerCoreTest, ETC2T)
+{
+	compareDecoders(FORMAT_RGB8_ETC2, etc2Blocks(FORMAT_RGB8_ETC2, ETC2_T, true, 11));
+}
+
+TEST(SamplerCoreTest, ETC2H)
+{
+	compareDecoders(FORMAT_RGB8_ETC2, etc2Blocks(FORMAT_RGB8_ETC2, ETC2_H, true, 12));
+}
+
+TEST(SamplerCoreTest, ETC2Planar)
+{
+	compareDecoders(FORMAT_RGB8_ETC2, etc2Blocks(FORMAT_RGB8_ETC2, ETC2_PLANAR, true, 13));
+}
+
+TEST(SamplerCoreTest, ETC2PunchThroughAlpha)
+{
+	const ETC2Mode modes[] = {ETC2_DIFFERENTIAL, ETC2_T, ETC2_H, ETC2_PLANAR};
+
+	for(ETC2Mode mode : modes)
+	{
+		compareDecoders(FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, etc2Blocks(FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, mode, true, 14 + mode));
+		compareDecoders(FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, etc2Blocks(FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, mode, false, 24 + mode));
+	}
+}
+
+TEST(SamplerCoreTest, ETC2EAC)
+{
+	const ETC2Mode modes[] = {ETC2_INDIVIDUAL, ETC2_DIFFERENTIAL, ETC2_T, ETC2_H, ETC2_PLANAR};
+
+	for(ETC2Mode mode : modes)
+	{
+		compareDecoders(FORMAT_RGBA8_ETC2_EAC, etc2Blocks(FORMAT_RGBA8_ETC2_EAC, mode, true, 34 + mode));
+	}
+}
+
+// Bilinear footprints which straddle the edges between blocks
+TEST(SamplerCoreTest, Bilinear)
+{
+	const Format formats[] = {FORMAT_DXT1, FORMAT_DXT3, FORMAT_DXT5, FORMAT_ETC1, FORMAT_RGB8_ETC2,
+	                          FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, FORMAT_RGBA8_ETC2_EAC};
+
+	for(Format format : formats)
+	{
+		compareSampling(format, mixedBlocks(format, blockCount, 40 + format), size, size, 1, 0.0f);
+	}
+}
+
+// The last column and row of blocks are only partially used
+TEST(SamplerCoreTest, PartialBlocks)
+{
+	const Format formats[] = {FORMAT_DXT1, FORMAT_DXT5, FORMAT_ETC1, FORMAT_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, FORMAT_RGBA8_ETC2_EAC};
+	const int sizes[][2] = {{13, 10}, {6, 7}, {3, 5}, {1, 1}};
+
+	for(Format format : formats)
+	{
+		for(const int *dimensions : sizes)
+		{
+			int width = dimensions[0];
+			int height = dimensions[1];
+			std::vector<unsigned char> blocks = mixedBlocks(format, blocksWide(width) * blocksHigh(height), 50 + width);
+
+			compareDecoders(format, blocks, width, height);
+			compareSampling(format, blocks, width, height, 1, 0.0f);
+		}
+	}
+}
+
+// Layers other than the first are offset by the slice pitch, which counts texels of the decoded layout
+TEST(SamplerCoreTest, ArrayLayers)
+{
+	const Format formats[] = {FORMAT_DXT1, FORMAT_DXT3, FORMAT_RGB8_ETC2, FORMAT_RGBA8_ETC2_EAC};
+	const int width = 10;
+	const int height = 6;
+	const int layers = 3;
+
+	for(Format format : formats)
+	{
+		std::vector<unsigned char> blocks = mixedBlocks(format, blocksWide(width) * blocksHigh(height) * layers, 60 + format);
+
+		for(int layer = 0; layer < layers; layer++)
+		{
+			compareSampling(format, blocks, width, height, layers, (float)layer);
+		}
+	}
+}
+
+TEST(SamplerCoreTest, AlphaBlocks)
+{
+	for(Format format : {FORMAT_DXT3, FORMAT_DXT5, FORMAT_RGBA8_ETC2_EAC})
+	{
+		std::vector<unsigned char> blocks = alphaBlocks(format, blockCount, 70 + format);
+
+		compareDecoders(format, blocks);
+		compareSampling(format, blocks, size, size, 1, 0.0f);
+	}
+}
@@ -0,0 +1,32 @@
+#
+# Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := swiftshader_thread_scaling
+
+ifeq ($(TARGET_TRANSLATE_2ND_ARCH),true)
+LOCAL_MULTILIB := first
+endif
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_CLANG := true
+LOCAL_SRC_FILES := ThreadScaling.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../include
+LOCAL_CFLAGS := -std=c++11 -Wall -Werror
+LOCAL_SHARED_LIBRARIES := libEGL_swiftshader libGLESv2_swiftshader
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,252 @@
+// Copyright 2018 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures rendering throughput as a function of the number of rendering threads.
+// The thread count is passed to SwiftShader through SwiftShader.ini in the working
+// directory, which is read each time a new context is created. Any existing
+// SwiftShader.ini is restored on exit.
+//
+// Usage: ThreadScaling [max threads] [frames]
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static const int width = 1920;
+static const int height = 1080;
+static const int layers = 64;   // Overlapping full-screen triangle pairs per frame
+
+static const char *vertexSource =
+	"attribute vec4 position;\n"
+	"varying vec2 texCoord;\n"
+	"void main()\n"
+	"{\n"
+	"    gl_Position = position;\n"
+	"    texCoord = position.xy * 0.5 + 0.5;\n"
+	"}\n";
+
+static const char *fragmentSource =
+	"precision mediump float;\n"
+	"uniform float layer;\n"
+	"varying vec2 texCoord;\n"
+	"void main()\n"
+	"{\n"
+	"    float s = sin(texCoord.x * 31.0 + layer) * cos(texCoord.y * 17.0 - layer);\n"
+	"    gl_FragColor = vec4(texCoord, s, 1.0 / (layer + 1.0));\n"
+	"}\n";
+
+static const char *configurationFile = "SwiftShader.ini";
+static bool hadConfiguration = false;
+static std::string originalConfiguration;
+
+static void restoreConfiguration()
+{
+	if(hadConfiguration)
+	{
+		FILE *ini = fopen(configurationFile, "wb");
+
+		if(ini)
+		{
+			fwrite(originalConfiguration.data(), 1, originalConfiguration.size(), ini);
+			fclose(ini);
+		}
+	}
+	else
+	{
+		remove(configurationFile);
+	}
+}
+
+static void backUpConfiguration()
+{
+	FILE *ini = fopen(configurationFile, "rb");
+
+	if(ini)
+	{
+		char buffer[4096];
+		size_t size;
+
+		while((size = fread(buffer, 1, sizeof(buffer), ini)) > 0)
+		{
+			originalConfiguration.append(buffer, size);
+		}
+
+		fclose(ini);
+		hadConfiguration = true;
+	}
+
+	atexit(restoreConfiguration);
+}
+
+static void writeConfiguration(int threadCount)
+{
+	FILE *ini = fopen(configurationFile, "w");
+
+	if(!ini)
+	{
+		fprintf(stderr, "Unable to write SwiftShader.ini\n");
+		exit(1);
+	}
+
+	fprintf(ini, "[Processor]\nThreadCount=%d\n[Testing]\nDisableServer=1\n", threadCount);
+	fclose(ini);
+}
+
+static GLuint compileShader(GLenum type, const char *source)
+{
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, nullptr);
+	glCompileShader(shader);
+
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+	if(!compiled)
+	{
+		fprintf(stderr, "Shader compilation failed\n");
+		exit(1);
+	}
+
+	return shader;
+}
+
+static double measure(EGLDisplay display, EGLConfig config, int threadCount, int frames)
+{
+	writeConfiguration(threadCount);
+
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+
+	const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+
+	if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+	{
+		fprintf(stderr, "Unable to create a rendering context\n");
+		exit(1);
+	}
+
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glBindAttribLocation(program, 0, "position");
+	glLinkProgram(program);
+	glUseProgram(program);
+
+	GLint layer = glGetUniformLocation(program, "layer");
+
+	const GLfloat quad[] = { -1, -1, 1, -1, -1, 1, -1, 1, 1, -1, 1, 1 };
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+	glEnableVertexAttribArray(0);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glViewport(0, 0, width, height);
+
+	auto render = [&](int frameCount)
+	{
+		for(int frame = 0; frame < frameCount; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			for(int i = 0; i < layers; i++)
+			{
+				glUniform1f(layer, (float)i);
+				glDrawArrays(GL_TRIANGLES, 0, 6);
+			}
+
+			glFinish();
+		}
+	};
+
+	render(1);   // Warm up the routine caches
+
+	auto start = std::chrono::steady_clock::now();
+	render(frames);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	glUseProgram(0);
+	glDeleteProgram(program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(display, context);
+	eglDestroySurface(display, surface);
+
+	return frames / elapsed.count();
+}
+
+int main(int argc, char **argv)
+{
+	int maxThreads = argc > 1 ? atoi(argv[1]) : 64;
+	int frames = argc > 2 ? atoi(argv[2]) : 20;
+
+	backUpConfiguration();
+
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if(!eglInitialize(display, nullptr, nullptr))
+	{
+		fprintf(stderr, "Unable to initialize EGL\n");
+		return 1;
+	}
+
+	eglBindAPI(EGL_OPENGL_ES_API);
+
+	const EGLint configAttributes[] =
+	{
+		EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_ES2_BIT,
+		EGL_ALPHA_SIZE,			8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint configCount = 0;
+
+	if(!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount != 1)
+	{
+		fprintf(stderr, "No suitable EGL config\n");
+		return 1;
+	}
+
+	printf("threads  frames/s  speedup  Mpixels/s\n");
+
+	double baseline = 0.0;
+
+	for(int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+	{
+		double fps = measure(display, config, threadCount, frames);
+
+		if(threadCount == 1)
+		{
+			baseline = fps;
+		}
+
+		printf("%7d  %8.2f  %7.2f  %9.1f\n", threadCount, fps, fps / baseline, fps * width * height * layers * 1e-6);
+		fflush(stdout);
+	}
+
+	eglTerminate(display);
+
+	return 0;
+}